@@ -26,6 +26,7 @@ Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA.
 #include	"JP2_Reader.hh"
 #include	"JP2_Exception.hh"
 #include	"JP2_Utilities.hh"
+#include	"JP2_Metrics.hh"
 
 //	Kakadu implementation.
 #include	"Kakadu/JP2_File_Reader.hh"
@@ -142,12 +143,14 @@ else
 			<< "reader" << endl
 		<< "for the " << name << " source." << endl
 		<< report;
+	JP2_Metrics::opened (false);
 	throw JP2_Invalid_Argument (message.str (), ID);
 	}
 
 try {reader->open (name);}
 catch (JP2_Exception& except)
 	{
+	JP2_Metrics::opened (false);
 	ostringstream
 		message;
 	message
@@ -159,6 +162,7 @@ catch (JP2_Exception& except)
 	except.message (message.str ());
 	throw;
 	}
+JP2_Metrics::opened (true);
 #if ((DEBUG) & DEBUG_CONSTRUCTORS)
 clog << "<<< JP2::reader" << endl;
 #endif
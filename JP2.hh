@@ -31,6 +31,10 @@ Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA.
 	will automatically be included.
 */
 #include	"JP2_Reader.hh"
+#include	"JP2_Reader_Pool.hh"
+#include	"JP2_Buffer_Pool.hh"
+#include	"JP2_Metrics.hh"
+#include	"JP2_Trace.hh"
 #include	"JP2_Exception.hh"
 #include	"JP2_Utilities.hh"
 
@@ -0,0 +1,383 @@
+/*	JP2_Buffer_Pool
+
+Copyright (C) 2026  Arizona Board of Regents on behalf of the
+Planetary Image Research Laboratory, Lunar and Planetary Laboratory at
+the University of Arizona.
+
+This library is free software; you can redistribute it and/or modify it
+under the terms of the GNU Lesser General Public License, version 2.1,
+as published by the Free Software Foundation.
+
+This library is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library; if not, write to the Free Software Foundation,
+Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA.
+
+*******************************************************************************/
+
+#include	"JP2_Buffer_Pool.hh"
+
+#include	<new>
+#include	<limits>
+
+#if defined (DEBUG)
+/*	DEBUG controls
+
+	DEBUG report selection options.
+	Define any of the following options to obtain the desired debug reports:
+*/
+#define DEBUG_ALL			-1
+#define DEBUG_CONSTRUCTORS	(1 << 0)
+#define DEBUG_ACCESSORS		(1 << 1)
+#define DEBUG_MANIPULATORS	(1 << 2)
+
+#include	<iostream>
+using std::clog;
+using std::endl;
+#endif	//	DEBUG
+
+
+namespace UA
+{
+namespace HiRISE
+{
+/*==============================================================================
+	Constants
+*/
+const char* const
+	JP2_Buffer_Pool::ID =
+		"UA::HiRISE::JP2_Buffer_Pool";
+
+#ifndef BUFFER_POOL_CAPACITY
+#define BUFFER_POOL_CAPACITY		(1024ULL * 1024 * 1024)
+#endif
+const unsigned long long
+	JP2_Buffer_Pool::DEFAULT_CAPACITY	= BUFFER_POOL_CAPACITY;
+
+#ifndef BUFFER_POOL_MINIMUM_SIZE
+#define BUFFER_POOL_MINIMUM_SIZE	(64 * 1024)
+#endif
+const size_t
+	JP2_Buffer_Pool::MINIMUM_SIZE_CLASS	= BUFFER_POOL_MINIMUM_SIZE;
+
+namespace
+{
+const unsigned long long
+	NO_LIMIT = std::numeric_limits<unsigned long long>::max ();
+}
+
+/*==============================================================================
+	Constructors
+*/
+JP2_Buffer_Pool::JP2_Buffer_Pool
+	(
+	unsigned long long					capacity,
+	JP2_Reader::Image_Buffer_Allocator*	allocator
+	)
+	:	Default_Allocator (),
+	Allocator (allocator ? allocator : &Default_Allocator),
+	Lock (),
+	Idle (),
+	Capacity (capacity),
+	Bytes (0),
+	Idle_Bytes (0),
+	Idle_Buffers (0),
+	Hits (0),
+	Misses (0)
+{
+#if ((DEBUG) & DEBUG_CONSTRUCTORS)
+clog << ">-< JP2_Buffer_Pool @ " << (void*)this
+		<< ": capacity " << Capacity << endl;
+#endif
+}
+
+
+JP2_Buffer_Pool::~JP2_Buffer_Pool ()
+{
+#if ((DEBUG) & DEBUG_CONSTRUCTORS)
+clog << ">-< ~JP2_Buffer_Pool @ " << (void*)this
+		<< ": " << Idle_Buffers << " idle buffers" << endl;
+#endif
+release ();
+}
+
+/*==============================================================================
+	Image_Buffer_Allocator
+*/
+void*
+JP2_Buffer_Pool::allocate
+	(
+	size_t	bytes
+	)
+{
+if (! bytes)
+	return NULL;
+size_t
+	size = size_class (bytes);
+Buffer_List
+	released;
+	{
+	std::lock_guard<std::mutex>
+		lock (Lock);
+	Idle_Map::iterator
+		idle = Idle.find (size);
+	if (idle != Idle.end () &&
+		! idle->second.empty ())
+		{
+		void
+			*buffer = idle->second.back ();
+		idle->second.pop_back ();
+		Idle_Bytes -= size;
+		--Idle_Buffers;
+		++Hits;
+		#if ((DEBUG) & DEBUG_MANIPULATORS)
+		clog << ">-< JP2_Buffer_Pool::allocate: reused " << size
+				<< " byte buffer @ " << buffer << endl;
+		#endif
+		return buffer;
+		}
+	++Misses;
+
+	//	Make room for the new buffer.
+	trim ((Capacity > size) ? (Capacity - size) : 0, NO_LIMIT, released);
+	Bytes += size;
+	}
+free_buffers (released);
+
+void
+	*buffer = NULL;
+try {buffer = Allocator->allocate (size);}
+catch (std::bad_alloc&) {}
+if (! buffer)
+	{
+	//	Memory pressure: release all idle buffers and try again.
+	if (release ())
+		{
+		try {buffer = Allocator->allocate (size);}
+		catch (std::bad_alloc&) {}
+		}
+	if (! buffer)
+		{
+		std::lock_guard<std::mutex>
+			lock (Lock);
+		Bytes -= size;
+		}
+	}
+#if ((DEBUG) & DEBUG_MANIPULATORS)
+clog << ">-< JP2_Buffer_Pool::allocate: new " << size
+		<< " byte buffer @ " << buffer << endl;
+#endif
+return buffer;
+}
+
+
+void
+JP2_Buffer_Pool::deallocate
+	(
+	void*	buffer,
+	size_t	bytes
+	)
+{
+if (! buffer)
+	return;
+size_t
+	size = size_class (bytes);
+	{
+	std::lock_guard<std::mutex>
+		lock (Lock);
+	if (Bytes <= Capacity)
+		{
+		Idle[size].push_back (buffer);
+		Idle_Bytes += size;
+		++Idle_Buffers;
+		#if ((DEBUG) & DEBUG_MANIPULATORS)
+		clog << ">-< JP2_Buffer_Pool::deallocate: held " << size
+				<< " byte buffer @ " << buffer << endl;
+		#endif
+		return;
+		}
+	Bytes -= size;
+	}
+//	Over capacity.
+#if ((DEBUG) & DEBUG_MANIPULATORS)
+clog << ">-< JP2_Buffer_Pool::deallocate: released " << size
+		<< " byte buffer @ " << buffer << endl;
+#endif
+Allocator->deallocate (buffer, size);
+}
+
+
+size_t
+JP2_Buffer_Pool::alignment () const
+{return Allocator->alignment ();}
+
+/*==============================================================================
+	Accessors
+*/
+JP2_Buffer_Pool&
+JP2_Buffer_Pool::capacity
+	(
+	unsigned long long	bytes
+	)
+{
+Buffer_List
+	released;
+	{
+	std::lock_guard<std::mutex>
+		lock (Lock);
+	Capacity = bytes;
+	trim (Capacity, NO_LIMIT, released);
+	}
+free_buffers (released);
+return *this;
+}
+
+
+unsigned long long
+JP2_Buffer_Pool::capacity () const
+{
+std::lock_guard<std::mutex>
+	lock (Lock);
+return Capacity;
+}
+
+
+unsigned long long
+JP2_Buffer_Pool::bytes () const
+{
+std::lock_guard<std::mutex>
+	lock (Lock);
+return Bytes;
+}
+
+
+unsigned long long
+JP2_Buffer_Pool::idle_bytes () const
+{
+std::lock_guard<std::mutex>
+	lock (Lock);
+return Idle_Bytes;
+}
+
+
+unsigned int
+JP2_Buffer_Pool::idle_buffers () const
+{
+std::lock_guard<std::mutex>
+	lock (Lock);
+return Idle_Buffers;
+}
+
+
+JP2_Buffer_Pool&
+JP2_Buffer_Pool::reset_statistics ()
+{
+Hits = 0;
+Misses = 0;
+return *this;
+}
+
+
+size_t
+JP2_Buffer_Pool::size_class
+	(
+	size_t	bytes
+	)
+{
+if (bytes <= MINIMUM_SIZE_CLASS)
+	return MINIMUM_SIZE_CLASS;
+
+//	The power of two below the size.
+size_t
+	power = MINIMUM_SIZE_CLASS;
+while ((power << 1) < bytes &&
+		(power << 1) > power)
+	power <<= 1;
+
+//	Four size classes between successive powers of two.
+size_t
+	step = power >> 2;
+return ((bytes + step - 1) / step) * step;
+}
+
+/*==============================================================================
+	Manipulators
+*/
+unsigned long long
+JP2_Buffer_Pool::release
+	(
+	unsigned long long	bytes
+	)
+{
+Buffer_List
+	released;
+	{
+	std::lock_guard<std::mutex>
+		lock (Lock);
+	trim (NO_LIMIT, bytes, released);
+	}
+unsigned long long
+	amount = 0;
+for (Buffer_List::const_iterator
+		buffer = released.begin ();
+		buffer != released.end ();
+		++buffer)
+	amount += buffer->second;
+free_buffers (released);
+#if ((DEBUG) & DEBUG_MANIPULATORS)
+clog << ">-< JP2_Buffer_Pool::release: " << amount << " bytes" << endl;
+#endif
+return amount;
+}
+
+
+void
+JP2_Buffer_Pool::trim
+	(
+	unsigned long long	held_limit,
+	unsigned long long	idle_limit,
+	Buffer_List&		released
+	)
+{
+while (Idle_Buffers &&
+		(Bytes > held_limit ||
+		 Idle_Bytes > idle_limit))
+	{
+	//	Largest size class first.
+	Idle_Map::iterator
+		idle = Idle.end ();
+	--idle;
+	if (idle->second.empty ())
+		{
+		Idle.erase (idle);
+		continue;
+		}
+	released.push_back (std::make_pair (idle->second.back (), idle->first));
+	idle->second.pop_back ();
+	Bytes -= idle->first;
+	Idle_Bytes -= idle->first;
+	--Idle_Buffers;
+	}
+}
+
+
+void
+JP2_Buffer_Pool::free_buffers
+	(
+	const Buffer_List&	released
+	)
+{
+for (Buffer_List::const_iterator
+		buffer = released.begin ();
+		buffer != released.end ();
+		++buffer)
+	Allocator->deallocate (buffer->first, buffer->second);
+}
+
+
+}	//	namespace HiRISE
+}	//	namespace UA
@@ -0,0 +1,260 @@
+/*	JP2_Buffer_Pool
+
+Copyright (C) 2026  Arizona Board of Regents on behalf of the
+Planetary Image Research Laboratory, Lunar and Planetary Laboratory at
+the University of Arizona.
+
+This library is free software; you can redistribute it and/or modify it
+under the terms of the GNU Lesser General Public License, version 2.1,
+as published by the Free Software Foundation.
+
+This library is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library; if not, write to the Free Software Foundation,
+Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA.
+
+*******************************************************************************/
+
+#ifndef _JP2_Buffer_Pool_
+#define _JP2_Buffer_Pool_
+
+#include	"JP2_Reader.hh"
+
+#include	<map>
+#include	<vector>
+#include	<mutex>
+#include	<atomic>
+
+namespace UA
+{
+namespace HiRISE
+{
+/**	A <i>JP2_Buffer_Pool</i> holds image data buffers for reuse by
+	JP2_Readers.
+
+	A JP2_Buffer_Pool is a JP2_Reader::Image_Buffer_Allocator that is
+	{@link JP2_Reader::image_buffer_allocator(Image_Buffer_Allocator*)
+	registered} with one or more readers. When a reader needs an image
+	data buffer it borrows one from the pool; when it no longer needs the
+	buffer - the rendering requires a different buffer size, or the
+	reader is closed - the buffer is returned to the pool. Readers that
+	render regions of a few recurring sizes thus reach a steady state in
+	which no buffers are allocated.
+
+	Buffers are held in size classes: a requested size is rounded up to
+	the next of four steps between successive powers of two, so a buffer
+	is at most 25% larger than requested and a returned buffer can be
+	reused for any request in the same class.
+
+	The pool is limited to a {@link capacity() capacity} of the total
+	bytes of the buffers it has provided, both borrowed and idle. Idle
+	buffers are released as needed to stay within the capacity. A buffer
+	returned when the pool is over capacity is released rather than held.
+	When the allocation of a new buffer fails all idle buffers are
+	released and the allocation is tried again; idle buffers may also
+	be {@link release(unsigned long long) released} on demand when the
+	application is under memory pressure.
+
+	The buffers are provided by a source allocator; by default the
+	reader's default JP2_Reader::Aligned_Buffer_Allocator.
+
+	The pool is thread safe and must remain valid while it is registered
+	with any reader.
+
+	@author		agent
+*/
+class JP2_Buffer_Pool
+:	public JP2_Reader::Image_Buffer_Allocator
+{
+public:
+/*==============================================================================
+	Constants
+*/
+//!	Class identification name with source code version and date.
+static const char* const
+	ID;
+
+/**	The default pool capacity.
+
+	The default is 1 GB.
+*/
+static const unsigned long long
+	DEFAULT_CAPACITY;
+
+/**	The smallest buffer size class.
+
+	The default is 64 KB.
+*/
+static const size_t
+	MINIMUM_SIZE_CLASS;
+
+/*==============================================================================
+	Constructors
+*/
+/**	Construct a JP2_Buffer_Pool.
+
+	@param	capacity	The maximum number of buffer bytes held by the pool.
+	@param	allocator	The source allocator for the buffers. If NULL a
+		default JP2_Reader::Aligned_Buffer_Allocator is used. The
+		allocator is owned by the user and must remain valid for the
+		life of the pool.
+*/
+explicit JP2_Buffer_Pool (unsigned long long capacity = DEFAULT_CAPACITY,
+	JP2_Reader::Image_Buffer_Allocator* allocator = NULL);
+
+/**	Destroy the JP2_Buffer_Pool.
+
+	All idle buffers are released. <b>N.B.</b>: The pool must not be
+	destroyed while any reader holds a buffer borrowed from it.
+*/
+virtual ~JP2_Buffer_Pool ();
+
+private:
+//	Not copyable.
+JP2_Buffer_Pool (const JP2_Buffer_Pool&);
+JP2_Buffer_Pool& operator= (const JP2_Buffer_Pool&);
+
+public:
+/*==============================================================================
+	Image_Buffer_Allocator
+*/
+/**	Borrow a buffer.
+
+	An idle buffer of the size class for the requested bytes is provided
+	if one is held; otherwise a new buffer is allocated from the source
+	allocator.
+
+	@param	bytes	The minimum size of the buffer in bytes.
+	@return	The address of the buffer, or NULL if it could not be
+		allocated.
+*/
+virtual void* allocate (size_t bytes);
+
+/**	Return a buffer.
+
+	@param	buffer	The address of a buffer provided by {@link
+		allocate(size_t) allocate}.
+	@param	bytes	The size of the buffer as requested when it was
+		allocated.
+*/
+virtual void deallocate (void* buffer, size_t bytes);
+
+//!	Get the alignment of the source allocator.
+virtual size_t alignment () const;
+
+/*==============================================================================
+	Accessors
+*/
+/**	Set the pool capacity.
+
+	If the pool holds more than the new capacity idle buffers are
+	released as needed.
+
+	@param	bytes	The maximum number of buffer bytes held by the pool.
+	@return	This JP2_Buffer_Pool.
+*/
+JP2_Buffer_Pool& capacity (unsigned long long bytes);
+
+//!	Get the maximum number of buffer bytes held by the pool.
+unsigned long long capacity () const;
+
+//!	Get the number of bytes of the buffers held, borrowed and idle.
+unsigned long long bytes () const;
+
+//!	Get the number of bytes of the idle buffers.
+unsigned long long idle_bytes () const;
+
+//!	Get the number of idle buffers.
+unsigned int idle_buffers () const;
+
+//!	Get the number of {@link allocate(size_t) allocations} that reused an idle buffer.
+inline unsigned long long hits () const
+	{return Hits;}
+
+//!	Get the number of {@link allocate(size_t) allocations} of a new buffer.
+inline unsigned long long misses () const
+	{return Misses;}
+
+/**	Reset the hits and misses counts to zero.
+
+	@return	This JP2_Buffer_Pool.
+*/
+JP2_Buffer_Pool& reset_statistics ();
+
+/**	Get the size class of a buffer size.
+
+	@param	bytes	A buffer size.
+	@return	The buffer size class for the size.
+*/
+static size_t size_class (size_t bytes);
+
+/*==============================================================================
+	Manipulators
+*/
+/**	Release idle buffers.
+
+	The largest idle buffers are released first.
+
+	@param	bytes	The number of idle bytes that may be retained.
+	@return	The number of bytes released.
+*/
+unsigned long long release (unsigned long long bytes = 0);
+
+/*==============================================================================
+	Data
+*/
+private:
+
+typedef std::map<size_t, std::vector<void*> >	Idle_Map;
+
+typedef std::vector<std::pair<void*, size_t> >	Buffer_List;
+
+/*	Move idle buffers, largest first, to the released list until both
+	the bytes held are within the held limit and the idle bytes are
+	within the idle limit, or there are no more idle buffers.
+
+	The Lock must be held.
+*/
+void trim (unsigned long long held_limit, unsigned long long idle_limit,
+	Buffer_List& released);
+
+//	Return released buffers to the source allocator.
+void free_buffers (const Buffer_List& released);
+
+//!	Used when no source allocator is specified.
+JP2_Reader::Aligned_Buffer_Allocator
+	Default_Allocator;
+
+//!	The source allocator.
+JP2_Reader::Image_Buffer_Allocator
+	*Allocator;
+
+mutable std::mutex
+	Lock;
+
+//!	Idle buffers by size class.
+Idle_Map
+	Idle;
+
+unsigned long long
+	Capacity,
+	Bytes,
+	Idle_Bytes;
+
+unsigned int
+	Idle_Buffers;
+
+std::atomic<unsigned long long>
+	Hits,
+	Misses;
+
+};	//	class JP2_Buffer_Pool
+
+
+}	//	namespace HiRISE
+}	//	namespace UA
+#endif	//	_JP2_Buffer_Pool_
@@ -540,9 +540,12 @@ JP2_Metadata::JP2_Metadata ()
 	Resolution_Levels (0),
 	Progression_Order (-1),
 	Transform (-1),
+	Code_Block_Size (),
+	Precinct_Sizes (),
 
 	//	PVL.
-	Parameters (new Aggregate (Parser::CONTAINER_NAME)),
+	Parameters_Owner (new Aggregate (Parser::CONTAINER_NAME)),
+	Parameters (Parameters_Owner.get ()),
 	Codestream_Parameters (NULL),
 	PLM_Packet_Length_Array (NULL),
 	PLT_Packet_Length_Array (NULL),
@@ -563,7 +566,8 @@ clog << ">-< JP2_Metadata" << endl;
 
 JP2_Metadata::JP2_Metadata
 	(
-	const JP2_Metadata&	JP2_metadata
+	const JP2_Metadata&	JP2_metadata,
+	bool				share_parameters
 	)
 	:
 	Source_Name (JP2_metadata.Source_Name),
@@ -584,8 +588,13 @@ JP2_Metadata::JP2_Metadata
 	Resolution_Levels (JP2_metadata.Resolution_Levels),
 	Progression_Order (JP2_metadata.Progression_Order),
 	Transform (JP2_metadata.Transform),
+	Code_Block_Size (JP2_metadata.Code_Block_Size),
+	Precinct_Sizes (JP2_metadata.Precinct_Sizes),
 
-	Parameters (new Aggregate (*JP2_metadata.Parameters)),
+	Parameters_Owner (share_parameters ?
+		JP2_metadata.Parameters_Owner :
+		std::shared_ptr<Aggregate> (new Aggregate (*JP2_metadata.Parameters))),
+	Parameters (Parameters_Owner.get ()),
 	Codestream_Parameters (NULL),
 	PLM_Packet_Length_Array (NULL),
 	PLT_Packet_Length_Array (NULL),
@@ -595,10 +604,12 @@ JP2_Metadata::JP2_Metadata
 	PLT_Packet_Length_Bytes_Remaining (0),
 	Data_Buffer (NULL),
 	Data_Amount (-1),
-	JP2_Validity (JP2_metadata.JP2_Validity)
+	JP2_Validity (JP2_metadata.JP2_Validity),
+	Codestream_Validity (JP2_metadata.Codestream_Validity)
 {
 #if ((DEBUG) & DEBUG_CONSTRUCTORS)
-clog << ">-< JP2_Metadata: Copy " << JP2_metadata.Source_Name << endl;
+clog << ">-< JP2_Metadata: Copy " << JP2_metadata.Source_Name
+		<< (share_parameters ? " sharing parameters" : "") << endl;
 #endif
 if (JP2_metadata.Pixel_Precision)
 	{
@@ -661,8 +672,7 @@ JP2_Metadata::~JP2_Metadata ()
 #if ((DEBUG) & DEBUG_CONSTRUCTORS)
 clog << ">>> ~JP2_Metadata @ " << (void*)this << endl;
 #endif
-if (Parameters)
-	delete Parameters;
+//	The Parameters are deleted by their (possibly shared) owner.
 if (Pixel_Precision)
 	{
 	#if ((DEBUG) & DEBUG_CONSTRUCTORS)
@@ -765,6 +775,20 @@ if (Pixel_Width &&
 return size;
 }
 
+
+Size_2D
+JP2_Metadata::precinct_size
+	(
+	unsigned int	resolution
+	) const
+{
+if (Precinct_Sizes.empty ())
+	return Size_2D (32768, 32768);
+if (resolution >= Precinct_Sizes.size ())
+	resolution = Precinct_Sizes.size () - 1;
+return Precinct_Sizes[resolution];
+}
+
 /*==============================================================================
 	Accessors
 */
@@ -802,10 +826,22 @@ Quality_Layers				= 0;
 Progression_Order			= -1;
 Resolution_Levels			= 0;
 Transform					= -1;
+Code_Block_Size.Width		=
+Code_Block_Size.Height		= 0;
+Precinct_Sizes.clear ();
 
 //	Clear the Aggregate hierarchy.
-Parameters->clear ();
-Parameters->name (Parser::CONTAINER_NAME);
+if (Parameters_Owner.use_count () > 1)
+	{
+	//	Shared; leave the hierarchy to its other owners.
+	Parameters_Owner.reset (new Aggregate (Parser::CONTAINER_NAME));
+	Parameters = Parameters_Owner.get ();
+	}
+else
+	{
+	Parameters->clear ();
+	Parameters->name (Parser::CONTAINER_NAME);
+	}
 Codestream_Parameters = NULL;
 
 JP2_Validity        = 0;
@@ -3102,6 +3138,8 @@ segment->add (Assignment (RESOLUTION_LEVELS_PARAMETER)
 if (! Resolution_Levels)
 	Resolution_Levels = levels + 1;
 
+bool
+	first_coding_style = ! Code_Block_Size.Width;
 parameter = new Assignment (CODE_BLOCK_WIDTH_PARAMETER);
 datum = get_unsigned_byte
 	(segment->name () + ' ' + CODE_BLOCK_WIDTH_PARAMETER);
@@ -3109,6 +3147,8 @@ comment << "\nCode-block width exponent offset " << datum << '.';
 parameter->comment (comment.str ());
 *parameter= Integer (1 << (datum + 2), Value::UNSIGNED);
 segment->add (parameter);
+if (first_coding_style)
+	Code_Block_Size.Width = 1 << (datum + 2);
 
 parameter = new Assignment (CODE_BLOCK_HEIGHT_PARAMETER);
 datum = get_unsigned_byte
@@ -3118,6 +3158,8 @@ comment << "\nCode-block height exponent offset " << datum << '.';
 parameter->comment (comment.str ());
 *parameter= Integer (1 << (datum + 2), Value::UNSIGNED);
 segment->add (parameter);
+if (first_coding_style)
+	Code_Block_Size.Height = 1 << (datum + 2);
 
 parameter = new Assignment (CODE_BLOCK_STYLE_PARAMETER);
 datum = get_unsigned_byte
@@ -3165,6 +3207,9 @@ if (has_precinct_sizes)
 		pair->add (new Integer (1 << (datum & 0x0F)));
 		pair->add (new Integer (1 << ((datum & 0xF0) >> 4)));
 		list.add (pair);
+		if (first_coding_style)
+			Precinct_Sizes.push_back (Size_2D
+				(1 << (datum & 0x0F), 1 << ((datum & 0xF0) >> 4)));
 		}
 	parameter = new Assignment (PRECINCT_SIZE_PARAMETER);
 	parameter->comment ("\nPrecinct (width, height) by resolution level.");
@@ -25,6 +25,8 @@ Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA.
 #define _JP2_Metadata_
 
 #include	<string>
+#include	<vector>
+#include	<memory>
 
 // PIRL++
 #include "Dimensions.hh"
@@ -561,9 +563,25 @@ JP2_Metadata ();
 
 /*	Construct a copy of JP2_Metadata.
 
+	Normally the {@link metadata_parameters() metadata parameters} are
+	copied. Copying a large parameters hierarchy, such as one with
+	extensive packet length segments, can be expensive. When the
+	parameters are shared the copy references the same parameters
+	hierarchy as the JP2_metadata; the hierarchy is deleted when the
+	last JP2_Metadata that references it is destroyed. A {@link reset()
+	reset} of a JP2_Metadata that shares its parameters provides it with
+	a new, empty, parameters hierarchy.
+
+	<b>N.B.</b>: Shared parameters must not be modified. Parameters
+	should only be shared when the JP2_metadata is {@link is_complete()
+	complete}.
+
 	@param	JP2_metadata	The JP2_Metadata to be copied.
+	@param	share_parameters	If true, the metadata parameters
+		are shared with the JP2_metadata instead of being copied.
 */
-JP2_Metadata (const JP2_Metadata& JP2_metadata);
+JP2_Metadata (const JP2_Metadata& JP2_metadata,
+	bool share_parameters = false);
 
 /**	Destroy this JP2_Metadata.
 
@@ -851,6 +869,35 @@ inline int progression_order () const
 inline int transform () const
 	{return Transform;}
 
+/**	Get the codestream code-block size.
+
+	The value is obtained from the first set of coding style parameters,
+	typically from the COD (coding style default) segment, in the
+	codestream main header.
+
+	@return	A Size_2D containing the nominal code-block width and height.
+		This will be zero until the coding style parameters have been
+		ingested.
+*/
+inline Size_2D code_block_size () const
+	{return Code_Block_Size;}
+
+/**	Get the codestream precinct size for a resolution.
+
+	The values are obtained from the first set of coding style
+	parameters, typically from the COD (coding style default) segment,
+	in the codestream main header.
+
+	@param	resolution	The codestream resolution index, where zero is
+		the lowest resolution (the LL subband) and the highest index is
+		the full resolution image. An index beyond the highest resolution
+		is taken to be the highest resolution.
+	@return	A Size_2D containing the precinct width and height. This
+		will be the maximum 32768 x 32768 size if the coding style
+		parameters do not specify precinct sizes.
+*/
+Size_2D precinct_size (unsigned int resolution) const;
+
 /**	Reset all metadata to their initial values.
 
 	All {@link parameters() parameters} are cleared and cached values
@@ -881,7 +928,7 @@ idaeim::PVL::Aggregate* metadata_parameters () const
 
 	@return	true if the metadata is complete; false otherwise.
 */
-inline bool is_complete ()
+inline bool is_complete () const
 	{return boxes_are_complete () && segments_are_complete ();}
 
 /**	Get a validity report for all metadata.
@@ -1982,7 +2029,16 @@ unsigned int
 int
 	Progression_Order,
 	Transform;
+Size_2D
+	Code_Block_Size;
+//	Precinct sizes by resolution, lowest first; empty if maximal.
+std::vector<Size_2D>
+	Precinct_Sizes;
+
 
+//!	Owner of the metadata PVL Parameters, which may be shared.
+std::shared_ptr<idaeim::PVL::Aggregate>
+	Parameters_Owner;
 
 //!	Metadata PVL Parameters.
 idaeim::PVL::Aggregate
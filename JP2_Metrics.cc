@@ -0,0 +1,464 @@
+/*	JP2_Metrics
+
+Copyright (C) 2026  Arizona Board of Regents on behalf of the
+Planetary Image Research Laboratory, Lunar and Planetary Laboratory at
+the University of Arizona.
+
+This library is free software; you can redistribute it and/or modify it
+under the terms of the GNU Lesser General Public License, version 2.1,
+as published by the Free Software Foundation.
+
+This library is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library; if not, write to the Free Software Foundation,
+Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA.
+
+*******************************************************************************/
+
+#include	"JP2_Metrics.hh"
+
+#include	"JP2_Exception.hh"
+
+#include	<atomic>
+#include	<sstream>
+#include	<fstream>
+#include	<iomanip>
+#include	<cstdio>
+#include	<cstring>
+#include	<cerrno>
+using std::string;
+using std::ostream;
+using std::ostringstream;
+using std::ofstream;
+using std::endl;
+
+#if defined (DEBUG)
+/*	DEBUG controls
+
+	DEBUG report selection options.
+	Define any of the following options to obtain the desired debug reports:
+*/
+#define DEBUG_ALL			-1
+#define DEBUG_RECORDING		(1 << 0)
+#define DEBUG_EXPORT		(1 << 1)
+
+#include	<iostream>
+using std::clog;
+using std::boolalpha;
+#endif	//	DEBUG
+
+
+namespace UA
+{
+namespace HiRISE
+{
+/*==============================================================================
+	Constants
+*/
+const char* const
+	JP2_Metrics::ID =
+		"UA::HiRISE::JP2_Metrics";
+
+const unsigned int
+	JP2_Metrics::RESOLUTION_LEVELS;
+
+const unsigned int
+	JP2_Metrics::LATENCY_BUCKETS;
+
+const double
+	JP2_Metrics::LATENCY_BOUNDS[JP2_Metrics::LATENCY_BUCKETS] =
+		{
+		0.005, 0.01, 0.025, 0.05, 0.1, 0.25,
+		0.5, 1.0, 2.5, 5.0, 10.0, 30.0
+		};
+
+#ifndef DOXYGEN_PROCESSING
+namespace
+{
+/*	The metrics registry.
+
+	Times are accumulated as integer nanoseconds so that they can be
+	atomic counters. The registry has static storage duration, so it is
+	zero initialized before any reader can record to it.
+*/
+struct Latency_Counters
+	{
+	std::atomic<unsigned long long>
+		Buckets[JP2_Metrics::LATENCY_BUCKETS + 1],
+		Count,
+		Sum_Nanoseconds;
+	};
+
+struct Metrics_Registry
+	{
+	std::atomic<unsigned long long>
+		Opens,
+		Open_Failures,
+		Renders,
+		Render_Failures,
+		Bytes_Rendered,
+		Decode_Nanoseconds,
+		JPIP_Bytes_Received,
+		Cache_Hits,
+		Cache_Misses,
+		Reconnects,
+		Reconnect_Failures;
+	Latency_Counters
+		Render_Latency[JP2_Metrics::RESOLUTION_LEVELS];
+	};
+
+Metrics_Registry
+	Registry;
+
+inline void
+count
+	(
+	std::atomic<unsigned long long>&	counter,
+	unsigned long long					amount = 1
+	)
+{counter.fetch_add (amount, std::memory_order_relaxed);}
+
+inline unsigned long long
+value
+	(
+	const std::atomic<unsigned long long>&	counter
+	)
+{return counter.load (std::memory_order_relaxed);}
+
+inline unsigned long long
+nanoseconds
+	(
+	double	seconds
+	)
+{return (seconds > 0) ? (unsigned long long)(seconds * 1.0e9 + 0.5) : 0;}
+
+//	Write a counter metric.
+void
+counter_exposition
+	(
+	ostream&			stream,
+	const char*			name,
+	const char*			help,
+	unsigned long long	amount
+	)
+{
+stream
+	<< "# HELP " << name << ' ' << help << '\n'
+	<< "# TYPE " << name << " counter\n"
+	<< name << ' ' << amount << '\n';
+}
+
+}	//	namespace
+#endif	//	DOXYGEN_PROCESSING
+
+/*==============================================================================
+	Recording
+*/
+void
+JP2_Metrics::opened
+	(
+	bool	succeeded
+	)
+{
+#if ((DEBUG) & DEBUG_RECORDING)
+clog << ">-< JP2_Metrics::opened: " << boolalpha << succeeded << endl;
+#endif
+count (succeeded ? Registry.Opens : Registry.Open_Failures);
+}
+
+
+void
+JP2_Metrics::rendered
+	(
+	unsigned int						resolution_level,
+	const JP2_Reader::Render_Statistics&	statistics
+	)
+{
+#if ((DEBUG) & DEBUG_RECORDING)
+clog << ">-< JP2_Metrics::rendered: resolution level " << resolution_level
+		<< ", " << statistics.Render_Seconds << " seconds" << endl;
+#endif
+count (Registry.Renders);
+count (Registry.Bytes_Rendered, statistics.Bytes_Rendered);
+count (Registry.Decode_Nanoseconds, nanoseconds (statistics.Decode_Seconds));
+
+if (resolution_level)
+	--resolution_level;
+if (resolution_level >= RESOLUTION_LEVELS)
+	resolution_level = RESOLUTION_LEVELS - 1;
+Latency_Counters
+	&latency = Registry.Render_Latency[resolution_level];
+unsigned int
+	bucket = 0;
+while (bucket < LATENCY_BUCKETS &&
+		statistics.Render_Seconds > LATENCY_BOUNDS[bucket])
+	++bucket;
+count (latency.Buckets[bucket]);
+count (latency.Count);
+count (latency.Sum_Nanoseconds, nanoseconds (statistics.Render_Seconds));
+}
+
+
+void
+JP2_Metrics::render_failed ()
+{count (Registry.Render_Failures);}
+
+
+void
+JP2_Metrics::JPIP_bytes_received
+	(
+	unsigned long long	bytes
+	)
+{count (Registry.JPIP_Bytes_Received, bytes);}
+
+
+void
+JP2_Metrics::cache_hit ()
+{count (Registry.Cache_Hits);}
+
+
+void
+JP2_Metrics::cache_miss ()
+{count (Registry.Cache_Misses);}
+
+
+void
+JP2_Metrics::reconnected
+	(
+	bool	succeeded
+	)
+{
+#if ((DEBUG) & DEBUG_RECORDING)
+clog << ">-< JP2_Metrics::reconnected: " << boolalpha << succeeded << endl;
+#endif
+count (Registry.Reconnects);
+if (! succeeded)
+	count (Registry.Reconnect_Failures);
+}
+
+/*==============================================================================
+	Export
+*/
+JP2_Metrics::Snapshot
+JP2_Metrics::snapshot ()
+{
+Snapshot
+	metrics;
+metrics.Opens				= value (Registry.Opens);
+metrics.Open_Failures		= value (Registry.Open_Failures);
+metrics.Renders				= value (Registry.Renders);
+metrics.Render_Failures		= value (Registry.Render_Failures);
+metrics.Bytes_Rendered		= value (Registry.Bytes_Rendered);
+metrics.Decode_Seconds		= value (Registry.Decode_Nanoseconds) / 1.0e9;
+metrics.JPIP_Bytes_Received	= value (Registry.JPIP_Bytes_Received);
+metrics.Cache_Hits			= value (Registry.Cache_Hits);
+metrics.Cache_Misses		= value (Registry.Cache_Misses);
+metrics.Reconnects			= value (Registry.Reconnects);
+metrics.Reconnect_Failures	= value (Registry.Reconnect_Failures);
+for (unsigned int
+		level = 0;
+		level < RESOLUTION_LEVELS;
+		level++)
+	{
+	Latency_Counters
+		&counters = Registry.Render_Latency[level];
+	Latency_Histogram
+		&histogram = metrics.Render_Latency[level];
+	for (unsigned int
+			bucket = 0;
+			bucket <= LATENCY_BUCKETS;
+			bucket++)
+		histogram.Buckets[bucket] = value (counters.Buckets[bucket]);
+	histogram.Count = value (counters.Count);
+	histogram.Sum_Seconds = value (counters.Sum_Nanoseconds) / 1.0e9;
+	}
+return metrics;
+}
+
+
+ostream&
+JP2_Metrics::exposition
+	(
+	ostream&	stream
+	)
+{return exposition (stream, snapshot ());}
+
+
+ostream&
+JP2_Metrics::exposition
+	(
+	ostream&		stream,
+	const Snapshot&	metrics
+	)
+{
+counter_exposition (stream, "jp2_reader_opens_total",
+	"Sources opened by JP2::reader.", metrics.Opens);
+counter_exposition (stream, "jp2_reader_open_failures_total",
+	"Sources that JP2::reader failed to open.", metrics.Open_Failures);
+counter_exposition (stream, "jp2_renders_total",
+	"Renderings completed.", metrics.Renders);
+counter_exposition (stream, "jp2_render_failures_total",
+	"Renderings that failed.", metrics.Render_Failures);
+counter_exposition (stream, "jp2_rendered_bytes_total",
+	"Image data bytes rendered.", metrics.Bytes_Rendered);
+
+std::streamsize
+	precision = stream.precision (9);
+stream
+	<< "# HELP jp2_decode_seconds_total"
+		" Elapsed time decompressing rendering increments.\n"
+	<< "# TYPE jp2_decode_seconds_total counter\n"
+	<< "jp2_decode_seconds_total " << metrics.Decode_Seconds << '\n';
+
+counter_exposition (stream, "jp2_jpip_received_bytes_total",
+	"Bytes received from JPIP servers.", metrics.JPIP_Bytes_Received);
+counter_exposition (stream, "jp2_tile_cache_hits_total",
+	"Tile cache lookups that found the tile.", metrics.Cache_Hits);
+counter_exposition (stream, "jp2_tile_cache_misses_total",
+	"Tile cache lookups that did not find the tile.", metrics.Cache_Misses);
+counter_exposition (stream, "jp2_jpip_reconnects_total",
+	"JPIP server reconnections attempted.", metrics.Reconnects);
+counter_exposition (stream, "jp2_jpip_reconnect_failures_total",
+	"JPIP server reconnections that failed.", metrics.Reconnect_Failures);
+
+stream
+	<< "# HELP jp2_render_duration_seconds"
+		" Rendering latency by resolution level.\n"
+	<< "# TYPE jp2_render_duration_seconds histogram\n";
+for (unsigned int
+		level = 0;
+		level < RESOLUTION_LEVELS;
+		level++)
+	{
+	const Latency_Histogram
+		&histogram = metrics.Render_Latency[level];
+	if (! histogram.Count)
+		continue;
+	unsigned long long
+		cumulative = 0;
+	for (unsigned int
+			bucket = 0;
+			bucket < LATENCY_BUCKETS;
+			bucket++)
+		{
+		cumulative += histogram.Buckets[bucket];
+		stream
+			<< "jp2_render_duration_seconds_bucket{resolution_level=\""
+				<< (level + 1) << "\",le=\"" << LATENCY_BOUNDS[bucket] << "\"} "
+				<< cumulative << '\n';
+		}
+	stream
+		<< "jp2_render_duration_seconds_bucket{resolution_level=\""
+			<< (level + 1) << "\",le=\"+Inf\"} " << histogram.Count << '\n'
+		<< "jp2_render_duration_seconds_sum{resolution_level=\""
+			<< (level + 1) << "\"} " << histogram.Sum_Seconds << '\n'
+		<< "jp2_render_duration_seconds_count{resolution_level=\""
+			<< (level + 1) << "\"} " << histogram.Count << '\n';
+	}
+stream.precision (precision);
+return stream;
+}
+
+
+string
+JP2_Metrics::exposition ()
+{
+ostringstream
+	stream;
+exposition (stream);
+return stream.str ();
+}
+
+
+void
+JP2_Metrics::write_exposition
+	(
+	const std::string&	pathname
+	)
+{
+#if ((DEBUG) & DEBUG_EXPORT)
+clog << ">>> JP2_Metrics::write_exposition: " << pathname << endl;
+#endif
+string
+	temporary (pathname + ".tmp");
+string
+	content (exposition ());
+	{
+	ofstream
+		file (temporary.c_str (), std::ios::out | std::ios::trunc);
+	if (file)
+		file << content;
+	if (file)
+		file.close ();
+	if (! file)
+		{
+		int
+			error = errno;
+		std::remove (temporary.c_str ());
+		ostringstream
+			message;
+		message
+			<< "Couldn't write the metrics exposition" << endl
+			<< "to the " << temporary << " file.";
+		if (error)
+			message << endl << strerror (error);
+		throw JP2_IO_Failure (message.str (), ID);
+		}
+	}
+if (std::rename (temporary.c_str (), pathname.c_str ()))
+	{
+	int
+		error = errno;
+	std::remove (temporary.c_str ());
+	ostringstream
+		message;
+	message
+		<< "Couldn't replace the " << pathname << " file" << endl
+		<< "with the metrics exposition." << endl
+		<< strerror (error);
+	throw JP2_IO_Failure (message.str (), ID);
+	}
+#if ((DEBUG) & DEBUG_EXPORT)
+clog << "<<< JP2_Metrics::write_exposition" << endl;
+#endif
+}
+
+
+void
+JP2_Metrics::reset ()
+{
+Registry.Opens					= 0;
+Registry.Open_Failures			= 0;
+Registry.Renders				= 0;
+Registry.Render_Failures		= 0;
+Registry.Bytes_Rendered			= 0;
+Registry.Decode_Nanoseconds		= 0;
+Registry.JPIP_Bytes_Received	= 0;
+Registry.Cache_Hits				= 0;
+Registry.Cache_Misses			= 0;
+Registry.Reconnects				= 0;
+Registry.Reconnect_Failures		= 0;
+for (unsigned int
+		level = 0;
+		level < RESOLUTION_LEVELS;
+		level++)
+	{
+	Latency_Counters
+		&counters = Registry.Render_Latency[level];
+	for (unsigned int
+			bucket = 0;
+			bucket <= LATENCY_BUCKETS;
+			bucket++)
+		counters.Buckets[bucket] = 0;
+	counters.Count = 0;
+	counters.Sum_Nanoseconds = 0;
+	}
+}
+
+
+}	//	namespace HiRISE
+}	//	namespace UA
@@ -0,0 +1,278 @@
+/*	JP2_Metrics
+
+Copyright (C) 2026  Arizona Board of Regents on behalf of the
+Planetary Image Research Laboratory, Lunar and Planetary Laboratory at
+the University of Arizona.
+
+This library is free software; you can redistribute it and/or modify it
+under the terms of the GNU Lesser General Public License, version 2.1,
+as published by the Free Software Foundation.
+
+This library is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library; if not, write to the Free Software Foundation,
+Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA.
+
+*******************************************************************************/
+
+#ifndef _JP2_Metrics_
+#define _JP2_Metrics_
+
+#include	"JP2_Reader.hh"
+
+#include	<string>
+#include	<ostream>
+
+
+namespace UA
+{
+namespace HiRISE
+{
+/**	<i>JP2_Metrics</i> is the process-wide registry of JP2 reader
+	metrics.
+
+	The registry aggregates counters across every JP2_Reader in the
+	process: sources opened by {@link JP2::reader(const std::string&)
+	JP2::reader} and the opens that failed, renderings and the
+	renderings that failed, the image data bytes rendered, the
+	decompression time, bytes received from JPIP servers, tile cache
+	hits and misses, and JPIP server reconnections and the reconnections
+	that failed. A histogram of rendering latency is kept for each
+	resolution level.
+
+	The metrics are recorded by the readers as they operate. All
+	recording is lock-free: each metric is an independent atomic
+	counter, so recording is safe from any thread and costs no more than
+	an atomic increment.
+
+	A {@link snapshot() snapshot} of all the metrics may be taken at any
+	time, and the metrics may be exported in the Prometheus {@link
+	exposition(std::ostream&) text exposition format} to any stream -
+	e.g. a socket stream served to a monitoring agent - or {@link
+	write_exposition(const std::string&) written to a file} that a
+	monitoring agent scrapes. Because the counters are independent a
+	snapshot taken while readers are active is not an instant in time:
+	each counter is exact, but related counters may differ by the
+	operations in progress.
+
+	All methods are static; JP2_Metrics objects are not constructed.
+
+	@author		agent
+*/
+class JP2_Metrics
+{
+public:
+/*==============================================================================
+	Constants
+*/
+//!	Class identification name with source code version and date.
+static const char* const
+	ID;
+
+/**	The number of resolution levels with a rendering latency histogram.
+
+	This is one more than the maximum number of JPEG2000 decomposition
+	levels. Renderings at a greater resolution level are recorded in the
+	last histogram.
+*/
+static const unsigned int
+	RESOLUTION_LEVELS = 33;
+
+//!	The number of rendering latency histogram buckets with an upper bound.
+static const unsigned int
+	LATENCY_BUCKETS = 12;
+
+/**	The rendering latency histogram bucket upper bounds in seconds.
+
+	An additional bucket counts the renderings with a greater latency.
+*/
+static const double
+	LATENCY_BOUNDS[LATENCY_BUCKETS];
+
+/*==============================================================================
+	Types
+*/
+//!	A rendering latency histogram.
+struct Latency_Histogram
+	{
+	/**	The number of renderings in each latency bucket.
+
+		The count of a bucket is for the renderings with a latency
+		greater than the upper bound of the previous bucket and no
+		greater than its upper bound. The last bucket counts the
+		renderings with a latency greater than the last upper bound.
+	*/
+	unsigned long long
+		Buckets[LATENCY_BUCKETS + 1];
+
+	//!	The total number of renderings.
+	unsigned long long
+		Count;
+
+	//!	The total latency of the renderings in seconds.
+	double
+		Sum_Seconds;
+	};
+
+//!	A snapshot of all the metrics.
+struct Snapshot
+	{
+	//!	Sources opened by JP2::reader.
+	unsigned long long
+		Opens;
+
+	//!	Sources that JP2::reader failed to open.
+	unsigned long long
+		Open_Failures;
+
+	//!	Renderings completed, including canceled renderings.
+	unsigned long long
+		Renders;
+
+	//!	Renderings that failed with an exception.
+	unsigned long long
+		Render_Failures;
+
+	//!	Image data bytes rendered.
+	unsigned long long
+		Bytes_Rendered;
+
+	//!	Elapsed time decompressing rendering increments in seconds.
+	double
+		Decode_Seconds;
+
+	//!	Bytes received from JPIP servers.
+	unsigned long long
+		JPIP_Bytes_Received;
+
+	//!	Tile cache lookups that found the tile.
+	unsigned long long
+		Cache_Hits;
+
+	//!	Tile cache lookups that did not find the tile.
+	unsigned long long
+		Cache_Misses;
+
+	//!	JPIP server reconnections attempted.
+	unsigned long long
+		Reconnects;
+
+	//!	JPIP server reconnections that failed.
+	unsigned long long
+		Reconnect_Failures;
+
+	/**	Rendering latency histograms.
+
+		The histogram for a resolution level, where level 1 is full
+		resolution, is at index level - 1.
+	*/
+	Latency_Histogram
+		Render_Latency[RESOLUTION_LEVELS];
+	};
+
+/*==============================================================================
+	Recording
+*/
+/**	Record a source open.
+
+	@param	succeeded	true if the source was opened; false if the open
+		failed.
+*/
+static void opened (bool succeeded);
+
+/**	Record a completed rendering.
+
+	@param	resolution_level	The resolution level of the rendering.
+	@param	statistics	The JP2_Reader::Render_Statistics of the
+		rendering.
+*/
+static void rendered (unsigned int resolution_level,
+	const JP2_Reader::Render_Statistics& statistics);
+
+//!	Record a rendering that failed.
+static void render_failed ();
+
+/**	Record bytes received from a JPIP server.
+
+	@param	bytes	The number of bytes received.
+*/
+static void JPIP_bytes_received (unsigned long long bytes);
+
+//!	Record a tile cache hit.
+static void cache_hit ();
+
+//!	Record a tile cache miss.
+static void cache_miss ();
+
+/**	Record a JPIP server reconnection.
+
+	@param	succeeded	true if the reconnection succeeded; false if it
+		failed.
+*/
+static void reconnected (bool succeeded);
+
+/*==============================================================================
+	Export
+*/
+/**	Get a snapshot of all the metrics.
+
+	@return	A Snapshot of the metrics.
+*/
+static Snapshot snapshot ();
+
+/**	Write the metrics in the Prometheus text exposition format.
+
+	@param	stream	The ostream to which the metrics are written.
+	@return	The stream.
+*/
+static std::ostream& exposition (std::ostream& stream);
+
+/**	Write a metrics snapshot in the Prometheus text exposition format.
+
+	Only the resolution levels that have been rendered have a latency
+	histogram in the exposition.
+
+	@param	stream	The ostream to which the metrics are written.
+	@param	metrics	The Snapshot of the metrics to be written.
+	@return	The stream.
+*/
+static std::ostream& exposition (std::ostream& stream,
+	const Snapshot& metrics);
+
+/**	Get the metrics in the Prometheus text exposition format.
+
+	@return	A string containing the metrics exposition.
+*/
+static std::string exposition ();
+
+/**	Write the metrics exposition to a file.
+
+	The exposition is written to a temporary file in the same directory
+	that then replaces the named file, so a reader of the file never
+	sees a partially written exposition.
+
+	@param	pathname	The pathname of the file.
+	@throws	JP2_IO_Failure	If the file could not be written.
+*/
+static void write_exposition (const std::string& pathname);
+
+/**	Reset all the metrics to zero.
+
+	<b>N.B.</b>: Monitoring systems expect counters to only increase;
+	a reset will appear to them as a process restart.
+*/
+static void reset ();
+
+private:
+JP2_Metrics () {}
+
+};	//	Class JP2_Metrics
+
+
+}	//	namespace HiRISE
+}	//	namespace UA
+#endif
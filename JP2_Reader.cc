@@ -22,6 +22,7 @@ Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA.
 *******************************************************************************/
 
 #include	"JP2_Reader.hh"
+#include	"JP2_Trace.hh"
 
 #if ! defined (THREAD_COUNT) || THREAD_COUNT < 0
 #undef THREAD_COUNT
@@ -44,11 +45,59 @@ using namespace kdu_core;
 using std::string;
 #include	<sstream>
 using std::ostringstream;
+#include	<fstream>
+using std::ifstream;
 #include	<iomanip>
 using std::endl;
 using std::setprecision;
 #include	<stdexcept>
 using std::bad_alloc;
+#include	<exception>
+#include	<system_error>
+#include	<thread>
+#include	<condition_variable>
+#include	<deque>
+#include	<cstring>
+#include	<cerrno>
+#include	<cstdlib>
+#include	<ctime>
+#include	<chrono>
+
+#ifdef _WIN32
+#include "Windows.h"	//	For file memory mapping.
+#include	<malloc.h>	//	For aligned allocation.
+#else
+#include	<fcntl.h>
+#include	<unistd.h>
+#include	<sys/mman.h>
+#endif
+
+#if defined (__linux__)
+#include	<sched.h>
+#include	<pthread.h>
+#endif
+
+/*	Vector sample bytes swapping kernels are selected at run time on
+	x86 hosts. SWAP_SAMPLE_BYTES_SIMD may be defined to 0 to use only
+	the portable kernel.
+*/
+#ifndef SWAP_SAMPLE_BYTES_SIMD
+#if defined (__GNUC__) && (defined (__x86_64__) || defined (__i386__))
+#define SWAP_SAMPLE_BYTES_SIMD	1
+#else
+#define SWAP_SAMPLE_BYTES_SIMD	0
+#endif
+#endif
+/*	Vector sample stretching kernels for 16-bit samples are likewise
+	selected at run time. STRETCH_SAMPLES_SIMD may be defined to 0 to
+	use only the portable kernel.
+*/
+#ifndef STRETCH_SAMPLES_SIMD
+#define STRETCH_SAMPLES_SIMD	SWAP_SAMPLE_BYTES_SIMD
+#endif
+#if SWAP_SAMPLE_BYTES_SIMD || STRETCH_SAMPLES_SIMD
+#include	<immintrin.h>
+#endif
 
 #if defined (DEBUG)
 /*	DEBUG controls
@@ -109,6 +158,44 @@ const unsigned int
 const unsigned long long
 	JP2_Reader::DEFAULT_RENDERING_INCREMENT_BYTES = INCREMENTAL_BUFFER_BYTES;
 
+#ifndef PROCESSOR_CACHE_BYTES
+#define PROCESSOR_CACHE_BYTES				(1024 * 1024)
+#endif
+const unsigned long long
+	JP2_Reader::DEFAULT_CACHE_BYTES = PROCESSOR_CACHE_BYTES;
+
+#ifndef IMAGE_BUFFER_ALIGNMENT
+#define IMAGE_BUFFER_ALIGNMENT				64
+#endif
+const size_t
+	JP2_Reader::DEFAULT_BUFFER_ALIGNMENT = IMAGE_BUFFER_ALIGNMENT;
+
+/*	The transparent huge page size.
+
+	Buffers that use huge pages are aligned to this size.
+*/
+#ifndef HUGE_PAGE_BYTES
+#define HUGE_PAGE_BYTES						(2 * 1024 * 1024)
+#endif
+
+#ifndef LINE_SINK_RING_BUFFERS
+#define LINE_SINK_RING_BUFFERS				2
+#endif
+const unsigned int
+	JP2_Reader::LINE_SINK_BUFFERS = LINE_SINK_RING_BUFFERS;
+
+#ifndef STRETCH_HISTOGRAM_PIXELS
+#define STRETCH_HISTOGRAM_PIXELS			(256 * 256)
+#endif
+const unsigned int
+	JP2_Reader::STRETCH_SAMPLE_PIXELS = STRETCH_HISTOGRAM_PIXELS;
+
+#ifndef THREAD_WORK_CODE_BLOCKS
+#define THREAD_WORK_CODE_BLOCKS				16
+#endif
+const unsigned int
+	JP2_Reader::DEFAULT_THREAD_WORK_CODE_BLOCKS = THREAD_WORK_CODE_BLOCKS;
+
 #define BUFFER_SIZE_REDUCTION_DIFFERENTIAL	(1024 * 1024)
 
 #define MAX_ARRAY_ALLOCATION				((unsigned long long)((size_t)-1))
@@ -180,6 +267,75 @@ int
 	JP2_Reader::Default_Autoreconnect_Retries =
 		DEFAULT_AUTORECONNECT_RETRIES;
 
+/*	Pipelined data disposition.
+
+	Increments are disposed by the Thread in the order in which they
+	were queued.
+*/
+struct JP2_Reader::Disposition_Pipeline
+{
+struct Disposition
+	{
+	Rendering_Monitor::Status
+		Status;
+	std::string
+		Message;
+	Cube
+		Region,
+		Image_Region;
+	//	Increment data buffers; empty for the image data buffers.
+	std::vector<void*>
+		Data;
+	unsigned int
+		Line_Stride;
+
+	Disposition
+		(
+		Rendering_Monitor::Status	status,
+		const std::string&			message,
+		const Cube&					region,
+		const Cube&					image_region
+		)
+		:	Status (status),
+			Message (message),
+			Region (region),
+			Image_Region (image_region),
+			Line_Stride (0)
+		{}
+	};
+
+std::thread
+	Thread;
+std::mutex
+	Lock;
+//	Signals that increments have been queued or the Thread is to stop.
+std::condition_variable
+	Ready;
+//	Signals that an increment has been disposed.
+std::condition_variable
+	Done;
+std::deque<Disposition>
+	Queue;
+//	Increments queued or being disposed.
+unsigned int
+	Pending;
+bool
+	Stop;
+//	Set when the rendering monitor cancels the rendering.
+std::atomic<bool>
+	Canceled;
+//	The first exception thrown while disposing an increment.
+std::exception_ptr
+	Failure;
+
+Disposition_Pipeline ()
+	:	Pending (0),
+		Stop (false),
+		Canceled (false)
+	{}
+};
+
+
 /*==============================================================================
 	Constructors
 */
@@ -198,14 +354,50 @@ JP2_Reader::JP2_Reader ()
 	Rendered_Region (),
 	Swap_Pixel_Bytes (false),
 	Rendered_Bits (0),
+	Rendered_Quality_Layers (0),
+	Progressive_Levels (0),
+	Float_Samples (false),
+	Calibration_Scale (),
+	Calibration_Offset (),
+	Stretches (),
+	Stretch_Tables (),
 	Rendering_Increment_Lines (0),
 	Thread_Count (THREAD_COUNT),
+	Processing_CPUs (),
+	Adaptive_Increment (false),
+	Low_Latency (false),
+	Adaptive_Threads (false),
+	Thread_Work_Code_Blocks (DEFAULT_THREAD_WORK_CODE_BLOCKS),
+	Effective_Threads (0),
+	Threads_Reason (),
+	Rendering_Strips (1),
 	JPIP_Request_Timeout (Default_JPIP_Request_Timeout),
 	JPIP_Proxy (Default_JPIP_Proxy),
 	JPIP_Cache_Directory (Default_JPIP_Cache_Directory),
 	Monitor (NULL),
+	Sink (NULL),
+	Tile_Cache (NULL),
+	Buffer_Allocator (NULL),
+	Local_Buffer_Bytes (0),
+	Pad_Image_Lines (false),
+	Separate_Band_Buffers (false),
+	Chunk_Lines (0),
+	Chunk_Buffers (),
+	Chunk_Data (),
+	Allocated_Chunk_Lines (0),
 	Autoreconnect_Retries (Default_Autoreconnect_Retries),
-	Bytes_Rendered (0)
+	Bytes_Rendered (0),
+	Rendering_Statistics (),
+	Last_Rendering_Statistics (),
+	Statistics_Lock (),
+	Render_Start_Time (0),
+	Render_Start_CPU_Time (0),
+	Increment_Start_Time (0),
+	Increment_Start_CPU_Time (0),
+	Async_Rendering (false),
+	Rendering_Canceled (false),
+	Pipelined_Disposition (false),
+	Pipeline ()
 {
 #if (DEBUG & DEBUG_CONSTRUCTORS)
 clog << ">-< JP2_Reader @ " << (void*)this << endl;
@@ -215,9 +407,10 @@ clog << ">-< JP2_Reader @ " << (void*)this << endl;
 
 JP2_Reader::JP2_Reader
 	(
-	const JP2_Reader&	JP2_reader
+	const JP2_Reader&	JP2_reader,
+	bool				share_metadata
 	)
-	:	JP2_Metadata (JP2_reader),
+	:	JP2_Metadata (JP2_reader, share_metadata),
 	Rendering_Configuration_Initialized (false),
 	Image_Data (NULL),
 	Buffer_Size (0),
@@ -231,14 +424,50 @@ JP2_Reader::JP2_Reader
 	Rendered_Region (),
 	Swap_Pixel_Bytes (JP2_reader.Swap_Pixel_Bytes),
 	Rendered_Bits (JP2_reader.Rendered_Bits),
+	Rendered_Quality_Layers (JP2_reader.Rendered_Quality_Layers),
+	Progressive_Levels (JP2_reader.Progressive_Levels),
+	Float_Samples (JP2_reader.Float_Samples),
+	Calibration_Scale (JP2_reader.Calibration_Scale),
+	Calibration_Offset (JP2_reader.Calibration_Offset),
+	Stretches (JP2_reader.Stretches),
+	Stretch_Tables (),
 	Rendering_Increment_Lines (JP2_reader.Rendering_Increment_Lines),
 	Thread_Count (THREAD_COUNT),
+	Processing_CPUs (JP2_reader.Processing_CPUs),
+	Adaptive_Increment (JP2_reader.Adaptive_Increment),
+	Low_Latency (JP2_reader.Low_Latency),
+	Adaptive_Threads (JP2_reader.Adaptive_Threads),
+	Thread_Work_Code_Blocks (JP2_reader.Thread_Work_Code_Blocks),
+	Effective_Threads (0),
+	Threads_Reason (),
+	Rendering_Strips (JP2_reader.Rendering_Strips),
 	JPIP_Request_Timeout (JP2_reader.JPIP_Request_Timeout),
 	JPIP_Proxy (JP2_reader.JPIP_Proxy),
 	JPIP_Cache_Directory (JP2_reader.JPIP_Cache_Directory),
 	Monitor (NULL),
+	Sink (NULL),
+	Tile_Cache (JP2_reader.Tile_Cache),
+	Buffer_Allocator (JP2_reader.Buffer_Allocator),
+	Local_Buffer_Bytes (0),
+	Pad_Image_Lines (JP2_reader.Pad_Image_Lines),
+	Separate_Band_Buffers (JP2_reader.Separate_Band_Buffers),
+	Chunk_Lines (JP2_reader.Chunk_Lines),
+	Chunk_Buffers (),
+	Chunk_Data (),
+	Allocated_Chunk_Lines (0),
 	Autoreconnect_Retries (JP2_reader.Autoreconnect_Retries),
-	Bytes_Rendered (0)
+	Bytes_Rendered (0),
+	Rendering_Statistics (),
+	Last_Rendering_Statistics (),
+	Statistics_Lock (),
+	Render_Start_Time (0),
+	Render_Start_CPU_Time (0),
+	Increment_Start_Time (0),
+	Increment_Start_CPU_Time (0),
+	Async_Rendering (false),
+	Rendering_Canceled (false),
+	Pipelined_Disposition (false),
+	Pipeline ()
 {
 #if (DEBUG & DEBUG_CONSTRUCTORS)
 clog << ">-< JP2_Reader @ " << (void*)this << endl
@@ -254,6 +483,7 @@ JP2_Reader::~JP2_Reader ()
 #if (DEBUG & DEBUG_CONSTRUCTORS)
 clog << ">>> ~JP2_Reader @ " << (void*)this << endl;
 #endif
+stop_data_disposition ();
 JP2_Reader::reset ();	//	Release any local resources.
 #if (DEBUG & DEBUG_CONSTRUCTORS)
 clog << "<<< ~JP2_Reader" << endl;
@@ -364,10 +594,7 @@ if (band  >= Rendered_Region.Depth ||
 	throw JP2_Invalid_Argument (message.str (), ID);
 	}
 
-return
-	(unsigned char*)(Image_Data[band])
-		+ (((line * line_stride ()) + pixel_stride ())
-			* rendered_pixel_bytes ());
+return band_data (band, line, pixel);
 }
 
 
@@ -486,9 +713,11 @@ if (bands)
 	{
 	switch (Data_Format)
 		{
-		case FORMAT_BSQ: return Rendered_Region.Width;
-		case FORMAT_BIP: return Rendered_Region.Width * bands;
-		case FORMAT_BIL: return Rendered_Region.Width * bands;
+		case FORMAT_BSQ: return padded_line_samples (Rendered_Region.Width);
+		case FORMAT_BIP:
+			return padded_line_samples (Rendered_Region.Width * bands);
+		case FORMAT_BIL:
+			return padded_line_samples (Rendered_Region.Width) * bands;
 		default: break;
 		}
 	}
@@ -496,6 +725,126 @@ return 0;
 }
 
 
+JP2_Reader&
+JP2_Reader::image_buffer_allocator
+	(
+	Image_Buffer_Allocator*	allocator
+	)
+{
+if (allocator != Buffer_Allocator)
+	{
+	//	The local buffer must be released by the allocator that provided it.
+	delete_local_data_buffer ();
+	Buffer_Allocator = allocator;
+	}
+return *this;
+}
+
+
+JP2_Reader::Image_Buffer_Allocator*
+JP2_Reader::image_buffer_allocator () const
+{
+if (Buffer_Allocator)
+	return Buffer_Allocator;
+
+//	Never deleted; buffers may be released during static destruction.
+static Aligned_Buffer_Allocator
+	*default_allocator = new Aligned_Buffer_Allocator;
+return default_allocator;
+}
+
+
+JP2_Reader&
+JP2_Reader::pad_image_lines
+	(
+	bool	enable
+	)
+{
+if (enable != Pad_Image_Lines)
+	{
+	//	The buffer layout changes.
+	delete_local_data_buffer ();
+	Pad_Image_Lines = enable;
+	}
+return *this;
+}
+
+
+JP2_Reader&
+JP2_Reader::separate_band_buffers
+	(
+	bool	enable
+	)
+{
+if (enable != Separate_Band_Buffers)
+	{
+	//	The buffer layout changes.
+	delete_local_data_buffer ();
+	Separate_Band_Buffers = enable;
+	}
+return *this;
+}
+
+
+JP2_Reader&
+JP2_Reader::image_data_chunk_lines
+	(
+	unsigned int	lines
+	)
+{
+if (lines != Chunk_Lines)
+	{
+	//	The buffer layout changes.
+	delete_local_data_buffer ();
+	Chunk_Lines = lines;
+	}
+return *this;
+}
+
+
+bool
+JP2_Reader::chunked_image_data () const
+{
+return
+	! User_Buffer &&
+	(Separate_Band_Buffers || Chunk_Lines) &&
+	(Data_Format == FORMAT_BSQ ||
+	 Data_Format == FORMAT_BIP ||
+	 Data_Format == FORMAT_BIL);
+}
+
+
+unsigned int
+JP2_Reader::effective_chunk_lines () const
+{
+if (! Chunk_Lines ||
+	Chunk_Lines > Rendered_Region.Height)
+	return Rendered_Region.Height;
+return Chunk_Lines;
+}
+
+
+void**
+JP2_Reader::image_data_chunk
+	(
+	unsigned int	chunk
+	)
+{
+if (chunk < Chunk_Data.size ())
+	return &Chunk_Data[chunk][0];
+return NULL;
+}
+
+
+JP2_Reader::Render_Statistics
+JP2_Reader::last_render_statistics () const
+{
+std::lock_guard<std::mutex>
+	lock (Statistics_Lock);
+return Last_Rendering_Statistics;
+}
+
+
 bool
 JP2_Reader::render_band
 	(
@@ -627,770 +976,3615 @@ return *this;
 }
 
 
+JP2_Reader&
+JP2_Reader::rendered_quality_layers
+	(
+	unsigned int	layers
+	)
+{
+if (layers &&
+	quality_layers () &&
+	layers > quality_layers ())
+	{
+	ostringstream
+		message;
+	message << "The maximum number of quality layers is "
+				<< quality_layers () << ", but " << layers
+				<< " was requested.";
+	throw JP2_Invalid_Argument (message.str (), ID);
+	}
+Rendered_Quality_Layers = layers;
+return *this;
+}
+
+
 unsigned int
 JP2_Reader::rendered_pixel_bytes () const
-{return bytes_of_bits (Rendered_Bits);}
+{return stretching () ? 1 : decoded_pixel_bytes ();}
 
 
-unsigned long long
-JP2_Reader::rendered_image_bytes () const
-{return (unsigned long long)
-	Rendered_Region.area () * image_bands () * rendered_pixel_bytes ();}
+unsigned int
+JP2_Reader::decoded_pixel_bytes () const
+{return (Float_Samples && ! stretching ()) ?
+	sizeof (float) : bytes_of_bits (Rendered_Bits);}
 
 
-unsigned int
-JP2_Reader::effective_rendering_increment_lines () const
+JP2_Reader&
+JP2_Reader::calibration
+	(
+	unsigned int	band,
+	float			scale,
+	float			offset
+	)
 {
-#if ((DEBUG) & DEBUG_RENDER)
-clog << ">>> JP2_Reader::effective_rendering_increment_lines" << endl;
+#if ((DEBUG) & DEBUG_ACCESSORS)
+clog << ">>> JP2_Reader::calibration: " << ((band == ALL_BANDS) ? -1 : band)
+		<< " scale " << scale << ", offset " << offset << endl;
 #endif
 unsigned int
-	bands = image_bands (),
-	increment_lines = 0;
-if (bands &&
-	Rendered_Region.Width)
+	bands = image_bands ();
+if (band != ALL_BANDS &&
+	band >= bands)
 	{
-	increment_lines = Rendering_Increment_Lines;
-	#if ((DEBUG) & DEBUG_RENDER)
-	clog << "    suggested increment: " << increment_lines << endl;
-	#endif
-	if (! increment_lines)
-		{
-		//	Default incremental rendering.
-		unsigned int
-			increment_pixels =
-				DEFAULT_RENDERING_INCREMENT_BYTES
-				/ bands / rendered_pixel_bytes ();
-		increment_lines = increment_pixels / Rendered_Region.Width;
-		if (increment_pixels % Rendered_Region.Width)
-			++increment_lines;
-		#if ((DEBUG) & DEBUG_RENDER)
-		clog
-			<< "    Using " << DEFAULT_RENDERING_INCREMENT_BYTES
-				<< " default increment bytes -" << endl
-			<< "                   bands: " << bands << endl
-			<< "            region width: " << Rendered_Region.Width << endl
-			<< "    rendered_pixel_bytes: " << rendered_pixel_bytes () << endl
-			<< "        increment_pixels: " << increment_pixels << endl
-			<< "         increment_lines: " << increment_lines << endl;
-		#endif
-		}
-
-	if (! increment_lines)
-		increment_lines = 1;
-	else
-	if (increment_lines > Rendered_Region.Height)
-		{
-		//	Maximum effective rendering increment.
-		increment_lines = Rendered_Region.Height;
-		#if ((DEBUG) & DEBUG_RENDER)
-		clog << "           region height: " << Rendered_Region.Height << endl;
-		#endif
-		}
+	ostringstream
+		message;
+	message << "Can't set the calibration of band " << band
+				<< " of an image with " << bands << " band"
+				<< ((bands == 1) ? "" : "s") << '.';
+	throw JP2_Invalid_Argument (message.str (), ID);
 	}
-#if ((DEBUG) & DEBUG_RENDER)
-clog << "<<< JP2_Reader::effective_rendering_increment_lines: "
-		<< increment_lines << endl;
-#endif
-return increment_lines;
+if (Calibration_Scale.size () < bands)
+	{
+	Calibration_Scale.resize (bands, 1.0f);
+	Calibration_Offset.resize (bands, 0.0f);
+	}
+if (band == ALL_BANDS)
+	{
+	Calibration_Scale.assign (bands, scale);
+	Calibration_Offset.assign (bands, offset);
+	}
+else
+	{
+	Calibration_Scale[band]  = scale;
+	Calibration_Offset[band] = offset;
+	}
+return *this;
 }
 
 
-JP2_Reader&
-JP2_Reader::processing_threads
+float
+JP2_Reader::calibration_scale
 	(
-	unsigned int	threads
+	unsigned int	band
 	)
+	const
 {
-if (! (Thread_Count = threads))
-	Thread_Count = processing_units ();
-return *this;
+if (band < Calibration_Scale.size ())
+	return Calibration_Scale[band];
+return 1.0f;
 }
 
-/*==============================================================================
-	Render
-*/
-bool
-JP2_Reader::ready
+
+float
+JP2_Reader::calibration_offset
 	(
-	string*	report
+	unsigned int	band
 	)
 	const
 {
-bool
-	is_ready = true;
-ostringstream
-	reason;
-if (report)
-	reason
-		<< "Not ready to render the " << source_name () << " source" << endl
-		<< "because:";
-if (! is_open ())
+if (band < Calibration_Offset.size ())
+	return Calibration_Offset[band];
+return 0.0f;
+}
+
+#ifndef DOXYGEN_PROCESSING
+namespace
+{
+void
+check_stretch_band
+	(
+	unsigned int	band,
+	unsigned int	bands
+	)
+{
+if (band != JP2_Reader::ALL_BANDS &&
+	band >= bands)
 	{
-	if (report)
-		reason << endl
-			<< "No source has been opened.";
-	is_ready = false;
+	ostringstream
+		message;
+	message << "Can't set the stretch of band " << band
+				<< " of an image with " << bands << " band"
+				<< ((bands == 1) ? "" : "s") << '.';
+	throw JP2_Invalid_Argument (message.str (), JP2_Reader::ID);
 	}
-else
-	{
-	unsigned long long
-		size = minimum_buffer_size (),
-		maximum;
+}
 
-	if (user_buffer () &&
-		Buffer_Size &&
-		Buffer_Size < size)
-		{
-		//	Undersized user specified pixel buffer.
-		if (report)
-			{
-			reason
-				<< endl
-				<< "A" << ((Buffer_Size == 8 || Buffer_Size == 18) ? "n " : " ")
-					<< magnitude (Buffer_Size);
-			if (Buffer_Size >= 1024)
-				reason << " (" << Buffer_Size << ')';
-			reason
-					<< " byte image data buffer size is specified," << endl
-				<< "but a " << magnitude (size)
-					<< " (" << size << ") byte size is required to render the "
-					<< Rendered_Region.Width << " wide, "
-					<< Rendered_Region.Height << " high region" << endl
-				<< "with a pixel stride of " << pixel_stride ()
-					<< " and a line stride of " << line_stride () << '.';
-			}
-		is_ready = false;
-		}
+
+/*	Stretch tables are padded beyond their last entry so the four byte
+	table gathers of the vector stretch kernels stay within the table.
+*/
+const unsigned int
+	STRETCH_TABLE_PADDING		= 3;
+
+
+/*	Assemble a linear stretch table.
+
+	Sample values from low to high are mapped to 0 to 255.
+*/
+void
+linear_table
+	(
+	std::vector<unsigned char>&	table,
+	unsigned int				entries,
+	double						low,
+	double						high
+	)
+{
+table.resize (entries);
+double
+	range = high - low;
+for (unsigned int
+		value = 0;
+		value < entries;
+		value++)
+	{
+	if (value <= low)
+		table[value] = 0;
 	else
-	if (! user_buffer () &&
-		(size *= rendered_bands ()) > (maximum = MAX_ARRAY_ALLOCATION))
-		{
-		//	Can't allocate a buffer for the rendered image region.
-		if (report)
-			reason << endl
-				<< "The required " << magnitude (size) << " (" << size
-					<< ") byte image data buffer size" << endl
-				<< "for the "
-					<< Rendered_Region.Width << " wide, "
-					<< Rendered_Region.Height << " high, "
-					<< rendered_bands () << " band image region" << endl
-				<< "is greater than the maximum " << magnitude (maximum)
-					<< " (" << maximum << ") byte allocation.";
-		is_ready = false;
-		}
+	if (value >= high)
+		table[value] = 255;
+	else
+		table[value] = (unsigned char)((value - low) * 255.0 / range + 0.5);
 	}
-
-if (! is_ready &&
-	report)
-	*report += reason.str ();
-return is_ready;
 }
 
 
+/*	Find the sample value at a histogram percentile.
+*/
 unsigned int
-JP2_Reader::default_JPIP_request_timeout
+percentile_value
 	(
-	unsigned int	timeout
+	const std::vector<unsigned long long>&	histogram,
+	double									percentile
 	)
 {
+unsigned long long
+	total = 0;
+for (unsigned int
+		value = 0;
+		value < histogram.size ();
+		value++)
+	total += histogram[value];
+if (! total)
+	return 0;
+
+unsigned long long
+	count = 0,
+	target = (unsigned long long)(total * percentile / 100.0);
 unsigned int
-	previous = Default_JPIP_Request_Timeout;
-Default_JPIP_Request_Timeout = timeout;
-return previous;
+	value = 0;
+while (value < histogram.size () - 1 &&
+		(count += histogram[value]) <= target)
+	++value;
+return value;
 }
+}	//	local namespace
+#endif	//	DOXYGEN_PROCESSING
 
 
-int
-JP2_Reader::default_autoreconnect_retries
+JP2_Reader&
+JP2_Reader::stretch_table
 	(
-	int		retries
+	unsigned int						band,
+	const std::vector<unsigned char>&	table
 	)
 {
-int
-	previous = Default_Autoreconnect_Retries;
-Default_Autoreconnect_Retries = retries;
-return previous;
+unsigned int
+	bands = image_bands ();
+check_stretch_band (band, bands);
+if (Stretches.size () < bands)
+	{
+	Band_Stretch
+		none;
+	none.Method = STRETCH_NONE;
+	none.Low = none.High = 0;
+	Stretches.resize (bands, none);
+	}
+for (unsigned int
+		index = (band == ALL_BANDS) ? 0 : band;
+		index < bands;
+		index++)
+	{
+	Stretches[index].Method = table.empty () ? STRETCH_NONE : STRETCH_TABLE;
+	Stretches[index].Table  = table;
+	if (band != ALL_BANDS)
+		break;
+	}
+return *this;
 }
 
 
-bool
-JP2_Reader::reconnect ()
-{return is_open ();}
-
-
-void
-JP2_Reader::reset ()
+JP2_Reader&
+JP2_Reader::linear_stretch
+	(
+	unsigned int	band,
+	unsigned int	low,
+	unsigned int	high
+	)
 {
-#if ((DEBUG) & (DEBUG_OPEN | DEBUG_CONSTRUCTORS))
-clog << ">>> JP2_Reader::reset" << endl;
-#endif
-//	Reset rendering specifications.
-Cube
-	empty;
-Rendered_Bands.clear ();
-Image_Region			=
-Rendered_Region			= empty;
-Resolution_Level		= 0;
-Swap_Pixel_Bytes		= false;
-Rendered_Bits			= 0;
-Rendering_Increment_Lines = 0;
-Bytes_Rendered			= 0;
-Monitor					= NULL;
-
-//	Delete locally managed image data buffers.
-delete_local_data_buffer ();
-if (Image_Data)
+if (high <= low)
 	{
-	delete[] Image_Data;
-	Image_Data			= NULL;
+	ostringstream
+		message;
+	message << "Invalid linear stretch from " << low << " to " << high << '.';
+	throw JP2_Invalid_Argument (message.str (), ID);
 	}
-Buffer_Size				= 0;
-User_Buffer				= false;
-Pixel_Stride			=
-Line_Stride				= 0;
-
-Data_Format				= Default_Image_Data_Format;
-
-/*	THREAD_COUNT
-	A preprocessor macro defined as processing_units() unless
-	defined as a non-negative value at compile time.
-*/
-Thread_Count			= THREAD_COUNT;
-JPIP_Proxy				= Default_JPIP_Proxy;
-JPIP_Cache_Directory	= Default_JPIP_Cache_Directory;
-
-//	Reset the metadata.
-JP2_Metadata::reset ();
-
-Rendering_Configuration_Initialized = false;
-#if ((DEBUG) & (DEBUG_OPEN | DEBUG_CONSTRUCTORS))
-clog << "<<< JP2_Reader::reset" << endl;
-#endif
+std::vector<unsigned char>
+	none;
+stretch_table (band, none);
+for (unsigned int
+		index = (band == ALL_BANDS) ? 0 : band;
+		index < Stretches.size ();
+		index++)
+	{
+	Stretches[index].Method = STRETCH_LINEAR;
+	Stretches[index].Low    = low;
+	Stretches[index].High   = high;
+	if (band != ALL_BANDS)
+		break;
+	}
+return *this;
 }
 
-/*==============================================================================
-	Helpers
-*/
-unsigned long long
-JP2_Reader::minimum_buffer_size () const
+
+JP2_Reader&
+JP2_Reader::percentile_stretch
+	(
+	unsigned int	band,
+	double			low_percentile,
+	double			high_percentile
+	)
 {
-return (unsigned long long)
-	rendered_pixel_bytes () *
-	pixel_stride () *
-	line_stride () *
-	Rendered_Region.height ();
+if (low_percentile < 0.0 ||
+	high_percentile > 100.0 ||
+	high_percentile <= low_percentile)
+	{
+	ostringstream
+		message;
+	message << "Invalid percentile stretch from " << low_percentile
+				<< "% to " << high_percentile << "%.";
+	throw JP2_Invalid_Argument (message.str (), ID);
+	}
+std::vector<unsigned char>
+	none;
+stretch_table (band, none);
+for (unsigned int
+		index = (band == ALL_BANDS) ? 0 : band;
+		index < Stretches.size ();
+		index++)
+	{
+	Stretches[index].Method = STRETCH_PERCENTILE;
+	Stretches[index].Low    = low_percentile;
+	Stretches[index].High   = high_percentile;
+	if (band != ALL_BANDS)
+		break;
+	}
+return *this;
 }
 
 
-bool
-JP2_Reader::allocate_data_buffers_array ()
+JP2_Reader&
+JP2_Reader::clear_stretch ()
 {
-if (Image_Data)
-	return true;
+Stretches.clear ();
+Stretch_Tables.clear ();
+return *this;
+}
 
-/*	Hidden local data buffer pointer.
 
-	An additional entry is provided for the pointer to a locally managed
-	image data buffer.
-*/
-unsigned int
-	bands = image_bands ();
-if (bands)
-	{
-	Image_Data = new void*[bands + 1];
-	for (unsigned int
-			band = 0;
-			band <= bands;
-			band++)
-		Image_Data[band] = NULL;
-	return true;
-	}
-return false;
+JP2_Reader::Stretch_Method
+JP2_Reader::stretch_method
+	(
+	unsigned int	band
+	)
+	const
+{
+if (band < Stretches.size ())
+	return Stretches[band].Method;
+return STRETCH_NONE;
 }
 
 
-void
-JP2_Reader::delete_local_data_buffer ()
+bool
+JP2_Reader::stretching () const
 {
-unsigned int
-	bands = image_bands ();
-if (! Image_Data ||
-	! Image_Data[bands])
-	return;
-
-#if ((DEBUG) & DEBUG_MANIPULATORS)
-clog << ">-< JP2_Reader::delete_local_data_buffer:" << endl
-	 << "      Deleting the local image data buffer @ "
-		<< Image_Data[bands] << endl;
-#endif
-delete[] reinterpret_cast<unsigned long long*>(Image_Data[bands]);
-Buffer_Size = 0;
 for (unsigned int
 		band = 0;
-		band <= bands;
+		band < Stretches.size ();
 		band++)
-	Image_Data[band] = NULL;
+	if (Stretches[band].Method != STRETCH_NONE)
+		return true;
+return false;
 }
 
 
-void
-JP2_Reader::allocate_image_data_buffer ()
+unsigned long long
+JP2_Reader::rendered_image_bytes () const
+{return (unsigned long long)
+	Rendered_Region.area () * image_bands () * rendered_pixel_bytes ();}
+
+
+unsigned int
+JP2_Reader::effective_rendering_increment_lines () const
 {
-#if ((DEBUG) & (DEBUG_MANIPULATORS | DEBUG_RENDER))
-clog << ">>> JP2_Reader::allocate_image_data_buffer" << endl;
+#if ((DEBUG) & DEBUG_RENDER)
+clog << ">>> JP2_Reader::effective_rendering_increment_lines" << endl;
 #endif
-if (! user_buffer ())
+unsigned int
+	bands = image_bands (),
+	increment_lines = 0;
+if (bands &&
+	Rendered_Region.Width)
 	{
-	unsigned long long
-		minimum = minimum_buffer_size () * rendered_bands ();
-	if (! minimum)
+	increment_lines = Rendering_Increment_Lines;
+	#if ((DEBUG) & DEBUG_RENDER)
+	clog << "    suggested increment: " << increment_lines << endl;
+	#endif
+	if (Adaptive_Increment)
 		{
-		#if ((DEBUG) & (DEBUG_MANIPULATORS | DEBUG_RENDER))
-		clog << "    Zero buffer size." << endl
-			 << "<<< JP2_Reader::allocate_image_data_buffer" << endl;
+		//	Cache sized increment of whole code-block rows.
+		unsigned int
+			threads = Effective_Threads ? Effective_Threads :
+				(Thread_Count ? Thread_Count : 1),
+			alignment = increment_alignment_lines ();
+		unsigned long long
+			line_bytes = (unsigned long long)Rendered_Region.Width
+				* bands * rendered_pixel_bytes (),
+			lines = (processing_cache_bytes () * threads) / line_bytes;
+		lines = ((lines + alignment - 1) / alignment) * alignment;
+		if (! lines)
+			lines = alignment;
+		increment_lines = (lines > Rendered_Region.Height) ?
+			Rendered_Region.Height : (unsigned int)lines;
+		#if ((DEBUG) & DEBUG_RENDER)
+		clog
+			<< "    Adaptive increment -" << endl
+			<< "             cache bytes: " << processing_cache_bytes () << endl
+			<< "                 threads: " << threads << endl
+			<< "              line bytes: " << line_bytes << endl
+			<< "               alignment: " << alignment << endl
+			<< "         increment_lines: " << increment_lines << endl;
 		#endif
-		return;
 		}
-
-	//	Convert to unsigned long long array size.
-	minimum = (minimum / sizeof (long long))
-				+ ((minimum % sizeof (long long) ? 1 : 0));
-	if (minimum > MAX_ARRAY_ALLOCATION)
+	else
+	if (! increment_lines)
 		{
-		ostringstream
-			message;
-		message << "The required image data buffer size - "
-					<< magnitude (minimum) << " (" << minimum << ") "
-					<< (sizeof (long long) << 3) << "-bit words" << endl
-				<< "is greater than the maximum size - "
-					<< magnitude (MAX_ARRAY_ALLOCATION)
-					<< " (" << MAX_ARRAY_ALLOCATION << ")." << endl;
+		//	Default incremental rendering.
+		unsigned int
+			increment_pixels =
+				DEFAULT_RENDERING_INCREMENT_BYTES
+				/ bands / rendered_pixel_bytes ();
+		increment_lines = increment_pixels / Rendered_Region.Width;
+		if (increment_pixels % Rendered_Region.Width)
+			++increment_lines;
+		#if ((DEBUG) & DEBUG_RENDER)
+		clog
+			<< "    Using " << DEFAULT_RENDERING_INCREMENT_BYTES
+				<< " default increment bytes -" << endl
+			<< "                   bands: " << bands << endl
+			<< "            region width: " << Rendered_Region.Width << endl
+			<< "    rendered_pixel_bytes: " << rendered_pixel_bytes () << endl
+			<< "        increment_pixels: " << increment_pixels << endl
+			<< "         increment_lines: " << increment_lines << endl;
+		#endif
+		}
+
+	if (! increment_lines)
+		increment_lines = 1;
+	else
+	if (increment_lines > Rendered_Region.Height)
+		{
+		//	Maximum effective rendering increment.
+		increment_lines = Rendered_Region.Height;
+		#if ((DEBUG) & DEBUG_RENDER)
+		clog << "           region height: " << Rendered_Region.Height << endl;
+		#endif
+		}
+	}
+#if ((DEBUG) & DEBUG_RENDER)
+clog << "<<< JP2_Reader::effective_rendering_increment_lines: "
+		<< increment_lines << endl;
+#endif
+return increment_lines;
+}
+
+
+JP2_Reader&
+JP2_Reader::adaptive_rendering_increment
+	(
+	bool	enable
+	)
+{
+Adaptive_Increment = enable;
+return *this;
+}
+
+
+JP2_Reader&
+JP2_Reader::low_latency_rendering
+	(
+	bool	enable
+	)
+{
+Low_Latency = enable;
+return *this;
+}
+
+
+unsigned int
+JP2_Reader::first_rendering_increment_lines () const
+{
+unsigned int
+	increment_lines = effective_rendering_increment_lines ();
+if (Low_Latency)
+	{
+	unsigned int
+		alignment = increment_alignment_lines ();
+	if (alignment < increment_lines)
+		increment_lines = alignment;
+	}
+return increment_lines;
+}
+
+
+unsigned int
+JP2_Reader::increment_alignment_lines () const
+{
+unsigned int
+	discarded = (Resolution_Level > 1) ? (Resolution_Level - 1) : 0,
+	resolutions = resolution_levels ();
+Size_2D
+	block (code_block_size ()),
+	precinct (precinct_size ((resolutions > Resolution_Level) ?
+		(resolutions - Resolution_Level) : 0));
+unsigned int
+	lines = block.Height ? block.Height : 64;
+if (lines > precinct.Height)
+	lines = precinct.Height;
+if (discarded < resolutions)
+	//	High frequency subband rows cover two lines each.
+	lines <<= 1;
+
+Size_2D
+	tile (tile_size ());
+if (tile.Height &&
+	discarded < 32)
+	{
+	unsigned int
+		tile_lines = tile.Height >> discarded;
+	if (tile_lines &&
+		tile_lines < lines)
+		lines = tile_lines;
+	}
+return lines ? lines : 1;
+}
+
+
+#ifndef DOXYGEN_PROCESSING
+namespace
+{
+//	The host processor cache size, or the default if it can't be determined.
+unsigned long long
+host_cache_bytes ()
+{
+#if defined (_SC_LEVEL2_CACHE_SIZE)
+long
+	bytes = sysconf (_SC_LEVEL2_CACHE_SIZE);
+if (bytes > 0)
+	return bytes;
+#endif
+return JP2_Reader::DEFAULT_CACHE_BYTES;
+}
+}	//	namespace
+#endif	//	DOXYGEN_PROCESSING
+
+
+unsigned long long
+JP2_Reader::processing_cache_bytes ()
+{
+//	Thread safe one-time initialization.
+static const unsigned long long
+	cache_bytes = host_cache_bytes ();
+return cache_bytes;
+}
+
+
+JP2_Reader&
+JP2_Reader::processing_threads
+	(
+	unsigned int	threads
+	)
+{
+if (! (Thread_Count = threads))
+	Thread_Count = processing_units ();
+return *this;
+}
+
+
+void
+JP2_Reader::release_processing_threads ()
+{}
+
+
+JP2_Reader&
+JP2_Reader::processing_CPUs
+	(
+	const std::vector<unsigned int>&	CPUs
+	)
+{
+Processing_CPUs = CPUs;
+return *this;
+}
+
+
+JP2_Reader&
+JP2_Reader::processing_node
+	(
+	unsigned int	node
+	)
+{
+ostringstream
+	pathname;
+pathname << "/sys/devices/system/node/node" << node << "/cpulist";
+ifstream
+	file (pathname.str ().c_str ());
+string
+	list;
+if (! file ||
+	! std::getline (file, list))
+	{
+	ostringstream
+		message;
+	message
+		<< "Unable to determine the processors of NUMA node " << node
+			<< '.' << endl
+		<< "Couldn't read " << pathname.str ();
+	throw JP2_Invalid_Argument (message.str (), ID);
+	}
+
+//	The list is comma separated processor numbers or ranges; e.g. 0-7,16-23
+std::vector<unsigned int>
+	CPUs;
+std::istringstream
+	entries (list);
+string
+	entry;
+while (std::getline (entries, entry, ','))
+	{
+	unsigned int
+		first,
+		last;
+	char
+		dash;
+	std::istringstream
+		range (entry);
+	if (! (range >> first))
+		continue;
+	last = first;
+	if (range >> dash >> last &&
+		dash != '-')
+		last = first;
+	while (first <= last)
+		CPUs.push_back (first++);
+	}
+if (CPUs.empty ())
+	{
+	ostringstream
+		message;
+	message
+		<< "NUMA node " << node << " has no processors.";
+	throw JP2_Invalid_Argument (message.str (), ID);
+	}
+Processing_CPUs = CPUs;
+return *this;
+}
+
+
+JP2_Reader&
+JP2_Reader::adaptive_processing_threads
+	(
+	bool	enable
+	)
+{
+Adaptive_Threads = enable;
+return *this;
+}
+
+
+JP2_Reader&
+JP2_Reader::thread_work_threshold
+	(
+	unsigned int	code_blocks
+	)
+{
+if (! (Thread_Work_Code_Blocks = code_blocks))
+	Thread_Work_Code_Blocks = DEFAULT_THREAD_WORK_CODE_BLOCKS;
+return *this;
+}
+
+
+unsigned int
+JP2_Reader::effective_rendering_strips () const
+{
+unsigned int
+	strips = 0;
+if (image_bands () &&
+	Rendered_Region.Height)
+	{
+	if (! (strips = Rendering_Strips))
+		strips = (Adaptive_Threads && Effective_Threads) ?
+			Effective_Threads : Thread_Count;
+	if (Thread_Count < 2)
+		//	No concurrency without processing threads.
+		strips = 1;
+	else
+	if (strips > Rendered_Region.Height)
+		strips = Rendered_Region.Height;
+	}
+#if ((DEBUG) & DEBUG_RENDER)
+clog << ">-< JP2_Reader::effective_rendering_strips: " << strips << endl;
+#endif
+return strips;
+}
+
+/*==============================================================================
+	Render
+*/
+bool
+JP2_Reader::ready
+	(
+	string*	report
+	)
+	const
+{
+bool
+	is_ready = true;
+ostringstream
+	reason;
+if (report)
+	reason
+		<< "Not ready to render the " << source_name () << " source" << endl
+		<< "because:";
+if (! is_open ())
+	{
+	if (report)
+		reason << endl
+			<< "No source has been opened.";
+	is_ready = false;
+	}
+else
+	{
+	unsigned long long
+		size = minimum_buffer_size (),
+		maximum;
+
+	//	Line sink rendering does not use the image data buffers.
+	if (! Sink &&
+		user_buffer () &&
+		Buffer_Size &&
+		Buffer_Size < size)
+		{
+		//	Undersized user specified pixel buffer.
+		if (report)
+			{
+			reason
+				<< endl
+				<< "A" << ((Buffer_Size == 8 || Buffer_Size == 18) ? "n " : " ")
+					<< magnitude (Buffer_Size);
+			if (Buffer_Size >= 1024)
+				reason << " (" << Buffer_Size << ')';
+			reason
+					<< " byte image data buffer size is specified," << endl
+				<< "but a " << magnitude (size)
+					<< " (" << size << ") byte size is required to render the "
+					<< Rendered_Region.Width << " wide, "
+					<< Rendered_Region.Height << " high region" << endl
+				<< "with a pixel stride of " << pixel_stride ()
+					<< " and a line stride of " << line_stride () << '.';
+			}
+		is_ready = false;
+		}
+	else
+	if (! Sink &&
+		chunked_image_data ())
+		{
+		//	Each chunk buffer is allocated separately.
+		if ((size = chunk_buffer_size ()) >
+				(maximum = MAX_ARRAY_ALLOCATION))
+			{
+			//	Can't allocate a buffer for an image data chunk.
+			if (report)
+				reason << endl
+					<< "The required " << magnitude (size) << " (" << size
+						<< ") byte image data chunk buffer size" << endl
+					<< "for the "
+						<< Rendered_Region.Width << " wide, "
+						<< effective_chunk_lines () << " line, "
+						<< rendered_bands () << " band image data chunks" << endl
+					<< "is greater than the maximum " << magnitude (maximum)
+						<< " (" << maximum << ") byte allocation.";
+			is_ready = false;
+			}
+		}
+	else
+	if (! Sink &&
+		! user_buffer () &&
+		(size *= rendered_bands ()) > (maximum = MAX_ARRAY_ALLOCATION))
+		{
+		//	Can't allocate a buffer for the rendered image region.
+		if (report)
+			reason << endl
+				<< "The required " << magnitude (size) << " (" << size
+					<< ") byte image data buffer size" << endl
+				<< "for the "
+					<< Rendered_Region.Width << " wide, "
+					<< Rendered_Region.Height << " high, "
+					<< rendered_bands () << " band image region" << endl
+				<< "is greater than the maximum " << magnitude (maximum)
+					<< " (" << maximum << ") byte allocation.";
+		is_ready = false;
+		}
+	}
+
+if (! is_ready &&
+	report)
+	*report += reason.str ();
+return is_ready;
+}
+
+
+unsigned int
+JP2_Reader::render
+	(
+	std::vector<Region_Request>&	requests
+	)
+{
+#if ((DEBUG) & (DEBUG_RENDER | DEBUG_LOCATION))
+clog << ">>> JP2_Reader::render: " << requests.size () << " region requests"
+		<< endl;
+#endif
+if (! is_open ())
+	{
+	ostringstream
+		message;
+	message
+		<< "Couldn't render " << requests.size () << " region requests" << endl
+		<< "because no source has been opened.";
+	throw JP2_Logic_Error (message.str (), ID);
+	}
+
+//	Save the rendering configuration.
+Cube
+	region (Image_Region);
+unsigned int
+	resolution = Resolution_Level,
+	bands = image_bands (),
+	pixel_gap = Pixel_Stride,
+	line_gap = Line_Stride;
+Band_Map
+	band_map (Rendered_Bands);
+bool
+	user_buffers = User_Buffer;
+unsigned long long
+	buffer_size = Buffer_Size;
+Image_Data_Format
+	data_format = Data_Format;
+std::vector<void*>
+	buffers;
+if (user_buffers &&
+	Image_Data)
+	buffers.assign (Image_Data, Image_Data + bands);
+
+Rendering_Monitor
+	*monitor = Monitor;
+Rendering_Monitor::Status
+	status = Rendering_Monitor::DONE;
+unsigned int
+	rendered = 0;
+std::exception_ptr
+	failure;
+try
+	{
+	//	Rendering notifications are for the batch, not each render.
+	Monitor = NULL;
+	for (unsigned int
+			index = 0;
+			index < requests.size ();
+			index++)
+		{
+		Region_Request&
+			request = requests[index];
+		request.Rendered_Region =
+		request.Image_Region = Cube ();
+		if (! request.Image_Data)
+			{
+			ostringstream
+				message;
+			message
+				<< "Region request " << index << " for image region "
+					<< request.Region << endl
+				<< "does not provide any pixel data buffers.";
+			throw JP2_Invalid_Argument (message.str (), ID);
+			}
+
+		//	Apply the request.
+		image_data (request.Image_Data, request.Buffer_Size);
+		for (unsigned int
+				band = 0;
+				band < request.Bands.size () &&
+				band < bands;
+				band++)
+			if (! request.Bands[band])
+				render_band (band, false);
+		Pixel_Stride = request.Pixel_Stride;
+		Line_Stride  = request.Line_Stride;
+		Data_Format  = (Pixel_Stride || Line_Stride) ?
+			FORMAT_AD_HOC : data_format;
+		resolution_and_region (request.Resolution_Level, request.Region);
+		#if ((DEBUG) & DEBUG_RENDER)
+		clog << "    request " << index << ": " << request.Region
+				<< " at resolution level " << Resolution_Level << endl;
+		#endif
+
+		request.Rendered_Region = render ();
+		if (request.Rendered_Region.Height != Rendered_Region.Height)
+			{
+			//	The render was canceled.
+			status = Rendering_Monitor::CANCELED;
+			break;
+			}
+		request.Image_Region = Image_Region;
+		++rendered;
+
+		if (monitor &&
+			! monitor->notify (*this, Rendering_Monitor::TOP_QUALITY_DATA,
+				Rendering_Monitor::Status_Message
+					[Rendering_Monitor::TOP_QUALITY_DATA],
+				request.Rendered_Region, request.Image_Region))
+			{
+			if (rendered < requests.size ())
+				status = Rendering_Monitor::CANCELED;
+			break;
+			}
+		}
+	}
+catch (...)
+	{failure = std::current_exception ();}
+
+//	Restore the rendering configuration.
+Monitor = monitor;
+if (user_buffers &&
+	! buffers.empty ())
+	image_data (&buffers[0], buffer_size);
+else
+	image_data ((void**)NULL, 0);
+Rendered_Bands = band_map;
+Rendered_Region.Depth = 0;
+for (unsigned int
+		band = 0;
+		band < Rendered_Bands.size ();
+		band++)
+	if (Rendered_Bands[band])
+		++Rendered_Region.Depth;
+Pixel_Stride = pixel_gap;
+Line_Stride  = line_gap;
+Data_Format  = data_format;
+resolution_and_region (resolution, region);
+Image_Region.Depth = Rendered_Region.Depth;
+
+if (failure)
+	std::rethrow_exception (failure);
+
+if (Monitor)
+	Monitor->notify (*this,
+		status, Rendering_Monitor::Status_Message[status]);
+#if ((DEBUG) & (DEBUG_RENDER | DEBUG_LOCATION))
+clog << "<<< JP2_Reader::render: " << rendered << " rendered" << endl;
+#endif
+return rendered;
+}
+
+
+/*------------------------------------------------------------------------------
+	Render to file
+*/
+#ifndef DOXYGEN_PROCESSING
+namespace
+{
+//	A file that is memory mapped for writing.
+class Mapped_File
+{
+public:
+
+Mapped_File ()
+	:	Address (NULL),
+		Size (0),
+	#ifdef _WIN32
+		File (INVALID_HANDLE_VALUE),
+		Mapping (NULL)
+	#else
+		File (-1)
+	#endif
+	{}
+
+~Mapped_File ()
+	{close ();}
+
+/*	Create, or truncate, the file, size it and map it.
+
+	Returns an empty string on success; otherwise a description of the
+	failure.
+*/
+std::string
+open
+	(
+	const std::string&	pathname,
+	unsigned long long	size
+	)
+{
+Size = size;
+if ((unsigned long long)((size_t)size) != size)
+	return "The file size exceeds the addressable memory size.";
+#ifdef _WIN32
+File = CreateFileA (pathname.c_str (), GENERIC_READ | GENERIC_WRITE, 0,
+	NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+if (File == INVALID_HANDLE_VALUE)
+	return "The file could not be created.";
+Mapping = CreateFileMappingA (File, NULL, PAGE_READWRITE,
+	(DWORD)(size >> 32), (DWORD)(size & 0xFFFFFFFF), NULL);
+if (! Mapping)
+	return "The file could not be sized for memory mapping.";
+Address = MapViewOfFile (Mapping, FILE_MAP_WRITE, 0, 0, (SIZE_T)size);
+if (! Address)
+	return "The file could not be memory mapped.";
+#else
+if ((File = ::open (pathname.c_str (), O_RDWR | O_CREAT | O_TRUNC, 0666))
+		< 0)
+	return std::string ("The file could not be created: ")
+		+ strerror (errno);
+if (ftruncate (File, (off_t)size) < 0)
+	return std::string ("The file could not be sized: ")
+		+ strerror (errno);
+void
+	*address = mmap (NULL, (size_t)size, PROT_READ | PROT_WRITE, MAP_SHARED,
+		File, 0);
+if (address == MAP_FAILED)
+	return std::string ("The file could not be memory mapped: ")
+		+ strerror (errno);
+Address = address;
+#endif
+return std::string ();
+}
+
+/*	Unmap and close the file.
+
+	Returns an empty string on success; otherwise a description of the
+	failure.
+*/
+std::string
+close ()
+{
+std::string
+	failure;
+#ifdef _WIN32
+if (Address &&
+	! UnmapViewOfFile (Address))
+	failure = "The file memory map could not be released.";
+if (Mapping)
+	CloseHandle (Mapping);
+if (File != INVALID_HANDLE_VALUE &&
+	! CloseHandle (File))
+	failure = "The file could not be closed.";
+Mapping = NULL;
+File = INVALID_HANDLE_VALUE;
+#else
+if (Address &&
+	munmap (Address, (size_t)Size) < 0)
+	failure = std::string ("The file memory map could not be released: ")
+		+ strerror (errno);
+if (File >= 0 &&
+	::close (File) < 0)
+	failure = std::string ("The file could not be closed: ")
+		+ strerror (errno);
+File = -1;
+#endif
+Address = NULL;
+return failure;
+}
+
+void
+	*Address;
+
+private:
+
+unsigned long long
+	Size;
+#ifdef _WIN32
+HANDLE
+	File,
+	Mapping;
+#else
+int
+	File;
+#endif
+};
+
+}	//	local namespace
+#endif
+
+
+Cube
+JP2_Reader::render_to_file
+	(
+	const std::string&	pathname,
+	Image_Data_Format	data_format
+	)
+{
+#if ((DEBUG) & (DEBUG_RENDER | DEBUG_LOCATION))
+clog << ">>> JP2_Reader::render_to_file: " << pathname << ' '
+		<< image_data_format_description (data_format) << endl;
+#endif
+if (data_format != FORMAT_BSQ &&
+	data_format != FORMAT_BIP &&
+	data_format != FORMAT_BIL)
+	{
+	ostringstream
+		message;
+	message
+		<< "Couldn't render to the " << pathname << " file" << endl
+		<< "using the " << image_data_format_description (data_format)
+			<< " image data format." << endl
+		<< "Only the BSQ, BIP and BIL formats may be rendered to a file.";
+	throw JP2_Invalid_Argument (message.str (), ID);
+	}
+if (! is_open ())
+	{
+	ostringstream
+		message;
+	message
+		<< "Couldn't render to the " << pathname << " file" << endl
+		<< "because no source has been opened.";
+	throw JP2_Logic_Error (message.str (), ID);
+	}
+
+unsigned int
+	total_bands = image_bands (),
+	bands = rendered_bands (),
+	pixel_bytes = rendered_pixel_bytes ();
+unsigned long long
+	band_size = (unsigned long long)Rendered_Region.area () * pixel_bytes,
+	file_size = band_size * bands;
+if (! file_size)
+	{
+	#if ((DEBUG) & (DEBUG_RENDER | DEBUG_LOCATION))
+	clog << "    Empty rendered area." << endl
+		 << "<<< JP2_Reader::render_to_file: (empty)" << endl;
+	#endif
+	return Cube ();
+	}
+
+Mapped_File
+	file;
+std::string
+	failure (file.open (pathname, file_size));
+if (! failure.empty ())
+	{
+	ostringstream
+		message;
+	message
+		<< "Couldn't render to the " << pathname << " file." << endl
+		<< failure << endl
+		<< "A " << magnitude (file_size) << " (" << file_size
+			<< ") byte file is required for the " << source_name ()
+			<< " source.";
+	throw JP2_IO_Failure (message.str (), ID);
+	}
+#if ((DEBUG) & (DEBUG_RENDER | DEBUG_LOCATION))
+clog << "    " << file_size << " byte file mapped @ " << file.Address << endl;
+#endif
+
+//	Image data buffers in the mapped file.
+std::vector<void*>
+	file_buffers (total_bands, (void*)NULL);
+unsigned char
+	*address = static_cast<unsigned char*>(file.Address);
+for (unsigned int
+		band = 0;
+		band < total_bands;
+		band++)
+	{
+	if (Rendered_Bands[band])
+		{
+		file_buffers[band] = address;
+		switch (data_format)
+			{
+			case FORMAT_BSQ:
+				address += band_size;
+				break;
+			case FORMAT_BIP:
+				address += pixel_bytes;
+				break;
+			case FORMAT_BIL:
+				address += Rendered_Region.Width * pixel_bytes;
+				break;
+			default: break;
+			}
+		}
+	}
+
+//	Save the image data configuration.
+bool
+	user_buffers = User_Buffer;
+unsigned long long
+	buffer_size = Buffer_Size;
+std::vector<void*>
+	buffers;
+if (user_buffers &&
+	Image_Data)
+	buffers.assign (Image_Data, Image_Data + total_bands);
+Band_Map
+	band_map (Rendered_Bands);
+unsigned int
+	pixel_gap = Pixel_Stride,
+	line_gap = Line_Stride;
+Image_Data_Format
+	format = Data_Format;
+//	The image data is rendered into the file, not to a line sink.
+Line_Sink
+	*sink = Sink;
+
+Cube
+	rendered;
+std::exception_ptr
+	render_failure;
+try
+	{
+	Sink = NULL;
+	image_data (&file_buffers[0], 0);
+	Pixel_Stride =
+	Line_Stride  = 0;
+	Data_Format  = data_format;
+	rendered = render ();
+	}
+catch (...)
+	{render_failure = std::current_exception ();}
+
+//	Restore the image data configuration.
+Sink = sink;
+if (user_buffers &&
+	! buffers.empty ())
+	image_data (&buffers[0], buffer_size);
+else
+	image_data ((void**)NULL, 0);
+Rendered_Bands = band_map;
+Rendered_Region.Depth = 0;
+for (unsigned int
+		band = 0;
+		band < Rendered_Bands.size ();
+		band++)
+	if (Rendered_Bands[band])
+		++Rendered_Region.Depth;
+Image_Region.Depth = Rendered_Region.Depth;
+Pixel_Stride = pixel_gap;
+Line_Stride  = line_gap;
+Data_Format  = format;
+
+failure = file.close ();
+if (render_failure)
+	std::rethrow_exception (render_failure);
+if (! failure.empty ())
+	{
+	ostringstream
+		message;
+	message
+		<< "Couldn't complete rendering to the " << pathname << " file." << endl
+		<< failure << endl
+		<< "for the " << source_name () << " source.";
+	throw JP2_IO_Failure (message.str (), ID);
+	}
+#if ((DEBUG) & (DEBUG_RENDER | DEBUG_LOCATION))
+clog << "<<< JP2_Reader::render_to_file: " << rendered << endl;
+#endif
+return rendered;
+}
+
+
+/*------------------------------------------------------------------------------
+	Rendering statistics
+*/
+JP2_Reader::Render_Statistics::Render_Statistics ()
+{clear ();}
+
+
+void
+JP2_Reader::Render_Statistics::clear ()
+{
+Open_Seconds			=
+Ingest_Seconds			=
+Render_Seconds			=
+Render_CPU_Seconds		=
+Decode_Seconds			=
+Decode_CPU_Seconds		=
+Max_Increment_Seconds	=
+Acquisition_Seconds		=
+Disposition_Seconds		= 0;
+Bytes_Rendered			= 0;
+Increments				=
+Acquisitions			=
+Threads					= 0;
+Peak_Buffer_Bytes		= 0;
+}
+
+
+double
+JP2_Reader::statistics_time ()
+{
+return std::chrono::duration<double>
+	(std::chrono::steady_clock::now ().time_since_epoch ()).count ();
+}
+
+
+double
+JP2_Reader::statistics_CPU_time ()
+{
+clock_t
+	cpu = clock ();
+if (cpu == clock_t (-1))
+	return 0;
+return double (cpu) / CLOCKS_PER_SEC;
+}
+
+
+void
+JP2_Reader::start_render_statistics
+	(
+	unsigned int	threads
+	)
+{
+double
+	open_seconds = Rendering_Statistics.Open_Seconds,
+	ingest_seconds = Rendering_Statistics.Ingest_Seconds;
+Rendering_Statistics.clear ();
+Rendering_Statistics.Open_Seconds = open_seconds;
+Rendering_Statistics.Ingest_Seconds = ingest_seconds;
+Rendering_Statistics.Threads = threads;
+Render_Start_Time =
+Increment_Start_Time = statistics_time ();
+Render_Start_CPU_Time =
+Increment_Start_CPU_Time = statistics_CPU_time ();
+}
+
+
+void
+JP2_Reader::finish_render_statistics ()
+{
+Rendering_Statistics.Render_Seconds =
+	statistics_time () - Render_Start_Time;
+Rendering_Statistics.Render_CPU_Seconds =
+	statistics_CPU_time () - Render_Start_CPU_Time;
+Rendering_Statistics.Bytes_Rendered = Bytes_Rendered;
+
+unsigned long long
+	buffer_bytes = Local_Buffer_Bytes;
+if (User_Buffer)
+	buffer_bytes = Buffer_Size * rendered_bands ();
+for (unsigned int
+		index = 0;
+		index < Chunk_Buffers.size ();
+		index++)
+	buffer_bytes += Chunk_Buffers[index].second;
+if (Rendering_Statistics.Peak_Buffer_Bytes < buffer_bytes)
+	Rendering_Statistics.Peak_Buffer_Bytes = buffer_bytes;
+#if ((DEBUG) & (DEBUG_RENDER | DEBUG_LOCATION))
+clog << ">-< JP2_Reader::finish_render_statistics: "
+		<< Rendering_Statistics.Increments << " increments, "
+		<< Rendering_Statistics.Bytes_Rendered << " bytes in "
+		<< Rendering_Statistics.Render_Seconds << " seconds" << endl;
+#endif
+
+std::lock_guard<std::mutex>
+	lock (Statistics_Lock);
+Last_Rendering_Statistics = Rendering_Statistics;
+}
+
+
+double
+JP2_Reader::increment_statistics ()
+{
+double
+	now = statistics_time (),
+	now_CPU = statistics_CPU_time (),
+	seconds = now - Increment_Start_Time;
+Rendering_Statistics.Decode_Seconds += seconds;
+Rendering_Statistics.Decode_CPU_Seconds += now_CPU - Increment_Start_CPU_Time;
+if (Rendering_Statistics.Max_Increment_Seconds < seconds)
+	Rendering_Statistics.Max_Increment_Seconds = seconds;
+++Rendering_Statistics.Increments;
+Increment_Start_Time = now;
+Increment_Start_CPU_Time = now_CPU;
+return now;
+}
+
+
+void
+JP2_Reader::acquisition_statistics
+	(
+	double	start
+	)
+{
+Increment_Start_Time = statistics_time ();
+Increment_Start_CPU_Time = statistics_CPU_time ();
+Rendering_Statistics.Acquisition_Seconds += Increment_Start_Time - start;
+++Rendering_Statistics.Acquisitions;
+}
+
+
+void
+JP2_Reader::disposition_statistics
+	(
+	double	start
+	)
+{
+Increment_Start_Time = statistics_time ();
+Increment_Start_CPU_Time = statistics_CPU_time ();
+Rendering_Statistics.Disposition_Seconds += Increment_Start_Time - start;
+}
+
+
+void
+JP2_Reader::open_statistics
+	(
+	double	open_seconds,
+	double	ingest_seconds
+	)
+{
+Rendering_Statistics.Open_Seconds = open_seconds;
+Rendering_Statistics.Ingest_Seconds = ingest_seconds;
+}
+
+/*------------------------------------------------------------------------------
+	Asynchronous rendering
+*/
+JP2_Reader::Rendering_Cancellation::Rendering_Cancellation ()
+	:	Cancellation_State (new State)
+{}
+
+
+void
+JP2_Reader::Rendering_Cancellation::cancel ()
+{
+std::lock_guard<std::mutex>
+	lock (Cancellation_State->Lock);
+Cancellation_State->Canceled = true;
+if (Cancellation_State->Reader)
+	Cancellation_State->Reader->cancel_rendering ();
+}
+
+
+bool
+JP2_Reader::Rendering_Cancellation::canceled () const
+{return Cancellation_State->Canceled;}
+
+
+std::future<Cube>
+JP2_Reader::render_async
+	(
+	Rendering_Cancellation*	cancellation
+	)
+{
+#if ((DEBUG) & (DEBUG_RENDER | DEBUG_LOCATION))
+clog << ">>> JP2_Reader::render_async" << endl;
+#endif
+	{
+	std::lock_guard<std::mutex>
+		lock (Rendering_Lock);
+	if (Async_Rendering)
+		{
+		ostringstream
+			message;
+		message
+			<< "Couldn't start an asynchronous rendering" << endl
+			<< "because one is already in progress" << endl
+			<< "for the " << source_name () << " source.";
+		throw JP2_Logic_Error (message.str (), ID);
+		}
+	Async_Rendering = true;
+	Rendering_Canceled = false;
+	}
+
+std::shared_ptr<Rendering_Cancellation::State>
+	state;
+if (cancellation)
+	state = cancellation->Cancellation_State;
+if (state)
+	{
+	//	Bind the token to the reader.
+	std::lock_guard<std::mutex>
+		lock (state->Lock);
+	state->Reader = this;
+	if (state->Canceled)
+		Rendering_Canceled = true;
+	}
+
+std::future<Cube>
+	rendering;
+try
+	{
+	rendering = std::async (std::launch::async, [this, state] ()
+		{
+		std::exception_ptr
+			failure;
+		Cube
+			rendered;
+		try {rendered = render ();}
+		catch (...)
+			{failure = std::current_exception ();}
+
+		//	Unbind the token before the rendering is declared complete.
+		if (state)
+			{
+			std::lock_guard<std::mutex>
+				lock (state->Lock);
+			state->Reader = NULL;
+			}
+			{
+			std::lock_guard<std::mutex>
+				lock (Rendering_Lock);
+			Async_Rendering = false;
+			Rendering_Canceled = false;
+			}
+		if (failure)
+			std::rethrow_exception (failure);
+		return rendered;
+		});
+	}
+catch (std::system_error&)
+	{
+	//	The rendering thread could not be started.
+	if (state)
+		{
+		std::lock_guard<std::mutex>
+			lock (state->Lock);
+		state->Reader = NULL;
+		}
+	std::lock_guard<std::mutex>
+		lock (Rendering_Lock);
+	Async_Rendering = false;
+	Rendering_Canceled = false;
+	throw;
+	}
+#if ((DEBUG) & (DEBUG_RENDER | DEBUG_LOCATION))
+clog << "<<< JP2_Reader::render_async" << endl;
+#endif
+return rendering;
+}
+
+
+void
+JP2_Reader::cancel_rendering ()
+{
+std::lock_guard<std::mutex>
+	lock (Rendering_Lock);
+if (Async_Rendering &&
+	! Rendering_Canceled)
+	{
+	#if ((DEBUG) & (DEBUG_RENDER | DEBUG_LOCATION))
+	clog << ">-< JP2_Reader::cancel_rendering" << endl;
+	#endif
+	Rendering_Canceled = true;
+	interrupt_rendering ();
+	}
+}
+
+
+void
+JP2_Reader::interrupt_rendering ()
+{}
+
+
+unsigned int
+JP2_Reader::default_JPIP_request_timeout
+	(
+	unsigned int	timeout
+	)
+{
+unsigned int
+	previous = Default_JPIP_Request_Timeout;
+Default_JPIP_Request_Timeout = timeout;
+return previous;
+}
+
+
+int
+JP2_Reader::default_autoreconnect_retries
+	(
+	int		retries
+	)
+{
+int
+	previous = Default_Autoreconnect_Retries;
+Default_Autoreconnect_Retries = retries;
+return previous;
+}
+
+
+bool
+JP2_Reader::reconnect ()
+{return is_open ();}
+
+
+void
+JP2_Reader::reset_rendering ()
+{
+#if ((DEBUG) & (DEBUG_OPEN | DEBUG_CONSTRUCTORS))
+clog << ">>> JP2_Reader::reset_rendering" << endl;
+#endif
+//	Reset rendering specifications.
+Cube
+	empty;
+Rendered_Bands.clear ();
+Image_Region			=
+Rendered_Region			= empty;
+Resolution_Level		= 0;
+Swap_Pixel_Bytes		= false;
+Rendered_Bits			= 0;
+Rendered_Quality_Layers	= 0;
+Progressive_Levels		= 0;
+Float_Samples			= false;
+Calibration_Scale.clear ();
+Calibration_Offset.clear ();
+Stretches.clear ();
+Stretch_Tables.clear ();
+Rendering_Increment_Lines = 0;
+Adaptive_Increment		= false;
+Low_Latency				= false;
+Rendering_Strips		= 1;
+Pipelined_Disposition	= false;
+Bytes_Rendered			= 0;
+Monitor					= NULL;
+Sink					= NULL;
+Tile_Cache				= NULL;
+
+/*	Delete locally managed image data buffers
+	before their allocator is forgotten.
+*/
+delete_local_data_buffer ();
+if (Image_Data &&
+	User_Buffer)
+	for (unsigned int
+			band = 0,
+			bands = image_bands ();
+			band <= bands;
+			band++)
+		Image_Data[band] = NULL;
+Buffer_Size				= 0;
+User_Buffer				= false;
+Buffer_Allocator		= NULL;
+Pad_Image_Lines			= false;
+Separate_Band_Buffers	= false;
+Chunk_Lines				= 0;
+Pixel_Stride			=
+Line_Stride				= 0;
+
+Data_Format				= Default_Image_Data_Format;
+
+Rendering_Configuration_Initialized = false;
+#if ((DEBUG) & (DEBUG_OPEN | DEBUG_CONSTRUCTORS))
+clog << "<<< JP2_Reader::reset_rendering" << endl;
+#endif
+}
+
+
+void
+JP2_Reader::reset ()
+{
+#if ((DEBUG) & (DEBUG_OPEN | DEBUG_CONSTRUCTORS))
+clog << ">>> JP2_Reader::reset" << endl;
+#endif
+JP2_Reader::reset_rendering ();
+Rendering_Statistics.clear ();
+
+if (Image_Data)
+	{
+	delete[] Image_Data;
+	Image_Data			= NULL;
+	}
+
+/*	THREAD_COUNT
+	A preprocessor macro defined as processing_units() unless
+	defined as a non-negative value at compile time.
+*/
+Thread_Count			= THREAD_COUNT;
+Processing_CPUs.clear ();
+Adaptive_Threads		= false;
+Thread_Work_Code_Blocks	= DEFAULT_THREAD_WORK_CODE_BLOCKS;
+Effective_Threads		= 0;
+Threads_Reason.clear ();
+JPIP_Proxy				= Default_JPIP_Proxy;
+JPIP_Cache_Directory	= Default_JPIP_Cache_Directory;
+
+//	Reset the metadata.
+JP2_Metadata::reset ();
+#if ((DEBUG) & (DEBUG_OPEN | DEBUG_CONSTRUCTORS))
+clog << "<<< JP2_Reader::reset" << endl;
+#endif
+}
+
+/*==============================================================================
+	Helpers
+*/
+unsigned int
+JP2_Reader::padded_line_samples
+	(
+	unsigned int	samples
+	)
+	const
+{
+if (! Pad_Image_Lines ||
+	User_Buffer ||
+	Line_Stride)
+	return samples;
+
+size_t
+	alignment = image_buffer_allocator ()->alignment ();
+unsigned int
+	pixel_bytes = rendered_pixel_bytes ();
+if (! pixel_bytes ||
+	alignment <= pixel_bytes ||
+	alignment % pixel_bytes)
+	return samples;
+unsigned int
+	unit = (unsigned int)(alignment / pixel_bytes);
+return ((samples + unit - 1) / unit) * unit;
+}
+
+
+unsigned char*
+JP2_Reader::band_data
+	(
+	unsigned int	band,
+	unsigned int	line,
+	unsigned int	pixel
+	)
+	const
+{
+unsigned char
+	*data;
+if (Chunk_Data.empty ())
+	data = static_cast<unsigned char*>(Image_Data[band]);
+else
+	{
+	unsigned int
+		chunk = line / Allocated_Chunk_Lines;
+	data = static_cast<unsigned char*>(Chunk_Data[chunk][band]);
+	line -= chunk * Allocated_Chunk_Lines;
+	}
+if (! data)
+	return NULL;
+return data
+	+ ((((size_t)line * line_stride ()) + ((size_t)pixel * pixel_stride ()))
+		* rendered_pixel_bytes ());
+}
+
+
+unsigned int
+JP2_Reader::chunk_segment_lines
+	(
+	unsigned int	line
+	)
+	const
+{
+if (Chunk_Data.empty ())
+	return Rendered_Region.Height - line;
+return Allocated_Chunk_Lines - (line % Allocated_Chunk_Lines);
+}
+
+
+unsigned long long
+JP2_Reader::chunk_buffer_size () const
+{
+unsigned long long
+	//	Bytes of a band of a chunk; all bands for interleaved formats.
+	size = (unsigned long long)
+		line_stride () *
+		effective_chunk_lines () *
+		rendered_pixel_bytes ();
+if (Data_Format == FORMAT_BSQ &&
+	! Separate_Band_Buffers)
+	size *= rendered_bands ();
+return size;
+}
+
+
+unsigned long long
+JP2_Reader::minimum_buffer_size () const
+{
+return (unsigned long long)
+	rendered_pixel_bytes () *
+	pixel_stride () *
+	line_stride () *
+	Rendered_Region.height ();
+}
+
+
+bool
+JP2_Reader::allocate_data_buffers_array ()
+{
+if (Image_Data)
+	return true;
+
+/*	Hidden local data buffer pointer.
+
+	An additional entry is provided for the pointer to a locally managed
+	image data buffer.
+*/
+unsigned int
+	bands = image_bands ();
+if (bands)
+	{
+	Image_Data = new void*[bands + 1];
+	for (unsigned int
+			band = 0;
+			band <= bands;
+			band++)
+		Image_Data[band] = NULL;
+	return true;
+	}
+return false;
+}
+
+
+void
+JP2_Reader::delete_local_data_buffer ()
+{
+unsigned int
+	bands = image_bands ();
+if (! Chunk_Buffers.empty ())
+	{
+	#if ((DEBUG) & DEBUG_MANIPULATORS)
+	clog << ">-< JP2_Reader::delete_local_data_buffer:" << endl
+		 << "      Deleting " << Chunk_Buffers.size ()
+			<< " local image data chunk buffers" << endl;
+	#endif
+	Image_Buffer_Allocator
+		*allocator = image_buffer_allocator ();
+	for (unsigned int
+			index = 0;
+			index < Chunk_Buffers.size ();
+			index++)
+		allocator->deallocate
+			(Chunk_Buffers[index].first, Chunk_Buffers[index].second);
+	Chunk_Buffers.clear ();
+	Chunk_Data.clear ();
+	Allocated_Chunk_Lines = 0;
+	Buffer_Size = 0;
+	if (Image_Data &&
+		! User_Buffer)
+		for (unsigned int
+				band = 0;
+				band <= bands;
+				band++)
+			Image_Data[band] = NULL;
+	}
+if (! Image_Data ||
+	! Image_Data[bands])
+	return;
+
+#if ((DEBUG) & DEBUG_MANIPULATORS)
+clog << ">-< JP2_Reader::delete_local_data_buffer:" << endl
+	 << "      Deleting the local image data buffer @ "
+		<< Image_Data[bands] << endl;
+#endif
+image_buffer_allocator ()->deallocate (Image_Data[bands], Local_Buffer_Bytes);
+Local_Buffer_Bytes = 0;
+Buffer_Size = 0;
+for (unsigned int
+		band = 0;
+		band <= bands;
+		band++)
+	Image_Data[band] = NULL;
+}
+
+
+/*------------------------------------------------------------------------------
+	Aligned_Buffer_Allocator
+*/
+JP2_Reader::Aligned_Buffer_Allocator::Aligned_Buffer_Allocator
+	(
+	size_t	alignment,
+	bool	huge_pages,
+	bool	prefault
+	)
+	:	Alignment (sizeof (void*)),
+	Huge_Pages (huge_pages),
+	Prefault (prefault)
+{
+while (Alignment < alignment)
+	Alignment <<= 1;
+}
+
+
+void*
+JP2_Reader::Aligned_Buffer_Allocator::allocate
+	(
+	size_t	bytes
+	)
+{
+if (! bytes)
+	return NULL;
+size_t
+	alignment = Alignment;
+#if defined (__linux__) && defined (MADV_HUGEPAGE)
+if (Huge_Pages &&
+	bytes >= HUGE_PAGE_BYTES &&
+	alignment < HUGE_PAGE_BYTES)
+	//	Huge pages must be aligned to the huge page size.
+	alignment = HUGE_PAGE_BYTES;
+#endif
+
+void*
+	buffer = NULL;
+#ifdef _WIN32
+buffer = _aligned_malloc (bytes, alignment);
+#else
+if (posix_memalign (&buffer, alignment, bytes))
+	buffer = NULL;
+#endif
+if (! buffer)
+	return NULL;
+
+#if defined (__linux__) && defined (MADV_HUGEPAGE)
+if (Huge_Pages &&
+	bytes >= HUGE_PAGE_BYTES)
+	//	Advisory only; failure leaves the buffer in normal pages.
+	madvise (buffer, bytes, MADV_HUGEPAGE);
+#endif
+
+if (Prefault)
+	{
+	//	Touch each page so no page faults occur during rendering.
+	size_t
+		page_size = 4096;
+	#ifndef _WIN32
+	long
+		size = sysconf (_SC_PAGESIZE);
+	if (size > 0)
+		page_size = size;
+	#endif
+	volatile unsigned char
+		*page = static_cast<unsigned char*>(buffer);
+	for (size_t
+			offset = 0;
+			offset < bytes;
+			offset += page_size)
+		page[offset] = 0;
+	page[bytes - 1] = 0;
+	}
+return buffer;
+}
+
+
+void
+JP2_Reader::Aligned_Buffer_Allocator::deallocate
+	(
+	void*	buffer,
+	size_t
+	)
+{
+#ifdef _WIN32
+_aligned_free (buffer);
+#else
+free (buffer);
+#endif
+}
+
+
+JP2_Reader::CPU_Binding::CPU_Binding
+	(
+	const std::vector<unsigned int>&	CPUs
+	)
+	:	Previous_CPUs (),
+	Bound (false)
+{
+#if defined (__linux__)
+if (CPUs.empty ())
+	return;
+cpu_set_t
+	current,
+	selected;
+if (pthread_getaffinity_np (pthread_self (), sizeof (cpu_set_t), &current))
+	return;
+CPU_ZERO (&selected);
+for (unsigned int
+		index = 0;
+		index < CPUs.size ();
+		index++)
+	if (CPUs[index] < CPU_SETSIZE)
+		CPU_SET (CPUs[index], &selected);
+if (! CPU_COUNT (&selected) ||
+	pthread_setaffinity_np (pthread_self (), sizeof (cpu_set_t), &selected))
+	return;
+for (unsigned int
+		CPU = 0;
+		CPU < CPU_SETSIZE;
+		CPU++)
+	if (CPU_ISSET (CPU, &current))
+		Previous_CPUs.push_back (CPU);
+Bound = true;
+#endif
+}
+
+
+JP2_Reader::CPU_Binding::~CPU_Binding ()
+{
+#if defined (__linux__)
+if (Bound)
+	{
+	cpu_set_t
+		previous;
+	CPU_ZERO (&previous);
+	for (unsigned int
+			index = 0;
+			index < Previous_CPUs.size ();
+			index++)
+		CPU_SET (Previous_CPUs[index], &previous);
+	pthread_setaffinity_np (pthread_self (), sizeof (cpu_set_t), &previous);
+	}
+#endif
+}
+
+
+unsigned int
+JP2_Reader::select_processing_threads ()
+{
+#if ((DEBUG) & DEBUG_RENDER)
+clog << ">>> JP2_Reader::select_processing_threads" << endl;
+#endif
+ostringstream
+	reason;
+Effective_Threads = Thread_Count ? Thread_Count : 1;
+if (! Adaptive_Threads)
+	reason << "All " << Effective_Threads
+		<< " processing threads; adaptive selection is disabled.";
+else
+if (Effective_Threads < 2)
+	reason << "One processing thread is available.";
+else
+	{
+	//	Code-blocks are no larger than the precincts at the resolution.
+	Size_2D
+		block (code_block_size ()),
+		precinct (precinct_size ((resolution_levels () > Resolution_Level) ?
+			(resolution_levels () - Resolution_Level) : 0));
+	if (! block.Width ||
+		! block.Height)
+		block.Width =
+		block.Height = 64;
+	if (block.Width > precinct.Width)
+		block.Width = precinct.Width;
+	if (block.Height > precinct.Height)
+		block.Height = precinct.Height;
+
+	unsigned long long
+		code_blocks =
+			((Rendered_Region.Width  + block.Width  - 1) / block.Width) *
+			((Rendered_Region.Height + block.Height - 1) / block.Height) *
+			(rendered_bands () ? rendered_bands () : 1),
+		threads = code_blocks / Thread_Work_Code_Blocks;
+	/*	The Kakadu thread group can not be limited to some of its
+		threads for a rendering, so the selection is between a single
+		thread, without the thread group, and all of the threads.
+	*/
+	if (threads < 2)
+		{
+		threads = 1;
+		reason << "One";
+		}
+	else
+		{
+		threads = Effective_Threads;
+		reason << "All " << threads;
+		}
+	reason
+		<< " processing thread" << (threads == 1 ? "" : "s") << " for "
+			<< code_blocks << ' ' << block.Width << 'x' << block.Height
+			<< " code-blocks in the " << Rendered_Region.Width << 'x'
+			<< Rendered_Region.Height << " region of "
+			<< rendered_bands () << " band" << (rendered_bands () == 1 ? "" : "s")
+			<< " at resolution level " << Resolution_Level
+			<< " with a work threshold of " << Thread_Work_Code_Blocks
+			<< " code-blocks per thread.";
+	Effective_Threads = (unsigned int)threads;
+	}
+Threads_Reason = reason.str ();
+#if ((DEBUG) & DEBUG_RENDER)
+clog << "    " << Threads_Reason << endl
+	 << "<<< JP2_Reader::select_processing_threads: "
+	 	<< Effective_Threads << endl;
+#endif
+return Effective_Threads;
+}
+
+
+void
+JP2_Reader::allocate_image_data_buffer ()
+{
+#if ((DEBUG) & (DEBUG_MANIPULATORS | DEBUG_RENDER))
+clog << ">>> JP2_Reader::allocate_image_data_buffer" << endl;
+#endif
+if (chunked_image_data ())
+	{
+	allocate_image_data_chunks ();
+	#if ((DEBUG) & (DEBUG_MANIPULATORS | DEBUG_RENDER))
+	clog << "<<< JP2_Reader::allocate_image_data_buffer: "
+			<< Chunk_Data.size () << " chunks" << endl;
+	#endif
+	return;
+	}
+if (! user_buffer ())
+	{
+	unsigned long long
+		minimum = minimum_buffer_size () * rendered_bands ();
+	if (! minimum)
+		{
+		#if ((DEBUG) & (DEBUG_MANIPULATORS | DEBUG_RENDER))
+		clog << "    Zero buffer size." << endl
+			 << "<<< JP2_Reader::allocate_image_data_buffer" << endl;
+		#endif
+		return;
+		}
+
+	//	Convert to unsigned long long array size.
+	minimum = (minimum / sizeof (long long))
+				+ ((minimum % sizeof (long long) ? 1 : 0));
+	if (minimum > MAX_ARRAY_ALLOCATION)
+		{
+		ostringstream
+			message;
+		message << "The required image data buffer size - "
+					<< magnitude (minimum) << " (" << minimum << ") "
+					<< (sizeof (long long) << 3) << "-bit words" << endl
+				<< "is greater than the maximum size - "
+					<< magnitude (MAX_ARRAY_ALLOCATION)
+					<< " (" << MAX_ARRAY_ALLOCATION << ")." << endl;
 		throw JP2_Out_of_Range (message.str (), ID);
 		}
 
-	//	Ensure that an image data buffers array is allocated.
-	allocate_data_buffers_array ();
-
-	unsigned int
-		bands = image_bands ();
-	size_t
-		size = (size_t)minimum,
-		buffer_size = size / rendered_bands ();
-	if (! Image_Data[bands] ||
-		 buffer_size > Buffer_Size ||
-		(Buffer_Size > BUFFER_SIZE_REDUCTION_DIFFERENTIAL &&
-		 buffer_size < (Buffer_Size - BUFFER_SIZE_REDUCTION_DIFFERENTIAL)))
-		{
-		//	Reallocate the image data buffer.
-		delete_local_data_buffer ();
+	//	Ensure that an image data buffers array is allocated.
+	allocate_data_buffers_array ();
+
+	unsigned int
+		bands = image_bands ();
+	size_t
+		size = (size_t)minimum,
+		buffer_size = size / rendered_bands ();
+	if (! Image_Data[bands] ||
+		 buffer_size > Buffer_Size ||
+		(Buffer_Size > BUFFER_SIZE_REDUCTION_DIFFERENTIAL &&
+		 buffer_size < (Buffer_Size - BUFFER_SIZE_REDUCTION_DIFFERENTIAL)))
+		{
+		//	Reallocate the image data buffer.
+		delete_local_data_buffer ();
+
+		#if ((DEBUG) & (DEBUG_MANIPULATORS | DEBUG_RENDER))
+		clog << "    Allocating " << size
+				<< " byte image data buffer" << endl;
+		#endif
+		CPU_Binding
+			binding (Processing_CPUs);
+		Image_Buffer_Allocator
+			*allocator = image_buffer_allocator ();
+		try {Image_Data[bands] = allocator->allocate (size * sizeof (long long));}
+		catch (bad_alloc&) {Image_Data[bands] = NULL;}
+		if (! Image_Data[bands])
+			{
+			minimum *= sizeof (long long);
+			ostringstream
+				message;
+			message << "Couldn't allocate a " << magnitude (minimum)
+						<< " (" << minimum << ") byte image data buffer.";
+			throw JP2_Out_of_Range (message.str (), ID);
+			}
+		if (binding.bound ())
+			//	First touch places the pages near the bound processors.
+			memset (Image_Data[bands], 0, size * sizeof (long long));
+		#if ((DEBUG) & (DEBUG_MANIPULATORS | DEBUG_RENDER))
+		clog << "      @ " << Image_Data[bands] << endl;
+		#endif
+		Local_Buffer_Bytes = size * sizeof (long long);
+		Buffer_Size = buffer_size;
+
+		unsigned char*
+			image_data =
+				reinterpret_cast<unsigned char*>(Image_Data[bands]);
+		switch (Data_Format)
+			{
+			case FORMAT_BSQ:
+				for (unsigned int
+						band = 0;
+						band < bands;
+						band++)
+					{
+					if (Rendered_Bands[band])
+						{
+						Image_Data[band] = image_data;
+						image_data += (size_t)line_stride ()
+							* Rendered_Region.Height * rendered_pixel_bytes ();
+						}
+					else
+						Image_Data[band] = NULL;
+					#if ((DEBUG) & (DEBUG_MANIPULATORS | DEBUG_RENDER))
+					clog << "    " << band << " @ " << Image_Data[band] << endl;
+					#endif
+					}
+				break;
+			case FORMAT_BIP:
+				for (unsigned int
+						band = 0;
+						band < bands;
+						band++)
+					{
+					if (Rendered_Bands[band])
+						{
+						Image_Data[band] = image_data;
+						image_data += rendered_pixel_bytes ();
+						}
+					else
+						Image_Data[band] = NULL;
+					#if ((DEBUG) & (DEBUG_MANIPULATORS | DEBUG_RENDER))
+					clog << "    " << band << " @ " << Image_Data[band] << endl;
+					#endif
+					}
+				break;
+			case FORMAT_BIL:
+				for (unsigned int
+						band = 0;
+						band < bands;
+						band++)
+					{
+					if (Rendered_Bands[band])
+						{
+						Image_Data[band] = image_data;
+						image_data += (line_stride () / rendered_bands ())
+							* rendered_pixel_bytes ();
+						}
+					else
+						Image_Data[band] = NULL;
+					#if ((DEBUG) & (DEBUG_MANIPULATORS | DEBUG_RENDER))
+					clog << "    " << band << " @ " << Image_Data[band] << endl;
+					#endif
+					}
+				break;
+			default: break;
+			}
+		}
+	#if ((DEBUG) & (DEBUG_MANIPULATORS | DEBUG_RENDER))
+	else
+		clog << "    Reusing existing buffer" << endl;
+	#endif
+	}
+#if ((DEBUG) & (DEBUG_MANIPULATORS | DEBUG_RENDER))
+else
+if (Image_Data)
+	{
+	clog << "    " << Buffer_Size << " byte user buffers -" << endl;
+	for (unsigned int
+			band = 0;
+			band < image_bands ();
+			band++)
+		clog << "      " << band << " @ " << Image_Data[band] << endl;
+	clog << "    Pixel_Stride - " << pixel_stride () << endl
+		 << "     Line_Stride - " << line_stride () << endl;
+	}
+clog << "<<< JP2_Reader::allocate_image_data_buffer" << endl;
+#endif
+}
+
+
+void
+JP2_Reader::allocate_image_data_chunks ()
+{
+unsigned int
+	bands = image_bands (),
+	rendered = rendered_bands (),
+	pixel_bytes = rendered_pixel_bytes (),
+	line_samples = line_stride (),
+	chunk_lines = effective_chunk_lines ();
+if (! bands ||
+	! rendered ||
+	! pixel_bytes ||
+	! line_samples ||
+	! chunk_lines)
+	return;
+
+unsigned int
+	chunks = (Rendered_Region.Height + chunk_lines - 1) / chunk_lines;
+bool
+	separate = Separate_Band_Buffers && Data_Format == FORMAT_BSQ;
+size_t
+	//	Bytes of a band of a chunk; all bands for interleaved formats.
+	band_bytes = (size_t)line_samples * chunk_lines * pixel_bytes,
+	buffer_bytes = (size_t)chunk_buffer_size (),
+	buffers = separate ? (size_t)chunks * rendered : chunks;
+#if ((DEBUG) & (DEBUG_MANIPULATORS | DEBUG_RENDER))
+clog << ">>> JP2_Reader::allocate_image_data_chunks: " << chunks
+		<< " chunks of " << chunk_lines << " lines in "
+		<< buffers << " buffers of " << buffer_bytes << " bytes" << endl;
+#endif
+
+//	Ensure that an image data buffers array is allocated.
+allocate_data_buffers_array ();
+
+if (Chunk_Buffers.size () != buffers ||
+	Chunk_Buffers[0].second != buffer_bytes)
+	{
+	//	Reallocate the image data chunks.
+	delete_local_data_buffer ();
+
+	CPU_Binding
+		binding (Processing_CPUs);
+	Image_Buffer_Allocator
+		*allocator = image_buffer_allocator ();
+	void
+		*buffer;
+	while (Chunk_Buffers.size () < buffers)
+		{
+		try {buffer = allocator->allocate (buffer_bytes);}
+		catch (bad_alloc&) {buffer = NULL;}
+		if (! buffer)
+			{
+			size_t
+				allocated = Chunk_Buffers.size ();
+			delete_local_data_buffer ();
+			ostringstream
+				message;
+			message << "Couldn't allocate a " << magnitude (buffer_bytes)
+						<< " (" << buffer_bytes << ") byte image data chunk buffer"
+						<< endl
+					<< "after allocating " << allocated << " of "
+						<< buffers << " chunk buffers.";
+			throw JP2_Out_of_Range (message.str (), ID);
+			}
+		if (binding.bound ())
+			//	First touch places the pages near the bound processors.
+			memset (buffer, 0, buffer_bytes);
+		Chunk_Buffers.push_back (std::make_pair (buffer, buffer_bytes));
+		}
+	}
+Allocated_Chunk_Lines = chunk_lines;
+Buffer_Size = band_bytes;
+
+//	Band addresses of each chunk.
+Chunk_Data.assign (chunks, std::vector<void*> (bands, (void*)NULL));
+size_t
+	next = 0;
+for (unsigned int
+		chunk = 0;
+		chunk < chunks;
+		chunk++)
+	{
+	unsigned char
+		*address = NULL;
+	if (! separate)
+		address = static_cast<unsigned char*>(Chunk_Buffers[next++].first);
+	for (unsigned int
+			band = 0;
+			band < bands;
+			band++)
+		{
+		if (! Rendered_Bands[band])
+			continue;
+		if (separate)
+			Chunk_Data[chunk][band] = Chunk_Buffers[next++].first;
+		else
+			{
+			Chunk_Data[chunk][band] = address;
+			switch (Data_Format)
+				{
+				case FORMAT_BSQ: address += band_bytes; break;
+				case FORMAT_BIP: address += pixel_bytes; break;
+				case FORMAT_BIL:
+					address += (line_samples / rendered) * pixel_bytes;
+					break;
+				default: break;
+				}
+			}
+		}
+	}
+for (unsigned int
+		band = 0;
+		band < bands;
+		band++)
+	Image_Data[band] = Chunk_Data[0][band];
+Image_Data[bands] = NULL;
+#if ((DEBUG) & (DEBUG_MANIPULATORS | DEBUG_RENDER))
+clog << "<<< JP2_Reader::allocate_image_data_chunks" << endl;
+#endif
+}
+
+/*------------------------------------------------------------------------------
+	Pixel data disposition
+*/
+
+#if ((DEBUG) & DEBUG_PIXEL_DATA)
+#ifndef DOXYGEN_PROCESSING
+namespace
+{
+void
+print_line
+	(
+	unsigned char*	data,
+	unsigned int	count,
+	unsigned int	pixel_stride
+	)
+{
+clog << hex << setfill ('0');
+for (unsigned int
+		index = 0;
+		index < count;
+		index++,
+			data += pixel_stride)
+	{
+	if (! (index % 16))
+		{
+		if (index)
+			clog << endl;
+		clog << dec << setfill (' ')
+			 << setw (5) << index << ": "
+			 << hex << setfill ('0');
+		}
+	clog << "  " << setw (2) << ((unsigned int)(*data) & 0xFF);
+	}
+clog << dec << setfill (' ') << endl;
+}
+
+
+void
+print_line
+	(
+	unsigned short*	data,
+	unsigned int	count,
+	unsigned int	pixel_stride
+	)
+{
+clog << hex << setfill ('0');
+for (unsigned int
+		index = 0;
+		index < count;
+		index++,
+			data += pixel_stride)
+	{
+	if (! (index % 16))
+		{
+		if (index)
+			clog << endl;
+		clog << dec << setfill (' ')
+			 << setw (5) << index << ": "
+			 << hex << setfill ('0');
+		}
+	clog << "  " << setw (4) << *data;
+	}
+clog << dec << setfill (' ') << endl;
+}
+
 
-		#if ((DEBUG) & (DEBUG_MANIPULATORS | DEBUG_RENDER))
-		clog << "    Allocating " << size
-				<< " byte image data buffer" << endl;
-		#endif
-		try {Image_Data[bands] = new unsigned long long[size];}
-		catch (bad_alloc&)
-			{
-			minimum *= sizeof (long long);
-			ostringstream
-				message;
-			message << "Couldn't allocate a " << magnitude (minimum)
-						<< " (" << minimum << ") byte image data buffer.";
-			throw JP2_Out_of_Range (message.str (), ID);
-			}
-		#if ((DEBUG) & (DEBUG_MANIPULATORS | DEBUG_RENDER))
-		clog << "      @ " << Image_Data[bands] << endl;
+void
+print_pixels
+	(
+	void**			image_data,
+	const Cube&		region,
+	const Cube&		rendered_region,
+	unsigned int	line_stride,
+	unsigned int	pixel_stride,
+	unsigned int	pixel_sample_bytes
+	)
+{
+clog << ">>> print_pixels:" << endl
+	 << "    region " << region << endl
+	 << "        of " << rendered_region << endl
+	 << "           line stride = " << line_stride << endl
+	 << "          pixel stride = " << pixel_stride << endl
+	 << "    pixel sample bytes = " << pixel_sample_bytes << endl;
+size_t
+	offset =
+		  ((region.X - rendered_region.X)	//	Horizontal, pixels, offset.
+			* pixel_stride)					//	Pixel size in bytes.
+		+ ((region.Y - rendered_region.Y)	//	Vertical, lines, offset.
+			* pixel_stride * line_stride);	//	Line length in bytes.
+clog << "    first pixel offset = " << offset << endl;
+int
+	last_line = region.Y +
+		#if ((DEBUG) & DEBUG_ONE_LINE)
+		1;
+		#else
+		region.Height;
 		#endif
-		Buffer_Size = buffer_size;
+unsigned char
+	*last_line_data,
+	*this_line_data,
+	*data_end,
+	*buffer_1 = NULL;
+unsigned short
+	*buffer_2 = NULL;
 
-		unsigned char*
-			image_data =
-				reinterpret_cast<unsigned char*>(Image_Data[bands]);
-		switch (Data_Format)
+for (unsigned int
+		band = 0;
+		band < region.Depth;
+		band++)
+	{
+	if (image_data[band])
+		{
+		clog << endl
+			 << "--> Image_Data[" << band << "] @ "
+				<< image_data[band] << endl;
+		if (pixel_sample_bytes == 1)
+			buffer_1 =
+				(unsigned char*)image_data[band] + offset;
+		else
+			buffer_2 =
+				(unsigned short*)image_data[band] + offset;
+		int
+			matches = 0,
+			line = region.Y;
+		for (line = region.Y;
+			 line < last_line;
+			 line++)
 			{
-			case FORMAT_BSQ:
-				for (unsigned int
-						band = 0;
-						band < bands;
-						band++)
+			if (line != region.Y)
+				{
+				if (buffer_1)
 					{
-					if (Rendered_Bands[band])
-						{
-						Image_Data[band] = image_data;
-						image_data +=
-							Rendered_Region.area () * rendered_pixel_bytes ();
-						}
-					else
-						Image_Data[band] = NULL;
-					#if ((DEBUG) & (DEBUG_MANIPULATORS | DEBUG_RENDER))
-					clog << "    " << band << " @ " << Image_Data[band] << endl;
-					#endif
+					last_line_data = buffer_1 - line_stride;
+					this_line_data = buffer_1;
+					data_end = buffer_1 + region.Width;
 					}
-				break;
-			case FORMAT_BIP:
-				for (unsigned int
-						band = 0;
-						band < bands;
-						band++)
+				else
 					{
-					if (Rendered_Bands[band])
-						{
-						Image_Data[band] = image_data;
-						image_data += rendered_pixel_bytes ();
-						}
-					else
-						Image_Data[band] = NULL;
-					#if ((DEBUG) & (DEBUG_MANIPULATORS | DEBUG_RENDER))
-					clog << "    " << band << " @ " << Image_Data[band] << endl;
-					#endif
+					last_line_data = (unsigned char*)(buffer_2 - line_stride);
+					this_line_data = (unsigned char*)buffer_2;
+					data_end = (unsigned char*)(buffer_2 + region.Width);
 					}
-				break;
-			case FORMAT_BIL:
-				for (unsigned int
-						band = 0;
-						band < bands;
-						band++)
+				while (this_line_data < data_end)
+					if (*last_line_data++ != *this_line_data++)
+						break;
+				if (this_line_data == data_end)
+					++matches;
+				else
+					matches = -matches;
+				}
+			if (matches <= 0)
+				{
+				if (matches < 0)
 					{
-					if (Rendered_Bands[band])
-						{
-						Image_Data[band] = image_data;
-						image_data +=
-							Rendered_Region.Width * rendered_pixel_bytes ();
-						}
-					else
-						Image_Data[band] = NULL;
-					#if ((DEBUG) & (DEBUG_MANIPULATORS | DEBUG_RENDER))
-					clog << "    " << band << " @ " << Image_Data[band] << endl;
-					#endif
+					clog << "line " << (line + matches);
+					if (matches != -1)
+						clog << " - " << (line - 1);
+					clog << " matches the previous line." << endl;
+					matches = 0;
 					}
-				break;
-			default: break;
+				clog << "line " << line << " @ ";
+				if (buffer_1)
+					{
+					clog << (void*)buffer_1 << " -" << endl;
+					print_line (buffer_1, region.Width, pixel_stride);
+					buffer_1 += line_stride;
+					}
+				else
+					{
+					clog << (void*)buffer_2 << " -" << endl;
+					print_line (buffer_2, region.Width, pixel_stride);
+					buffer_2 += line_stride;
+					}
+				}
 			}
+		if (matches)
+			{
+			clog << "line " << (line - matches);
+			if (matches != 1)
+				clog << " - " << (line - 1);
+			clog << " matches the previous line." << endl;
+			}
+		}
+	}
+clog << "<<< print_pixels" << endl;
+}
+
+}	//	local namespace.
+#endif
+#endif
+
+
+/*------------------------------------------------------------------------------
+	Decompressed pixel data byte swapping and monitor notification.
+*/
+bool
+JP2_Reader::data_disposition
+	(
+	Rendering_Monitor::Status	status,
+	const std::string&			message,
+	const Cube&					region,
+	const Cube&					image_region_rendered,
+	void**						data,
+	unsigned int				data_line_stride
+	)
+{
+double
+	disposition_start = increment_statistics ();
+JP2_Trace::Span
+	span ("data_disposition", this);
+
+bool
+	continue_rendering = ! Rendering_Canceled;
+if (! Pipelined_Disposition)
+	{
+	//	Swap the increment bytes while they are still in the cache.
+	swap_rendered_bytes (region, data, data_line_stride);
+	if (! dispose_data (status, message, region, image_region_rendered,
+			data, data_line_stride, true))
+		continue_rendering = false;
+	disposition_statistics (disposition_start);
+	return continue_rendering;
+	}
+
+//	Pipelined data disposition.
+if (! Pipeline)
+	Pipeline.reset (new Disposition_Pipeline);
+if (! Pipeline->Thread.joinable ())
+	{
+	#if ((DEBUG) & (DEBUG_DISPOSITION | DEBUG_LOCATION))
+	clog << "*** JP2_Reader::data_disposition: "
+			"starting the disposition thread" << endl;
+	#endif
+	Pipeline->Stop = false;
+	Pipeline->Canceled = false;
+	Pipeline->Failure = NULL;
+	Pipeline->Pending = 0;
+	Pipeline->Thread =
+		std::thread (&JP2_Reader::data_disposition_pipeline, this);
+	}
+	{
+	std::lock_guard<std::mutex>
+		lock (Pipeline->Lock);
+	Pipeline->Queue.push_back (Disposition_Pipeline::Disposition
+		(status, message, region, image_region_rendered));
+	if (data)
+		{
+		Pipeline->Queue.back ().Data.assign (data, data + image_bands ());
+		Pipeline->Queue.back ().Line_Stride = data_line_stride;
+		}
+	++Pipeline->Pending;
+	}
+Pipeline->Ready.notify_one ();
+
+if (Pipeline->Canceled)
+	continue_rendering = false;
+#if ((DEBUG) & (DEBUG_DISPOSITION | DEBUG_LOCATION))
+clog << "*** JP2_Reader::data_disposition: queued " << region
+		<< "; " << boolalpha << continue_rendering << endl;
+#endif
+disposition_statistics (disposition_start);
+return continue_rendering;
+}
+
+
+bool
+JP2_Reader::dispose_data
+	(
+	Rendering_Monitor::Status	status,
+	const std::string&			message,
+	const Cube&					region,
+	const Cube&					image_region_rendered,
+	void**						data,
+	unsigned int				data_line_stride,
+	bool						notify
+	)
+{
+#if ((DEBUG) & (DEBUG_DISPOSITION | DEBUG_PIXEL_DATA | DEBUG_LOCATION))
+clog << ">>> JP2_Reader::dispose_data:" << endl
+	 << "    status " << status << " \"" << message << '"' << endl
+	 << "    source \"" << source_name () << '"' << endl
+	 << "    size " << image_size ()
+	 	<< ", resolution level " << resolution_level ()
+		<< ", " << rendered_pixel_bytes () << " byte pixel data" << endl
+	 << "    region rendered " << region << endl
+	 << "                 of " << Rendered_Region << endl
+	 << "     image rendered " << image_region_rendered << endl
+	 << "                 of " << Image_Region << endl;
+#endif
+bool
+	stretched = stretching ();
+if (Float_Samples &&
+	! stretched &&
+	region.area ())
+	{
+	//	Calibrate the floating point samples.
+	#if ((DEBUG) & DEBUG_DISPOSITION)
+	clog << "    Calibrating pixel samples ..." << endl;
+	#endif
+	if (data)
+		{
+		//	Increment data buffers.
+		for (unsigned int
+				band = 0;
+				band < image_bands ();
+				band++)
+			if (data[band])
+				calibrate_samples (band, data[band],
+					region.Width, region.Height, 1, data_line_stride);
 		}
-	#if ((DEBUG) & (DEBUG_MANIPULATORS | DEBUG_RENDER))
 	else
-		clog << "    Reusing existing buffer" << endl;
+		{
+		unsigned int
+			pixel_gap = pixel_stride (),
+			line_gap = line_stride (),
+			pixel = region.X - Rendered_Region.X,
+			line = region.Y - Rendered_Region.Y,
+			end = line + region.Height,
+			lines;
+		for (;
+			 line < end;
+			 line += lines)
+			{
+			//	Image data chunk segment.
+			if ((lines = chunk_segment_lines (line)) > (end - line))
+				lines = end - line;
+			for (unsigned int
+					band = 0;
+					band < region.Depth;
+					band++)
+				if (Image_Data[band])
+					calibrate_samples (band, band_data (band, line, pixel),
+						region.Width, lines, pixel_gap, line_gap);
+			}
+		}
+	}
+if (stretched &&
+	data &&
+	region.area ())
+	{
+	//	Map the decoded increment samples to 8-bit pixels.
+	#if ((DEBUG) & DEBUG_DISPOSITION)
+	clog << "    Stretching pixel samples ..." << endl;
 	#endif
+	unsigned int
+		pixel = region.X - Rendered_Region.X,
+		first_line = region.Y - Rendered_Region.Y,
+		end = first_line + region.Height,
+		line,
+		lines;
+	for (unsigned int
+			band = 0;
+			band < image_bands ();
+			band++)
+		{
+		if (! data[band])
+			continue;
+		if (Sink)
+			//	In place for delivery to the line sink.
+			stretch_samples (band, data[band], data_line_stride,
+				(unsigned char*)data[band], 1, data_line_stride,
+				region.Width, region.Height);
+		else
+		if (Image_Data &&
+			Image_Data[band])
+			{
+			for (line = first_line;
+				 line < end;
+				 line += lines)
+				{
+				//	Image data chunk segment.
+				if ((lines = chunk_segment_lines (line)) > (end - line))
+					lines = end - line;
+				stretch_samples (band,
+					static_cast<unsigned char*>(data[band])
+						+ ((size_t)(line - first_line) * data_line_stride
+							* decoded_pixel_bytes ()),
+					data_line_stride,
+					band_data (band, line, pixel),
+					pixel_stride (), line_stride (),
+					region.Width, lines);
+				}
+			}
+		}
 	}
-#if ((DEBUG) & (DEBUG_MANIPULATORS | DEBUG_RENDER))
-else
-if (Image_Data)
+#if ((DEBUG) & DEBUG_PIXEL_DATA)
+if (region.area () &&
+	! data)
+	print_pixels (Image_Data, region, Rendered_Region,
+		line_stride (), pixel_stride (), rendered_pixel_bytes ());
+#endif
+
+bool
+	continue_rendering = true;
+if (Sink &&
+	data &&
+	notify &&
+	region.area ())
 	{
-	clog << "    " << Buffer_Size << " byte user buffers -" << endl;
+	//	Deliver the lines to the Line_Sink.
+	#if ((DEBUG) & (DEBUG_DISPOSITION | DEBUG_LOCATION))
+	clog << "*** JP2_Reader::dispose_data: line sink lines "
+			<< (region.Y - Rendered_Region.Y) << '-'
+			<< (region.Y - Rendered_Region.Y + region.Height - 1) << endl;
+	#endif
 	for (unsigned int
 			band = 0;
+			continue_rendering &&
 			band < image_bands ();
 			band++)
-		clog << "      " << band << " @ " << Image_Data[band] << endl;
-	clog << "    Pixel_Stride - " << pixel_stride () << endl
-		 << "     Line_Stride - " << line_stride () << endl;
+		if (data[band] &&
+			! Sink->lines (*this, band, region.Y - Rendered_Region.Y,
+				region.Height, data[band], data_line_stride))
+			continue_rendering = false;
 	}
-clog << "<<< JP2_Reader::allocate_image_data_buffer" << endl;
+if (Monitor &&
+	notify &&
+	continue_rendering)
+	{
+	//	Notify the Rendering_Monitor of the rendering progress.
+	#if ((DEBUG) & (DEBUG_DISPOSITION | DEBUG_NOTIFY | DEBUG_LOCATION))
+	clog << "*** JP2_Reader::dispose_data: notify status "
+			<< status << " \"" << message << '"' << endl
+		 << "    region = " << region << endl;
+	#endif
+	JP2_Trace::Span
+		span ("monitor_notify", this);
+	continue_rendering =
+		Monitor->notify (*this, status, message, region, image_region_rendered);
+	}
+#if ((DEBUG) & (DEBUG_DISPOSITION | DEBUG_PIXEL_DATA | DEBUG_LOCATION))
+clog << "<<< JP2_Reader::dispose_data: "
+		<< boolalpha << continue_rendering << endl;
 #endif
+return continue_rendering;
 }
 
-/*------------------------------------------------------------------------------
-	Pixel data disposition
-*/
 
-#if ((DEBUG) & DEBUG_PIXEL_DATA)
+void
+JP2_Reader::swap_rendered_bytes
+	(
+	const Cube&		region,
+	void**			data,
+	unsigned int	data_line_stride
+	)
+{
+if (! Swap_Pixel_Bytes ||
+	decoded_pixel_bytes () < 2 ||
+	Float_Samples ||
+	//	Decoded samples index the stretch tables in host order.
+	stretching () ||
+	! region.area ())
+	return;
+
+#if ((DEBUG) & DEBUG_DISPOSITION)
+clog << "    Swapping pixel bytes ..." << endl;
+#endif
+if (data)
+	{
+	//	Increment data buffers.
+	for (unsigned int
+			band = 0;
+			band < image_bands ();
+			band++)
+		if (data[band])
+			swap_sample_bytes (data[band],
+				region.Width, region.Height, 1, data_line_stride);
+	return;
+	}
+
+unsigned int
+	pixel_gap = pixel_stride (),
+	line_gap = line_stride (),
+	pixel = region.X - Rendered_Region.X,
+	line = region.Y - Rendered_Region.Y,
+	end = line + region.Height,
+	lines,
+	band;
+#if ((DEBUG) & DEBUG_DISPOSITION)
+clog << "            pixel_stride = " << pixel_stride () << endl
+	 << "             line_stride = " << line_stride () << endl
+	 << "     first sample line,pixel = " << line << ',' << pixel << endl;
+#endif
+bool
+	interleaved = false;
+if (pixel_gap > 1 &&
+	pixel_gap == region.Depth)
+	{
+	/*	Band interleaved by pixel.
+
+		When the bands are interleaved in a single buffer each line of
+		pixels is a contiguous run of samples for all bands.
+	*/
+	unsigned short
+		*first = (unsigned short*)band_data (0, line, pixel);
+	for (band = 0;
+		 band < region.Depth;
+		 band++)
+		if ((unsigned short*)band_data (band, line, pixel) != first + band)
+			break;
+	interleaved = first && band == region.Depth;
+	}
+for (;
+	 line < end;
+	 line += lines)
+	{
+	//	Image data chunk segment.
+	if ((lines = chunk_segment_lines (line)) > (end - line))
+		lines = end - line;
+	if (interleaved)
+		swap_sample_bytes (band_data (0, line, pixel),
+			region.Width * pixel_gap, lines, 1, line_gap);
+	else
+		for (band = 0;
+			 band < region.Depth;
+			 band++)
+			if (Image_Data[band])
+				swap_sample_bytes (band_data (band, line, pixel),
+					region.Width, lines, pixel_gap, line_gap);
+	}
+}
+
+
+void
+JP2_Reader::data_disposition_pipeline ()
+{
+Disposition_Pipeline
+	&pipeline = *Pipeline;
+std::unique_lock<std::mutex>
+	lock (pipeline.Lock);
+while (true)
+	{
+	pipeline.Ready.wait (lock,
+		[&pipeline] {return pipeline.Stop || ! pipeline.Queue.empty ();});
+	if (pipeline.Queue.empty ())
+		break;	//	Stopped.
+	Disposition_Pipeline::Disposition
+		disposition (pipeline.Queue.front ());
+	pipeline.Queue.pop_front ();
+	lock.unlock ();
+
+	/*	Once canceled the remaining increments are still disposed,
+		because they have been decompressed and will be reported as
+		rendered, but the rendering monitor is no longer notified.
+	*/
+	bool
+		notify = ! pipeline.Canceled;
+	void
+		**data = disposition.Data.empty () ? NULL : &disposition.Data[0];
+	try
+		{
+		/*	The bytes are swapped here, not by the rendering thread,
+			so the decompression machinery does not wait for them.
+		*/
+		swap_rendered_bytes (disposition.Region, data,
+			disposition.Line_Stride);
+		if (! dispose_data (disposition.Status, disposition.Message,
+				disposition.Region, disposition.Image_Region,
+				data, disposition.Line_Stride, notify) &&
+			notify)
+			pipeline.Canceled = true;
+		}
+	catch (...)
+		{
+		pipeline.Canceled = true;
+		if (! pipeline.Failure)
+			pipeline.Failure = std::current_exception ();
+		}
+	lock.lock ();
+	--pipeline.Pending;
+	pipeline.Done.notify_all ();
+	}
+}
+
+
+void
+JP2_Reader::wait_data_disposition
+	(
+	unsigned int	pending
+	)
+{
+if (! Pipeline ||
+	! Pipeline->Thread.joinable ())
+	return;
+std::unique_lock<std::mutex>
+	lock (Pipeline->Lock);
+Pipeline->Done.wait (lock,
+	[this, pending] {return Pipeline->Pending <= pending;});
+}
+
+
+bool
+JP2_Reader::finish_data_disposition ()
+{
+if (! Pipeline ||
+	! Pipeline->Thread.joinable ())
+	return true;
+#if ((DEBUG) & (DEBUG_DISPOSITION | DEBUG_LOCATION))
+clog << ">>> JP2_Reader::finish_data_disposition" << endl;
+#endif
+	{
+	std::lock_guard<std::mutex>
+		lock (Pipeline->Lock);
+	Pipeline->Stop = true;
+	}
+Pipeline->Ready.notify_one ();
+Pipeline->Thread.join ();
+
+bool
+	continue_rendering = ! Pipeline->Canceled;
+std::exception_ptr
+	failure (Pipeline->Failure);
+Pipeline->Failure = NULL;
+#if ((DEBUG) & (DEBUG_DISPOSITION | DEBUG_LOCATION))
+clog << "<<< JP2_Reader::finish_data_disposition: "
+		<< boolalpha << continue_rendering << endl;
+#endif
+if (failure)
+	std::rethrow_exception (failure);
+return continue_rendering;
+}
+
+
+void
+JP2_Reader::stop_data_disposition ()
+	throw()
+{
+try {finish_data_disposition ();}
+catch (...) {}
+}
+
 #ifndef DOXYGEN_PROCESSING
 namespace
 {
+/*	Sample bytes swapping kernels.
+
+	Each kernel swaps the bytes of count contiguous 16-bit samples.
+	Each strided kernel swaps the bytes of count 16-bit samples that are
+	stride samples apart; the samples between them are not accessed.
+*/
+typedef void (*Swap_Kernel) (unsigned short*, size_t);
+typedef void (*Strided_Swap_Kernel) (unsigned short*, size_t, unsigned int);
+
 void
-print_line
+swap_bytes_portable
 	(
-	unsigned char*	data,
-	unsigned int	count,
-	unsigned int	pixel_stride
+	unsigned short*	data,
+	size_t			count
 	)
 {
-clog << hex << setfill ('0');
-for (unsigned int
-		index = 0;
-		index < count;
-		index++,
-			data += pixel_stride)
+for (unsigned short*
+		end = data + count;
+		data < end;
+		data++)
+	*data = (unsigned short)((*data << 8) | (*data >> 8));
+}
+
+void
+swap_strided_bytes_portable
+	(
+	unsigned short*	data,
+	size_t			count,
+	unsigned int	stride
+	)
+{
+for (size_t
+		sample = 0;
+		sample < count;
+		sample++,
+		data += stride)
+	*data = (unsigned short)((*data << 8) | (*data >> 8));
+}
+
+#if SWAP_SAMPLE_BYTES_SIMD
+__attribute__ ((target ("sse2")))
+void
+swap_bytes_sse2
+	(
+	unsigned short*	data,
+	size_t			count
+	)
+{
+size_t
+	index = 0;
+for (;
+	 (index + 8) <= count;
+	 index += 8)
 	{
-	if (! (index % 16))
-		{
-		if (index)
-			clog << endl;
-		clog << dec << setfill (' ')
-			 << setw (5) << index << ": "
-			 << hex << setfill ('0');
-		}
-	clog << "  " << setw (2) << ((unsigned int)(*data) & 0xFF);
+	__m128i
+		samples = _mm_loadu_si128 ((__m128i*)(data + index));
+	_mm_storeu_si128 ((__m128i*)(data + index),
+		_mm_or_si128
+			(_mm_slli_epi16 (samples, 8), _mm_srli_epi16 (samples, 8)));
 	}
-clog << dec << setfill (' ') << endl;
+swap_bytes_portable (data + index, count - index);
 }
 
+__attribute__ ((target ("avx2")))
+void
+swap_bytes_avx2
+	(
+	unsigned short*	data,
+	size_t			count
+	)
+{
+const __m256i
+	order = _mm256_setr_epi8
+		(1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14,
+		 1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14);
+size_t
+	index = 0;
+for (;
+	 (index + 32) <= count;
+	 index += 32)
+	{
+	//	Two vectors per iteration to keep the load and store ports busy.
+	__m256i
+		samples_0 = _mm256_loadu_si256 ((__m256i*)(data + index)),
+		samples_1 = _mm256_loadu_si256 ((__m256i*)(data + index + 16));
+	_mm256_storeu_si256 ((__m256i*)(data + index),
+		_mm256_shuffle_epi8 (samples_0, order));
+	_mm256_storeu_si256 ((__m256i*)(data + index + 16),
+		_mm256_shuffle_epi8 (samples_1, order));
+	}
+for (;
+	 (index + 16) <= count;
+	 index += 16)
+	_mm256_storeu_si256 ((__m256i*)(data + index),
+		_mm256_shuffle_epi8
+			(_mm256_loadu_si256 ((__m256i*)(data + index)), order));
+swap_bytes_portable (data + index, count - index);
+}
 
+__attribute__ ((target ("avx512f,avx512bw")))
 void
-print_line
+swap_bytes_avx512
 	(
 	unsigned short*	data,
-	unsigned int	count,
-	unsigned int	pixel_stride
+	size_t			count
+	)
+{
+const __m512i
+	order = _mm512_broadcast_i32x4 (_mm_setr_epi8
+		(1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14));
+size_t
+	index = 0;
+for (;
+	 (index + 32) <= count;
+	 index += 32)
+	_mm512_storeu_si512 ((void*)(data + index),
+		_mm512_shuffle_epi8
+			(_mm512_loadu_si512 ((const void*)(data + index)), order));
+if (index < count)
+	{
+	//	Masked remainder.
+	__mmask32
+		mask = (__mmask32)((1ULL << (count - index)) - 1);
+	_mm512_mask_storeu_epi16 ((void*)(data + index), mask,
+		_mm512_shuffle_epi8
+			(_mm512_maskz_loadu_epi16 (mask, (const void*)(data + index)),
+			order));
+	}
+}
+/*	Strided samples are gathered from, and scattered back to, each run
+	of 32 samples with masked loads and stores that only touch the
+	selected samples; the samples of other bands are left alone.
+*/
+__attribute__ ((target ("avx512f,avx512bw")))
+void
+swap_strided_bytes_avx512
+	(
+	unsigned short*	data,
+	size_t			count,
+	unsigned int	stride
+	)
+{
+if (! count)
+	return;
+if (stride > 16)
+	{
+	//	Too few samples in each run to be worth the masking.
+	swap_strided_bytes_portable (data, count, stride);
+	return;
+	}
+const __m512i
+	order = _mm512_broadcast_i32x4 (_mm_setr_epi8
+		(1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14));
+//	The selected samples of a run that starts with a selected sample.
+__mmask32
+	pattern = 0;
+for (unsigned int
+		sample = 0;
+		sample < 32;
+		sample += stride)
+	pattern |= (__mmask32)1 << sample;
+size_t
+	span = (count - 1) * stride + 1,
+	index = 0;
+unsigned int
+	first = 0,	//	The first selected sample of the run.
+	advance = stride - (32 % stride);
+__mmask32
+	mask;
+for (;
+	 index < span;
+	 index += 32,
+	 first = (first + advance) % stride)
+	{
+	mask = (__mmask32)(pattern << first);
+	if ((span - index) < 32)
+		mask &= (__mmask32)((1ULL << (span - index)) - 1);
+	_mm512_mask_storeu_epi16 ((void*)(data + index), mask,
+		_mm512_shuffle_epi8
+			(_mm512_maskz_loadu_epi16 (mask, (const void*)(data + index)),
+			order));
+	}
+}
+#endif	//	SWAP_SAMPLE_BYTES_SIMD
+
+struct Swap_Kernel_Selection
+	{
+	Swap_Kernel
+		Kernel;
+	Strided_Swap_Kernel
+		Strided;
+	const char*
+		Name;
+	};
+
+Swap_Kernel_Selection
+select_swap_kernel ()
+{
+Swap_Kernel_Selection
+	selection =
+		{swap_bytes_portable, swap_strided_bytes_portable, "portable"};
+#if SWAP_SAMPLE_BYTES_SIMD
+__builtin_cpu_init ();
+if (__builtin_cpu_supports ("avx512bw"))
+	{
+	selection.Kernel  = swap_bytes_avx512;
+	selection.Strided = swap_strided_bytes_avx512;
+	selection.Name    = "AVX-512";
+	}
+else
+if (__builtin_cpu_supports ("avx2"))
+	{
+	selection.Kernel = swap_bytes_avx2;
+	selection.Name   = "AVX2";
+	}
+else
+if (__builtin_cpu_supports ("sse2"))
+	{
+	selection.Kernel = swap_bytes_sse2;
+	selection.Name   = "SSE2";
+	}
+#endif
+return selection;
+}
+
+const Swap_Kernel_Selection&
+swap_kernel ()
+{
+static const Swap_Kernel_Selection
+	selection = select_swap_kernel ();
+return selection;
+}
+
+}	//	local namespace.
+#endif	//	DOXYGEN_PROCESSING
+
+
+void
+JP2_Reader::swap_sample_bytes
+	(
+	void*			data,
+	unsigned int	width,
+	unsigned int	height,
+	unsigned int	pixel_stride,
+	unsigned int	line_stride
+	)
+{
+unsigned short*
+	buffer_2 = (unsigned short*)data;
+if (pixel_stride == 1)
+	{
+	//	Contiguous samples in each line.
+	Swap_Kernel
+		kernel = swap_kernel ().Kernel;
+	if (line_stride == width)
+		//	Contiguous lines.
+		kernel (buffer_2, (size_t)width * height);
+	else
+		for (unsigned int
+				line = 0;
+				line < height;
+				line++,
+				buffer_2 += line_stride)
+			kernel (buffer_2, width);
+	return;
+	}
+
+//	Samples of one band interleaved with other bands in each line.
+Strided_Swap_Kernel
+	kernel = swap_kernel ().Strided;
+for (unsigned int
+		line = 0;
+		line < height;
+		line++,
+		buffer_2 += line_stride)
+	kernel (buffer_2, width, pixel_stride);
+}
+
+
+const char*
+JP2_Reader::sample_bytes_swapper ()
+{return swap_kernel ().Name;}
+
+
+
+void
+JP2_Reader::calibrate_samples
+	(
+	unsigned int	band,
+	void*			data,
+	unsigned int	width,
+	unsigned int	height,
+	unsigned int	pixel_stride,
+	unsigned int	line_stride
 	)
+	const
 {
-clog << hex << setfill ('0');
+float
+	scale  = calibration_scale (band),
+	offset = calibration_offset (band);
+if (scale == 1.0f &&
+	offset == 0.0f)
+	return;
+
+float*
+	line_start = (float*)data;
 for (unsigned int
-		index = 0;
-		index < count;
-		index++,
-			data += pixel_stride)
+		line = 0;
+		line < height;
+		line++,
+		line_start += line_stride)
 	{
-	if (! (index % 16))
+	float*
+		sample = line_start;
+	if (pixel_stride == 1)
 		{
-		if (index)
-			clog << endl;
-		clog << dec << setfill (' ')
-			 << setw (5) << index << ": "
-			 << hex << setfill ('0');
+		//	Contiguous samples; a loop the compiler can vectorize.
+		for (unsigned int
+				index = 0;
+				index < width;
+				index++)
+			sample[index] = sample[index] * scale + offset;
+		}
+	else
+		{
+		for (unsigned int
+				index = 0;
+				index < width;
+				index++,
+				sample += pixel_stride)
+			*sample = *sample * scale + offset;
 		}
-	clog << "  " << setw (4) << *data;
 	}
-clog << dec << setfill (' ') << endl;
 }
 
 
+
 void
-print_pixels
-	(
-	void**			image_data,
-	const Cube&		region,
-	const Cube&		rendered_region,
-	unsigned int	line_stride,
-	unsigned int	pixel_stride,
-	unsigned int	pixel_sample_bytes
-	)
+JP2_Reader::prepare_stretch ()
 {
-clog << ">>> print_pixels:" << endl
-	 << "    region " << region << endl
-	 << "        of " << rendered_region << endl
-	 << "           line stride = " << line_stride << endl
-	 << "          pixel stride = " << pixel_stride << endl
-	 << "    pixel sample bytes = " << pixel_sample_bytes << endl;
-size_t
-	offset =
-		  ((region.X - rendered_region.X)	//	Horizontal, pixels, offset.
-			* pixel_stride)					//	Pixel size in bytes.
-		+ ((region.Y - rendered_region.Y)	//	Vertical, lines, offset.
-			* pixel_stride * line_stride);	//	Line length in bytes.
-clog << "    first pixel offset = " << offset << endl;
-int
-	last_line = region.Y +
-		#if ((DEBUG) & DEBUG_ONE_LINE)
-		1;
-		#else
-		region.Height;
-		#endif
-unsigned char
-	*last_line_data,
-	*this_line_data,
-	*data_end,
-	*buffer_1 = NULL;
-unsigned short
-	*buffer_2 = NULL;
-
+#if ((DEBUG) & DEBUG_RENDER)
+clog << ">>> JP2_Reader::prepare_stretch" << endl;
+#endif
+unsigned int
+	bands = image_bands (),
+	entries = 1 << rendered_pixel_bits ();
+std::vector<std::vector<unsigned long long> >
+	histograms;
+bool
+	histograms_obtained = false;
+Stretch_Tables.assign (bands, std::vector<unsigned char> ());
 for (unsigned int
 		band = 0;
-		band < region.Depth;
+		band < bands;
 		band++)
 	{
-	if (image_data[band])
+	if (! Rendered_Bands[band])
+		continue;
+	std::vector<unsigned char>
+		&table = Stretch_Tables[band];
+	switch (stretch_method (band))
 		{
-		clog << endl
-			 << "--> Image_Data[" << band << "] @ "
-				<< image_data[band] << endl;
-		if (pixel_sample_bytes == 1)
-			buffer_1 =
-				(unsigned char*)image_data[band] + offset;
-		else
-			buffer_2 =
-				(unsigned short*)image_data[band] + offset;
-		int
-			matches = 0,
-			line = region.Y;
-		for (line = region.Y;
-			 line < last_line;
-			 line++)
-			{
-			if (line != region.Y)
+		case STRETCH_TABLE:
+			table = Stretches[band].Table;
+			table.resize (entries, table.back ());
+			break;
+		case STRETCH_LINEAR:
+			linear_table (table, entries,
+				Stretches[band].Low, Stretches[band].High);
+			break;
+		case STRETCH_PERCENTILE:
+			if (! histograms_obtained)
 				{
-				if (buffer_1)
-					{
-					last_line_data = buffer_1 - line_stride;
-					this_line_data = buffer_1;
-					data_end = buffer_1 + region.Width;
-					}
-				else
-					{
-					last_line_data = (unsigned char*)(buffer_2 - line_stride);
-					this_line_data = (unsigned char*)buffer_2;
-					data_end = (unsigned char*)(buffer_2 + region.Width);
-					}
-				while (this_line_data < data_end)
-					if (*last_line_data++ != *this_line_data++)
-						break;
-				if (this_line_data == data_end)
-					++matches;
-				else
-					matches = -matches;
+				stretch_histograms (histograms);
+				histograms_obtained = true;
 				}
-			if (matches <= 0)
+			if (band < histograms.size () &&
+				histograms[band].size () == entries)
 				{
-				if (matches < 0)
-					{
-					clog << "line " << (line + matches);
-					if (matches != -1)
-						clog << " - " << (line - 1);
-					clog << " matches the previous line." << endl;
-					matches = 0;
-					}
-				clog << "line " << line << " @ ";
-				if (buffer_1)
-					{
-					clog << (void*)buffer_1 << " -" << endl;
-					print_line (buffer_1, region.Width, pixel_stride);
-					buffer_1 += line_stride;
-					}
-				else
-					{
-					clog << (void*)buffer_2 << " -" << endl;
-					print_line (buffer_2, region.Width, pixel_stride);
-					buffer_2 += line_stride;
-					}
+				unsigned int
+					low  = percentile_value
+						(histograms[band], Stretches[band].Low),
+					high = percentile_value
+						(histograms[band], Stretches[band].High);
+				#if ((DEBUG) & DEBUG_RENDER)
+				clog << "    band " << band << " percentile stretch "
+						<< low << '-' << high << endl;
+				#endif
+				if (high <= low)
+					high = low + 1;
+				linear_table (table, entries, low, high);
+				break;
 				}
-			}
-		if (matches)
-			{
-			clog << "line " << (line - matches);
-			if (matches != 1)
-				clog << " - " << (line - 1);
-			clog << " matches the previous line." << endl;
-			}
+			//	No histogram; stretch the full range.
+		default:
+			linear_table (table, entries, 0, entries - 1);
 		}
+	table.resize (entries + STRETCH_TABLE_PADDING, table.back ());
 	}
-clog << "<<< print_pixels" << endl;
+#if ((DEBUG) & DEBUG_RENDER)
+clog << "<<< JP2_Reader::prepare_stretch" << endl;
+#endif
 }
 
-}	//	local namespace.
-#endif
-#endif
 
+void
+JP2_Reader::stretch_histograms
+	(
+	std::vector<std::vector<unsigned long long> >&
+	)
+{}
 
-/*------------------------------------------------------------------------------
-	Decompressed pixel data byte swapping and monitor notification.
+#ifndef DOXYGEN_PROCESSING
+namespace
+{
+/*	Map a line of samples through a lookup table.
+
+	Contiguous pixels are mapped in groups of eight, all table lookups
+	of a group before any stores, so the lookups are independent of
+	each other and may be done by vector gather instructions; this also
+	allows the destination to overwrite the source samples in place.
 */
-bool
-JP2_Reader::data_disposition
+template<typename Sample>
+void
+map_line
 	(
-	Rendering_Monitor::Status	status,
-	const std::string&			message,
-	const Cube&					region,
-	const Cube&					image_region_rendered
+	const Sample*			source,
+	unsigned char*			destination,
+	unsigned int			pixel_stride,
+	unsigned int			width,
+	const unsigned char*	table,
+	unsigned int			mask
 	)
 {
-#if ((DEBUG) & (DEBUG_DISPOSITION | DEBUG_PIXEL_DATA | DEBUG_LOCATION))
-clog << ">>> JP2_Reader::data_disposition:" << endl
-	 << "    status " << status << " \"" << message << '"' << endl
-	 << "    source \"" << source_name () << '"' << endl
-	 << "    size " << image_size ()
-	 	<< ", resolution level " << resolution_level ()
-		<< ", " << rendered_pixel_bytes () << " byte pixel data" << endl
-	 << "    region rendered " << region << endl
-	 << "                 of " << Rendered_Region << endl
-	 << "     image rendered " << image_region_rendered << endl
-	 << "                 of " << Image_Region << endl;
-#endif
-if (Swap_Pixel_Bytes &&
-	rendered_pixel_bytes () > 1 &&
-	region.area ())
+unsigned int
+	index = 0;
+if (pixel_stride == 1)
 	{
-	// Swap byte order.
-	#if ((DEBUG) & DEBUG_DISPOSITION)
-	clog << "    Swapping pixel bytes ..." << endl;
-	#endif
-	unsigned int
-		pixel_gap = pixel_stride (),
-		line_gap = line_stride ();
-	size_t
-		offset =
-			  ((region.X - Rendered_Region.X)	//	Horizontal, pixels, offset.
-				* pixel_gap)					//	Pixel stride samples.
-			+ ((region.Y - Rendered_Region.Y)	//	Vertical, lines, offset.
-				* line_gap);					//	Line stride in samples.
-	#if ((DEBUG) & DEBUG_DISPOSITION)
-	clog << "            pixel_stride = " << pixel_stride () << endl
-		 << "             line_stride = " << line_stride () << endl
-		 << "     first sample offset = " << offset << endl;
-	#endif
-	unsigned char*
-		buffer_1;
-	unsigned short*
-		buffer_2;
 	unsigned char
-		datum;
-	pixel_gap <<= 1;	//	Convert from samples to bytes.
-	for (unsigned int
-			band = 0;
-			band < region.Depth;
-			band++)
+		pixels[8];
+	for (;
+		 index + 8 <= width;
+		 index += 8)
 		{
-		if (Image_Data[band])
-			{
-			buffer_2 =
-				(unsigned short*)Image_Data[band] + offset;
-			for (unsigned int
-					line = 0;
-					line < region.Height;
-					line++,
-					buffer_2 += line_gap)
-				{
-				buffer_1 = (unsigned char*)buffer_2;
-				for (unsigned int
-						sample = 0;
-						sample < region.Width;
-						sample++,
-						buffer_1 += pixel_gap)
-					{
-					datum = *buffer_1;
-					*buffer_1 = *(buffer_1 + 1);
-					*(buffer_1 + 1) = datum;
-					}
-				}
-			}
+		for (unsigned int
+				pixel = 0;
+				pixel < 8;
+				pixel++)
+			pixels[pixel] = table[source[index + pixel] & mask];
+		std::memcpy (destination + index, pixels, 8);
 		}
+	for (;
+		 index < width;
+		 index++)
+		destination[index] = table[source[index] & mask];
 	}
-#if ((DEBUG) & DEBUG_PIXEL_DATA)
-if (region.area ())
-	print_pixels (Image_Data, region, Rendered_Region,
-		line_stride (), pixel_stride (), rendered_pixel_bytes ());
-#endif
+else
+	{
+	for (;
+		 index < width;
+		 index++,
+		 destination += pixel_stride)
+		*destination = table[source[index] & mask];
+	}
+}
 
-bool
-	continue_rendering = true;
-if (Monitor)
+/*	16-bit sample stretching kernels.
+
+	Each kernel maps width contiguous samples through a lookup table to
+	contiguous 8-bit pixels. The pixels may overwrite the samples in
+	place.
+*/
+typedef void (*Map_Kernel) (const unsigned short*, unsigned char*,
+	unsigned int, const unsigned char*, unsigned int);
+
+void
+map_samples_portable
+	(
+	const unsigned short*	source,
+	unsigned char*			destination,
+	unsigned int			width,
+	const unsigned char*	table,
+	unsigned int			mask
+	)
+{map_line (source, destination, 1, width, table, mask);}
+
+#if STRETCH_SAMPLES_SIMD
+/*	Sixteen samples are widened to 32-bit table indices that gather
+	the table entries. The samples are all loaded before the pixels are
+	stored, and the pixels are stored below the samples that remain to
+	be loaded, so the pixels may overwrite the samples in place.
+*/
+__attribute__ ((target ("avx2")))
+void
+map_samples_avx2
+	(
+	const unsigned short*	source,
+	unsigned char*			destination,
+	unsigned int			width,
+	const unsigned char*	table,
+	unsigned int			mask
+	)
+{
+const __m256i
+	index_mask = _mm256_set1_epi32 ((int)mask),
+	byte_mask  = _mm256_set1_epi32 (0xFF);
+unsigned int
+	index = 0;
+for (;
+	 (index + 16) <= width;
+	 index += 16)
 	{
-	//	Notify the Rendering_Monitor of the rendering progress.
-	#if ((DEBUG) & (DEBUG_DISPOSITION | DEBUG_NOTIFY | DEBUG_LOCATION))
-	clog << "*** JP2_Reader::data_disposition: notify status "
-			<< status << " \"" << message << '"' << endl
-		 << "    region = " << region << endl;
-	#endif
-	continue_rendering =
-		Monitor->notify (*this, status, message, region, image_region_rendered);
+	__m256i
+		samples = _mm256_loadu_si256 ((const __m256i*)(source + index)),
+		indices_0 = _mm256_and_si256 (index_mask,
+			_mm256_cvtepu16_epi32 (_mm256_castsi256_si128 (samples))),
+		indices_1 = _mm256_and_si256 (index_mask,
+			_mm256_cvtepu16_epi32 (_mm256_extracti128_si256 (samples, 1))),
+		//	The low byte of each gathered word is the table entry.
+		pixels_0 = _mm256_and_si256 (byte_mask,
+			_mm256_i32gather_epi32 ((const int*)table, indices_0, 1)),
+		pixels_1 = _mm256_and_si256 (byte_mask,
+			_mm256_i32gather_epi32 ((const int*)table, indices_1, 1)),
+		//	Pack to 16-bit words in pixel order.
+		words = _mm256_permute4x64_epi64
+			(_mm256_packus_epi32 (pixels_0, pixels_1), 0xD8);
+	_mm_storeu_si128 ((__m128i*)(destination + index),
+		_mm_packus_epi16 (_mm256_castsi256_si128 (words),
+			_mm256_extracti128_si256 (words, 1)));
+	}
+map_line (source + index, destination + index, 1, width - index,
+	table, mask);
+}
+#endif	//	STRETCH_SAMPLES_SIMD
+
+struct Map_Kernel_Selection
+	{
+	Map_Kernel
+		Kernel;
+	const char*
+		Name;
+	};
+
+Map_Kernel_Selection
+select_map_kernel ()
+{
+Map_Kernel_Selection
+	selection = {map_samples_portable, "portable"};
+#if STRETCH_SAMPLES_SIMD
+__builtin_cpu_init ();
+if (__builtin_cpu_supports ("avx2"))
+	{
+	selection.Kernel = map_samples_avx2;
+	selection.Name   = "AVX2";
 	}
-#if ((DEBUG) & (DEBUG_DISPOSITION | DEBUG_PIXEL_DATA | DEBUG_LOCATION))
-clog << "<<< JP2_Reader::data_disposition: "
-		<< boolalpha << continue_rendering << endl;
 #endif
-return continue_rendering;
+return selection;
+}
+
+const Map_Kernel_Selection&
+map_kernel ()
+{
+static const Map_Kernel_Selection
+	selection = select_map_kernel ();
+return selection;
+}
+}	//	local namespace
+#endif	//	DOXYGEN_PROCESSING
+
+
+void
+JP2_Reader::stretch_samples
+	(
+	unsigned int	band,
+	const void*		source,
+	unsigned int	source_line_stride,
+	unsigned char*	destination,
+	unsigned int	pixel_stride,
+	unsigned int	line_stride,
+	unsigned int	width,
+	unsigned int	height
+	)
+	const
+{
+if (band >= Stretch_Tables.size () ||
+	Stretch_Tables[band].empty ())
+	return;
+
+const unsigned char
+	*table = &Stretch_Tables[band][0];
+unsigned int
+	mask = Stretch_Tables[band].size () - STRETCH_TABLE_PADDING - 1;
+if (decoded_pixel_bytes () == 1)
+	{
+	const unsigned char
+		*samples = (const unsigned char*)source;
+	for (unsigned int
+			line = 0;
+			line < height;
+			line++,
+			samples += source_line_stride,
+			destination += line_stride)
+		map_line (samples, destination, pixel_stride, width, table, mask);
+	}
+else
+if (pixel_stride == 1)
+	{
+	//	Contiguous pixels.
+	Map_Kernel
+		kernel = map_kernel ().Kernel;
+	const unsigned short
+		*samples = (const unsigned short*)source;
+	for (unsigned int
+			line = 0;
+			line < height;
+			line++,
+			samples += source_line_stride,
+			destination += line_stride)
+		kernel (samples, destination, width, table, mask);
+	}
+else
+	{
+	const unsigned short
+		*samples = (const unsigned short*)source;
+	for (unsigned int
+			line = 0;
+			line < height;
+			line++,
+			samples += source_line_stride,
+			destination += line_stride)
+		map_line (samples, destination, pixel_stride, width, table, mask);
+	}
 }
 
+
+const char*
+JP2_Reader::sample_stretcher ()
+{return map_kernel ().Name;}
+
 /*==============================================================================
 	Utility
 */
@@ -26,12 +26,17 @@ Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA.
 
 #include	"JP2_Metadata.hh"
 #include	"JP2_Exception.hh"
+#include	"JP2_Tile_Cache.hh"
 
 //	PIRL++
 #include	"Dimensions.hh"
 
 #include	<string>
 #include	<vector>
+#include	<future>
+#include	<mutex>
+#include	<atomic>
+#include	<memory>
 
 //	Provides stringification of #defined names.
 #ifdef  STRINGIFIED
@@ -98,6 +103,15 @@ enum Image_Data_Format
 static const char* const
 	FORMAT_DESCRIPTIONS[];
 
+//!	Specifies how a band is {@link stretching() stretched} to 8-bit pixels.
+enum Stretch_Method
+	{
+	STRETCH_NONE = 0,
+	STRETCH_TABLE = 1,
+	STRETCH_LINEAR = 2,
+	STRETCH_PERCENTILE = 3
+	};
+
 /**	The {@link render_band(unsigned int, bool) band rendering selection}
 	applies to all image bands.
 */
@@ -111,6 +125,51 @@ static const unsigned int
 static const unsigned long long
 	DEFAULT_RENDERING_INCREMENT_BYTES;
 
+/**	Processor cache bytes for each processing thread used when the
+	cache size can not be determined for an {@link
+	adaptive_rendering_increment(bool) adaptive rendering increment}.
+
+	The default is 1 MB.
+*/
+static const unsigned long long
+	DEFAULT_CACHE_BYTES;
+
+/**	The default alignment, in bytes, of locally managed image data
+	buffers.
+
+	The default is 64 bytes; a processor cache line.
+*/
+static const size_t
+	DEFAULT_BUFFER_ALIGNMENT;
+
+/**	The number of increment buffers used for {@link
+	line_sink(Line_Sink*) line sink} rendering with {@link
+	pipelined_disposition(bool) pipelined data disposition}.
+
+	The default is 2; one increment buffer being delivered to the line
+	sink while the next is being rendered.
+*/
+static const unsigned int
+	LINE_SINK_BUFFERS;
+
+/**	The maximum number of pixels rendered by the low resolution pre-pass
+	that determines the sample values of a {@link
+	percentile_stretch(unsigned int, double, double) percentile stretch}.
+
+	The default is 65536 (a 256x256 pixel region).
+*/
+static const unsigned int
+	STRETCH_SAMPLE_PIXELS;
+
+/**	The default number of code-blocks of decompression work for each
+	{@link adaptive_processing_threads(bool) adaptively} selected
+	processing thread.
+
+	The default is 16.
+*/
+static const unsigned int
+	DEFAULT_THREAD_WORK_CODE_BLOCKS;
+
 /*==============================================================================
 	Defaults
 */
@@ -203,6 +262,365 @@ struct Rendering_Monitor
 	virtual ~Rendering_Monitor () {}
 	};
 
+/**	Receives rendered image lines.
+
+	A Line_Sink may be {@link line_sink(Line_Sink*) registered} with a
+	reader to have the rendered image data delivered, one rendering
+	increment at a time, instead of being rendered into {@link
+	image_data(void**, unsigned long long) image data} buffers that hold
+	the entire rendered region. This allows an image region that is too
+	large to fit in memory to be streamed to a file or a downstream
+	processing filter.
+*/
+class Line_Sink
+	{
+	public:
+
+	/**	Deliver rendered image lines.
+
+		The lines are contiguous, full width, lines of the {@link
+		rendered_region() rendered region} for a single image band. The
+		pixel samples are {@link rendered_pixel_bytes() rendered pixel
+		bytes} in size and are adjacent within each line.
+
+		<b>N.B.</b>: The data is only valid for the duration of the call.
+
+		@param	JP2_reader	The JP2_Reader that rendered the lines.
+		@param	band	The image band of the lines.
+		@param	first_line	The line number, relative to the first line
+			of the rendered region, of the first line delivered.
+		@param	line_count	The number of lines delivered.
+		@param	data	The address of the first pixel sample of the
+			first line.
+		@param	line_stride	The distance, in samples, between
+			vertically adjacent pixels.
+		@return	true if rendering is to continue; false if rendering is
+			to be canceled.
+	*/
+	virtual bool lines (JP2_Reader& JP2_reader, unsigned int band,
+		unsigned int first_line, unsigned int line_count,
+		const void* data, unsigned int line_stride) = 0;
+
+	virtual ~Line_Sink () {}
+	};
+
+/**	Provides locally managed image data buffers.
+
+	An Image_Buffer_Allocator may be {@link
+	image_buffer_allocator(Image_Buffer_Allocator*) registered} with a
+	reader to provide the image data buffer that the reader allocates
+	when the image data buffers are not {@link user_buffer() provided by
+	the user}; for example from a pool of buffers or a custom memory
+	arena. The {@link Aligned_Buffer_Allocator} is used by default.
+*/
+class Image_Buffer_Allocator
+	{
+	public:
+
+	/**	Allocate an image data buffer.
+
+		@param	bytes	The size of the buffer in bytes.
+		@return	The address of the buffer. The address must be aligned
+			to the {@link alignment() alignment}. NULL, or a thrown
+			std::bad_alloc, signals that the buffer could not be
+			allocated.
+	*/
+	virtual void* allocate (size_t bytes) = 0;
+
+	/**	Deallocate an image data buffer.
+
+		@param	buffer	The address of a buffer provided by {@link
+			allocate(size_t) allocate}.
+		@param	bytes	The size of the buffer in bytes as specified when
+			it was allocated.
+	*/
+	virtual void deallocate (void* buffer, size_t bytes) = 0;
+
+	/**	Get the buffer alignment.
+
+		@return	The alignment, in bytes, of the buffer addresses. This
+			is used to {@link pad_image_lines(bool) pad} image lines.
+	*/
+	virtual size_t alignment () const
+		{return DEFAULT_BUFFER_ALIGNMENT;}
+
+	virtual ~Image_Buffer_Allocator () {}
+	};
+
+/**	Allocates aligned image data buffers.
+
+	Buffers are aligned to the {@link alignment() alignment}. Optionally
+	the buffers are advised to use transparent huge pages, to reduce TLB
+	misses on very large renderings, and may be pre-faulted so that the
+	page faults of first touch do not occur during rendering.
+
+	<b>N.B.</b>: Huge pages are only available on Linux hosts.
+*/
+class Aligned_Buffer_Allocator
+:	public Image_Buffer_Allocator
+	{
+	public:
+
+	/**	Construct an Aligned_Buffer_Allocator.
+
+		@param	alignment	The buffer alignment in bytes. This is
+			rounded up to a power of two that is at least the size of a
+			pointer.
+		@param	huge_pages	true if buffers are to use transparent huge
+			pages.
+		@param	prefault	true if buffer pages are to be pre-faulted.
+	*/
+	explicit Aligned_Buffer_Allocator
+		(size_t alignment = DEFAULT_BUFFER_ALIGNMENT,
+		bool huge_pages = false, bool prefault = false);
+
+	virtual void* allocate (size_t bytes);
+	virtual void deallocate (void* buffer, size_t bytes);
+
+	virtual size_t alignment () const
+		{return Alignment;}
+
+	//!	Test if buffers use transparent huge pages.
+	inline bool huge_pages () const
+		{return Huge_Pages;}
+
+	//!	Test if buffer pages are pre-faulted.
+	inline bool prefault () const
+		{return Prefault;}
+
+	private:
+
+	size_t
+		Alignment;
+	bool
+		Huge_Pages,
+		Prefault;
+	};
+
+/**	A request to render an image region.
+
+	A batch of Region_Requests may be {@link
+	render(std::vector<Region_Request>&) rendered} in a single operation.
+	Each request specifies its own image region, resolution level, image
+	bands and destination pixel data buffers independent of the reader's
+	rendering configuration. The reader's {@link rendered_pixel_bits()
+	rendered pixel bits}, {@link swap_pixel_bytes() pixel bytes swapping}
+	and {@link image_data_format() image data format} apply to all
+	requests.
+
+	When a request has been rendered its Rendered_Region and Image_Region
+	are set to the regions that were rendered.
+*/
+struct Region_Request
+	{
+	/**	The image region to render on the full resolution grid.
+		If empty the entire image is selected.
+	*/
+	Rectangle
+		Region;
+
+	//!	The resolution level at which to render the region.
+	unsigned int
+		Resolution_Level;
+
+	/**	Map of image bands to be rendered.
+		If empty all bands with a pixel data buffer are rendered.
+	*/
+	Band_Map
+		Bands;
+
+	/**	Pixel data buffers.
+
+		This array must have an entry for each {@link image_bands() image
+		band}. An entry is the address of the pixel data buffer for the
+		band, or NULL if the band is not to be rendered.
+	*/
+	void
+		**Image_Data;
+
+	//!	Size, in bytes, of each pixel data buffer (zero means unchecked).
+	unsigned long long
+		Buffer_Size;
+
+	/**	Distance, in samples, between horizontally adjacent pixels, and
+		vertically adjacent lines. If zero the value is determined by the
+		reader's image data format for the request's rendered region.
+	*/
+	unsigned int
+		Pixel_Stride,
+		Line_Stride;
+
+	//!	Region rendered on the rendering resolution grid.
+	Cube
+		Rendered_Region;
+
+	//!	Region rendered on the full resolution grid.
+	Cube
+		Image_Region;
+
+	Region_Request
+		(
+		const Rectangle&	region = Rectangle (),
+		unsigned int		resolution_level = 1,
+		void**				image_data = NULL,
+		unsigned long long	buffer_size = 0
+		)
+		:	Region (region),
+			Resolution_Level (resolution_level),
+			Bands (),
+			Image_Data (image_data),
+			Buffer_Size (buffer_size),
+			Pixel_Stride (0),
+			Line_Stride (0)
+		{}
+	};
+
+/**	A cancellation token for an asynchronous rendering operation.
+
+	A Rendering_Cancellation is provided to {@link
+	render_async(Rendering_Cancellation*) render_async} which binds it to
+	the reader for the duration of the asynchronous rendering. Copies of
+	a Rendering_Cancellation share the same cancellation state, so a
+	copy may be handed to whatever thread is to cancel the rendering
+	(e.g. the event loop of an interactive viewer).
+
+	A token is intended to be used for a single rendering operation: a
+	token that has already been canceled will cancel the rendering it
+	is bound to as soon as it starts.
+*/
+class Rendering_Cancellation
+	{
+	public:
+
+	Rendering_Cancellation ();
+
+	/**	Cancel the rendering.
+
+		If the token is bound to a reader that is rendering the reader's
+		{@link cancel_rendering() cancel_rendering} method is called.
+		It is safe to call this method from any thread, and more than
+		once.
+	*/
+	void cancel ();
+
+	/**	Test if the rendering has been canceled.
+
+		@return	true if the token has been {@link cancel() canceled};
+			false otherwise.
+	*/
+	bool canceled () const;
+
+	private:
+
+	friend class JP2_Reader;
+
+	struct State
+		{
+		std::mutex
+			Lock;
+		std::atomic<bool>
+			Canceled;
+		//	The reader that is rendering; NULL when not bound.
+		JP2_Reader
+			*Reader;
+
+		State () : Canceled (false), Reader (NULL) {}
+		};
+
+	std::shared_ptr<State>
+		Cancellation_State;
+	};
+
+/**	Timing and throughput statistics of a rendering.
+
+	The statistics are collected for every {@link render() rendering},
+	whatever the build configuration, and are available from {@link
+	last_render_statistics() last_render_statistics} when the rendering
+	has completed. Collection uses a monotonic clock and the process CPU
+	clock once per rendering increment, so its cost is negligible
+	relative to the decompression of an increment.
+
+	Times are in seconds. CPU times are for the process as a whole, so
+	they include the time of all processing threads.
+*/
+struct Render_Statistics
+	{
+	/**	Time to open the source, including the ingest of its metadata,
+		when it was last opened.
+	*/
+	double
+		Open_Seconds;
+
+	//!	Time to ingest the source metadata when it was last opened.
+	double
+		Ingest_Seconds;
+
+	//!	Elapsed time of the rendering.
+	double
+		Render_Seconds;
+
+	//!	CPU time of the rendering.
+	double
+		Render_CPU_Seconds;
+
+	/**	Elapsed time decompressing increments.
+
+		This includes starting the decompression of each increment and
+		any buffer allocation before the first increment, but not the
+		time waiting for data acquisition or in data disposition.
+	*/
+	double
+		Decode_Seconds;
+
+	//!	CPU time decompressing increments.
+	double
+		Decode_CPU_Seconds;
+
+	//!	Longest elapsed time decompressing a single increment.
+	double
+		Max_Increment_Seconds;
+
+	//!	Time waiting for codestream data acquisition (JPIP sources).
+	double
+		Acquisition_Seconds;
+
+	/**	Time spent by the rendering in {@link data_disposition(
+		Rendering_Monitor::Status, const std::string&, const Cube&,
+		const Cube&, void**, unsigned int) data disposition}.
+
+		With {@link pipelined_disposition(bool) pipelined disposition}
+		this is the time to swap the increment bytes and hand the
+		increment to the disposition thread.
+	*/
+	double
+		Disposition_Seconds;
+
+	//!	Image data bytes rendered.
+	unsigned long long
+		Bytes_Rendered;
+
+	//!	Rendering increments decompressed.
+	unsigned int
+		Increments;
+
+	//!	Codestream data acquisitions (JPIP sources).
+	unsigned int
+		Acquisitions;
+
+	//!	Processing threads used for decompression.
+	unsigned int
+		Threads;
+
+	//!	Largest size, in bytes, of the image data buffers held.
+	unsigned long long
+		Peak_Buffer_Bytes;
+
+	Render_Statistics ();
+
+	//!	Reset all statistics to zero.
+	void clear ();
+	};
+
 /*==============================================================================
 	Constructors
 */
@@ -217,8 +635,12 @@ JP2_Reader ();
 	The new JP2_Reader will be {@link open() open} and ready to use.
 
 	@param	JP2_reader	The JP2_Reader to be copied.
+	@param	share_metadata	If true, the {@link metadata_parameters()
+		metadata parameters} are shared with the JP2_reader instead of
+		being copied.
+	@see	JP2_Metadata(const JP2_Metadata&, bool)
 */
-JP2_Reader (const JP2_Reader& JP2_reader);
+JP2_Reader (const JP2_Reader& JP2_reader, bool share_metadata = false);
 
 /**	Destroy this JP2_Reader.
 */
@@ -357,6 +779,9 @@ inline void** image_data (unsigned long long* buffer_size = NULL) const
 
 /**	Get the image data address for an image location.
 
+	The address accounts for {@link chunked_image_data() chunked} image
+	data.
+
 	@param	band	A rendered image band index; zero is the first band.
 	@param	line	The index of a line in the band; zero is the first
 		line of the rendered region.
@@ -383,6 +808,112 @@ void* image_data (unsigned int band,
 inline bool user_buffer () const
 	{return User_Buffer;}
 
+/**	Enable or disable separate band buffers.
+
+	When separate band buffers are enabled the locally managed image
+	data of each rendered band is allocated as a separate buffer, rather
+	than all bands in a single buffer. This is only possible for the
+	FORMAT_BSQ {@link image_data_format(Image_Data_Format) image data
+	format}; for the FORMAT_BIP and FORMAT_BIL formats the bands are
+	interleaved and a buffer always holds all bands.
+
+	Separate band buffers, like {@link image_data_chunk_lines(unsigned
+	int) image data chunks}, allow very large image regions to be
+	rendered without a single giant allocation. The image data is then
+	{@link chunked_image_data() chunked}.
+
+	Separate band buffers are initially disabled.
+
+	@param	enable	true to allocate separate band buffers; false
+		otherwise.
+	@return	This JP2_Reader.
+*/
+JP2_Reader& separate_band_buffers (bool enable);
+
+/**	Test if separate band buffers are enabled.
+
+	@return	true if separate band buffers are enabled; false otherwise.
+	@see	separate_band_buffers(bool)
+*/
+inline bool separate_band_buffers () const
+	{return Separate_Band_Buffers;}
+
+/**	Set the number of lines in each image data chunk.
+
+	When image data chunk lines are specified the locally managed image
+	data is allocated as a sequence of chunks, each holding the
+	specified number of lines of the {@link rendered_region() rendered
+	region} (the last chunk may hold fewer lines). Each chunk is a
+	separate buffer that holds all bands, unless {@link
+	separate_band_buffers(bool) separate band buffers} are enabled in
+	which case each band of each chunk is a separate buffer. The image
+	data is then {@link chunked_image_data() chunked}.
+
+	Image data chunks are initially disabled.
+
+	@param	lines	The number of lines in each image data chunk. If zero
+		the image data is not divided into row chunks.
+	@return	This JP2_Reader.
+*/
+JP2_Reader& image_data_chunk_lines (unsigned int lines);
+
+/**	Get the number of lines in each image data chunk.
+
+	@return	The number of lines in each image data chunk. This will be
+		zero if the image data is not divided into row chunks.
+	@see	image_data_chunk_lines(unsigned int)
+*/
+inline unsigned int image_data_chunk_lines () const
+	{return Chunk_Lines;}
+
+/**	Test if the image data is chunked.
+
+	The image data is chunked when it is locally managed (not {@link
+	user_buffer() user buffers}), is in a named {@link
+	image_data_format(Image_Data_Format) image data format}, and either
+	{@link separate_band_buffers(bool) separate band buffers} or {@link
+	image_data_chunk_lines(unsigned int) image data chunks} are enabled.
+
+	<b>N.B.</b>: When the image data is chunked the {@link
+	image_data(unsigned long long*) image data buffers} array only
+	addresses the first chunk. Use the {@link image_data_chunk(unsigned
+	int) image data chunk} band addresses, or the {@link
+	image_data(unsigned int, unsigned int, unsigned int) image data
+	address} of each line, to traverse the image data.
+
+	@return	true if the image data is chunked; false otherwise.
+*/
+bool chunked_image_data () const;
+
+/**	Get the number of lines in each chunk of the rendered region.
+
+	@return	The number of lines of the {@link rendered_region() rendered
+		region} in each image data chunk. This is the rendered region
+		height if the image data is not divided into row chunks.
+*/
+unsigned int effective_chunk_lines () const;
+
+/**	Get the number of allocated image data chunks.
+
+	@return	The number of image data chunks. This will be zero if the
+		image data is not {@link chunked_image_data() chunked} or has
+		not yet been allocated.
+*/
+inline unsigned int image_data_chunks () const
+	{return (unsigned int)Chunk_Data.size ();}
+
+/**	Get the image data band addresses of a chunk.
+
+	@param	chunk	The index of an image data chunk. Chunk c holds the
+		lines of the {@link rendered_region() rendered region} starting
+		at line c * {@link effective_chunk_lines() effective chunk lines}.
+	@return	An array of band addresses of the first line of the chunk,
+		with an entry for each {@link image_bands() image band}; NULL
+		entries are for bands that are not rendered. This will be NULL
+		if the chunk does not exist.
+*/
+void** image_data_chunk (unsigned int chunk);
+
 /**	Set the image data format structure.
 
 	A named image data structure is used to indirectly specify the {@link
@@ -558,7 +1089,8 @@ unsigned int pixel_stride () const;
 
 /**	Get the image data buffer line stride.
 
-	@return	The line stride distance in pixel samples.
+	@return	The line stride distance in pixel samples. This includes any
+		{@link pad_image_lines(bool) image line padding}.
 	@see	image_data_format(unsigned int, unsigned int)
 */
 unsigned int line_stride () const;
@@ -717,6 +1249,72 @@ inline JP2_Reader& resolution_level (unsigned int level)
 inline unsigned int resolution_level () const
 	{return Resolution_Level;}
 
+/**	Set the maximum number of quality layers to be rendered.
+
+	Only the first layers of each codestream packet are decoded, and
+	for a JPIP source only those layers are requested from the server.
+	This trades image fidelity for speed, which is useful for thumbnails
+	and previews of layered codestreams.
+
+	The number of layers may be set before the source is opened, when
+	the {@link quality_layers() number of quality layers} in the
+	codestream is not yet known; it is limited to that number when the
+	source is rendered.
+
+	@param	layers	The maximum number of quality layers to be rendered.
+		Zero means all layers, which is the initial value.
+	@return	This JP2_Reader.
+	@throws	JP2_Invalid_Argument	If the number of layers exceeds the
+		{@link quality_layers() number of quality layers} in the
+		codestream, when that is known.
+*/
+JP2_Reader& rendered_quality_layers (unsigned int layers);
+
+/**	Get the maximum number of quality layers to be rendered.
+
+	@return	The maximum number of quality layers to be rendered. Zero
+		means all layers.
+	@see	rendered_quality_layers(unsigned int)
+*/
+inline unsigned int rendered_quality_layers () const
+	{return Rendered_Quality_Layers;}
+
+/**	Set progressive rendering.
+
+	With progressive rendering a preview of the rendered region is
+	first decoded at a coarser resolution level from the first quality
+	layer, upsampled into the image data buffers, and the {@link
+	rendering_monitor(Rendering_Monitor*) rendering monitor} is notified
+	with the {@link Rendering_Monitor::LOW_QUALITY_DATA} status for the
+	entire rendered region. The image is then rendered as usual, which
+	refines the preview with {@link
+	Rendering_Monitor::TOP_QUALITY_DATA} notifications.
+
+	Progressive rendering applies to image data buffer rendering of a
+	local file source. It is not used when there is a {@link
+	line_sink(Line_Sink*) line sink} or the image is {@link stretching()
+	stretched}.
+
+	@param	levels	The number of resolution levels coarser than the
+		{@link resolution_level() rendering resolution level} at which
+		the preview is decoded, limited to the resolution levels that are
+		available. Zero disables progressive rendering, which is the
+		initial value.
+	@return	This JP2_Reader.
+*/
+inline JP2_Reader& progressive_rendering (unsigned int levels)
+	{Progressive_Levels = levels; return *this;}
+
+/**	Get the progressive rendering levels.
+
+	@return	The number of resolution levels coarser than the rendering
+		resolution level at which a preview is decoded. Zero if
+		progressive rendering is disabled.
+	@see	progressive_rendering(unsigned int)
+*/
+inline unsigned int progressive_rendering () const
+	{return Progressive_Levels;}
+
 /**	Get the rendered image region.
 
 	The rendered image region is the {@link image_region() image region}
@@ -774,7 +1372,8 @@ inline unsigned int rendered_height () const
 	order and the JP2 file does not specify the order. Therefor, if the
 	JP2 codestream is known, a priori, to produce LSB (least significant
 	byte first) multi-byte pixel samples, then pixel byte swapping should
-	be set.
+	be set. Pixel bytes are not swapped when {@link float_samples(bool)
+	floating point samples} are rendered.
 
 	@param	swap_data	true if multi-byte pixels are to be reordered
 		when rendering; false otherwise.
@@ -821,11 +1420,158 @@ inline unsigned int rendered_pixel_bits () const
 /**	Get the number of bytes for each rendered pixel sample.
 
 	@return	The number of bytes used to store each rendered pixel sample
-		in one band.
+		in one band. This is sizeof (float) when {@link
+		float_samples(bool) floating point samples} are rendered.
 	@see	rendered_pixel_bits()
 */
 unsigned int rendered_pixel_bytes () const;
 
+/**	Enable or disable floating point pixel sample rendering.
+
+	When enabled, pixel samples are rendered as 32-bit floats with the
+	nominal range of the source image samples (e.g. 0 to 2<sup>P</sup>-1
+	for unsigned P-bit samples) instead of integers of the {@link
+	rendered_pixel_bits() rendered pixel precision}. The {@link
+	calibration(unsigned int, float, float) calibration} of each band is
+	applied to the floating point samples as each rendering increment is
+	disposed, while the increment is still in the processor cache, so
+	calibrated rasters are produced by a single rendering pass.
+
+	Floating point samples are in host byte order; {@link
+	swap_pixel_bytes(bool) pixel bytes swapping} does not apply.
+
+	@param	enable	true if floating point samples are to be rendered;
+		false otherwise. The initial value is false.
+	@return	This JP2_Reader.
+*/
+inline JP2_Reader& float_samples (bool enable)
+	{Float_Samples = enable; return *this;}
+
+/**	Test if floating point pixel samples are rendered.
+
+	@return	true if floating point samples are rendered; false otherwise.
+	@see	float_samples(bool)
+*/
+inline bool float_samples () const
+	{return Float_Samples;}
+
+/**	Set the calibration of floating point pixel samples for a band.
+
+	Each {@link float_samples(bool) floating point} pixel sample value,
+	v, of the band is rendered as v * scale + offset.
+
+	@param	band	The image band to which the calibration applies. If
+		{@link #ALL_BANDS} the calibration applies to all image bands.
+	@param	scale	The calibration scale factor. The initial value is 1.
+	@param	offset	The calibration offset. The initial value is 0.
+	@return	This JP2_Reader.
+*/
+JP2_Reader& calibration (unsigned int band, float scale, float offset);
+
+/**	Get the calibration scale factor for a band.
+
+	@param	band	An image band index.
+	@return	The calibration scale factor for the band.
+	@see	calibration(unsigned int, float, float)
+*/
+float calibration_scale (unsigned int band) const;
+
+/**	Get the calibration offset for a band.
+
+	@param	band	An image band index.
+	@return	The calibration offset for the band.
+	@see	calibration(unsigned int, float, float)
+*/
+float calibration_offset (unsigned int band) const;
+
+/**	Stretch a band to 8-bit pixels using a lookup table.
+
+	When any band has a stretch method other than {@link #STRETCH_NONE}
+	the rendered image is {@link stretching() stretched}: the pixel
+	samples of each band are decoded with the {@link rendered_pixel_bits()
+	rendered pixel precision} and mapped through the band's lookup table
+	to 8-bit pixels that are written directly to the image data buffer
+	(or delivered to the {@link line_sink(Line_Sink*) line sink}) as each
+	rendering increment is produced. A rendered band with no stretch
+	method is linearly scaled from the rendered pixel precision to 8 bits.
+
+	Stretched rendering is done by the line rendering engine and is not
+	available for JPIP sources. {@link float_samples(bool) Floating point
+	samples} are not rendered when stretching.
+
+	@param	band	The image band to be stretched. If {@link #ALL_BANDS}
+		the table applies to all image bands.
+	@param	table	The lookup table indexed by decoded sample value. A
+		table shorter than 2<sup>P</sup>, where P is the rendered pixel
+		precision, is extended with its last entry. An empty table sets
+		the band's stretch method to {@link #STRETCH_NONE}.
+	@return	This JP2_Reader.
+	@throws	JP2_Invalid_Argument	If the band is not a valid image band.
+*/
+JP2_Reader& stretch_table (unsigned int band,
+	const std::vector<unsigned char>& table);
+
+/**	Linearly stretch a band to 8-bit pixels.
+
+	Decoded sample values from low to high are mapped linearly to the
+	0 to 255 pixel range; values outside the range are clipped.
+
+	@param	band	The image band to be stretched. If {@link #ALL_BANDS}
+		the stretch applies to all image bands.
+	@param	low	The decoded sample value mapped to 0.
+	@param	high	The decoded sample value mapped to 255.
+	@return	This JP2_Reader.
+	@throws	JP2_Invalid_Argument	If the band is not a valid image band
+		or high is not greater than low.
+	@see	stretch_table(unsigned int, const std::vector<unsigned char>&)
+*/
+JP2_Reader& linear_stretch (unsigned int band,
+	unsigned int low, unsigned int high);
+
+/**	Stretch a band to 8-bit pixels between sample value percentiles.
+
+	The decoded sample values at the low and high percentiles of the
+	band's histogram are {@link linear_stretch(unsigned int, unsigned int,
+	unsigned int) linearly stretched}. The histogram is obtained from a
+	low resolution rendering of the image region, limited to {@link
+	#STRETCH_SAMPLE_PIXELS}, before the image is rendered. A reader that
+	can not obtain the histogram stretches the full sample value range.
+
+	@param	band	The image band to be stretched. If {@link #ALL_BANDS}
+		the stretch applies to all image bands.
+	@param	low_percentile	The percentile, 0 to 100, of the sample
+		value to be mapped to 0.
+	@param	high_percentile	The percentile, 0 to 100, of the sample
+		value to be mapped to 255.
+	@return	This JP2_Reader.
+	@throws	JP2_Invalid_Argument	If the band is not a valid image band
+		or the percentiles are not ordered in the 0 to 100 range.
+	@see	stretch_table(unsigned int, const std::vector<unsigned char>&)
+*/
+JP2_Reader& percentile_stretch (unsigned int band,
+	double low_percentile, double high_percentile);
+
+/**	Remove the stretch of all bands.
+
+	@return	This JP2_Reader.
+*/
+JP2_Reader& clear_stretch ();
+
+/**	Get the stretch method of a band.
+
+	@param	band	An image band index.
+	@return	The Stretch_Method of the band.
+*/
+Stretch_Method stretch_method (unsigned int band) const;
+
+/**	Test if the rendered image is stretched to 8-bit pixels.
+
+	@return	true if any band has a stretch method other than {@link
+		#STRETCH_NONE}; false otherwise.
+	@see	stretch_table(unsigned int, const std::vector<unsigned char>&)
+*/
+bool stretching () const;
+
 /**	Set the suggested rendering increment.
 
 	The specified number of rendering increment lines is a suggestion to
@@ -880,6 +1626,99 @@ inline unsigned int rendering_increment_lines () const
 */
 unsigned int effective_rendering_increment_lines () const;
 
+/**	Enable or disable the adaptive rendering increment.
+
+	When the adaptive rendering increment is enabled the {@link
+	effective_rendering_increment_lines() effective rendering increment}
+	is chosen from the image rather than the {@link
+	rendering_increment_lines(unsigned int) suggested increment} or the
+	{@link #DEFAULT_RENDERING_INCREMENT_BYTES}. The increment holds
+	about as many lines of the rendered region as fit in the {@link
+	processing_cache_bytes() processor cache} of each processing
+	thread, scaled by the number of {@link
+	effective_processing_threads() processing threads} in use. It is
+	aligned to whole rows of {@link code_block_size() code-blocks} at
+	the rendering resolution level, limited by the {@link
+	precinct_size(unsigned int) precinct} and {@link tile_size() tile}
+	heights, so that each increment completes the code-block rows it
+	decompresses.
+
+	The adaptive rendering increment is initially disabled.
+
+	@param	enable	true to enable the adaptive rendering increment;
+		false otherwise.
+	@return	This JP2_Reader.
+	@see	low_latency_rendering(bool)
+*/
+JP2_Reader& adaptive_rendering_increment (bool enable);
+
+/**	Test if the adaptive rendering increment is enabled.
+
+	@return	true if the adaptive rendering increment is enabled; false
+		otherwise.
+	@see	adaptive_rendering_increment(bool)
+*/
+inline bool adaptive_rendering_increment () const
+	{return Adaptive_Increment;}
+
+/**	Enable or disable low latency rendering.
+
+	With low latency rendering the {@link
+	first_rendering_increment_lines() first rendering increment} is a
+	single code-block row so that the {@link
+	rendering_monitor(Rendering_Monitor*) rendering monitor} or {@link
+	line_sink(Line_Sink*) line sink} receives image data as soon as
+	possible. The remaining increments are the {@link
+	effective_rendering_increment_lines() effective rendering increment}.
+
+	Low latency rendering is initially disabled.
+
+	@param	enable	true to enable low latency rendering; false
+		otherwise.
+	@return	This JP2_Reader.
+*/
+JP2_Reader& low_latency_rendering (bool enable);
+
+/**	Test if low latency rendering is enabled.
+
+	@return	true if low latency rendering is enabled; false otherwise.
+	@see	low_latency_rendering(bool)
+*/
+inline bool low_latency_rendering () const
+	{return Low_Latency;}
+
+/**	Get the first rendering increment.
+
+	@return	The rendering increment, in image lines, for the first
+		increment of a rendering. This is the {@link
+		increment_alignment_lines() increment alignment} if {@link
+		low_latency_rendering(bool) low latency rendering} is enabled
+		and it is smaller than the {@link
+		effective_rendering_increment_lines() effective rendering
+		increment}; otherwise it is the effective rendering increment.
+*/
+unsigned int first_rendering_increment_lines () const;
+
+/**	Get the rendering increment alignment.
+
+	@return	The number of rendered image lines covered by a row of
+		{@link code_block_size() code-blocks} of the highest frequency
+		subbands at the rendering resolution level, limited by the
+		{@link precinct_size(unsigned int) precinct} and {@link
+		tile_size() tile} heights at that level.
+*/
+unsigned int increment_alignment_lines () const;
+
+/**	Get the processor cache size available to each processing thread.
+
+	On systems where it can be determined this is the size of the
+	level 2 processor cache; otherwise it is the {@link
+	#DEFAULT_CACHE_BYTES}.
+
+	@return	The processor cache size in bytes.
+*/
+static unsigned long long processing_cache_bytes ();
+
 /**	Set the number of processing threads used for decompression.
 
 	@param	threads	The number of processing threads used for
@@ -899,31 +1738,271 @@ JP2_Reader& processing_threads (unsigned int threads);
 inline unsigned int processing_threads () const
 	{return Thread_Count;}
 
-inline static void default_jpip_proxy (const std::string& server)
-	{Default_JPIP_Proxy = server;}
-inline static std::string default_jpip_proxy ()
-	{return Default_JPIP_Proxy;}
-inline JP2_Reader& jpip_proxy (const std::string& server)
-	{JPIP_Proxy = server; return *this;}
-inline std::string jpip_proxy () const
-	{return JPIP_Proxy;}
+/**	Release the deployed processing threads.
 
-inline static void default_jpip_cache_directory (const std::string& directory)
-	{Default_JPIP_Cache_Directory = directory;}
-inline static std::string default_jpip_cache_directory ()
-	{return Default_JPIP_Cache_Directory;}
-inline JP2_Reader& jpip_cache_directory (const std::string& directory)
-	{JPIP_Cache_Directory = directory; return *this;}
-inline std::string jpip_cache_directory () const
-	{return JPIP_Cache_Directory;}
+	A reader that holds decompression processing threads between
+	renderings returns them; they are deployed again when the reader
+	next renders. This is done when a reader is closed, including when
+	a JP2_Reader_Pool deletes a reader it evicts or closes; idle
+	readers in a pool keep their threads for the next checkout. The
+	{@link processing_threads() processing threads} setting is not
+	changed.
 
-/**	Register a rendering monitor.
+	<b>N.B.</b>: Processing threads must not be released while the
+	reader is rendering.
 
-	The {@link #Rendering_Monitor} is called during {@link render()
-	rendering} after each {@link rendering_increment_lines(unsigned int)
-	increment of rendered source lines} has been decompressed as well as
-	when the rendering of the current {@link image_region(const
-	Rectange&) image region} has been completed.
+	The base implementation does nothing.
+*/
+virtual void release_processing_threads ();
+
+/**	Set the processors on which processing threads are placed.
+
+	The decompression {@link processing_threads() processing threads}
+	of a reader are bound to the processors when they are deployed,
+	which occurs when the reader is {@link open(const std::string&)
+	opened}; the processors should be set on a reader constructed
+	without a source before it is opened. A locally allocated {@link
+	image_data() image data} buffer is first touched while bound to the
+	processors so that, with the usual first touch memory policy, its
+	pages are placed in the memory of the processors' NUMA node.
+
+	<b>N.B.</b>: Processor binding is only implemented for Linux; on
+	other systems the processors have no effect.
+
+	@param	CPUs	A vector of processor numbers. If empty, processing
+		is not bound to any processors, which is the initial condition.
+	@return	This JP2_Reader.
+	@see	processing_node(unsigned int)
+*/
+JP2_Reader& processing_CPUs (const std::vector<unsigned int>& CPUs);
+
+/**	Get the processors on which processing threads are placed.
+
+	@return	A vector of processor numbers. This will be empty if
+		processing is not bound to any processors.
+	@see	processing_CPUs(const std::vector<unsigned int>&)
+*/
+inline const std::vector<unsigned int>& processing_CPUs () const
+	{return Processing_CPUs;}
+
+/**	Set the processors on which processing threads are placed to
+	those of a NUMA node.
+
+	The processors of the node are listed by the system in
+	/sys/devices/system/node/node<i>N</i>/cpulist.
+
+	@param	node	A NUMA node number.
+	@return	This JP2_Reader.
+	@throws	JP2_Invalid_Argument	If the processors of the node could
+		not be determined.
+	@see	processing_CPUs(const std::vector<unsigned int>&)
+*/
+JP2_Reader& processing_node (unsigned int node);
+
+/**	Enable or disable adaptive selection of processing threads.
+
+	Using all {@link processing_threads() processing threads} for a
+	small rendering costs more in thread synchronization than it saves.
+	When adaptive selection is enabled the number of processing threads
+	to be used is {@link effective_processing_threads() selected} for
+	each {@link render() rendering}. The amount of decompression work is
+	estimated as the number of code-blocks covering the {@link
+	rendered_region() rendered region}, given the {@link
+	code_block_size() code-block} and {@link precinct_size(unsigned int)
+	precinct} geometry for the {@link resolution_level() resolution
+	level}, for each rendered band. When there is less than twice the
+	{@link thread_work_threshold(unsigned int) thread work threshold} of
+	code-blocks the rendering is done with a single thread; otherwise
+	all of the processing threads are used. The processing thread group
+	can not be limited to only some of its threads for a rendering.
+
+	Adaptive selection is initially disabled.
+
+	@param	enable	true to enable adaptive selection; false to always
+		use all processing threads.
+	@return	This JP2_Reader.
+	@see	processing_threads_reason()
+*/
+JP2_Reader& adaptive_processing_threads (bool enable);
+
+/**	Test if adaptive selection of processing threads is enabled.
+
+	@return	true if adaptive selection is enabled; false otherwise.
+	@see	adaptive_processing_threads(bool)
+*/
+inline bool adaptive_processing_threads () const
+	{return Adaptive_Threads;}
+
+/**	Set the work threshold for adaptively selected processing threads.
+
+	@param	code_blocks	The number of code-blocks of decompression work
+		for each {@link adaptive_processing_threads(bool) adaptively
+		selected} processing thread. If zero the {@link
+		#DEFAULT_THREAD_WORK_CODE_BLOCKS} is used.
+	@return	This JP2_Reader.
+*/
+JP2_Reader& thread_work_threshold (unsigned int code_blocks);
+
+/**	Get the work threshold for adaptively selected processing threads.
+
+	@return	The number of code-blocks of decompression work for each
+		adaptively selected processing thread.
+	@see	thread_work_threshold(unsigned int)
+*/
+inline unsigned int thread_work_threshold () const
+	{return Thread_Work_Code_Blocks;}
+
+/**	Get the number of processing threads selected for the most recent
+	rendering.
+
+	@return	The number of processing threads used by the most recent
+		{@link render() rendering}. This will be zero if nothing has been
+		rendered.
+	@see	processing_threads_reason()
+*/
+inline unsigned int effective_processing_threads () const
+	{return Effective_Threads;}
+
+/**	Get the reason for the processing threads selected for the most
+	recent rendering.
+
+	@return	A description of how the {@link effective_processing_threads()
+		effective processing threads} were selected. This will be empty
+		if nothing has been rendered.
+*/
+inline std::string processing_threads_reason () const
+	{return Threads_Reason;}
+
+/**	Set the number of horizontal strips to be rendered concurrently.
+
+	When more than one rendering strip is in effect the {@link
+	rendered_region() rendered region} is divided into horizontal strips
+	along codestream tile row boundaries, so no two strips use the same
+	tile, and the strips are decompressed together, each by its own
+	rendering engine operating on the shared source codestream and
+	writing directly into its part of the {@link image_data(void**,
+	unsigned long long) image data} buffers. The work queued for all of
+	the strips is available to the {@link processing_threads()
+	processing threads}, which may help when the parallelism available
+	within each rendering increment is insufficient; the strips are
+	driven from the rendering thread, so the rendering does not scale
+	with the number of strips.
+
+	The rendered region is rendered as a single strip when it lies
+	within one tile row, when the image is {@link
+	rendering_scale(unsigned int, unsigned int) scaled}, or when no
+	processing thread group is used for the rendering.
+
+	<b>N.B.</b>: With strip rendering in effect the {@link
+	rendering_monitor(Rendering_Monitor*) rendering monitor} is
+	notified of the rendering increments of each strip as they
+	complete; successive notifications are not necessarily for
+	vertically adjacent regions.
+
+	@param	strips	The number of rendering strips. If zero, the
+		number of {@link processing_threads() processing threads} will
+		be used. The initial value is one; i.e. the entire region is
+		rendered as a single strip.
+	@return	This JP2_Reader.
+	@see	effective_rendering_strips()
+*/
+inline JP2_Reader& rendering_strips (unsigned int strips)
+	{Rendering_Strips = strips; return *this;}
+
+/**	Get the number of horizontal strips to be rendered concurrently.
+
+	@return	The number of rendering strips that was specified.
+	@see	rendering_strips(unsigned int)
+*/
+inline unsigned int rendering_strips () const
+	{return Rendering_Strips;}
+
+/**	Get the effective number of rendering strips.
+
+	The {@link rendering_strips(unsigned int) specified number of
+	rendering strips} is limited by the number of {@link
+	processing_threads() processing threads} - concurrent strip
+	rendering is not possible with less than two - and the height of
+	the {@link rendered_region() rendered region}. The number of strips
+	actually rendered is also limited by the number of tile rows of
+	the rendered region.
+
+	@return	The number of strips into which the rendered region will be
+		divided. This will be zero if the JP2 source is not {@link open()
+		open}.
+	@see	rendering_strips(unsigned int)
+*/
+unsigned int effective_rendering_strips () const;
+
+/**	Enable or disable pipelined data disposition.
+
+	Normally the {@link data_disposition(Rendering_Monitor::Status,
+	const std::string&, const Cube&, const Cube&) data disposition} of
+	each rendering increment - {@link swap_pixel_bytes(bool) pixel
+	bytes swapping} and {@link rendering_monitor(Rendering_Monitor*)
+	rendering monitor} notification - is done by the rendering thread
+	while the decompression machinery waits. With pipelined data
+	disposition each rendered increment is handed to a disposition
+	thread and the rendering engine immediately continues with the next
+	increment.
+
+	With pipelined data disposition the pixel bytes are swapped by the
+	disposition thread. This takes the swapping off the rendering
+	thread, but by the time an increment is disposed its samples may no
+	longer be in the processor cache; without pipelining each increment
+	is swapped as soon as it has been decoded. For small increments,
+	whose swapping costs little, pipelining may gain nothing.
+
+	The rendering monitor is notified of the increments in the same
+	order, and from a single thread, as it would be without pipelining;
+	the final rendering notification is not sent until all increments
+	have been disposed. However, the rendering monitor is notified from
+	the disposition thread, not the rendering thread, and rendering
+	cancellation by the monitor takes effect after the increments that
+	have already been decompressed; these are still byte swapped but
+	the monitor is not notified of them.
+
+	@param	enable	true if pipelined data disposition is to be used;
+		false otherwise. The initial value is false.
+	@return	This JP2_Reader.
+*/
+inline JP2_Reader& pipelined_disposition (bool enable)
+	{Pipelined_Disposition = enable; return *this;}
+
+/**	Test if pipelined data disposition is enabled.
+
+	@return	true if pipelined data disposition is enabled; false
+		otherwise.
+	@see	pipelined_disposition(bool)
+*/
+inline bool pipelined_disposition () const
+	{return Pipelined_Disposition;}
+
+inline static void default_jpip_proxy (const std::string& server)
+	{Default_JPIP_Proxy = server;}
+inline static std::string default_jpip_proxy ()
+	{return Default_JPIP_Proxy;}
+inline JP2_Reader& jpip_proxy (const std::string& server)
+	{JPIP_Proxy = server; return *this;}
+inline std::string jpip_proxy () const
+	{return JPIP_Proxy;}
+
+inline static void default_jpip_cache_directory (const std::string& directory)
+	{Default_JPIP_Cache_Directory = directory;}
+inline static std::string default_jpip_cache_directory ()
+	{return Default_JPIP_Cache_Directory;}
+inline JP2_Reader& jpip_cache_directory (const std::string& directory)
+	{JPIP_Cache_Directory = directory; return *this;}
+inline std::string jpip_cache_directory () const
+	{return JPIP_Cache_Directory;}
+
+/**	Register a rendering monitor.
+
+	The {@link #Rendering_Monitor} is called during {@link render()
+	rendering} after each {@link rendering_increment_lines(unsigned int)
+	increment of rendered source lines} has been decompressed as well as
+	when the rendering of the current {@link image_region(const
+	Rectange&) image region} has been completed.
 
 	The Rendering_Monitor is an object with a notify function that
 	identifies the JP2_Reader for which the event occured and provides
@@ -948,6 +2027,127 @@ inline JP2_Reader& rendering_monitor (Rendering_Monitor* monitor)
 inline Rendering_Monitor* rendering_monitor () const
 	{return Monitor;}
 
+/**	Register a line sink.
+
+	When a {@link #Line_Sink} is registered the {@link render()
+	rendering} delivers the image data to the line sink as each {@link
+	effective_rendering_increment_lines() rendering increment} has been
+	rendered. The increments are rendered into a small, fixed, set of
+	increment sized buffers rather than {@link image_data(void**,
+	unsigned long long) image data} buffers for the entire rendered
+	region, so the memory required is proportional to the rendering
+	increment size, not the size of the rendered region. The image data
+	format does not apply; each band is delivered separately.
+
+	The line sink is called before the {@link
+	rendering_monitor(Rendering_Monitor*) rendering monitor} is
+	notified of each increment. With {@link pipelined_disposition(bool)
+	pipelined data disposition} the line sink is called from the
+	disposition thread while the next increment is rendered.
+
+	@param	sink	The Line_Sink to receive the rendered image lines.
+		If NULL the image data is rendered into the image data buffers.
+	@return	This JP2_Reader.
+	@see	line_sink()
+*/
+inline JP2_Reader& line_sink (Line_Sink* sink)
+	{Sink = sink; return *this;}
+
+/**	Get the Line_Sink.
+
+	@return	The registered Line_Sink. This will be NULL if no Line_Sink
+		is currently registered.
+	@see	line_sink(Line_Sink*)
+*/
+inline Line_Sink* line_sink () const
+	{return Sink;}
+
+/**	Register a decoded tile cache.
+
+	When a tile cache is registered the image data of a local file source
+	is rendered cell by cell of the cache's {@link
+	JP2_Tile_Cache::cell_size() cell grid}: each cell is obtained from the
+	cache if it is held, otherwise it is decoded and inserted into the
+	cache. Renderings of the same or overlapping regions then reuse the
+	decoded cells. The same cache may be registered with any number of
+	readers.
+
+	The tile cache is not used when there is a {@link
+	line_sink(Line_Sink*) line sink} or the image is {@link stretching()
+	stretched}.
+
+	<b>N.B.</b>: The tile cache is owned by the user and must remain
+	valid while it is registered.
+
+	@param	cache	A pointer to the JP2_Tile_Cache to be used. If NULL
+		no cache is used.
+	@return	This JP2_Reader.
+*/
+inline JP2_Reader& tile_cache (JP2_Tile_Cache* cache)
+	{Tile_Cache = cache; return *this;}
+
+/**	Get the registered tile cache.
+
+	@return	A pointer to the registered JP2_Tile_Cache. This will be NULL
+		if no cache is registered.
+	@see	tile_cache(JP2_Tile_Cache*)
+*/
+inline JP2_Tile_Cache* tile_cache () const
+	{return Tile_Cache;}
+
+/**	Register an image data buffer allocator.
+
+	The allocator provides the image data buffer when the image data
+	buffers are not {@link user_buffer() provided by the user}. Any
+	image data buffer provided by the previous allocator is released.
+
+	<b>N.B.</b>: The allocator is owned by the user and must remain
+	valid while it is registered. The same allocator may be registered
+	with any number of readers; it must then be thread safe.
+
+	@param	allocator	A pointer to the Image_Buffer_Allocator to be
+		used. If NULL the default {@link Aligned_Buffer_Allocator} is
+		used.
+	@return	This JP2_Reader.
+*/
+JP2_Reader& image_buffer_allocator (Image_Buffer_Allocator* allocator);
+
+/**	Get the image data buffer allocator.
+
+	@return	A pointer to the Image_Buffer_Allocator used to provide
+		locally managed image data buffers. This is never NULL.
+	@see	image_buffer_allocator(Image_Buffer_Allocator*)
+*/
+Image_Buffer_Allocator* image_buffer_allocator () const;
+
+/**	Enable or disable image line padding.
+
+	When image line padding is enabled the {@link line_stride() line
+	stride} of a locally managed image data buffer in a named {@link
+	image_data_format(Image_Data_Format) image data format} is padded so
+	that each line of each band starts at an address that is a multiple
+	of the {@link Image_Buffer_Allocator::alignment() allocator
+	alignment}. User specified buffers and ad hoc strides are never
+	padded.
+
+	<b>N.B.</b>: With padding the image data of a band is not contiguous;
+	use the line stride to traverse the lines.
+
+	Image line padding is initially disabled.
+
+	@param	enable	true to pad image lines; false otherwise.
+	@return	This JP2_Reader.
+*/
+JP2_Reader& pad_image_lines (bool enable);
+
+/**	Test if image lines are padded.
+
+	@return	true if image line padding is enabled; false otherwise.
+	@see	pad_image_lines(bool)
+*/
+inline bool pad_image_lines () const
+	{return Pad_Image_Lines;}
+
 /**	Get the total number of image data bytes last rendered.
 
 	At the beginning of each image data {@link render() rendering
@@ -962,6 +2162,16 @@ inline Rendering_Monitor* rendering_monitor () const
 inline unsigned long long bytes_rendered ()
 	{return Bytes_Rendered;}
 
+/**	Get the statistics of the last rendering.
+
+	The statistics are those of the last {@link render() rendering} to
+	complete, whether it succeeded, was canceled or failed. It is safe
+	to use this method while another rendering is in progress.
+
+	@return	A copy of the Render_Statistics of the last rendering.
+*/
+Render_Statistics last_render_statistics () const;
+
 /*==============================================================================
 	Reader Implementation
 
@@ -979,6 +2189,21 @@ inline unsigned long long bytes_rendered ()
 */
 virtual JP2_Reader* clone () const = 0;
 
+/**	Clone the JP2_Reader sharing its immutable source state.
+
+	A clone that shares the immutable state of this JP2_Reader - e.g.
+	its parsed metadata - is constructed. Only the rendering state is
+	unique to the clone. This is intended to make it inexpensive to
+	provide each of multiple threads with its own reader for the same
+	source.
+
+	This base implementation simply returns a {@link clone() clone}.
+
+	@return	A pointer to a clone of the implementing JP2_Reader.
+*/
+virtual JP2_Reader* shared_clone () const
+	{return clone ();}
+
 /**	Open a JP2 source.
 
 	Normally the {@link JP2::reader(const std::string&) JP2 reader)
@@ -1183,6 +2408,134 @@ virtual bool resolution_and_region
 */
 virtual Cube render () = 0;
 
+/**	Render a batch of image regions.
+
+	Each {@link Region_Request} is rendered into its own pixel data
+	buffers. If a {@link rendering_monitor() rendering monitor} has been
+	registered it is notified with {@link
+	Rendering_Monitor::TOP_QUALITY_DATA} status as each request has been
+	rendered, and with DONE, or CANCELED, status when the batch is
+	complete. A false return from the monitor cancels the remaining
+	requests.
+
+	This implementation renders each request in turn by applying the
+	request to the reader's rendering configuration and {@link render()
+	rendering} it. The reader's resolution level, image region, band
+	selection and image data format are restored when the batch is
+	complete. <b>N.B.</b>: Locally managed image data buffers are
+	released; they will be reallocated when next needed. Implementing
+	subclasses may provide more efficient implementations.
+
+	@param	requests	A vector of Region_Requests. The Rendered_Region
+		and Image_Region of each request are set when it is rendered.
+	@return	The number of requests that were completely rendered.
+	@throws	JP2_Logic_Error	If the reader is not open.
+	@throws	JP2_Invalid_Argument	If a request does not provide pixel
+		data buffers, or its buffers are too small.
+*/
+virtual unsigned int render (std::vector<Region_Request>& requests);
+
+/**	Render the image data directly into a file.
+
+	The file is created, or truncated, and sized to hold the {@link
+	rendered_region() rendered region} for all {@link rendered_bands()
+	rendered bands} in the specified image data format. The file is then
+	memory mapped and the mapped file content is used as the {@link
+	image_data(void**, unsigned long long) image data} buffers while the
+	image data is {@link render() rendered}. The decompressor thus
+	writes the pixel data straight into the file's pages in the system
+	page cache; no separate image data buffer, or copy of it to the file,
+	is needed, and the rendered region may be larger than the available
+	memory.
+
+	The file contains raw pixel data only; there is no header. Pixel
+	samples are {@link rendered_pixel_bytes() rendered pixel bytes} in
+	size and are in MSB order unless {@link swap_pixel_bytes(bool) pixel
+	bytes swapping} is enabled.
+
+	The reader's image data buffers and image data format are restored
+	after rendering.
+
+	@param	pathname	The pathname of the file to be written.
+	@param	data_format	The image data format of the file content. This
+		must be FORMAT_BSQ, FORMAT_BIP or FORMAT_BIL.
+	@return	A Cube indicating what was rendered.
+	@throws	JP2_Logic_Error	If the reader is not open.
+	@throws	JP2_Invalid_Argument	If the data format is not one of the
+		supported formats.
+	@throws	JP2_IO_Failure	If the file could not be created, sized or
+		memory mapped.
+*/
+Cube render_to_file (const std::string& pathname,
+	Image_Data_Format data_format = FORMAT_BSQ);
+
+/**	Render the image data asynchronously.
+
+	The {@link render() render} method is run on a separate thread.
+	The returned future provides the Cube that was rendered, or the
+	exception that was thrown by the render method.
+
+	The rendering may be canceled at any time by {@link
+	Rendering_Cancellation::cancel() canceling} the cancellation token,
+	or by calling {@link cancel_rendering() cancel_rendering}. A
+	canceled rendering completes with a Cube describing the region that
+	was completely rendered, and the {@link rendering_monitor()
+	rendering monitor}, if any, is notified with CANCELED status. The
+	reader remains open, including the connection of a JPIP source, and
+	may be used to render again. However, if the reader's rendering
+	engine can not be restored after it was interrupted the reader is
+	closed and the future provides the exception describing the
+	failure; the reader must then be {@link open(const std::string&)
+	opened} again, or a JPIP source {@link reconnect() reconnected},
+	before it is used.
+
+	How soon a cancellation takes effect depends on the rendering. When
+	the rendering uses the processing thread group the decompression in
+	progress is {@link interrupt_rendering() interrupted}; this is done
+	for the image, line sink, chunked image data, strip, tile cache and
+	progressive preview renderings. When a single processing thread is
+	{@link select_processing_threads() selected} there is no thread
+	group to interrupt, so the rendering is canceled when the
+	decompression increment in progress - a tile cache cell, or the
+	entire progressive preview - is complete. The sampling of the
+	{@link stretching() stretch} histograms is never interrupted; the
+	cancellation takes effect when it is done. A batch {@link
+	render(std::vector<Region_Request>&) region requests rendering} is
+	not run asynchronously.
+
+	<b>N.B.</b>: The reader must not otherwise be used, or destroyed,
+	until the future is ready. The reader's Kakadu processing thread
+	group is driven by the rendering thread while the rendering is in
+	progress.
+
+	@param	cancellation	A pointer to a Rendering_Cancellation token
+		to be bound to the rendering. May be NULL.
+	@return	A std::future for the Cube that was rendered.
+	@throws	JP2_Logic_Error	If an asynchronous rendering is already in
+		progress.
+*/
+std::future<Cube> render_async (Rendering_Cancellation* cancellation = NULL);
+
+/**	Cancel an asynchronous rendering in progress.
+
+	If an {@link render_async(Rendering_Cancellation*) asynchronous
+	rendering} is in progress it is flagged as canceled and the
+	implementing subclass is given the opportunity to {@link
+	interrupt_rendering() interrupt} the rendering engine. Otherwise
+	nothing is done.
+
+	It is safe to call this method from any thread.
+*/
+void cancel_rendering ();
+
+/**	Test if an asynchronous rendering has been canceled.
+
+	@return	true if the asynchronous rendering in progress has been
+		{@link cancel_rendering() canceled}; false otherwise.
+*/
+inline bool rendering_canceled () const
+	{return Rendering_Canceled;}
+
 /**	Close access to the JP2 source.
 
 	The JP2 source stream is closed and the rendering machinery resources
@@ -1207,6 +2560,36 @@ virtual Cube render () = 0;
 */
 virtual void close (bool force = false) = 0;
 
+/**	Reset the rendering configuration to its default.
+
+	The rendering configuration that the user may set is restored to
+	the state of a reader that has just been opened: the entire image
+	region at full resolution with all bands rendered at the {@link
+	pixel_precision() pixel precision} in the {@link
+	default_image_data_format() default image data format}, without
+	pixel bytes swapping, quality layers limit, progressive levels,
+	float samples, calibration, stretching, {@link tile_cache(JP2_Tile_Cache*)
+	tile cache}, rendering strips, pipelined disposition or adaptive
+	rendering increment. Any rendering monitor, line sink, image data
+	buffers allocator or user image data buffers are forgotten, and a
+	locally managed image data buffer is deleted.
+
+	The source, if open, remains open. The JP2 metadata, the {@link
+	processing_threads() processing threads} configuration and any
+	deployed processing threads, and the JPIP configuration are not
+	changed.
+
+	The base implementation clears the rendering configuration; an
+	implementation with an open source restores the defaults for the
+	source.
+
+	<b>N.B.</b>: The rendering configuration must not be reset while the
+	reader is rendering.
+
+	@see	reset()
+*/
+virtual void reset_rendering ();
+
 /**	Reset the reader to it's initial, default, configuration.
 
 	All data members are reset to their empty, NULL or zero intial state
@@ -1223,6 +2606,8 @@ virtual void close (bool force = false) = 0;
 	directory}.
 
 	The base JP2_Metadata is also {@link JP2_Metadata::reset() reset}.
+
+	@see	reset_rendering()
 */
 virtual void reset ();
 
@@ -1280,14 +2665,310 @@ protected:
 		sent.
 	@param	message	A message associated with the notification event.
 		This may be empty.
+	@param	data	An array of pixel data buffer addresses, one for each
+		image band, that hold the rendered region; NULL entries are for
+		bands that are not rendered. If NULL the region is in the
+		image data buffers. When data is provided it is delivered to the
+		{@link line_sink(Line_Sink*) line sink}, if any.
+	@param	data_line_stride	The distance, in samples, between
+		vertically adjacent pixels in the data buffers. Pixels in the
+		data buffers are adjacent.
 	@return	true if rendering is to be continued; false if it is to be
 		discontinued. If a Rendering_Monitor is called its return value
-		is used; otherwise true is returned by default.
+		is used; otherwise true is returned by default. However, false
+		is always returned if the rendering has been {@link
+		cancel_rendering() canceled}.
 	@see	rendering_monitor(Rendering_Monitor*)
 */
 bool data_disposition
 	(Rendering_Monitor::Status status, const std::string& message,
-		const Cube& region_rendered, const Cube& image_region_rendered);
+		const Cube& region_rendered, const Cube& image_region_rendered,
+		void** data = NULL, unsigned int data_line_stride = 0);
+
+/**	Wait for pipelined data disposition.
+
+	If {@link pipelined_disposition(bool) pipelined data disposition}
+	is in progress, wait until no more than the specified number of
+	increments remain to be disposed.
+
+	A rendering engine that reuses increment data buffers must wait for
+	the disposition of the increment that last used a buffer before the
+	buffer is reused.
+
+	@param	pending	The maximum number of increments that may remain
+		to be disposed.
+*/
+void wait_data_disposition (unsigned int pending);
+
+/**	Finish pipelined data disposition.
+
+	If a {@link pipelined_disposition(bool) pipelined data disposition}
+	thread is running, all of the increments handed to it are disposed
+	and the thread is stopped. A rendering engine must use this method
+	before it sends its final rendering monitor notification.
+
+	@return	true if rendering is to be continued; false if the rendering
+		monitor canceled the rendering.
+	@throws	std::exception	Any exception thrown by the rendering
+		monitor while disposing increments.
+*/
+bool finish_data_disposition ();
+
+/**	Stop pipelined data disposition.
+
+	This is the same as {@link finish_data_disposition()
+	finish_data_disposition} but any exception thrown by the rendering
+	monitor is discarded. It is intended for use on rendering failure
+	paths.
+*/
+void stop_data_disposition () throw();
+
+/**	Get the current time of the monotonic statistics clock.
+
+	@return	The time, in seconds, from an arbitrary epoch.
+*/
+static double statistics_time ();
+
+/**	Get the current time of the process CPU clock.
+
+	@return	The CPU time, in seconds, used by the process.
+*/
+static double statistics_CPU_time ();
+
+/**	Start collecting the {@link last_render_statistics() rendering
+	statistics}.
+
+	The statistics of the rendering are reset, except for the source
+	open times, and the rendering clocks are started.
+
+	@param	threads	The number of processing threads used by the
+		rendering.
+*/
+void start_render_statistics (unsigned int threads);
+
+/**	Finish collecting the rendering statistics.
+
+	The rendering totals are set and the statistics are made available
+	from {@link last_render_statistics() last_render_statistics}.
+*/
+void finish_render_statistics ();
+
+/**	Record the decompression of a rendering increment.
+
+	The time since the current increment started is counted as
+	decompression time and the next increment is started. This is done
+	by {@link data_disposition(Rendering_Monitor::Status,
+	const std::string&, const Cube&, const Cube&, void**, unsigned int)
+	data disposition}; a rendering engine that does not use data
+	disposition uses this method after each increment.
+
+	@return	The {@link statistics_time() statistics time} at the end of
+		the increment.
+*/
+double increment_statistics ();
+
+/**	Record a data disposition.
+
+	The time since the start of the disposition is counted as
+	disposition time and the next increment is started.
+
+	@param	start	The {@link statistics_time() statistics time} when
+		the disposition started.
+*/
+void disposition_statistics (double start);
+
+/**	Record a codestream data acquisition wait.
+
+	The wait is not counted as decompression time.
+
+	@param	start	The {@link statistics_time() statistics time} when
+		the wait started.
+*/
+void acquisition_statistics (double start);
+
+/**	Record the times to open the source.
+
+	@param	open_seconds	The time to open the source.
+	@param	ingest_seconds	The part of the open time used to ingest the
+		source metadata.
+*/
+void open_statistics (double open_seconds, double ingest_seconds);
+
+/**	Collects rendering statistics while it is in scope.
+
+	A rendering engine constructs a Render_Statistics_Guard on its stack
+	so that the statistics are finished however the rendering ends.
+*/
+class Render_Statistics_Guard
+	{
+	public:
+	Render_Statistics_Guard (JP2_Reader& reader, unsigned int threads)
+		:	Reader (reader)
+		{Reader.start_render_statistics (threads);}
+	~Render_Statistics_Guard ()
+		{Reader.finish_render_statistics ();}
+
+	private:
+	JP2_Reader
+		&Reader;
+	};
+
+/**	Stops pipelined data disposition when it goes out of scope.
+
+	A rendering engine constructs a Data_Disposition_Guard on its stack
+	so that the disposition thread, which accesses the reader and its
+	image data buffers, is stopped however the rendering engine exits.
+*/
+class Data_Disposition_Guard
+	{
+	public:
+	explicit Data_Disposition_Guard (JP2_Reader& reader)
+		:	Reader (reader)
+		{}
+	~Data_Disposition_Guard ()
+		{Reader.stop_data_disposition ();}
+
+	private:
+	JP2_Reader
+		&Reader;
+	};
+
+/**	Swap the bytes of 16-bit pixel samples.
+
+	When the samples of each line are contiguous (the pixel stride is
+	one) the samples are swapped by a vector kernel selected at run time
+	for the host processor, if available; contiguous lines are swapped
+	as a single run of samples. Band interleaved by line data is
+	swapped a line at a time as contiguous samples. When the samples
+	of a band are interleaved with those of other bands (the pixel
+	stride is more than one) the samples of each line are gathered and
+	scattered back by masked vector loads and stores, when the host
+	supports AVX-512, that do not touch the samples of other bands;
+	otherwise they are swapped one at a time.
+
+	@param	data	The address of the first pixel sample of the region.
+	@param	width	The number of pixels in each line of the region.
+	@param	height	The number of lines in the region.
+	@param	pixel_stride	Distance, in samples, between horizontally
+		adjacent pixels.
+	@param	line_stride	Distance, in samples, between vertically
+		adjacent pixels.
+*/
+static void swap_sample_bytes (void* data,
+	unsigned int width, unsigned int height,
+	unsigned int pixel_stride, unsigned int line_stride);
+
+/**	Get the name of the sample bytes swapping kernel.
+
+	@return	The name of the kernel used by {@link
+		swap_sample_bytes(void*, unsigned int, unsigned int, unsigned int,
+		unsigned int) sample bytes swapping} for contiguous samples on
+		this host: "AVX-512", "AVX2", "SSE2" or "portable". Strided
+		samples are only swapped by a vector kernel with AVX-512.
+*/
+static const char* sample_bytes_swapper ();
+
+/**	Get the name of the 16-bit sample stretching kernel.
+
+	@return	The name of the kernel used to map contiguous 16-bit
+		samples through a stretch table to 8-bit pixels on this host:
+		"AVX2" or "portable".
+*/
+static const char* sample_stretcher ();
+
+/**	Apply the calibration of a band to floating point pixel samples.
+
+	If the band has no calibration, or an identity calibration, nothing
+	is done.
+
+	@param	band	The image band of the samples.
+	@param	data	The address of the first pixel sample of the region.
+	@param	width	The number of pixels in each line of the region.
+	@param	height	The number of lines in the region.
+	@param	pixel_stride	Distance, in samples, between horizontally
+		adjacent pixels.
+	@param	line_stride	Distance, in samples, between vertically
+		adjacent pixels.
+	@see	calibration(unsigned int, float, float)
+*/
+void calibrate_samples (unsigned int band, void* data,
+	unsigned int width, unsigned int height,
+	unsigned int pixel_stride, unsigned int line_stride) const;
+
+/**	Get the number of bytes for each decoded pixel sample.
+
+	This is the same as the {@link rendered_pixel_bytes() rendered pixel
+	bytes} unless the image is {@link stretching() stretched}, in which
+	case it is the number of bytes of the rendered pixel precision before
+	the samples are mapped to 8-bit pixels.
+
+	@return	The number of bytes of each decoded pixel sample.
+*/
+unsigned int decoded_pixel_bytes () const;
+
+/**	Prepare the stretch lookup tables for rendering.
+
+	An effective lookup table with an entry for every decoded sample
+	value of the rendered pixel precision is assembled for each rendered
+	band. The {@link stretch_histograms(std::vector<std::vector<unsigned
+	long long> >&) histograms} are obtained if any band has a percentile
+	stretch.
+
+	This must be called after the rendering configuration is set and
+	before the first increment is disposed.
+*/
+void prepare_stretch ();
+
+/**	Obtain the sample value histograms used for percentile stretching.
+
+	The base implementation does nothing, in which case percentile
+	stretched bands are stretched over the full sample value range.
+
+	@param	histograms	A vector of per band histograms. Each histogram
+		to be provided is to have an entry for every decoded sample value
+		of the rendered pixel precision. An empty histogram means the band
+		has no histogram.
+*/
+virtual void stretch_histograms
+	(std::vector<std::vector<unsigned long long> >& histograms);
+
+/**	Map decoded pixel samples of a band through its stretch table.
+
+	The source and destination may be the same buffer provided the
+	destination line stride and pixel stride are the same as the source
+	(the 8-bit pixels then replace the leading bytes of each line).
+
+	@param	band	The image band of the samples.
+	@param	source	The address of the first decoded sample of the region.
+	@param	source_line_stride	Distance, in samples, between vertically
+		adjacent source pixels. Source pixels are contiguous in a line.
+	@param	destination	The address of the first 8-bit pixel of the
+		region.
+	@param	pixel_stride	Distance, in bytes, between horizontally
+		adjacent destination pixels.
+	@param	line_stride	Distance, in bytes, between vertically adjacent
+		destination pixels.
+	@param	width	The number of pixels in each line of the region.
+	@param	height	The number of lines in the region.
+	@see	prepare_stretch()
+*/
+void stretch_samples (unsigned int band,
+	const void* source, unsigned int source_line_stride,
+	unsigned char* destination,
+	unsigned int pixel_stride, unsigned int line_stride,
+	unsigned int width, unsigned int height) const;
+
+/**	Interrupt the rendering engine.
+
+	This method is called by {@link cancel_rendering() cancel_rendering}
+	from the canceling thread, with the Rendering_Lock held, when an
+	asynchronous rendering is in progress. The base implementation does
+	nothing; the rendering is stopped when the next rendering increment
+	is {@link data_disposition(Rendering_Monitor::Status, const
+	std::string&, const Cube&, const Cube&) disposed}. Implementing
+	subclasses may stop the rendering engine sooner.
+*/
+virtual void interrupt_rendering ();
 
 /**	An image data buffer is allocated.
 
@@ -1308,9 +2989,150 @@ bool data_disposition
 */
 void allocate_image_data_buffer ();
 
+/**	Select the processing threads for a rendering.
+
+	If {@link adaptive_processing_threads(bool) adaptive selection} is
+	not enabled all {@link processing_threads() processing threads} are
+	selected. Otherwise either one thread or all of the threads are
+	selected for the estimated decompression work of the current
+	rendering configuration.
+
+	The selection and the reason for it are recorded for the {@link
+	effective_processing_threads() effective processing threads} and
+	{@link processing_threads_reason() reason} accessors.
+
+	@return	The number of processing threads to be used.
+*/
+unsigned int select_processing_threads ();
+
+/**	A <i>CPU_Binding</i> binds the calling thread to processors.
+
+	While a CPU_Binding exists the calling thread is bound to the
+	processors it was constructed with. The previous binding of the
+	thread is restored when the CPU_Binding is destroyed. Threads
+	created by the bound thread inherit its binding.
+*/
+class CPU_Binding
+{
+public:
+/**	Bind the calling thread to processors.
+
+	@param	CPUs	A vector of processor numbers. If empty the
+		thread is not bound.
+*/
+explicit CPU_Binding (const std::vector<unsigned int>& CPUs);
+
+//!	Restore the previous binding of the thread.
+~CPU_Binding ();
+
+/**	Test if the thread is bound.
+
+	@return	true if the thread was bound to the processors; false if
+		no processors were specified or binding is not available.
+*/
+inline bool bound () const
+	{return Bound;}
+
+private:
+CPU_Binding (const CPU_Binding&);
+CPU_Binding& operator= (const CPU_Binding&);
+
+std::vector<unsigned int>
+	Previous_CPUs;
+bool
+	Bound;
+};
+
 
 private:
 
+/**	Swap the bytes of a rendering increment, if required.
+
+	This is done by {@link data_disposition(Rendering_Monitor::Status,
+	const std::string&, const Cube&, const Cube&, void**, unsigned int)
+	data disposition} in the rendering thread, before the increment is
+	queued for pipelined disposition, while the increment data is still
+	in the processor cache.
+
+	The bytes of a {@link stretching() stretched} rendering are not
+	swapped: the decoded samples must remain in host order to index
+	the stretch tables, and the stretched pixels are single bytes.
+
+	When the bands are interleaved by pixel in a single image data
+	buffer each line is swapped as one contiguous run of samples.
+*/
+void swap_rendered_bytes (const Cube& region_rendered,
+	void** data, unsigned int data_line_stride);
+
+/**	Disposition of a rendering increment.
+
+	Floating point samples are calibrated, if required. Then, if
+	notification is requested, the data is delivered to the line sink,
+	if any, and the rendering monitor, if any, is notified.
+
+	@return	The rendering monitor notification result; true if no
+		notification was done.
+	@see	data_disposition(Rendering_Monitor::Status, const std::string&,
+		const Cube&, const Cube&)
+*/
+bool dispose_data
+	(Rendering_Monitor::Status status, const std::string& message,
+		const Cube& region_rendered, const Cube& image_region_rendered,
+		void** data, unsigned int data_line_stride, bool notify);
+
+//	Pipelined data disposition thread and queue.
+struct Disposition_Pipeline;
+
+//!	Data disposition thread procedure.
+void data_disposition_pipeline ();
+
+/**	Pad a number of image line samples to the buffer alignment.
+
+	@param	samples	The number of pixel samples in a line.
+	@return	The number of samples rounded up to a multiple of the
+		{@link Image_Buffer_Allocator::alignment() allocator alignment},
+		if {@link pad_image_lines(bool) image line padding} applies;
+		otherwise the samples value.
+*/
+unsigned int padded_line_samples (unsigned int samples) const;
+
+/**	Get the image data address of a band location.
+
+	No checks are made.
+
+	@param	band	The image band.
+	@param	line	The line relative to the rendered region.
+	@param	pixel	The pixel relative to the rendered region.
+	@return	The address of the pixel sample in the image data buffers,
+		including {@link chunked_image_data() chunked} image data.
+*/
+unsigned char* band_data (unsigned int band,
+	unsigned int line, unsigned int pixel) const;
+
+/**	Get the number of contiguous lines in the image data.
+
+	@param	line	A line relative to the rendered region.
+	@return	The number of lines, from the line, to the end of the image
+		data chunk that holds the line; or to the end of the rendered
+		region if the image data is not chunked.
+*/
+unsigned int chunk_segment_lines (unsigned int line) const;
+
+/**	Get the size of an image data chunk buffer.
+
+	@return	The number of bytes in each buffer of {@link
+		chunked_image_data() chunked} image data: one band of a chunk for
+		{@link separate_band_buffers(bool) separate band buffers};
+		otherwise all rendered bands of a chunk.
+*/
+unsigned long long chunk_buffer_size () const;
+
+/**	Allocate the image data chunks.
+
+	@see	chunked_image_data()
+*/
+void allocate_image_data_chunks ();
+
 /**	Allocate the Image_Data array.
 
 	If the Image_Data array has already been allocated nothing is done.
@@ -1427,6 +3249,42 @@ bool
 unsigned int
 	Rendered_Bits;
 
+//!	Maximum quality layers to be rendered; zero for all.
+unsigned int
+	Rendered_Quality_Layers;
+
+//!	Progressive rendering preview resolution levels; zero for none.
+unsigned int
+	Progressive_Levels;
+
+//!	Whether pixel samples are rendered as floats.
+bool
+	Float_Samples;
+
+/**	Per band calibration of floating point samples.
+	Empty until a calibration has been set.
+*/
+std::vector<float>
+	Calibration_Scale,
+	Calibration_Offset;
+
+//!	The stretch specification of a band.
+struct Band_Stretch
+	{
+	Stretch_Method				Method;
+	std::vector<unsigned char>	Table;
+	double						Low,
+								High;
+	};
+
+//!	Per band stretch specifications. Empty until a stretch has been set.
+std::vector<Band_Stretch>
+	Stretches;
+
+//!	Per band effective stretch lookup tables assembled for rendering.
+std::vector<std::vector<unsigned char> >
+	Stretch_Tables;
+
 //!	Suggested number of output image lines in each rendering increment.
 unsigned int
 	Rendering_Increment_Lines;
@@ -1435,6 +3293,28 @@ unsigned int
 unsigned int
 	Thread_Count;
 
+//!	Processors to which processing is bound.
+std::vector<unsigned int>
+	Processing_CPUs;
+
+//	Adaptive rendering increment.
+bool
+	Adaptive_Increment,
+	Low_Latency;
+
+//	Adaptive processing threads selection.
+bool
+	Adaptive_Threads;
+unsigned int
+	Thread_Work_Code_Blocks,
+	Effective_Threads;
+std::string
+	Threads_Reason;
+
+//!	Number of horizontal strips to be rendered concurrently.
+unsigned int
+	Rendering_Strips;
+
 //	JPIP_Client configuration options:
 
 //!	The default JPIP request timeout (seconds).
@@ -1454,6 +3334,44 @@ std::string
 Rendering_Monitor
 	*Monitor;
 
+Line_Sink
+	*Sink;
+
+JP2_Tile_Cache
+	*Tile_Cache;
+
+//!	The user's image data buffer allocator; NULL for the default.
+Image_Buffer_Allocator
+	*Buffer_Allocator;
+
+//!	The size, in bytes, of the locally managed image data buffer.
+size_t
+	Local_Buffer_Bytes;
+
+//!	Flags padding of locally managed image lines.
+bool
+	Pad_Image_Lines;
+
+//!	Flags allocation of a separate buffer for each band.
+bool
+	Separate_Band_Buffers;
+
+//!	Lines in each image data chunk; zero if not divided into row chunks.
+unsigned int
+	Chunk_Lines;
+
+//!	Locally managed image data chunk buffers with their sizes.
+std::vector<std::pair<void*, size_t> >
+	Chunk_Buffers;
+
+//!	Band addresses of each allocated image data chunk.
+std::vector<std::vector<void*> >
+	Chunk_Data;
+
+//!	Lines in each allocated image data chunk.
+unsigned int
+	Allocated_Chunk_Lines;
+
 static int
 	Default_Autoreconnect_Retries;
 int
@@ -1462,6 +3380,48 @@ int
 unsigned long long
 	Bytes_Rendered;
 
+//!	Statistics of the rendering in progress.
+Render_Statistics
+	Rendering_Statistics;
+
+//!	Statistics of the last completed rendering.
+Render_Statistics
+	Last_Rendering_Statistics;
+
+//!	Protects the Last_Rendering_Statistics.
+mutable std::mutex
+	Statistics_Lock;
+
+//!	Statistics clock times when the rendering started.
+double
+	Render_Start_Time,
+	Render_Start_CPU_Time;
+
+//!	Statistics clock times when the current increment started.
+double
+	Increment_Start_Time,
+	Increment_Start_CPU_Time;
+
+//!	Serializes asynchronous rendering state changes.
+std::mutex
+	Rendering_Lock;
+
+//!	Flags that an asynchronous rendering is in progress.
+bool
+	Async_Rendering;
+
+//!	Flags that the asynchronous rendering has been canceled.
+std::atomic<bool>
+	Rendering_Canceled;
+
+//!	Flags pipelined data disposition.
+bool
+	Pipelined_Disposition;
+
+//!	The data disposition pipeline; NULL until first used.
+std::unique_ptr<Disposition_Pipeline>
+	Pipeline;
+
 };	//	Class JP2_Reader
 
 /*=*****************************************************************************
@@ -0,0 +1,497 @@
+/*	JP2_Reader_Pool
+
+Copyright (C) 2026  Arizona Board of Regents on behalf of the
+Planetary Image Research Laboratory, Lunar and Planetary Laboratory at
+the University of Arizona.
+
+This library is free software; you can redistribute it and/or modify it
+under the terms of the GNU Lesser General Public License, version 2.1,
+as published by the Free Software Foundation.
+
+This library is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library; if not, write to the Free Software Foundation,
+Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA.
+
+*******************************************************************************/
+
+#include	"JP2_Reader_Pool.hh"
+
+#include	"JP2.hh"
+#include	"JP2_Reader.hh"
+#include	"JP2_Exception.hh"
+
+#include	<sstream>
+using std::ostringstream;
+using std::endl;
+
+#if defined (DEBUG)
+/*	DEBUG controls
+
+	DEBUG report selection options.
+	Define any of the following options to obtain the desired debug reports:
+*/
+#define DEBUG_ALL			-1
+#define DEBUG_CONSTRUCTORS	(1 << 0)
+#define DEBUG_ACCESSORS		(1 << 1)
+#define DEBUG_MANIPULATORS	(1 << 2)
+
+#include	<iostream>
+using std::clog;
+#endif	//	DEBUG
+
+
+namespace UA
+{
+namespace HiRISE
+{
+/*==============================================================================
+	Constants
+*/
+const char* const
+	JP2_Reader_Pool::ID =
+		"UA::HiRISE::JP2_Reader_Pool";
+
+#ifndef READER_POOL_READERS_PER_SOURCE
+#define READER_POOL_READERS_PER_SOURCE	8
+#endif
+const unsigned int
+	JP2_Reader_Pool::DEFAULT_READERS_PER_SOURCE	=
+		READER_POOL_READERS_PER_SOURCE;
+
+#ifndef READER_POOL_OPEN_LIMIT
+#define READER_POOL_OPEN_LIMIT			256
+#endif
+const unsigned int
+	JP2_Reader_Pool::DEFAULT_OPEN_LIMIT			= READER_POOL_OPEN_LIMIT;
+
+#ifndef READER_POOL_IDLE_SECONDS
+#define READER_POOL_IDLE_SECONDS		60
+#endif
+const unsigned int
+	JP2_Reader_Pool::DEFAULT_IDLE_SECONDS		= READER_POOL_IDLE_SECONDS;
+
+/*==============================================================================
+	Constructors
+*/
+JP2_Reader_Pool::JP2_Reader_Pool
+	(
+	unsigned int	readers_per_source,
+	unsigned int	open_limit,
+	unsigned int	idle_seconds
+	)
+	:	Readers_Per_Source (readers_per_source ?
+		readers_per_source : DEFAULT_READERS_PER_SOURCE),
+	Open_Limit (open_limit ?
+		(open_limit < 2 ? 2 : open_limit) : DEFAULT_OPEN_LIMIT),
+	Idle_Seconds (idle_seconds),
+	Lock (),
+	Available (),
+	Sources (),
+	Checked_Out (),
+	Open_Readers (0)
+{
+#if ((DEBUG) & DEBUG_CONSTRUCTORS)
+clog << ">-< JP2_Reader_Pool @ " << (void*)this
+		<< ": " << Readers_Per_Source << " readers per source, "
+		<< Open_Limit << " open limit, "
+		<< Idle_Seconds << " idle seconds" << endl;
+#endif
+}
+
+
+JP2_Reader_Pool::~JP2_Reader_Pool ()
+{
+#if ((DEBUG) & DEBUG_CONSTRUCTORS)
+clog << ">>> ~JP2_Reader_Pool @ " << (void*)this << endl;
+#endif
+Reader_List
+	closed;
+std::lock_guard<std::mutex>
+	lock (Lock);
+close_idle (closed, true);
+//	The remaining prototypes are deleted with the Sources.
+}
+
+/*==============================================================================
+	Accessors
+*/
+unsigned int
+JP2_Reader_Pool::open_readers () const
+{
+std::lock_guard<std::mutex>
+	lock (Lock);
+return Open_Readers;
+}
+
+
+unsigned int
+JP2_Reader_Pool::idle_readers () const
+{
+std::lock_guard<std::mutex>
+	lock (Lock);
+unsigned int
+	total = 0;
+for (Source_Map::const_iterator
+		source = Sources.begin ();
+		source != Sources.end ();
+	  ++source)
+	total += source->second.Idle.size ();
+return total;
+}
+
+
+unsigned int
+JP2_Reader_Pool::checked_out_readers () const
+{
+std::lock_guard<std::mutex>
+	lock (Lock);
+return Checked_Out.size ();
+}
+
+/*==============================================================================
+	Manipulators
+*/
+JP2_Reader*
+JP2_Reader_Pool::checkout
+	(
+	const std::string&	source,
+	bool				wait
+	)
+{
+#if ((DEBUG) & DEBUG_MANIPULATORS)
+clog << ">>> JP2_Reader_Pool::checkout: " << source << endl;
+#endif
+if (source.empty ())
+	throw JP2_Invalid_Argument
+		("Can't check out a JP2_Reader without a source.", ID);
+
+Reader_List
+	closed;
+std::unique_lock<std::mutex>
+	lock (Lock);
+unsigned int
+	needed;
+while (true)
+	{
+	close_idle (closed);
+
+	Source_Readers
+		&readers = Sources[source];
+	readers.Last_Use = Clock::now ();
+	if (! readers.Idle.empty ())
+		{
+		JP2_Reader
+			*reader = readers.Idle.front ().Reader;
+		readers.Idle.pop_front ();
+		++readers.Checked_Out;
+		Checked_Out[reader] = source;
+		#if ((DEBUG) & DEBUG_MANIPULATORS)
+		clog << "<<< JP2_Reader_Pool::checkout: idle reader @ "
+				<< (void*)reader << endl;
+		#endif
+		return reader;
+		}
+
+	//	A new reader, and a prototype if there is none.
+	needed = readers.Prototype ? 1 : 2;
+	if (readers.Checked_Out < Readers_Per_Source &&
+		make_room (needed, source, closed))
+		break;
+
+	if (! wait)
+		{
+		#if ((DEBUG) & DEBUG_MANIPULATORS)
+		clog << "<<< JP2_Reader_Pool::checkout: no reader available" << endl;
+		#endif
+		return NULL;
+		}
+	if (! closed.empty ())
+		{
+		//	Don't hold closed readers open while waiting.
+		lock.unlock ();
+		closed.clear ();
+		lock.lock ();
+		continue;
+		}
+	#if ((DEBUG) & DEBUG_MANIPULATORS)
+	clog << "    waiting for a reader" << endl;
+	#endif
+	Available.wait (lock);
+	}
+
+//	Reserve the new reader while it is opened without the Lock.
+Open_Readers += needed;
+++Sources[source].Checked_Out;
+std::shared_ptr<JP2_Reader>
+	prototype (Sources[source].Prototype);
+lock.unlock ();
+
+JP2_Reader
+	*reader = NULL;
+try
+	{
+	if (! prototype)
+		{
+		#if ((DEBUG) & DEBUG_MANIPULATORS)
+		clog << "    construct the prototype" << endl;
+		#endif
+		prototype.reset (JP2::reader (source));
+		}
+	reader = prototype->shared_clone ();
+	if (! reader->is_open ())
+		{
+		ostringstream
+			message;
+		message
+			<< "Failed to open a pooled JP2_Reader" << endl
+			<< "for the " << source << " source.";
+		throw JP2_IO_Failure (message.str (), ID);
+		}
+	}
+catch (...)
+	{
+	if (reader)
+		delete reader;
+	lock.lock ();
+	Open_Readers -= needed;
+	--Sources[source].Checked_Out;
+	Available.notify_all ();
+	throw;
+	}
+
+lock.lock ();
+Source_Readers
+	&readers = Sources[source];
+if (needed > 1)
+	{
+	if (readers.Prototype)
+		{
+		//	Another checkout provided the prototype.
+		--Open_Readers;
+		closed.push_back (prototype);
+		}
+	else
+		readers.Prototype = prototype;
+	}
+Checked_Out[reader] = source;
+#if ((DEBUG) & DEBUG_MANIPULATORS)
+clog << "<<< JP2_Reader_Pool::checkout: new reader @ "
+		<< (void*)reader << endl;
+#endif
+return reader;
+}
+
+
+void
+JP2_Reader_Pool::checkin
+	(
+	JP2_Reader*	reader
+	)
+{
+#if ((DEBUG) & DEBUG_MANIPULATORS)
+clog << ">>> JP2_Reader_Pool::checkin: " << (void*)reader << endl;
+#endif
+if (! reader)
+	return;
+
+Reader_List
+	closed;
+std::lock_guard<std::mutex>
+	lock (Lock);
+std::unordered_map<const JP2_Reader*, std::string>::iterator
+	entry = Checked_Out.find (reader);
+if (entry == Checked_Out.end ())
+	{
+	ostringstream
+		message;
+	message
+		<< "Can't check in the JP2_Reader for the "
+			<< reader->source_name () << " source" << endl
+		<< "that was not checked out of this pool.";
+	throw JP2_Invalid_Argument (message.str (), ID);
+	}
+Source_Readers
+	&readers = Sources[entry->second];
+Checked_Out.erase (entry);
+--readers.Checked_Out;
+readers.Last_Use = Clock::now ();
+
+/*	Release the user's rendering resources and restore the default
+	rendering configuration for the next user.
+
+	The processing threads are kept for the next checkout of an idle
+	reader; they are returned when the pool deletes the reader.
+*/
+try {reader->reset_rendering ();}
+catch (...)
+	{
+	//	A reader that can't be reset is not reused.
+	reader->close ();
+	}
+
+if (reader->is_open ())
+	{
+	Idle_Reader
+		idle = {reader, readers.Last_Use};
+	readers.Idle.push_front (idle);
+	}
+else
+	{
+	#if ((DEBUG) & DEBUG_MANIPULATORS)
+	clog << "    reader is closed" << endl;
+	#endif
+	--Open_Readers;
+	closed.push_back (std::shared_ptr<JP2_Reader> (reader));
+	}
+close_idle (closed);
+Available.notify_all ();
+#if ((DEBUG) & DEBUG_MANIPULATORS)
+clog << "<<< JP2_Reader_Pool::checkin" << endl;
+#endif
+}
+
+
+void
+JP2_Reader_Pool::close_idle ()
+{
+Reader_List
+	closed;
+std::lock_guard<std::mutex>
+	lock (Lock);
+close_idle (closed);
+}
+
+
+void
+JP2_Reader_Pool::clear ()
+{
+Reader_List
+	closed;
+std::lock_guard<std::mutex>
+	lock (Lock);
+close_idle (closed, true);
+}
+
+
+void
+JP2_Reader_Pool::close_idle
+	(
+	Reader_List&	closed,
+	bool			everything
+	)
+{
+Clock::time_point
+	now = Clock::now ();
+Clock::duration
+	idle = std::chrono::seconds (Idle_Seconds);
+Reader_List::size_type
+	count = closed.size ();
+
+Source_Map::iterator
+	source = Sources.begin ();
+while (source != Sources.end ())
+	{
+	Source_Readers
+		&readers = source->second;
+	while (! readers.Idle.empty () &&
+			(everything ||
+			 now - readers.Idle.back ().Since > idle))
+		{
+		closed.push_back
+			(std::shared_ptr<JP2_Reader> (readers.Idle.back ().Reader));
+		readers.Idle.pop_back ();
+		--Open_Readers;
+		}
+	if (readers.Idle.empty () &&
+		! readers.Checked_Out &&
+		(everything ||
+		 now - readers.Last_Use > idle))
+		{
+		//	Nothing left for the source.
+		if (readers.Prototype)
+			{
+			closed.push_back (readers.Prototype);
+			--Open_Readers;
+			}
+		source = Sources.erase (source);
+		}
+	else
+		++source;
+	}
+
+if (closed.size () != count)
+	{
+	#if ((DEBUG) & DEBUG_MANIPULATORS)
+	clog << "    JP2_Reader_Pool::close_idle: "
+			<< (closed.size () - count) << " readers closed" << endl;
+	#endif
+	Available.notify_all ();
+	}
+}
+
+
+bool
+JP2_Reader_Pool::make_room
+	(
+	unsigned int		needed,
+	const std::string&	excluded,
+	Reader_List&		closed
+	)
+{
+while (Open_Readers + needed > Open_Limit)
+	{
+	Source_Map::iterator
+		oldest = Sources.end (),
+		unused = Sources.end ();
+	for (Source_Map::iterator
+			source = Sources.begin ();
+			source != Sources.end ();
+		  ++source)
+		{
+		Source_Readers
+			&readers = source->second;
+		if (! readers.Idle.empty ())
+			{
+			if (oldest == Sources.end () ||
+				readers.Idle.back ().Since <
+					oldest->second.Idle.back ().Since)
+				oldest = source;
+			}
+		else
+		if (! readers.Checked_Out &&
+			readers.Prototype &&
+			source->first != excluded)
+			{
+			if (unused == Sources.end () ||
+				readers.Last_Use < unused->second.Last_Use)
+				unused = source;
+			}
+		}
+
+	if (oldest != Sources.end ())
+		{
+		closed.push_back (std::shared_ptr<JP2_Reader>
+			(oldest->second.Idle.back ().Reader));
+		oldest->second.Idle.pop_back ();
+		}
+	else
+	if (unused != Sources.end ())
+		{
+		closed.push_back (unused->second.Prototype);
+		Sources.erase (unused);
+		}
+	else
+		return false;
+	--Open_Readers;
+	}
+return true;
+}
+
+
+}	//	namespace HiRISE
+}	//	namespace UA
@@ -0,0 +1,317 @@
+/*	JP2_Reader_Pool
+
+Copyright (C) 2026  Arizona Board of Regents on behalf of the
+Planetary Image Research Laboratory, Lunar and Planetary Laboratory at
+the University of Arizona.
+
+This library is free software; you can redistribute it and/or modify it
+under the terms of the GNU Lesser General Public License, version 2.1,
+as published by the Free Software Foundation.
+
+This library is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library; if not, write to the Free Software Foundation,
+Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA.
+
+*******************************************************************************/
+
+#ifndef _JP2_Reader_Pool_
+#define _JP2_Reader_Pool_
+
+#include	<string>
+#include	<list>
+#include	<map>
+#include	<unordered_map>
+#include	<vector>
+#include	<memory>
+#include	<mutex>
+#include	<condition_variable>
+#include	<chrono>
+
+namespace UA
+{
+namespace HiRISE
+{
+//	Forward reference.
+class JP2_Reader;
+
+/**	A <i>JP2_Reader_Pool</i> holds open JP2_Readers for reuse.
+
+	Constructing and opening a JP2_Reader for each request on a source
+	is expensive. A JP2_Reader_Pool retains open readers so that a
+	reader for a source may be {@link checkout(const std::string&, bool)
+	checked out}, used, and {@link checkin(JP2_Reader*) checked in}
+	again with its source, codestream and processing threads intact.
+
+	The first reader for a source is a prototype {@link
+	JP2::reader(const std::string&) constructed} for the source. The
+	prototype is never checked out; each reader that is checked out is
+	a {@link JP2_Reader::shared_clone() shared clone} of the prototype,
+	so only the prototype ingests the source metadata.
+
+	The number of readers that may be checked out for each source is
+	limited to the {@link readers_per_source() readers per source}. The
+	total number of open readers held by the pool, including the
+	prototypes, is limited to the {@link open_limit() open limit}; this
+	bounds the number of open file descriptors. When the open limit is
+	reached the least recently used idle readers, of any source, are
+	closed to make room for a new reader. Readers that have been idle
+	for longer than the {@link idle_seconds() idle time} are closed.
+
+	The pool is thread safe. When no reader for a source can be made
+	available a checkout either waits for a reader to be checked in or
+	returns NULL.
+
+	@author		agent
+*/
+class JP2_Reader_Pool
+{
+public:
+/*==============================================================================
+	Constants
+*/
+//!	Class identification name with source code version and date.
+static const char* const
+	ID;
+
+/**	The default maximum number of readers checked out for a source.
+
+	The default is 8.
+*/
+static const unsigned int
+	DEFAULT_READERS_PER_SOURCE;
+
+/**	The default maximum number of open readers held by the pool.
+
+	The default is 256.
+*/
+static const unsigned int
+	DEFAULT_OPEN_LIMIT;
+
+/**	The default number of seconds a reader may be idle before it is
+	closed.
+
+	The default is 60 seconds.
+*/
+static const unsigned int
+	DEFAULT_IDLE_SECONDS;
+
+/*==============================================================================
+	Constructors
+*/
+/**	Construct a JP2_Reader_Pool.
+
+	@param	readers_per_source	The maximum number of readers that may
+		be checked out for each source. If zero the {@link
+		#DEFAULT_READERS_PER_SOURCE} is used.
+	@param	open_limit	The maximum number of open readers held by the
+		pool. If zero the {@link #DEFAULT_OPEN_LIMIT} is used. This is
+		never less than two; room for the prototype and one reader.
+	@param	idle_seconds	The number of seconds a checked in reader
+		may remain idle before it is closed.
+*/
+explicit JP2_Reader_Pool
+	(
+	unsigned int	readers_per_source = DEFAULT_READERS_PER_SOURCE,
+	unsigned int	open_limit = DEFAULT_OPEN_LIMIT,
+	unsigned int	idle_seconds = DEFAULT_IDLE_SECONDS
+	);
+
+/**	Destroy the JP2_Reader_Pool.
+
+	All idle readers and prototypes are deleted. <b>N.B.</b>: Readers
+	that are checked out when the pool is destroyed are not deleted;
+	they become owned by the user.
+*/
+~JP2_Reader_Pool ();
+
+private:
+//	Not copyable.
+JP2_Reader_Pool (const JP2_Reader_Pool&);
+JP2_Reader_Pool& operator= (const JP2_Reader_Pool&);
+
+public:
+/*==============================================================================
+	Accessors
+*/
+//!	Get the maximum number of readers checked out for a source.
+inline unsigned int readers_per_source () const
+	{return Readers_Per_Source;}
+
+//!	Get the maximum number of open readers held by the pool.
+inline unsigned int open_limit () const
+	{return Open_Limit;}
+
+//!	Get the number of seconds a reader may be idle before it is closed.
+inline unsigned int idle_seconds () const
+	{return Idle_Seconds;}
+
+/**	Get the number of open readers held by the pool.
+
+	@return	The number of open readers, including prototypes, idle
+		readers, and readers that are checked out.
+*/
+unsigned int open_readers () const;
+
+/**	Get the number of idle readers.
+
+	@return	The number of readers that are checked in and available
+		to be checked out.
+*/
+unsigned int idle_readers () const;
+
+/**	Get the number of readers that are checked out.
+
+	@return	The number of readers that are checked out.
+*/
+unsigned int checked_out_readers () const;
+
+/*==============================================================================
+	Manipulators
+*/
+/**	Check out a reader for a source.
+
+	The most recently checked in idle reader for the source is provided
+	if one is available. Otherwise a new reader is cloned from the
+	prototype for the source, which is constructed if necessary.
+
+	The reader is open on the source with the default {@link
+	JP2_Reader::reset_rendering() rendering configuration}; the user
+	should configure the rendering as needed.
+
+	@param	source	The source name for the reader.
+	@param	wait	If true and no reader can be made available because
+		the {@link readers_per_source() readers per source} or {@link
+		open_limit() open limit} has been reached, wait until a reader
+		is checked in. If false, NULL is returned instead of waiting.
+	@return	A pointer to a JP2_Reader open on the source. This will be
+		NULL if wait is false and no reader is available. The reader
+		must be {@link checkin(JP2_Reader*) checked in} when it is no
+		longer being used.
+	@throws	JP2_Exception	If a reader for the source could not be
+		constructed or opened.
+*/
+JP2_Reader* checkout (const std::string& source, bool wait = true);
+
+/**	Check in a reader.
+
+	The reader's {@link JP2_Reader::reset_rendering() rendering
+	configuration is reset}, which releases any rendering monitor, line
+	sink or user image data buffers registered with it, so the next
+	user of the reader does not inherit the rendering region,
+	resolution, bands or other settings. If the reader is still
+	open it becomes idle and available to be checked out again with
+	its processing threads intact; otherwise it is deleted. A reader's
+	{@link JP2_Reader::release_processing_threads() processing threads}
+	are only released, returning any threads counted against the
+	{@link JP2_File_Reader::processing_threads_limit(unsigned int)
+	processing threads limit}, when the pool deletes the reader:
+	because it was closed when checked in, it has been idle too long,
+	or room is needed for another reader.
+
+	@param	reader	A pointer to a JP2_Reader that was {@link
+		checkout(const std::string&, bool) checked out} of this pool.
+		If NULL nothing is done.
+	@throws	JP2_Invalid_Argument	If the reader was not checked out
+		of this pool.
+*/
+void checkin (JP2_Reader* reader);
+
+/**	Close idle readers.
+
+	Readers that have been idle longer than the {@link idle_seconds()
+	idle time} are deleted, as are the prototypes of sources for which
+	no readers remain.
+*/
+void close_idle ();
+
+/**	Close all idle readers and unused prototypes.
+
+	Readers that are checked out are not affected.
+*/
+void clear ();
+
+/*==============================================================================
+	Data
+*/
+private:
+
+typedef std::chrono::steady_clock	Clock;
+
+struct Idle_Reader
+	{
+	JP2_Reader*			Reader;
+	Clock::time_point	Since;
+	};
+
+//!	The readers for a source.
+struct Source_Readers
+	{
+	Source_Readers ()
+		:	Checked_Out (0)
+		{}
+
+	//!	The reader that is cloned; never checked out.
+	std::shared_ptr<JP2_Reader>	Prototype;
+	//!	Idle readers; the most recently checked in at the front.
+	std::list<Idle_Reader>		Idle;
+	//!	Readers checked out, or being opened to be checked out.
+	unsigned int				Checked_Out;
+	//!	When the source was last used.
+	Clock::time_point			Last_Use;
+	};
+
+typedef std::map<std::string, Source_Readers>	Source_Map;
+typedef std::vector<std::shared_ptr<JP2_Reader> >	Reader_List;
+
+/*	Move readers that have been idle too long, or all idle readers and
+	unused prototypes if everything is true, to the closed list.
+
+	The Lock must be held.
+*/
+void close_idle (Reader_List& closed, bool everything = false);
+
+/*	Move least recently used idle readers, and unused prototypes of
+	sources other than the excluded source, to the closed list until
+	there is room to open the needed number of readers.
+
+	The Lock must be held.
+
+	@return	true if there is room; false otherwise.
+*/
+bool make_room (unsigned int needed, const std::string& excluded,
+	Reader_List& closed);
+
+const unsigned int
+	Readers_Per_Source,
+	Open_Limit,
+	Idle_Seconds;
+
+mutable std::mutex
+	Lock;
+
+//!	Signalled when a reader is checked in or closed.
+std::condition_variable
+	Available;
+
+Source_Map
+	Sources;
+
+//!	Source names of the checked out readers.
+std::unordered_map<const JP2_Reader*, std::string>
+	Checked_Out;
+
+//!	Open readers, including prototypes and readers being opened.
+unsigned int
+	Open_Readers;
+
+};	//	class JP2_Reader_Pool
+
+
+}	//	namespace HiRISE
+}	//	namespace UA
+#endif	//	_JP2_Reader_Pool_
@@ -0,0 +1,266 @@
+/*	JP2_Tile_Cache
+
+Copyright (C) 2026  Arizona Board of Regents on behalf of the
+Planetary Image Research Laboratory, Lunar and Planetary Laboratory at
+the University of Arizona.
+
+This library is free software; you can redistribute it and/or modify it
+under the terms of the GNU Lesser General Public License, version 2.1,
+as published by the Free Software Foundation.
+
+This library is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library; if not, write to the Free Software Foundation,
+Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA.
+
+*******************************************************************************/
+
+#include	"JP2_Tile_Cache.hh"
+#include	"JP2_Metrics.hh"
+
+#include	<functional>
+
+#if defined (DEBUG)
+/*	DEBUG controls
+
+	DEBUG report selection options.
+	Define any of the following options to obtain the desired debug reports:
+*/
+#define DEBUG_ALL			-1
+#define DEBUG_CONSTRUCTORS	(1 << 0)
+#define DEBUG_ACCESSORS		(1 << 1)
+#define DEBUG_MANIPULATORS	(1 << 2)
+
+#include	<iostream>
+using std::clog;
+using std::endl;
+#endif	//	DEBUG
+
+
+namespace UA
+{
+namespace HiRISE
+{
+/*==============================================================================
+	Constants
+*/
+const char* const
+	JP2_Tile_Cache::ID =
+		"UA::HiRISE::JP2_Tile_Cache";
+
+#ifndef TILE_CACHE_BUDGET
+#define TILE_CACHE_BUDGET			(256ULL * 1024 * 1024)
+#endif
+const unsigned long long
+	JP2_Tile_Cache::DEFAULT_BUDGET		= TILE_CACHE_BUDGET;
+
+#ifndef TILE_CACHE_CELL_SIZE
+#define TILE_CACHE_CELL_SIZE		512
+#endif
+const unsigned int
+	JP2_Tile_Cache::DEFAULT_CELL_SIZE	= TILE_CACHE_CELL_SIZE;
+
+/*==============================================================================
+	Constructors
+*/
+JP2_Tile_Cache::JP2_Tile_Cache
+	(
+	unsigned long long	budget,
+	unsigned int		cell_size
+	)
+	:	Lock (),
+	Entries (),
+	Usage (),
+	Budget (budget),
+	Bytes (0),
+	Cell_Size (cell_size ? cell_size : DEFAULT_CELL_SIZE),
+	Hits (0),
+	Misses (0),
+	Evictions (0)
+{
+#if ((DEBUG) & DEBUG_CONSTRUCTORS)
+clog << ">-< JP2_Tile_Cache @ " << (void*)this
+		<< ": budget " << Budget << ", cell size " << Cell_Size << endl;
+#endif
+}
+
+/*==============================================================================
+	Accessors
+*/
+std::size_t
+JP2_Tile_Cache::Key_Hash::operator()
+	(
+	const Key&	key
+	)
+	const
+{
+std::size_t
+	hash = std::hash<std::string> ()(key.Source);
+hash = hash * 31 + key.Resolution_Level;
+hash = hash * 31 + key.Band;
+hash = hash * 31 + (std::size_t)key.Column;
+hash = hash * 31 + (std::size_t)key.Row;
+hash = hash * 31 + (std::size_t)key.Format;
+return hash;
+}
+
+
+JP2_Tile_Cache&
+JP2_Tile_Cache::budget
+	(
+	unsigned long long	bytes
+	)
+{
+std::lock_guard<std::mutex>
+	lock (Lock);
+Budget = bytes;
+evict (Budget);
+return *this;
+}
+
+
+unsigned long long
+JP2_Tile_Cache::budget () const
+{
+std::lock_guard<std::mutex>
+	lock (Lock);
+return Budget;
+}
+
+
+unsigned long long
+JP2_Tile_Cache::bytes () const
+{
+std::lock_guard<std::mutex>
+	lock (Lock);
+return Bytes;
+}
+
+
+unsigned int
+JP2_Tile_Cache::tiles () const
+{
+std::lock_guard<std::mutex>
+	lock (Lock);
+return Entries.size ();
+}
+
+
+JP2_Tile_Cache&
+JP2_Tile_Cache::reset_statistics ()
+{
+Hits = 0;
+Misses = 0;
+Evictions = 0;
+return *this;
+}
+
+/*==============================================================================
+	Manipulators
+*/
+std::shared_ptr<const JP2_Tile_Cache::Tile>
+JP2_Tile_Cache::find
+	(
+	const Key&	key
+	)
+{
+std::lock_guard<std::mutex>
+	lock (Lock);
+std::unordered_map<Key, Entry, Key_Hash>::iterator
+	entry = Entries.find (key);
+if (entry == Entries.end ())
+	{
+	++Misses;
+	JP2_Metrics::cache_miss ();
+	return std::shared_ptr<const Tile> ();
+	}
+++Hits;
+JP2_Metrics::cache_hit ();
+
+//	Most recently used.
+Usage.splice (Usage.begin (), Usage, entry->second.Usage);
+return entry->second.Cached_Tile;
+}
+
+
+void
+JP2_Tile_Cache::insert
+	(
+	const Key&							key,
+	const std::shared_ptr<const Tile>&	tile
+	)
+{
+if (! tile)
+	return;
+unsigned long long
+	size = tile->Data.size ();
+
+std::lock_guard<std::mutex>
+	lock (Lock);
+if (size > Budget)
+	{
+	#if ((DEBUG) & DEBUG_MANIPULATORS)
+	clog << "    JP2_Tile_Cache::insert: " << size
+			<< " byte tile exceeds the " << Budget << " byte budget" << endl;
+	#endif
+	return;
+	}
+
+std::unordered_map<Key, Entry, Key_Hash>::iterator
+	entry = Entries.find (key);
+if (entry != Entries.end ())
+	{
+	//	Replace the existing tile.
+	Bytes -= entry->second.Cached_Tile->Data.size ();
+	Usage.erase (entry->second.Usage);
+	Entries.erase (entry);
+	}
+
+evict (Budget - size);
+
+Usage.push_front (key);
+Entry
+	&new_entry = Entries[key];
+new_entry.Cached_Tile = tile;
+new_entry.Usage = Usage.begin ();
+Bytes += size;
+}
+
+
+JP2_Tile_Cache&
+JP2_Tile_Cache::clear ()
+{
+std::lock_guard<std::mutex>
+	lock (Lock);
+Entries.clear ();
+Usage.clear ();
+Bytes = 0;
+return *this;
+}
+
+
+void
+JP2_Tile_Cache::evict
+	(
+	unsigned long long	budget
+	)
+{
+while (Bytes > budget &&
+		! Usage.empty ())
+	{
+	std::unordered_map<Key, Entry, Key_Hash>::iterator
+		entry = Entries.find (Usage.back ());
+	Bytes -= entry->second.Cached_Tile->Data.size ();
+	Entries.erase (entry);
+	Usage.pop_back ();
+	++Evictions;
+	}
+}
+
+
+}	//	namespace HiRISE
+}	//	namespace UA
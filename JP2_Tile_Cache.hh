@@ -0,0 +1,293 @@
+/*	JP2_Tile_Cache
+
+Copyright (C) 2026  Arizona Board of Regents on behalf of the
+Planetary Image Research Laboratory, Lunar and Planetary Laboratory at
+the University of Arizona.
+
+This library is free software; you can redistribute it and/or modify it
+under the terms of the GNU Lesser General Public License, version 2.1,
+as published by the Free Software Foundation.
+
+This library is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library; if not, write to the Free Software Foundation,
+Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA.
+
+*******************************************************************************/
+
+#ifndef _JP2_Tile_Cache_
+#define _JP2_Tile_Cache_
+
+#include	<string>
+#include	<vector>
+#include	<list>
+#include	<unordered_map>
+#include	<memory>
+#include	<mutex>
+#include	<atomic>
+
+namespace UA
+{
+namespace HiRISE
+{
+/**	A <i>JP2_Tile_Cache</i> holds decoded image tiles for reuse by
+	JP2_Readers.
+
+	The rendered image grid at each resolution level is partitioned into
+	square cells of the {@link cell_size() cell size}. A decoded Tile
+	holds the pixel samples of one band of one cell, before any pixel
+	byte swapping or calibration is applied. Tiles are identified by a
+	Key of the source name, resolution level, band, cell column and row,
+	and a rendering format signature that distinguishes renderings that
+	produce different sample values (e.g. pixel precision).
+
+	The cache is limited to a {@link budget() byte budget}. When a tile
+	is inserted the least recently used tiles are evicted as needed to
+	keep the cache within its budget. Tiles are shared; an evicted tile
+	remains valid for as long as a user holds it.
+
+	A single cache may be shared by any number of JP2_Readers, in any
+	number of threads, by {@link JP2_Reader::tile_cache(JP2_Tile_Cache*)
+	registering} it with each reader. The cache must remain valid while it
+	is registered.
+
+	The numbers of {@link hits() hits}, {@link misses() misses} and
+	{@link evictions() evictions} are counted to help size the cache.
+
+	@author		agent
+*/
+class JP2_Tile_Cache
+{
+public:
+/*==============================================================================
+	Constants
+*/
+//!	Class identification name with source code version and date.
+static const char* const
+	ID;
+
+/**	The default cache byte budget.
+
+	The default is 256 MB.
+*/
+static const unsigned long long
+	DEFAULT_BUDGET;
+
+/**	The default cell size.
+
+	The default is 512 pixels.
+*/
+static const unsigned int
+	DEFAULT_CELL_SIZE;
+
+/*==============================================================================
+	Types
+*/
+//!	Tile identification.
+struct Key
+	{
+	//!	The source name of the image.
+	std::string			Source;
+	//!	The rendering resolution level.
+	unsigned int		Resolution_Level;
+	//!	The image band.
+	unsigned int		Band;
+	//!	Cell column on the rendered grid.
+	int					Column;
+	//!	Cell row on the rendered grid.
+	int					Row;
+	//!	Signature of the rendering format that produced the samples.
+	unsigned long long	Format;
+
+	bool operator== (const Key& key) const
+		{
+		return
+			Resolution_Level == key.Resolution_Level &&
+			Band == key.Band &&
+			Column == key.Column &&
+			Row == key.Row &&
+			Format == key.Format &&
+			Source == key.Source;
+		}
+	};
+
+//!	Key hash function.
+struct Key_Hash
+	{
+	std::size_t operator() (const Key& key) const;
+	};
+
+//!	Decoded pixel samples of one band of one cell.
+struct Tile
+	{
+	/**	The cell region on the rendered grid.
+
+		This is the cell clipped to the rendered image.
+	*/
+	int							X,
+								Y;
+	unsigned int				Width,
+								Height;
+	//!	Bytes per pixel sample.
+	unsigned int				Pixel_Bytes;
+	//!	Tightly packed lines of pixel samples.
+	std::vector<unsigned char>	Data;
+	};
+
+/*==============================================================================
+	Constructors
+*/
+/**	Construct a JP2_Tile_Cache.
+
+	@param	budget	The cache byte budget.
+	@param	cell_size	The width and height, in pixels, of the cells
+		of the rendered image grid. If zero the {@link
+		#DEFAULT_CELL_SIZE} is used.
+*/
+explicit JP2_Tile_Cache (unsigned long long budget = DEFAULT_BUDGET,
+	unsigned int cell_size = DEFAULT_CELL_SIZE);
+
+private:
+//	Not copyable.
+JP2_Tile_Cache (const JP2_Tile_Cache&);
+JP2_Tile_Cache& operator= (const JP2_Tile_Cache&);
+
+public:
+/*==============================================================================
+	Accessors
+*/
+/**	Get the cell size.
+
+	@return	The width and height, in pixels, of the cells of the
+		rendered image grid.
+*/
+inline unsigned int cell_size () const
+	{return Cell_Size;}
+
+/**	Set the cache byte budget.
+
+	If the cache holds more than the new budget the least recently used
+	tiles are evicted.
+
+	@param	bytes	The maximum number of tile data bytes to be held.
+	@return	This JP2_Tile_Cache.
+*/
+JP2_Tile_Cache& budget (unsigned long long bytes);
+
+/**	Get the cache byte budget.
+
+	@return	The maximum number of tile data bytes to be held.
+*/
+unsigned long long budget () const;
+
+/**	Get the number of tile data bytes held.
+
+	@return	The number of tile data bytes held.
+*/
+unsigned long long bytes () const;
+
+/**	Get the number of tiles held.
+
+	@return	The number of tiles held.
+*/
+unsigned int tiles () const;
+
+//!	Get the number of {@link find(const Key&) finds} that found a tile.
+inline unsigned long long hits () const
+	{return Hits;}
+
+//!	Get the number of {@link find(const Key&) finds} that found nothing.
+inline unsigned long long misses () const
+	{return Misses;}
+
+//!	Get the number of tiles evicted to stay within the budget.
+inline unsigned long long evictions () const
+	{return Evictions;}
+
+/**	Reset the hits, misses and evictions counts to zero.
+
+	@return	This JP2_Tile_Cache.
+*/
+JP2_Tile_Cache& reset_statistics ();
+
+/*==============================================================================
+	Manipulators
+*/
+/**	Find a tile.
+
+	A tile that is found becomes the most recently used tile.
+
+	@param	key	The Key of the tile.
+	@return	A shared pointer to the tile, or an empty pointer if the
+		tile is not held.
+*/
+std::shared_ptr<const Tile> find (const Key& key);
+
+/**	Insert a tile.
+
+	The tile becomes the most recently used tile, replacing any tile
+	with the same key. The least recently used tiles are evicted as
+	needed to stay within the budget. A tile larger than the budget is
+	not held.
+
+	@param	key	The Key of the tile.
+	@param	tile	A shared pointer to the tile.
+*/
+void insert (const Key& key, const std::shared_ptr<const Tile>& tile);
+
+/**	Remove all tiles.
+
+	The statistics are not reset.
+
+	@return	This JP2_Tile_Cache.
+*/
+JP2_Tile_Cache& clear ();
+
+/*==============================================================================
+	Data
+*/
+private:
+
+//!	Least recently used tile order; the most recent at the front.
+typedef std::list<Key>	Usage_List;
+
+struct Entry
+	{
+	std::shared_ptr<const Tile>	Cached_Tile;
+	Usage_List::iterator		Usage;
+	};
+
+//!	Evict least recently used tiles until the cache fits in the budget.
+void evict (unsigned long long budget);
+
+mutable std::mutex
+	Lock;
+
+std::unordered_map<Key, Entry, Key_Hash>
+	Entries;
+
+Usage_List
+	Usage;
+
+unsigned long long
+	Budget,
+	Bytes;
+
+const unsigned int
+	Cell_Size;
+
+std::atomic<unsigned long long>
+	Hits,
+	Misses,
+	Evictions;
+
+};	//	class JP2_Tile_Cache
+
+
+}	//	namespace HiRISE
+}	//	namespace UA
+#endif	//	_JP2_Tile_Cache_
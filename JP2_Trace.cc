@@ -0,0 +1,245 @@
+/*	JP2_Trace
+
+Copyright (C) 2026  Arizona Board of Regents on behalf of the
+Planetary Image Research Laboratory, Lunar and Planetary Laboratory at
+the University of Arizona.
+
+This library is free software; you can redistribute it and/or modify it
+under the terms of the GNU Lesser General Public License, version 2.1,
+as published by the Free Software Foundation.
+
+This library is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library; if not, write to the Free Software Foundation,
+Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA.
+
+*******************************************************************************/
+
+#include	"JP2_Trace.hh"
+
+#include	"JP2_Exception.hh"
+
+#include	<fstream>
+#include	<sstream>
+#include	<iomanip>
+#include	<mutex>
+#include	<chrono>
+#include	<cstdlib>
+#include	<cstring>
+#include	<cerrno>
+using std::string;
+using std::ofstream;
+using std::ostringstream;
+using std::endl;
+
+#ifdef _WIN32
+#include	<process.h>
+#define getpid	_getpid
+#else
+#include	<unistd.h>
+#endif
+
+#if defined (DEBUG)
+/*	DEBUG controls
+
+	DEBUG report selection options.
+	Define any of the following options to obtain the desired debug reports:
+*/
+#define DEBUG_ALL			-1
+#define DEBUG_TRACING		(1 << 0)
+
+#include	<iostream>
+using std::clog;
+#endif	//	DEBUG
+
+
+namespace UA
+{
+namespace HiRISE
+{
+/*==============================================================================
+	Constants
+*/
+const char* const
+	JP2_Trace::ID =
+		"UA::HiRISE::JP2_Trace";
+
+#ifndef TRACE_ENVIRONMENT_VARIABLE
+#define TRACE_ENVIRONMENT_VARIABLE	"JP2_TRACE"
+#endif
+const char* const
+	JP2_Trace::ENVIRONMENT_VARIABLE	= TRACE_ENVIRONMENT_VARIABLE;
+
+/*==============================================================================
+	Trace state
+*/
+std::atomic<bool>
+	JP2_Trace::Enabled (false);
+
+#ifndef DOXYGEN_PROCESSING
+namespace
+{
+//	Serializes the trace file.
+std::mutex
+	Trace_Lock;
+
+ofstream
+	Trace_File;
+
+string
+	Trace_Pathname;
+
+//	No event has yet been written to the trace file.
+bool
+	First_Event = true;
+
+//	Trace clock epoch.
+const std::chrono::steady_clock::time_point
+	Epoch = std::chrono::steady_clock::now ();
+
+//	Sequential trace thread identifiers.
+std::atomic<unsigned int>
+	Thread_Count (0);
+
+unsigned int
+thread_ID ()
+{
+static thread_local unsigned int
+	ID = ++Thread_Count;
+return ID;
+}
+
+/*	Starts tracing if the environment variable is set when the library is
+	loaded, and completes the trace file when the process exits.
+*/
+struct Environment_Trace
+	{
+	Environment_Trace ()
+		{
+		const char
+			*pathname = getenv (JP2_Trace::ENVIRONMENT_VARIABLE);
+		if (pathname &&
+			*pathname)
+			{
+			try {JP2_Trace::start (pathname);}
+			catch (...) {}
+			}
+		}
+	~Environment_Trace ()
+		{JP2_Trace::stop ();}
+	}
+	Environment_Tracing;
+
+}	//	namespace
+#endif	//	DOXYGEN_PROCESSING
+
+/*==============================================================================
+	Tracing
+*/
+void
+JP2_Trace::start
+	(
+	const std::string&	pathname
+	)
+{
+#if ((DEBUG) & DEBUG_TRACING)
+clog << ">-< JP2_Trace::start: " << pathname << endl;
+#endif
+stop ();
+
+std::lock_guard<std::mutex>
+	lock (Trace_Lock);
+Trace_File.clear ();
+Trace_File.open (pathname.c_str (), std::ios::out | std::ios::trunc);
+if (! Trace_File)
+	{
+	int
+		error = errno;
+	Trace_File.close ();
+	ostringstream
+		message;
+	message
+		<< "Couldn't open the " << pathname << " trace file.";
+	if (error)
+		message << endl << strerror (error);
+	throw JP2_IO_Failure (message.str (), ID);
+	}
+Trace_File << "[\n";
+Trace_File << std::fixed << std::setprecision (3);
+Trace_Pathname = pathname;
+First_Event = true;
+Enabled = true;
+}
+
+
+void
+JP2_Trace::stop ()
+{
+std::lock_guard<std::mutex>
+	lock (Trace_Lock);
+if (! Trace_File.is_open ())
+	return;
+#if ((DEBUG) & DEBUG_TRACING)
+clog << ">-< JP2_Trace::stop: " << Trace_Pathname << endl;
+#endif
+Enabled = false;
+Trace_File << "\n]\n";
+Trace_File.close ();
+Trace_Pathname.clear ();
+}
+
+
+string
+JP2_Trace::pathname ()
+{
+std::lock_guard<std::mutex>
+	lock (Trace_Lock);
+return Trace_Pathname;
+}
+
+
+double
+JP2_Trace::begin ()
+{
+return std::chrono::duration<double, std::micro>
+	(std::chrono::steady_clock::now () - Epoch).count ();
+}
+
+
+void
+JP2_Trace::end
+	(
+	const char*	name,
+	const void*	reader,
+	double		start
+	)
+{
+double
+	duration = begin () - start;
+unsigned int
+	thread = thread_ID ();
+
+std::lock_guard<std::mutex>
+	lock (Trace_Lock);
+if (! Trace_File.is_open ())
+	//	Tracing stopped during the phase.
+	return;
+if (! First_Event)
+	Trace_File << ",\n";
+First_Event = false;
+Trace_File
+	<< "{\"name\":\"" << name
+	<< "\",\"cat\":\"JP2\",\"ph\":\"X\",\"ts\":" << start
+	<< ",\"dur\":" << duration
+	<< ",\"pid\":" << getpid ()
+	<< ",\"tid\":" << thread
+	<< ",\"args\":{\"reader\":\"" << reader << "\"}}";
+}
+
+
+}	//	namespace HiRISE
+}	//	namespace UA
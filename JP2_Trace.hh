@@ -0,0 +1,176 @@
+/*	JP2_Trace
+
+Copyright (C) 2026  Arizona Board of Regents on behalf of the
+Planetary Image Research Laboratory, Lunar and Planetary Laboratory at
+the University of Arizona.
+
+This library is free software; you can redistribute it and/or modify it
+under the terms of the GNU Lesser General Public License, version 2.1,
+as published by the Free Software Foundation.
+
+This library is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library; if not, write to the Free Software Foundation,
+Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA.
+
+*******************************************************************************/
+
+#ifndef _JP2_Trace_
+#define _JP2_Trace_
+
+#include	<string>
+#include	<atomic>
+
+
+namespace UA
+{
+namespace HiRISE
+{
+/**	<i>JP2_Trace</i> records the phases of JP2 reader operations as
+	trace events.
+
+	When tracing is {@link start(const std::string&) started} each
+	traced phase - opening a source, ingesting its metadata, codestream
+	data requests and acquisitions, decompression increments, data
+	disposition and rendering monitor notifications - is written as a
+	complete event to a file in the Chrome trace event JSON format that
+	can be loaded into the chrome://tracing viewer or Perfetto. Each
+	event is tagged with the thread that ran the phase, and with the
+	address of the reader that the phase was for, so the phases of
+	concurrent readers and threads can be correlated.
+
+	Tracing is also started when the library is loaded if the {@link
+	#ENVIRONMENT_VARIABLE} is set to the pathname of the trace file, and
+	is stopped when the process exits.
+
+	When tracing is not enabled a traced phase costs only the test of an
+	atomic flag.
+
+	All methods are static; JP2_Trace objects are not constructed.
+
+	@author		agent
+*/
+class JP2_Trace
+{
+public:
+/*==============================================================================
+	Constants
+*/
+//!	Class identification name with source code version and date.
+static const char* const
+	ID;
+
+/**	The name of the environment variable that starts tracing.
+
+	The default is "JP2_TRACE". If the variable is set to a non-empty
+	value when the library is loaded tracing is started with the value
+	as the pathname of the trace file.
+*/
+static const char* const
+	ENVIRONMENT_VARIABLE;
+
+/*==============================================================================
+	Tracing
+*/
+/**	Start tracing.
+
+	Any trace in progress is {@link stop() stopped} first.
+
+	@param	pathname	The pathname of the trace file. An existing file
+		is replaced.
+	@throws	JP2_IO_Failure	If the trace file could not be opened.
+*/
+static void start (const std::string& pathname);
+
+/**	Stop tracing.
+
+	The trace file is completed and closed. Nothing is done if tracing
+	is not enabled.
+*/
+static void stop ();
+
+/**	Test if tracing is enabled.
+
+	@return	true if tracing has been started; false otherwise.
+*/
+inline static bool enabled ()
+	{return Enabled.load (std::memory_order_relaxed);}
+
+/**	Get the pathname of the trace file.
+
+	@return	The pathname of the trace file. This will be empty if
+		tracing is not enabled.
+*/
+static std::string pathname ();
+
+/**	A traced phase.
+
+	A Span is constructed on the stack at the beginning of the phase to
+	be traced. If tracing is enabled the phase event is written when the
+	Span goes out of scope.
+*/
+class Span
+	{
+	public:
+
+	/**	Begin a traced phase.
+
+		@param	name	The name of the phase. <b>N.B.</b>: This must be
+			a string literal; it must not contain characters that must
+			be escaped in a JSON string.
+		@param	reader	The address of the reader that the phase is for.
+			May be NULL.
+	*/
+	inline Span (const char* name, const void* reader = NULL)
+		:	Name (enabled () ? name : NULL),
+			Reader (reader),
+			Start (Name ? JP2_Trace::begin () : 0)
+		{}
+
+	//!	End the traced phase.
+	inline ~Span ()
+		{if (Name) JP2_Trace::end (Name, Reader, Start);}
+
+	private:
+
+	//	Not copyable.
+	Span (const Span&);
+	Span& operator= (const Span&);
+
+	//	The phase name; NULL if tracing was not enabled.
+	const char
+		*Name;
+	const void
+		*Reader;
+	//	Phase start time in microseconds.
+	double
+		Start;
+	};
+
+/*==============================================================================
+	Data
+*/
+private:
+
+//	Get the trace clock time in microseconds.
+static double begin ();
+
+//	Write a complete event for a phase.
+static void end (const char* name, const void* reader, double start);
+
+//!	Flags that tracing is enabled.
+static std::atomic<bool>
+	Enabled;
+
+JP2_Trace () {}
+
+};	//	Class JP2_Trace
+
+
+}	//	namespace HiRISE
+}	//	namespace UA
+#endif
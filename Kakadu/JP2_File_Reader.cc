@@ -31,6 +31,8 @@ using namespace kdu_core;
 using namespace kdu_supp;
 #include	"KDU_dims.hh"
 #include	"JP2_Box.hh"
+#include	"JP2_Metrics.hh"
+#include	"JP2_Trace.hh"
 
 #include	<string>
 using std::string;
@@ -41,6 +43,9 @@ using std::endl;
 #include	<stdexcept>
 using std::exception;
 #include	<cstring>
+#include	<vector>
+#include	<algorithm>
+#include	<mutex>
 
 #ifdef _WIN32
 #include "Windows.h"	//	For Sleep system function.
@@ -127,6 +132,77 @@ const kdu_exception
 /*==============================================================================
 	Constructors
 */
+#ifndef DOXYGEN_PROCESSING
+namespace
+{
+/*	Metadata is only shared from an open, complete, local source.
+
+	The metadata of a JPIP source is acquired incrementally.
+*/
+bool
+shareable_metadata
+	(
+	const JP2_File_Reader&	JP2_file_reader,
+	bool					share_metadata
+	)
+{
+return
+	share_metadata &&
+	! dynamic_cast<const JP2_JPIP_Reader*>(&JP2_file_reader) &&
+	JP2_file_reader.is_open () &&
+	JP2_file_reader.is_complete ();
+}
+
+//	Process-wide processing threads.
+std::mutex
+	Processing_Threads_Lock;
+unsigned int
+	Processing_Threads_Limit	= 0,
+	Processing_Threads_In_Use	= 0;
+
+/*	Obtain up to the desired number of worker threads.
+
+	Returns the number of worker threads obtained.
+*/
+unsigned int
+acquire_processing_threads
+	(
+	unsigned int	desired
+	)
+{
+std::lock_guard<std::mutex>
+	lock (Processing_Threads_Lock);
+if (! Processing_Threads_Limit)
+	return desired;
+unsigned int
+	available = (Processing_Threads_In_Use < Processing_Threads_Limit) ?
+		(Processing_Threads_Limit - Processing_Threads_In_Use) : 0;
+if (desired > available)
+	desired = available;
+Processing_Threads_In_Use += desired;
+return desired;
+}
+
+void
+return_processing_threads
+	(
+	unsigned int&	threads
+	)
+{
+if (threads)
+	{
+	std::lock_guard<std::mutex>
+		lock (Processing_Threads_Lock);
+	Processing_Threads_In_Use -=
+		(threads < Processing_Threads_In_Use) ?
+		threads : Processing_Threads_In_Use;
+	threads = 0;
+	}
+}
+}
+#endif
+
+
 JP2_File_Reader::JP2_File_Reader ()
 	:
 	JP2_Stream (),
@@ -136,7 +212,18 @@ JP2_File_Reader::JP2_File_Reader ()
 	Channel_Mapping (),
 	Expand_Numerator (1, 1),
 	Expand_Denominator (1, 1),
+	Base_Expand_Numerator (1, 1),
+	Base_Expand_Denominator (1, 1),
+	Scaled_Size (),
+	Scale_Numerator (0),
+	Scale_Denominator (0),
+	Metadata_Shared (false),
 	Thread_Group (NULL),
+	Master_Queue (NULL),
+	Limited_Threads (0),
+	Deployed_Threads (0),
+	Interruptible (false),
+	Interrupted (false),
 	Error_Message_Queue ()
 {
 #if (DEBUG & DEBUG_CONSTRUCTORS)
@@ -169,7 +256,18 @@ JP2_File_Reader::JP2_File_Reader
 	Channel_Mapping (),
 	Expand_Numerator (1, 1),
 	Expand_Denominator (1, 1),
+	Base_Expand_Numerator (1, 1),
+	Base_Expand_Denominator (1, 1),
+	Scaled_Size (),
+	Scale_Numerator (0),
+	Scale_Denominator (0),
+	Metadata_Shared (false),
 	Thread_Group (NULL),
+	Master_Queue (NULL),
+	Limited_Threads (0),
+	Deployed_Threads (0),
+	Interruptible (false),
+	Interrupted (false),
 	Error_Message_Queue ()
 {
 #if (DEBUG & DEBUG_CONSTRUCTORS)
@@ -209,9 +307,11 @@ catch (...)
 
 JP2_File_Reader::JP2_File_Reader
 	(
-	const JP2_File_Reader&	JP2_file_reader
+	const JP2_File_Reader&	JP2_file_reader,
+	bool					share_metadata
 	)
-	:	JP2_Reader (JP2_file_reader),
+	:	JP2_Reader (JP2_file_reader,
+			shareable_metadata (JP2_file_reader, share_metadata)),
 	JP2_Stream (),
 	JP2_Source (),
 	JPEG2000_Codestream (),
@@ -219,13 +319,26 @@ JP2_File_Reader::JP2_File_Reader
 	Channel_Mapping (),
 	Expand_Numerator (1, 1),
 	Expand_Denominator (1, 1),
+	Base_Expand_Numerator (1, 1),
+	Base_Expand_Denominator (1, 1),
+	Scaled_Size (),
+	Scale_Numerator (0),
+	Scale_Denominator (0),
+	Metadata_Shared
+		(metadata_parameters () == JP2_file_reader.metadata_parameters ()),
 	Thread_Group (NULL),
+	Master_Queue (NULL),
+	Limited_Threads (0),
+	Deployed_Threads (0),
+	Interruptible (false),
+	Interrupted (false),
 	Error_Message_Queue ()
 {
 #if (DEBUG & DEBUG_CONSTRUCTORS)
 clog << ">-< JP2_File_Reader @ " << (void*)this << endl
 	 << "    Copy @ " << (void*)&JP2_file_reader << endl
-	 << "    source_name = " << JP2_file_reader.source_name () << endl;
+	 << "    source_name = " << JP2_file_reader.source_name () << endl
+	 << "    metadata shared = " << Metadata_Shared << endl;
 #endif
 #if defined DEBUG
 clog << boolalpha;
@@ -266,18 +379,8 @@ JP2_File_Reader::~JP2_File_Reader () throw()
 #if (DEBUG & DEBUG_CONSTRUCTORS)
 clog << ">>> ~JP2_File_Reader @ " << (void*)this << endl;
 #endif
+//	Closing releases the processing threads.
 JP2_File_Reader::reset ();
-
-if (Thread_Group)
-	{
-	#if ((DEBUG) & (DEBUG_OPEN | DEBUG_CONSTRUCTORS))
-	clog << "    destroy and delete the Thread_Group @ "
-			<< (void*)Thread_Group << endl;
-	#endif
-	Thread_Group->destroy ();
-	delete Thread_Group;
-	Thread_Group = NULL;
-	}
 #if (DEBUG & DEBUG_CONSTRUCTORS)
 clog << "<<< ~JP2_File_Reader" << endl;
 #endif
@@ -288,6 +391,11 @@ JP2_File_Reader*
 JP2_File_Reader::clone () const
 {return new JP2_File_Reader (*this);}
 
+
+JP2_File_Reader*
+JP2_File_Reader::shared_clone () const
+{return new JP2_File_Reader (*this, true);}
+
 /*==============================================================================
 	Source open, configure and close
 */
@@ -392,6 +500,10 @@ struct timeval
 gettimeofday (&begin_time, 0);
 #endif	//	!_WIN32
 #endif
+double
+	open_start = statistics_time ();
+JP2_Trace::Span
+	span ("open_source", this);
 if (is_open ())
 	{
 	#if ((DEBUG) & (DEBUG_OPEN | DEBUG_TIMING))
@@ -514,7 +626,17 @@ end_time = &time_values[time_select = time_select ? 0 : 1];
 #endif	//	!_WIN32
 clog << "    Metadata ingest ..." << endl;
 #endif
-if (! ingest_metadata () ||
+/*
+	Shared metadata was ingested by the reader it is shared with,
+	and must not be modified.
+*/
+double
+	ingest_start = statistics_time ();
+bool
+	ingested = Metadata_Shared || ingest_metadata ();
+double
+	ingest_seconds = statistics_time () - ingest_start;
+if (! ingested ||
 	! is_complete ())
 	{
 	ostringstream
@@ -555,6 +677,7 @@ else
 	Resolution_Level = 0;
 	resolution_and_region (resolution_level, Image_Region);
 	}
+open_statistics (statistics_time () - open_start, ingest_seconds);
 #if ((DEBUG) & (DEBUG_OPEN | DEBUG_TIMING))
 #ifndef _WIN32
 //	Procedure timing is not implemented for MS/Windows.
@@ -673,6 +796,8 @@ kdu_coords
 	reference_size,
 	minimum_size,
 	size;
+Expand_Numerator =
+Expand_Denominator = kdu_coords (1, 1);
 JPEG2000_Codestream.get_subsampling
 	(Channel_Mapping.source_components[0], reference_size, true);
 minimum_size = reference_size;
@@ -713,11 +838,17 @@ if (minimum_size.y < reference_size.y)
 	Expand_Numerator.y = reference_size.y;
 	Expand_Denominator.y = minimum_size.y;
 	}
+Base_Expand_Numerator   = Expand_Numerator;
+Base_Expand_Denominator = Expand_Denominator;
 #if ((DEBUG) & DEBUG_OPEN)
 clog << "      Expand_Numerator - " << Expand_Numerator << endl
 	 << "    Expand_Denominator - " << Expand_Denominator << endl;
 #endif
 
+if (scaled_rendering ())
+	//	Apply the rendering scale set before the source was opened.
+	scaled_resolution_and_region (Image_Region);
+
 if (! Rendering_Increment_Lines)
 	//	Default rendering increment.
 	Rendering_Increment_Lines = effective_rendering_increment_lines ();
@@ -733,6 +864,8 @@ JP2_File_Reader::ingest_metadata ()
 #if ((DEBUG) & (DEBUG_OPEN | DEBUG_METADATA))
 clog << ">>> JP2_File_Reader::ingest_metadata" << endl;
 #endif
+JP2_Trace::Span
+	span ("ingest_metadata", this);
 bool
 	loaded = false;
 JP2_Box
@@ -963,6 +1096,28 @@ if (! JPEG2000_Codestream)
 	return false;
 	}
 
+if (scaled_rendering ())
+	{
+	//	The resolution level is selected for the rendering scale.
+	try {changed = scaled_resolution_and_region (selected_region);}
+	catch (kdu_exception except)
+		{
+		ostringstream
+			message;
+		message
+			<< "Couldn't set the scaled rendering of region "
+				<< selected_region << endl
+			<< "for the " << source_name () << " source." << endl
+			<< Kakadu_error_message (except);
+		throw JP2_Exception (message.str (), ID);
+		}
+	#if ((DEBUG) & (DEBUG_RES_REGION | DEBUG_OPEN))
+	clog << "<<< JP2_File_Reader::resolution_and_region: "
+			<< boolalpha << changed << endl;
+	#endif
+	return changed;
+	}
+
 //	Limit the rendered resolution level.
 if (resolution < 1)
 	resolution = 1;
@@ -1062,63 +1217,423 @@ return changed;
 }
 
 
+#ifndef DOXYGEN_PROCESSING
+namespace
+{
+int
+greatest_common_divisor
+	(
+	int		a,
+	int		b
+	)
+{
+while (b)
+	{
+	int
+		remainder = a % b;
+	a = b;
+	b = remainder;
+	}
+return a;
+}
+
+/*	Fit a rendered region dimension to an exact size.
+
+	The region is extended, within the limits of the full rendered
+	image, or truncated to the size.
+*/
+void
+fit_dimension
+	(
+	int&	position,
+	int&	extent,
+	int		size,
+	int		full_position,
+	int		full_extent
+	)
+{
+extent = size;
+if (position + extent > full_position + full_extent)
+	position = full_position + full_extent - extent;
+if (position < full_position)
+	{
+	position = full_position;
+	if (extent > full_extent)
+		extent = full_extent;
+	}
+}
+}	//	local namespace
+#endif	//	DOXYGEN_PROCESSING
+
+
+int
+JP2_File_Reader::max_quality_layers () const
+{
+unsigned int
+	layers = rendered_quality_layers ();
+if (! layers)
+	return INT_MAX;
+if (quality_layers () &&
+	layers > quality_layers ())
+	//	Set before the codestream's quality layers were known.
+	layers = quality_layers ();
+return (int)layers;
+}
+
+JP2_File_Reader&
+JP2_File_Reader::rendered_size
+	(
+	unsigned int	width,
+	unsigned int	height
+	)
+{
+if (! width ||
+	! height)
+	return clear_rendering_scale ();
+Scaled_Size.Width  = width;
+Scaled_Size.Height = height;
+Scale_Numerator =
+Scale_Denominator = 0;
+resolution_and_region (Resolution_Level, Image_Region);
+return *this;
+}
+
+
+JP2_File_Reader&
+JP2_File_Reader::rendering_scale
+	(
+	unsigned int	numerator,
+	unsigned int	denominator
+	)
+{
+if (! numerator ||
+	! denominator)
+	return clear_rendering_scale ();
+Scaled_Size = Size_2D ();
+int
+	divisor = greatest_common_divisor (numerator, denominator);
+Scale_Numerator   = numerator / divisor;
+Scale_Denominator = denominator / divisor;
+resolution_and_region (Resolution_Level, Image_Region);
+return *this;
+}
+
+
+JP2_File_Reader&
+JP2_File_Reader::clear_rendering_scale ()
+{
+if (scaled_rendering ())
+	{
+	Scaled_Size = Size_2D ();
+	Scale_Numerator =
+	Scale_Denominator = 0;
+	Expand_Numerator   = Base_Expand_Numerator;
+	Expand_Denominator = Base_Expand_Denominator;
+
+	//	Force the rendered region to be reset.
+	unsigned int
+		resolution = Resolution_Level;
+	Resolution_Level = 0;
+	resolution_and_region (resolution, Image_Region);
+	}
+return *this;
+}
+
+
+bool
+JP2_File_Reader::scaled_resolution_and_region
+	(
+	const Rectangle&	selected_region
+	)
+{
+#if ((DEBUG) & (DEBUG_RES_REGION | DEBUG_OPEN))
+clog << ">>> JP2_File_Reader::scaled_resolution_and_region: "
+		<< selected_region << endl;
+#endif
+KDU_dims
+	image_dimensions (image_size ()),
+	selection (selected_region);
+if (selection.is_empty ())
+	selection = image_dimensions;
+else
+	selection &= image_dimensions;
+if (selection.is_empty ())
+	{
+	#if ((DEBUG) & (DEBUG_RES_REGION | DEBUG_OPEN))
+	clog << "<<< JP2_File_Reader::scaled_resolution_and_region: empty" << endl;
+	#endif
+	return false;
+	}
+
+//	Target rendered size.
+kdu_coords
+	target;
+if (Scaled_Size.Width)
+	{
+	target.x = Scaled_Size.Width;
+	target.y = Scaled_Size.Height;
+	}
+else
+	{
+	target.x = (int)(((kdu_long)selection.size.x * Scale_Numerator
+		+ (Scale_Denominator >> 1)) / Scale_Denominator);
+	target.y = (int)(((kdu_long)selection.size.y * Scale_Numerator
+		+ (Scale_Denominator >> 1)) / Scale_Denominator);
+	if (target.x < 1)
+		target.x = 1;
+	if (target.y < 1)
+		target.y = 1;
+	}
+
+//	Full resolution sub-sampling of the reference component.
+kdu_coords
+	subsampling;
+JPEG2000_Codestream.get_subsampling
+	(Channel_Mapping.source_components[0], subsampling, true);
+if (Resolution_Level > 1)
+	{
+	subsampling.x >>= Resolution_Level - 1;
+	subsampling.y >>= Resolution_Level - 1;
+	}
+
+//	Select the cheapest discard level that is no smaller than the target.
+int
+	discard = resolution_levels () - 1;
+KDU_dims
+	reduced;
+while (true)
+	{
+	reduced = Decompressor.find_render_dims (selection,
+		kdu_coords (subsampling.x << discard, subsampling.y << discard),
+		Base_Expand_Numerator, Base_Expand_Denominator);
+	if (! discard ||
+		(reduced.size.x >= target.x &&
+		 reduced.size.y >= target.y))
+		break;
+	--discard;
+	}
+#if ((DEBUG) & (DEBUG_RES_REGION | DEBUG_OPEN))
+clog << "    target size = " << target << endl
+	 << "    discard levels " << discard
+	 	<< ", reduced region " << reduced << endl;
+#endif
+
+//	Resample the reduced region to the target size.
+kdu_coords
+	numerator (Base_Expand_Numerator.x * target.x,
+			   Base_Expand_Numerator.y * target.y),
+	denominator (Base_Expand_Denominator.x * reduced.size.x,
+				 Base_Expand_Denominator.y * reduced.size.y);
+int
+	divisor = greatest_common_divisor (numerator.x, denominator.x);
+numerator.x   /= divisor;
+denominator.x /= divisor;
+divisor = greatest_common_divisor (numerator.y, denominator.y);
+numerator.y   /= divisor;
+denominator.y /= divisor;
+
+bool
+	changed =
+		(unsigned int)(discard + 1) != Resolution_Level ||
+		static_cast<const Rectangle&>(selection) != Image_Region ||
+		numerator != Expand_Numerator ||
+		denominator != Expand_Denominator;
+
+Resolution_Level = discard + 1;
+JPEG2000_Codestream.apply_input_restrictions
+	(0, 0, discard, 0, &selection, KDU_WANT_OUTPUT_COMPONENTS, Thread_Group);
+Expand_Numerator   = numerator;
+Expand_Denominator = denominator;
+Image_Region = static_cast<const Rectangle&>(selection);
+
+//	The rendered region at exactly the target size.
+JPEG2000_Codestream.get_subsampling
+	(Channel_Mapping.source_components[0], subsampling, true);
+KDU_dims
+	rendered,
+	full;
+rendered = Decompressor.find_render_dims (selection,
+	subsampling, Expand_Numerator, Expand_Denominator);
+full = Decompressor.find_render_dims (image_dimensions,
+	subsampling, Expand_Numerator, Expand_Denominator);
+fit_dimension (rendered.pos.x, rendered.size.x, target.x,
+	full.pos.x, full.size.x);
+fit_dimension (rendered.pos.y, rendered.size.y, target.y,
+	full.pos.y, full.size.y);
+if (static_cast<const Rectangle&>(rendered) != Rendered_Region)
+	changed = true;
+Rendered_Region = static_cast<const Rectangle&>(rendered);
+#if ((DEBUG) & (DEBUG_RES_REGION | DEBUG_OPEN))
+clog << "        Image_Region-> " << Image_Region << endl
+	 << "     Rendered_Region-> " << Rendered_Region << endl
+	 << "    Expand_Numerator-> " << Expand_Numerator << endl
+	 << "  Expand_Denominator-> " << Expand_Denominator << endl
+	 << "<<< JP2_File_Reader::scaled_resolution_and_region: "
+	 	<< boolalpha << changed << endl;
+#endif
+return changed;
+}
+
+
 void
 JP2_File_Reader::deploy_processing_threads ()
 {
 #if ((DEBUG) & DEBUG_RENDER)
 clog << ">>> JP2_File_Reader::deploy_processing_threads" << endl;
 #endif
-if (! Thread_Group &&
-	Thread_Count > 1)
+if (Thread_Count < 2 ||
+	Deployed_Threads >= Thread_Count)
+	{
+	#if ((DEBUG) & DEBUG_RENDER)
+	clog << "    " << Deployed_Threads << " of " << Thread_Count
+			<< " processing threads deployed" << endl
+		 << "<<< JP2_File_Reader::deploy_processing_threads" << endl;
+	#endif
+	return;
+	}
+if (! Thread_Group)
 	{
+	/*	The Thread_Group is created, with only its owner thread, even
+		when no worker threads can be obtained so that the codestream
+		is created for multi-threaded use and the worker threads can
+		be added when they become available.
+	*/
 	#if ((DEBUG) & DEBUG_RENDER)
-	clog << "    Creating " << Thread_Count << " processing threads." << endl;
+	clog << "    Creating the Thread_Group." << endl;
 	#endif
 	Thread_Group = new kdu_thread_env ();
 	Thread_Group->create ();	//	Owner thread.
+	Deployed_Threads = 1;
 
-  for (auto
-			count = 1;
-			count < Thread_Count;
-			count++)
-		if (! Thread_Group->add_thread ())
-			Thread_Count = count;
+	Master_Queue = new kdu_thread_queue ();
+	try
+		{
+		#if ((DEBUG) & DEBUG_RENDER)
+		bool
+			attached =
+		#endif
+		Thread_Group->attach_queue (Master_Queue, NULL, "CHANGEME", 0,
+			KDU_THREAD_QUEUE_SAFE_CONTEXT);
+		#if ((DEBUG) & DEBUG_RENDER)
+		clog << (attached ? "Successfully created " : "Failed to create ")
+				<< "a thread queue" << endl;
+		#endif
+		}
+	catch (kdu_exception except)
+		{
+		ostringstream
+			message;
+		message
+			<< "Couldn't attach a thread queue." << endl
+			<< Kakadu_error_message (except);
+		throw JP2_Exception (message.str (), ID);
+		}
+	}
+
+//	Worker threads.
+unsigned int
+	workers = Thread_Count - Deployed_Threads;
+bool
+	limited = processing_threads_limit ();
+if (limited)
+	{
+	//	Worker threads from the process-wide limit.
+	workers = acquire_processing_threads (workers);
+	Limited_Threads += workers;
 	#if ((DEBUG) & DEBUG_RENDER)
-	clog << "    Created  " << Thread_Count << " processing threads." << endl;
+	clog << "    Obtained " << workers
+			<< " limited worker threads." << endl;
 	#endif
+	}
+unsigned int
+	added = 0;
+	{
+	//	Worker threads inherit the binding to the processing CPUs.
+	CPU_Binding
+		binding (processing_CPUs ());
+	while (added < workers &&
+			Thread_Group->add_thread ())
+		++added;
+	}
+Deployed_Threads += added;
+if (limited &&
+	added < workers)
+	{
+	//	Return the threads the system refused to provide.
+	unsigned int
+		unused = workers - added;
+	Limited_Threads -= unused;
+	return_processing_threads (unused);
+	}
+#if ((DEBUG) & DEBUG_RENDER)
+clog << "    " << Deployed_Threads << " of " << Thread_Count
+		<< " processing threads deployed" << endl
+	 << "<<< JP2_File_Reader::deploy_processing_threads" << endl;
+#endif
+}
 
-  Master_Queue = new kdu_thread_queue ();
-try {
-  #if ((DEBUG) & DEBUG_RENDER)
-	auto attached =
-	#endif
-  Thread_Group->attach_queue(Master_Queue, NULL, "CHANGEME", 0, KDU_THREAD_QUEUE_SAFE_CONTEXT);
-  #if ((DEBUG) & DEBUG_RENDER)
-	clog << (attached ? "Successfully created " : "Failed to create ") << "a thread queue" << endl;
+
+void
+JP2_File_Reader::release_processing_threads ()
+{
+#if ((DEBUG) & DEBUG_RENDER)
+clog << ">>> JP2_File_Reader::release_processing_threads: "
+		<< Deployed_Threads << " deployed, "
+		<< Limited_Threads << " limited" << endl;
+#endif
+if (Thread_Group)
+	{
+	if (JPEG2000_Codestream.exists ())
+		//	Ensure shutdown of all thread processing.
+		Thread_Group->cs_terminate (JPEG2000_Codestream);
+	#if ((DEBUG) & (DEBUG_OPEN | DEBUG_CONSTRUCTORS))
+	clog << "    destroy and delete the Thread_Group @ "
+			<< (void*)Thread_Group << endl;
 	#endif
-} catch (kdu_exception except)
-  	{
-  	ostringstream
-  		message;
-  	message
-  		<< "Couldn't attach a thread queue." << endl
-  		<< Kakadu_error_message (except);
-  	throw JP2_Exception (message.str (), ID);
-  	}
-
-   #if ((DEBUG) & DEBUG_RENDER)
-   clog << "    Using default thread queues" << endl;
-   #endif
+	Thread_Group->destroy ();
+	delete Thread_Group;
+	Thread_Group = NULL;
+	delete Master_Queue;
+	Master_Queue = NULL;
 	}
+Deployed_Threads = 0;
+return_processing_threads (Limited_Threads);
 #if ((DEBUG) & DEBUG_RENDER)
-else
-	clog << "    Thread_Group "
-			<< ((Thread_Count > 1) ? "already" : "not") << " created" << endl;
-clog << "<<< JP2_File_Reader::deploy_processing_threads" << endl;
+clog << "<<< JP2_File_Reader::release_processing_threads" << endl;
 #endif
 }
 
 
+void
+JP2_File_Reader::processing_threads_limit
+	(
+	unsigned int	threads
+	)
+{
+std::lock_guard<std::mutex>
+	lock (Processing_Threads_Lock);
+Processing_Threads_Limit = threads;
+}
+
+
+unsigned int
+JP2_File_Reader::processing_threads_limit ()
+{
+std::lock_guard<std::mutex>
+	lock (Processing_Threads_Lock);
+return Processing_Threads_Limit;
+}
+
+
+unsigned int
+JP2_File_Reader::processing_threads_in_use ()
+{
+std::lock_guard<std::mutex>
+	lock (Processing_Threads_Lock);
+return Processing_Threads_In_Use;
+}
+
+
 bool
 JP2_File_Reader::is_open () const
 {
@@ -1174,6 +1689,9 @@ if (JPEG2000_Codestream.exists ())
     }
 	JPEG2000_Codestream.destroy ();
 	}
+
+//	Return the processing threads; they are deployed again on opening.
+release_processing_threads ();
 #if ((DEBUG) & (DEBUG_OPEN | DEBUG_CONSTRUCTORS))
 clog << "<<< JP2_File_Reader::close" << endl;
 #endif
@@ -1188,11 +1706,39 @@ clog << ">>> JP2_File_Reader::reset" << endl;
 #endif
 JP2_File_Reader::close ();
 JP2_Reader::reset ();
+Metadata_Shared = false;
+Scaled_Size = Size_2D ();
+Scale_Numerator =
+Scale_Denominator = 0;
 #if ((DEBUG) & (DEBUG_OPEN | DEBUG_CONSTRUCTORS))
 clog << "<<< JP2_File_Reader::reset" << endl;
 #endif
 }
 
+
+void
+JP2_File_Reader::reset_rendering ()
+{
+#if ((DEBUG) & (DEBUG_OPEN | DEBUG_CONSTRUCTORS))
+clog << ">>> JP2_File_Reader::reset_rendering" << endl;
+#endif
+JP2_Reader::reset_rendering ();
+Scaled_Size = Size_2D ();
+Scale_Numerator =
+Scale_Denominator = 0;
+if (is_open ())
+	{
+	initialize ();
+
+	//	Force the entire image at full resolution to be restored.
+	Resolution_Level = 0;
+	resolution_and_region (1, Image_Region);
+	}
+#if ((DEBUG) & (DEBUG_OPEN | DEBUG_CONSTRUCTORS))
+clog << "<<< JP2_File_Reader::reset_rendering" << endl;
+#endif
+}
+
 /*==============================================================================
 	Codestream data acquisition.
 */
@@ -1302,11 +1848,343 @@ return report.str ();
 }
 
 /*==============================================================================
-	Render
+	Rendering engine support
 */
-Cube
-JP2_File_Reader::render ()
-{
+#ifndef DOXYGEN_PROCESSING
+namespace
+{
+/*	Decompress the next increment of a region slice.
+
+	The line increment is extended to the remainder of the slice if
+	less than an eighth of the increment would otherwise remain.
+
+	If the row_gap is zero the increment is written to the start of the
+	image_data buffers as tightly packed lines, and max_pixels limits
+	the number of pixels written.
+
+	The reader tags the JP2_Trace event of the increment.
+*/
+bool
+decompress_increment
+	(
+	const JP2_Reader*			reader,
+	kdu_region_decompressor&	decompressor,
+	void**						image_data,
+	int							pixel_bytes,
+	int							pixel_bits,
+	int							pixel_gap,
+	kdu_coords					buffer_origin,
+	int							row_gap,
+	int							line_increment,
+	KDU_dims&					slice,
+	KDU_dims&					rendered,
+	int							max_pixels = -1
+	)
+{
+JP2_Trace::Span
+	span ("decompress_increment", reader);
+int
+	suggested_increment;
+if (line_increment < slice.size.y &&
+   (line_increment + (line_increment >> 3)) > slice.size.y)
+	suggested_increment = slice.size.y * slice.size.x;
+else
+	suggested_increment = line_increment * slice.size.x;
+
+if (pixel_bytes == 1)
+	return decompressor.process
+		(
+		reinterpret_cast<kdu_byte**>(image_data),
+		false,
+		pixel_gap,
+		buffer_origin,
+		row_gap,
+		suggested_increment,
+		max_pixels,
+		slice,
+		rendered,
+		pixel_bits,
+		false
+		);
+if (pixel_bytes == sizeof (float))
+	//	Floating point samples in the nominal source sample range.
+	return decompressor.process
+		(
+		reinterpret_cast<float**>(image_data),
+		false,
+		pixel_gap,
+		buffer_origin,
+		row_gap,
+		suggested_increment,
+		max_pixels,
+		slice,
+		rendered,
+		false,
+		false,
+		true
+		);
+return decompressor.process
+	(
+	reinterpret_cast<kdu_uint16**>(image_data),
+	false,
+	pixel_gap,
+	buffer_origin,
+	row_gap,
+	suggested_increment,
+	max_pixels,
+	slice,
+	rendered,
+	pixel_bits,
+	false
+	);
+}
+
+}	//	local namespace
+#endif
+
+
+void
+JP2_File_Reader::start_decompressor
+	(
+	kdu_region_decompressor&	decompressor,
+	const kdu_dims&				region,
+	kdu_thread_env*				thread_env
+	)
+{
+#if ((DEBUG) & (DEBUG_RENDER | DEBUG_LOCATION))
+clog << "==> Starting the Decompressor for region " << region << endl;
+#endif
+/*	After being started the Decompressor will only process codestream
+	regions in a sequentially forward manner; the Decompressor will
+	not allow decompression regions to be repeated unless it has been
+	finished and then restarted.
+
+	<b>N.B.</b>: The Decompressor assumes MSB pixel samples and
+	automatically swaps sample bytes on an LSB host.
+*/
+decompressor.start
+	(
+	JPEG2000_Codestream,
+	&Channel_Mapping,
+	//	Single component (ignored when Channel_Mapping used).
+	-1,
+	//	Discard levels (resolution).
+	resolution_level () - 1,
+	//	Max layers (quality).
+	max_quality_layers (),
+	//	Selected region on the rendering grid.
+	region,
+	//	Channel expansion factors used with Channel_Mapping.
+	Expand_Numerator,
+	Expand_Denominator,
+	//	High precision decompression operations.
+	true,
+	//	Access mode.
+	KDU_WANT_OUTPUT_COMPONENTS,
+	//	Fastest (ignored when precise is true).
+	false,
+	//	Multi-threaded processing environment (single threaded if NULL).
+	thread_env,
+	(thread_env ? Master_Queue : NULL)
+	);
+}
+
+
+std::string
+JP2_File_Reader::rendering_failure
+	(
+	const std::string&	description,
+	const std::string&	report
+	) const
+{
+ostringstream
+	message;
+message
+	<< "Couldn't render region " << rendered_region () << endl;
+if (rendered_region () != image_region ())
+	message << "- image region " << image_region () << " -" << endl;
+message
+	<< "at resolution level " << resolution_level () << '.' << endl
+	<< description << endl;
+if (Bytes_Rendered)
+	message
+		<< "after rendering " << magnitude (Bytes_Rendered)
+			<< " (" << Bytes_Rendered << ") image data bytes" << endl;
+message
+	<< "for the " << source_name () << " source.";
+if (! report.empty ())
+	message << endl << report;
+return message.str ();
+}
+
+
+void
+JP2_File_Reader::abandon_decompression
+	(
+	kdu_thread_env*				thread_env,
+	kdu_region_decompressor*	decompressor
+	)
+{
+#if ((DEBUG) & DEBUG_RENDER)
+clog << "<-- Decompression exception!" << endl;
+#endif
+if (thread_env)
+	//	Stop the work queued for the decompression.
+	thread_env->handle_exception (READER_ERROR);
+if (decompressor)
+	decompressor->finish ();
+if (thread_env)
+	thread_env->terminate (NULL, true);
+//	The codestream may not be used after a decompression exception.
+close ();
+}
+
+
+Cube
+JP2_File_Reader::image_region_rendered
+	(
+	const Cube&	rendered
+	)
+{
+kdu_coords
+	subsampling;
+JPEG2000_Codestream.get_subsampling
+	(Channel_Mapping.source_components[0], subsampling, true);
+KDU_dims
+	region_rendered;
+region_rendered = rendered;
+//	Reverse map rendered res dimensions to the full res dimensions.
+region_rendered =
+	Decompressor.find_codestream_cover_dims (region_rendered,
+		subsampling, Expand_Numerator, Expand_Denominator);
+Cube
+	full_res_rendered_cube (image_region ());
+full_res_rendered_cube.Y      = region_rendered.pos.y;
+full_res_rendered_cube.Height = region_rendered.size.y;
+//	Clip to the user specifified dimensions.
+full_res_rendered_cube &= image_region ();
+return full_res_rendered_cube;
+}
+
+
+bool
+JP2_File_Reader::dispose_increment
+	(
+	Rendering_Monitor::Status	status,
+	const kdu_dims&				increment,
+	void**						data,
+	unsigned int				data_line_stride
+	)
+{
+Bytes_Rendered += (unsigned long long)
+	increment.area () * rendered_bands () * rendered_pixel_bytes ();
+
+//	Rendered region decompressed for data_disposition.
+Cube
+	rendered_res_cube (rendered_region ());
+rendered_res_cube.Y      = increment.pos.y;
+rendered_res_cube.Height = increment.size.y;
+Cube
+	full_res_rendered_cube (image_region_rendered (rendered_res_cube));
+#if ((DEBUG) & (DEBUG_RENDER | DEBUG_LOCATION))
+clog << "       decompressed region = " << rendered_res_cube << endl
+	 << "              image region = " << full_res_rendered_cube << endl;
+#endif
+//	Wrangle the data into the correct structure and notify monitor.
+return
+	data_disposition
+		(status, Rendering_Monitor::Status_Message[status],
+		rendered_res_cube, full_res_rendered_cube,
+		data, data_line_stride);
+}
+
+
+Cube
+JP2_File_Reader::rendering_finished
+	(
+	unsigned int	rendered_lines,
+	bool			completed
+	)
+{
+//	Complete any pipelined data disposition before the final notification.
+if (! finish_data_disposition ())
+	completed = false;
+
+//	Region rendered, from the top of the rendered region.
+Cube
+	rendered_res_cube (rendered_region ());
+rendered_res_cube.Height = rendered_lines;
+Cube
+	full_res_rendered_cube (image_region_rendered (rendered_res_cube));
+
+Rendering_Monitor::Status
+	status = completed ?
+		Rendering_Monitor::DONE : Rendering_Monitor::CANCELED;
+#if ((DEBUG) & (DEBUG_RENDER | DEBUG_NOTIFY | DEBUG_LOCATION))
+clog << "    JP2_File_Reader::rendering_finished: notify status "
+		<< status << " \""
+		<< Rendering_Monitor::Status_Message[status] << '"' << endl
+	 << "    rendered region = " << rendered_res_cube << endl
+	 << "       image region = " << full_res_rendered_cube << endl;
+#endif
+Rendering_Monitor
+	*monitor = rendering_monitor ();
+if (monitor)
+	monitor->notify (*this,
+		status, Rendering_Monitor::Status_Message[status],
+		rendered_res_cube, full_res_rendered_cube);
+return rendered_res_cube;
+}
+
+
+/*==============================================================================
+	Render
+*/
+Cube
+JP2_File_Reader::render ()
+{
+if (is_open ())
+	//	Obtain any processing threads that were not available.
+	deploy_processing_threads ();
+
+/*	The processing environment for the rendering.
+
+	When a single thread is selected the rendering is done without the
+	Thread_Group, which remains intact so the reader can be closed, or
+	recover from an interruption, while rendering.
+*/
+kdu_thread_env
+	*thread_env = Thread_Group;
+if (select_processing_threads () < 2 ||
+	Deployed_Threads < 2)
+	{
+	#if ((DEBUG) & (DEBUG_RENDER | DEBUG_LOCATION))
+	if (Thread_Group)
+		clog << ">-< JP2_File_Reader::render: single threaded - "
+				<< processing_threads_reason () << endl;
+	#endif
+	thread_env = NULL;
+	}
+
+Cube
+	rendered;
+try {rendered = render_image (thread_env);}
+catch (...)
+	{
+	JP2_Metrics::render_failed ();
+	throw;
+	}
+JP2_Metrics::rendered (resolution_level (), last_render_statistics ());
+return rendered;
+}
+
+
+Cube
+JP2_File_Reader::render_image
+	(
+	kdu_thread_env*	thread_env
+	)
+{
 #if ((DEBUG) & (DEBUG_RENDER | DEBUG_TIMING | DEBUG_LOCATION))
 clog << ">>> JP2_File_Reader::render" << endl;
 #ifndef _WIN32
@@ -1326,6 +2204,9 @@ gettimeofday (&begin_time, 0);
 #endif	//	!_WIN32
 #endif
 Bytes_Rendered = 0;
+//	Collects the rendering statistics however rendering ends.
+Render_Statistics_Guard
+	statistics_guard (*this, thread_env ? thread_env->get_num_threads () : 1);
 
 string
 	reasons;
@@ -1335,17 +2216,7 @@ if (! ready (&reasons))
 	clog << "    Not ready -" << endl
 		 << reasons << endl;
 	#endif
-	ostringstream
-		message;
-	message
-		<< "Couldn't render region " << rendered_region () << endl;
-	if (rendered_region () != image_region ())
-		message << " of image region " << image_region () << " -" << endl;
-	message
-		<< "at resolution level " << resolution_level () << '.' << endl
-		<< reasons << endl
-		<< "for the " << source_name () << " source.";
-	throw JP2_Logic_Error (message.str (), ID);
+	throw JP2_Logic_Error (rendering_failure (reasons), ID);
 	}
 
 if (! rendered_region ().area ())
@@ -1357,14 +2228,90 @@ if (! rendered_region ().area ())
 	return Cube ();
 	}
 
+//	Line sink, or stretched, rendering of a local file source.
+if (line_sink () ||
+	stretching ())
+	{
+	if (JP2_Stream.uses_cache ())
+		throw JP2_Logic_Error (rendering_failure
+			(string (line_sink () ? "Line sink" : "Stretched")
+				+ " rendering is not available for a JPIP source."), ID);
+	Cube
+		rendered (render_lines (thread_env));
+	#if ((DEBUG) & (DEBUG_RENDER | DEBUG_TIMING | DEBUG_LOCATION))
+	clog << "<<< JP2_File_Reader::render: " << rendered << endl;
+	#endif
+	return rendered;
+	}
+
+//	Chunked image data rendering.
+if (chunked_image_data ())
+	{
+	if (JP2_Stream.uses_cache ())
+		throw JP2_Logic_Error (rendering_failure
+			("Chunked image data rendering is not available"
+				" for a JPIP source."), ID);
+	Cube
+		rendered (render_chunks (thread_env));
+	#if ((DEBUG) & (DEBUG_RENDER | DEBUG_TIMING | DEBUG_LOCATION))
+	clog << "<<< JP2_File_Reader::render: " << rendered << endl;
+	#endif
+	return rendered;
+	}
+
+//	Progressive rendering preview of a local file source.
+if (progressive_rendering () &&
+	! JP2_Stream.uses_cache () &&
+	! render_preview (thread_env))
+	{
+	//	Canceled after the preview.
+	Rendering_Monitor
+		*monitor = rendering_monitor ();
+	if (monitor)
+		monitor->notify (*this,
+			Rendering_Monitor::CANCELED,
+			Rendering_Monitor::Status_Message[Rendering_Monitor::CANCELED],
+			Cube (), Cube ());
+	#if ((DEBUG) & (DEBUG_RENDER | DEBUG_TIMING | DEBUG_LOCATION))
+	clog << "<<< JP2_File_Reader::render: preview canceled" << endl;
+	#endif
+	return Cube ();
+	}
+
+//	Tile cache rendering of a local file source.
+if (tile_cache () &&
+	! JP2_Stream.uses_cache ())
+	{
+	Cube
+		rendered (render_cells (thread_env));
+	#if ((DEBUG) & (DEBUG_RENDER | DEBUG_TIMING | DEBUG_LOCATION))
+	clog << "<<< JP2_File_Reader::render: " << rendered << endl;
+	#endif
+	return rendered;
+	}
+
+//	Concurrent strip rendering of a local file source.
+std::vector<kdu_dims>
+	slices;
+if (effective_rendering_strips () > 1 &&
+	thread_env &&
+	! JP2_Stream.uses_cache ())
+	//	Empty if the region can not be divided along tile rows.
+	slices = strip_slices (effective_rendering_strips ());
+if (! slices.empty ())
+	{
+	Cube
+		rendered (render_strips (slices, thread_env));
+	#if ((DEBUG) & (DEBUG_RENDER | DEBUG_TIMING | DEBUG_LOCATION))
+	clog << "<<< JP2_File_Reader::render: " << rendered << endl;
+	#endif
+	return rendered;
+	}
+
 //	Image data characterization ------------------------------------------------
 
 //	Rendering region management.
 Cube
-	//	Region to render on the full resolution grid.
-	full_res_region_cube (image_region ()),
-	//	Region rendered on the full resolution grid.
-	full_res_rendered_cube (full_res_region_cube),
 	//	Region rendered on the rendering grid.
 	rendered_res_cube (rendered_region ());
 Rectangle
@@ -1384,27 +2331,26 @@ int
     resolution			= resolution_level (),
     pixel_bits			= rendered_pixel_bits (),
     pixel_bytes			= rendered_pixel_bytes (),
-    bands				= rendered_bands (),
     pixel_gap			= pixel_stride (),
     row_gap				= line_stride (),
     line_increment		= effective_rendering_increment_lines (),
-    suggested_increment;
+    increment_lines		= first_rendering_increment_lines ();
 
+#if ((DEBUG) & (DEBUG_RENDER | DEBUG_TIMING | DEBUG_LOCATION))
 kdu_coords
 	subsampling;
 JPEG2000_Codestream.get_subsampling
 	(Channel_Mapping.source_components[0], subsampling, true);
-
-#if ((DEBUG) & (DEBUG_RENDER | DEBUG_TIMING | DEBUG_LOCATION))
 clog << "       resolution level = " << resolution << endl
 	 << "         pixel precison: "
 	 	<< pixel_bits << "-bit (" << pixel_bytes << " byte)" << endl
-	 << "            image bands = " << bands << '/' << image_bands () << endl
-	 << "           image region = " << full_res_region_cube << endl
+	 << "            image bands = " << rendered_bands () << '/' << image_bands () << endl
+	 << "           image region = " << image_region () << endl
 	 << "          render_region = " << render_region << endl
 	 << "              pixel_gap = " << pixel_gap << endl
 	 << "                row_gap = " << row_gap << endl
 	 << "         line_increment = " << line_increment << endl
+	 << "        increment_lines = " << increment_lines << endl
 	 << "            subsampling = " << subsampling << endl
 	 << "       Expand_Numerator = " << Expand_Numerator << endl
 	 << "     Expand_Denominator = " << Expand_Denominator << endl;
@@ -1421,9 +2367,8 @@ kdu_coords
 //	Image data buffers.
 unsigned int
 	total_bands = image_bands ();
-void
-	//	The MSVC compiler wont allocate variable length arrays on the stack.
-	**image_data = new void*[total_bands];
+std::vector<void*>
+	image_data (total_bands, (void*)NULL);
 #if ((DEBUG) & DEBUG_RENDER)
 clog << "       image buffers -" << endl
 	 << "       buffer_origin: " << buffer_origin << endl;
@@ -1478,17 +2423,20 @@ int
 Acquired_Data
 	acquired_data;
 
-Rendering_Monitor
-	*monitor = rendering_monitor ();
 //	File source always provides top quality data.
 Rendering_Monitor::Status
 	status = Rendering_Monitor::TOP_QUALITY_DATA;
 
+//	Stops any pipelined data disposition however rendering ends.
+Data_Disposition_Guard
+	disposition_guard (*this);
+
 kdu_exception
 	kdu_exception_value;
 
 bool
-	continue_rendering = true;	//	False if rendering canceled.
+	continue_rendering = true,	//	False if rendering canceled.
+	interrupted = false;		//	True if rendering interrupted.
 while (continue_rendering)
 	{
 	//	Acquire more data when the last request is complete.
@@ -1498,23 +2446,18 @@ while (continue_rendering)
 		#if ((DEBUG) & (DEBUG_RENDER | DEBUG_TIMING | DEBUG_LOCATION))
 		clog << "==> data_request for region " << region_section << endl;
 		#endif
-		try {data_request_status = data_request (&region_section);}
+		try
+			{
+			JP2_Trace::Span
+				span ("data_request", this);
+			data_request_status = data_request (&region_section);
+			}
 		catch (JPIP_Exception except)
 			{
-			if (Thread_Group)
-				Thread_Group->handle_exception (READER_ERROR);
-			delete[] image_data;
-			ostringstream
-				message;
-			message
-				<< "Couldn't render region " << rendered_region () << endl;
-			if (rendered_region () != image_region ())
-				message << "- image region " << image_region () << " -" << endl;
-			message
-				<< "at resolution level " << resolution << endl
-				<< "for the " << source_name () << " source." << endl
-				<< except.message ();
-			except.message (message.str ());
+			if (thread_env)
+				thread_env->handle_exception (READER_ERROR);
+			except.message (rendering_failure
+				("The codestream data request failed.", except.message ()));
 			throw;
 			}
 		#if ((DEBUG) & (DEBUG_RENDER | DEBUG_TIMING | DEBUG_LOCATION))
@@ -1535,25 +2478,23 @@ while (continue_rendering)
 		#if ((DEBUG) & (DEBUG_RENDER | DEBUG_TIMING | DEBUG_LOCATION))
 		clog << "--> " << ++acquisitions << " - data_acquisition" << endl;
 		#endif
-		try {data_acquisition_status = data_acquisition (&acquired_data);}
+		double
+			acquisition_start = statistics_time ();
+		try
+			{
+			JP2_Trace::Span
+				span ("data_acquisition", this);
+			data_acquisition_status = data_acquisition (&acquired_data);
+			}
 		catch (JPIP_Exception except)
 			{
-			if (Thread_Group)
-				Thread_Group->handle_exception (READER_ERROR);
-			delete[] image_data;
-			ostringstream
-				message;
-			message
-				<< "Couldn't render region " << rendered_region () << endl;
-			if (rendered_region () != image_region ())
-				message << "- image region " << image_region () << " -" << endl;
-			message
-				<< "at resolution level " << resolution << endl
-				<< "for the " << source_name () << " source." << endl
-				<< except.message ();
-			except.message (message.str ());
+			if (thread_env)
+				thread_env->handle_exception (READER_ERROR);
+			except.message (rendering_failure
+				("The codestream data acquisition failed.", except.message ()));
 			throw;
 			}
+		acquisition_statistics (acquisition_start);
 		#if ((DEBUG) & (DEBUG_RENDER | DEBUG_TIMING | DEBUG_LOCATION))
 		#ifndef _WIN32
 		//	Procedure timing is not implemented for MS/Windows.
@@ -1618,68 +2559,25 @@ while (continue_rendering)
 
 	/*	Start the Decompressor.
 
-		After being started the Decompressor will only process codestream
-		regions in a sequentially forward manner; the Decompressor will
-		not allow decompression regions to be repeated unless it has been
-		finished and then restarted. Thus a complete start-process-finish
-		sequence must be done whenever new codestream data has been
-		acquired.
-
-		<b>N.B.</b>: The Decompressor assumes MSB pixel samples and
-		automatically swaps sample bytes on an LSB host.
+		A complete start-process-finish sequence must be done whenever
+		new codestream data has been acquired.
 	*/
 	#if ((DEBUG) & (DEBUG_RENDER | DEBUG_LOCATION))
-	clog
-		<< "==> Starting the Decompressor for region " << region_slice << endl;
 	decompressions = 0;
 	#endif
-	try {Decompressor.start
-		(
-		JPEG2000_Codestream,
-		&Channel_Mapping,
-		//	Single component (ignored when Channel_Mapping used).
-		-1,
-		//	Discard levels (resolution).
-		resolution - 1,
-		//	Max layers (quality).
-		INT_MAX,
-		//	Selected region on the rendering grid.
-		region_slice,
-		//	Channel expansion factors used with Channel_Mapping.
-		Expand_Numerator,
-		Expand_Denominator,
-		//	High precision decompression operations.
-		true,
-		//	Access mode.
-		KDU_WANT_OUTPUT_COMPONENTS,
-		//	Fastest (ignored when precise is true).
-		false,
-		//	Multi-threaded processing environment (single threaded if NULL).
-		Thread_Group,
-
-    Master_Queue
-		);}
+	try {start_decompressor (Decompressor, region_slice, thread_env);}
 	catch (kdu_exception except)
 		{
-		if (Thread_Group)
-			Thread_Group->handle_exception (READER_ERROR);
-		delete[] image_data;
-		ostringstream
-			message;
-		message
-			<< "Couldn't render region " << rendered_region () << endl;
-		if (rendered_region () != image_region ())
-			message << "- image region " << image_region () << " -" << endl;
-		message
-			<< "at resolution level " << resolution << '.' << endl
-			<< "Starting the JPEG2000 codestream decompressor failed" << endl
-			<< "after rendering " << magnitude (Bytes_Rendered)
-				<< " (" << Bytes_Rendered << ") image data bytes" << endl
-			<< "for the " << source_name () << " source." << endl
-			<< Kakadu_error_message (except);
-		throw JP2_Exception (message.str (), ID);
+		if (thread_env)
+			thread_env->handle_exception (READER_ERROR);
+		throw JP2_Exception (rendering_failure
+			("Starting the JPEG2000 codestream decompressor failed",
+			Kakadu_error_message (except)), ID);
 		}
 
+	//	The decompression may be interrupted by cancel_rendering.
+	interruptible (true, thread_env);
+
 	bool
 		continue_decompressing = true;
 	while (continue_decompressing)
@@ -1694,152 +2592,47 @@ while (continue_rendering)
 		gettimeofday (start_time, 0);
 		#endif	//	!_WIN32
 		#endif
-		if (line_increment < region_slice.size.y &&
-		   (line_increment + (line_increment >> 3)) > region_slice.size.y)
-			{
-			//	Render the remainder of the slice.
-			suggested_increment = region_slice.size.y * region_slice.size.x;
-			#if ((DEBUG) & (DEBUG_RENDER | DEBUG_TIMING | DEBUG_LOCATION))
-			clog << "    increased line increment from " << line_increment
-					<< " to " << region_slice.size.y << endl;
-			#endif
-			}
-		else
-			suggested_increment = line_increment * region_slice.size.x;
 		try
 			{
-			if (pixel_bytes == 1)
-				continue_decompressing = Decompressor.process
-					(
-					/*	Array of rendered pixel data buffer pointers.
-
-						Each entry is the address of the pixel data buffer
-						for the corresponding codestream channel. NULL
-						entries indicated channels to be skipped.
-					*/
-					reinterpret_cast<kdu_byte**>(image_data),
-
-					//	Expand single band to multi-band.
-					false,
-					//	Pixel sample stride distance in bytes.
-					pixel_gap,
-
-					/*	Origin on the rendered grid of the image_data buffers.
-
-						This is set to the render region origin.
-						The buffer origin is ignored if the row_gap is zero.
-					*/
-					buffer_origin,
-
-					//	Line stride distance in pixel samples.
-					row_gap,
-
-					/*	Suggested samples, of the first channel, to render.
-
-						<b>N.B.</b>: This is only a suggestion; the method
-						may decompress fewer or more lines. Experience shows
-						that the method is likely to decompresses one more
-						line than suggested. The exception is the last
-						increment which will never exceed the incomplete
-						region slice.
-					*/
-					suggested_increment,
-
-					//	Max buffer samples; ignored if row_gap non-zero.
-					-1,
-
-					/*	The incomplete region yet to be rendered.
-
-						When the method returns the position of the first
-						line (pos.y) will have been moved down (increased)
-						by the number of completely decompressed lines.
-					*/
-					region_slice,
-
-					/*	Reports the region that was rendered.
-
-						The region that was actually decompressed and written
-						to the image_data buffers. May be empty on return
-						even if there is more data to decompress (i.e. use
-						continue_decompressing).
-					*/
-					region_rendered,
-
-					//	Precision of the rendered pixel samples.
-					pixel_bits,
-					//	Is row_gap measured in pixels (or samples)?
-					false
-					);
-			else
-				continue_decompressing = Decompressor.process
-	  				(
-					reinterpret_cast<kdu_uint16**>(image_data),
-					false,
-					pixel_gap,
-					buffer_origin,
-					row_gap,
-					suggested_increment,
-					-1,
-					region_slice,
-					region_rendered,
-					pixel_bits,
-					false
-					);
-          /*
-          if (Thread_Group)
-            {
-              #if ((DEBUG) & DEBUG_RENDER)
-              clog << "   Waiting for threads to complete..." << endl;
-              #endif
-                    //	Ensure completion of all thread processing.
-            if(!Thread_Group->join (Master_Queue, false, &kdu_exception_value))
-            {
-            throw JP2_Exception("Thread join failed");
-            }
-          }*/
+			continue_decompressing =
+				decompress_increment (this, Decompressor,
+					&image_data[0], pixel_bytes, pixel_bits,
+					pixel_gap, buffer_origin, row_gap, increment_lines,
+					region_slice, region_rendered);
+			//	Only the first increment may be a low latency increment.
+			increment_lines = line_increment;
 			}
 		catch (kdu_exception except)
 			{
-			#if ((DEBUG) & DEBUG_RENDER)
-			clog << "<-- Decompression exception!" << endl;
-			#endif
-			if (Thread_Group)
-				Thread_Group->handle_exception (READER_ERROR);
-			Decompressor.finish ();
-			if (Thread_Group)
-				Thread_Group->terminate (NULL, true);
-			close ();
-			delete[] image_data;
+			if (interruptible (false))
+				{
+				//	Rendering canceled.
+				#if ((DEBUG) & DEBUG_RENDER)
+				clog << "<-- Decompression interrupted" << endl;
+				#endif
+				Decompressor.finish ();
+				recover_from_interruption ();
+				interrupted = true;
+				continue_rendering = false;
+				break;
+				}
+			abandon_decompression (thread_env, &Decompressor);
 			ostringstream
-				message;
-			message
-				<< "Couldn't render region " << rendered_region () << endl;
-			if (rendered_region () != image_region ())
-				message << "- image region " << image_region () << " -" << endl;
-			message
-				<< "at resolution level " << resolution << '.' << endl
+				description;
+			description
 				<< "JPEG2000 codestream decompression failed" << endl
-				<< "while rendering section " << region_slice << endl
-				<< "after rendering " << magnitude (Bytes_Rendered)
-					<< " (" << Bytes_Rendered << ") image data bytes" << endl
-				<< "for the " << source_name () << " source." << endl
-				<< Kakadu_error_message (except);
-			throw JP2_Exception (message.str (), ID);
+				<< "while rendering section " << region_slice;
+			throw JP2_Exception (rendering_failure
+				(description.str (), Kakadu_error_message (except)), ID);
 			}
 
-
-
-		Bytes_Rendered +=
-			region_rendered.area () * bands * pixel_bytes;
-
 		#if ((DEBUG) & (DEBUG_RENDER | DEBUG_TIMING | DEBUG_LOCATION))
 		clog << "..> " << acquisitions << '-'
 				<< decompressions << '/' << total_decompressions
 			<< " - decompression - continue = "
 				<< boolalpha << continue_decompressing << endl
 			<< "         region_slice: " << region_slice << endl
-			<< "      region_rendered: " << region_rendered << endl
-			<< "       Bytes_Rendered: " << Bytes_Rendered << endl;
+			<< "      region_rendered: " << region_rendered << endl;
 		#ifndef _WIN32
 		//	Procedure timing is not implemented for MS/Windows.
 		end_clock = clock ();
@@ -1868,30 +2661,8 @@ while (continue_rendering)
 			//!!! Work-around for case where process should return false.
 			continue_decompressing = false;
 
-		//	Rendered region decompressed for data_disposition.
-		rendered_res_cube.Y           = region_rendered.pos.y;
-		rendered_res_cube.Height      = region_rendered.size.y;
-		//	Reverse map rendered res dimensions to the full res dimensions.
-		region_rendered =
-			Decompressor.find_codestream_cover_dims (region_rendered,
-				subsampling, Expand_Numerator, Expand_Denominator);
-		full_res_rendered_cube.Y      = region_rendered.pos.y;
-		full_res_rendered_cube.Height = region_rendered.size.y;
-		//	Clip to the user specifified dimensions.
-		full_res_rendered_cube &= full_res_region_cube;
-		#if ((DEBUG) & (DEBUG_RENDER | DEBUG_LOCATION))
-		clog << "       decompressed region = "
-				<< rendered_res_cube << endl
-			 << "           rendered region = "
-			 	<< render_region << endl
-			 << "              image region = "
-			 	<< full_res_rendered_cube << endl;
-		#endif
-		//	Wrangle the data into the correct structure and notify monitor.
 		continue_rendering =	//	False if monitor user cancelled.
-			data_disposition
-				(status, Rendering_Monitor::Status_Message[status],
-				rendered_res_cube, full_res_rendered_cube);
+			dispose_increment (status, region_rendered);
 
 		continue_decompressing =
 			//	Monitor user cancelled?
@@ -1902,28 +2673,32 @@ while (continue_rendering)
 			region_slice.size.y;
 		}	//	Decompression.
 
+	if (! interrupted &&
+		interruptible (false))
+		{
+		//	Interrupted after the last decompression increment.
+		#if ((DEBUG) & DEBUG_RENDER)
+		clog << "<-- Decompression interrupted" << endl;
+		#endif
+		Decompressor.finish ();
+		recover_from_interruption ();
+		interrupted = true;
+		continue_rendering = false;
+		}
+	if (interrupted)
+		break;
+
 	//	Stop the decompressor.
-  Thread_Group->cs_terminate(JPEG2000_Codestream, &kdu_exception_value);
+	if (thread_env)
+		thread_env->cs_terminate (JPEG2000_Codestream, &kdu_exception_value);
 
 	if (! Decompressor.finish (&kdu_exception_value, false))
 		{
 		close ();
-		delete[] image_data;
-		ostringstream
-			message;
-			message
-				<< "Couldn't render region " << rendered_region () << endl;
-			if (rendered_region () != image_region ())
-				message << "- image region " << image_region () << " -" << endl;
-			message
-				<< "at resolution level " << resolution << '.' << endl
-			<< "JPEG2000 codestream decompression finish failed" << endl
-			<< "after rendering " << magnitude (Bytes_Rendered)
-				<< " (" << Bytes_Rendered << ") image data bytes." << endl
-			<< "The codestream may be corrupted" << endl
-			<< "for the " << source_name () << " source." << endl
-			<< Kakadu_error_message (kdu_exception_value);
-		throw JP2_Exception (message.str (), ID);
+		throw JP2_Exception (rendering_failure
+			("JPEG2000 codestream decompression finish failed;\n"
+			 "the codestream may be corrupted",
+			Kakadu_error_message (kdu_exception_value)), ID);
 		}
 
 	//	Check if more data needs to be acquired --------------------------------
@@ -1955,21 +2730,9 @@ while (continue_rendering)
 					if (region_section.Height == 1)
 						{
 						//	Can't obtain the codestream for a single line!
-						ostringstream
-							message;
-						message
-							<< "Couldn't render region "
-								<< rendered_region () << endl;
-						if (rendered_region () != image_region ())
-							message << "- image region "
-								<< image_region () << " -" << endl;
-						message
-							<< "at resolution level "
-								<< resolution << '.' << endl
-							<< "Unable to obtain a single line"
-								" of codestream data" << endl
-							<< "for the " << source_name () << " source.";
-						throw JPIP_Exception (message.str (), ID);
+						throw JPIP_Exception (rendering_failure
+							("Unable to obtain a single line"
+								" of codestream data."), ID);
 						}
 					adjusted_height = 1;
 					}
@@ -1992,38 +2755,12 @@ while (continue_rendering)
 		}
 	}	//	Data acquisition.
 
-//	Region rendered.
-rendered_res_cube.Y = render_region.Y;
-rendered_res_cube.Height = region_slice.pos.y - render_region.Y;
-region_rendered = rendered_res_cube;
-//	Reverse map the rendered res dimensions to the full res dimensions.
-region_rendered =
-	Decompressor.find_codestream_cover_dims (region_rendered,
-		subsampling, Expand_Numerator, Expand_Denominator);
-full_res_rendered_cube.Y          = region_rendered.pos.y;
-full_res_rendered_cube.Height     = region_rendered.size.y;
-//	Clip to the user specifified dimensions.
-full_res_rendered_cube &= full_res_region_cube;
-
 #if ((DEBUG) & (DEBUG_RENDER | DEBUG_LOCATION))
 clog << "<== Decompression finished" << endl;
 #endif
-status = continue_rendering ?
-	Rendering_Monitor::DONE : Rendering_Monitor::CANCELED;
-#if ((DEBUG) & (DEBUG_RENDER | DEBUG_NOTIFY | DEBUG_LOCATION))
-clog << "    JP2_File_Reader::render: notify status "
-		<< status << " \""
-		<< Rendering_Monitor::Status_Message[status] << '"' << endl
-	 << "    rendered region = " << rendered_res_cube << endl
-	 << "       image region = " << full_res_rendered_cube << endl;
-#endif
-if (monitor)
-	monitor->notify (*this,
-		status, Rendering_Monitor::Status_Message[status],
-		rendered_res_cube, full_res_rendered_cube);
+rendered_res_cube = rendering_finished
+	(region_slice.pos.y - render_region.Y, continue_rendering);
 
-//	Cleanup.
-delete[] image_data;
 #if ((DEBUG) & (DEBUG_RENDER | DEBUG_TIMING | DEBUG_LOCATION))
 #ifndef _WIN32
 //	Procedure timing is not implemented for MS/Windows.
@@ -2053,6 +2790,2211 @@ return rendered_res_cube;
 }
 
 
+/*==============================================================================
+	Strip rendering
+*/
+#ifndef DOXYGEN_PROCESSING
+namespace
+{
+/*	Rendering engine for one horizontal strip of the rendered region.
+
+	Each strip has its own region decompressor; all of them share the
+	reader's codestream and Thread_Group. Strips do not share any tiles.
+*/
+struct Rendering_Strip
+{
+kdu_region_decompressor
+	Decompressor;
+//	The part of the strip yet to be decompressed.
+KDU_dims
+	Slice;
+//	The part of the strip decompressed by the last increment.
+KDU_dims
+	Rendered;
+bool
+	Started,
+	Decompressing;
+
+Rendering_Strip ()
+	:	Started (false),
+		Decompressing (false)
+	{}
+};
+
+
+bool
+finish_strips
+	(
+	std::vector<Rendering_Strip>&	strips,
+	kdu_exception*					exception_value
+	)
+{
+bool
+	finished = true;
+for (unsigned int
+		index = 0;
+		index < strips.size ();
+		index++)
+	{
+	if (strips[index].Started &&
+		! strips[index].Decompressor.finish (exception_value, false))
+		finished = false;
+	strips[index].Started =
+	strips[index].Decompressing = false;
+	}
+return finished;
+}
+
+}	//	local namespace
+#endif
+
+
+std::vector<kdu_dims>
+JP2_File_Reader::strip_slices
+	(
+	unsigned int	strips
+	)
+{
+std::vector<kdu_dims>
+	slices;
+if (strips < 2 ||
+	Expand_Numerator.x != Expand_Denominator.x ||
+	Expand_Numerator.y != Expand_Denominator.y)
+	//	Expanded rendering lines depend on the lines of adjacent tiles.
+	return slices;
+
+KDU_dims
+	region (rendered_region ());
+int
+	end_line = region.pos.y + region.size.y;
+
+//	The first line of each tile row in the rendered region.
+std::vector<int>
+	row_lines;
+kdu_dims
+	tile_indices,
+	tile;
+JPEG2000_Codestream.get_valid_tiles (tile_indices);
+for (int
+		row = 0;
+		row < tile_indices.size.y;
+		row++)
+	{
+	JPEG2000_Codestream.get_tile_dims
+		(kdu_coords (tile_indices.pos.x, tile_indices.pos.y + row),
+		Channel_Mapping.source_components[0], tile, true);
+	int
+		line = std::max (tile.pos.y, region.pos.y);
+	if (line < std::min (tile.pos.y + tile.size.y, end_line))
+		row_lines.push_back (line);
+	}
+#if ((DEBUG) & DEBUG_RENDER)
+clog << ">-< JP2_File_Reader::strip_slices: " << row_lines.size ()
+		<< " tile rows in region " << region << endl;
+#endif
+if (row_lines.size () < 2)
+	return slices;
+
+//	Contiguous groups of whole tile rows.
+unsigned int
+	rows = row_lines.size ();
+if (strips > rows)
+	strips = rows;
+row_lines.push_back (end_line);
+for (unsigned int
+		index = 0;
+		index < strips;
+		index++)
+	{
+	unsigned int
+		first = (index * rows) / strips,
+		last  = ((index + 1) * rows) / strips;
+	KDU_dims
+		slice (region);
+	slice.pos.y  = row_lines[first];
+	slice.size.y = row_lines[last] - row_lines[first];
+	slices.push_back (slice);
+	}
+return slices;
+}
+
+
+Cube
+JP2_File_Reader::render_strips
+	(
+	const std::vector<kdu_dims>&	slices,
+	kdu_thread_env*					thread_env
+	)
+{
+#if ((DEBUG) & (DEBUG_RENDER | DEBUG_LOCATION))
+clog << ">>> JP2_File_Reader::render_strips: " << slices.size () << endl;
+#endif
+Rectangle
+	//	Region to render on the rendering grid.
+	render_region (rendered_region ());
+
+//	Rendering parameters.
+int
+    pixel_bits			= rendered_pixel_bits (),
+    pixel_bytes			= rendered_pixel_bytes (),
+    pixel_gap			= pixel_stride (),
+    row_gap				= line_stride (),
+    line_increment		= effective_rendering_increment_lines ();
+
+//	Pixel data storage ---------------------------------------------------------
+
+allocate_image_data_buffer ();
+
+/*	The image data buffers origin on the rendering grid.
+
+	All strips use the same buffer origin; the decompressor of each
+	strip writes its pixels directly into its part of the buffers.
+*/
+kdu_coords
+	buffer_origin (render_region.X, render_region.Y);
+unsigned int
+	total_bands = image_bands ();
+std::vector<void*>
+	image_data (total_bands, (void*)NULL);
+for (unsigned int
+		band = 0;
+		band < total_bands;
+		band++)
+	image_data[band] = Rendered_Bands[band] ? Image_Data[band] : NULL;
+
+//	Rendering strips -----------------------------------------------------------
+
+unsigned int
+	strips = slices.size (),
+	index;
+std::vector<Rendering_Strip>
+	strip (strips);
+for (index = 0;
+	 index < strips;
+	 index++)
+	{
+	strip[index].Slice = slices[index];
+	#if ((DEBUG) & DEBUG_RENDER)
+	clog << "    strip " << index << ": " << strip[index].Slice << endl;
+	#endif
+	}
+
+kdu_exception
+	kdu_exception_value;
+try
+	{
+	for (index = 0;
+		 index < strips;
+		 index++)
+		{
+		start_decompressor
+			(strip[index].Decompressor, strip[index].Slice, thread_env);
+		strip[index].Started =
+		strip[index].Decompressing = true;
+		}
+	}
+catch (kdu_exception except)
+	{
+	thread_env->handle_exception (READER_ERROR);
+	finish_strips (strip, NULL);
+	ostringstream
+		description;
+	description
+		<< "Starting the JPEG2000 codestream decompressor for strip "
+			<< index << " of " << strips << " failed";
+	throw JP2_Exception (rendering_failure
+		(description.str (), Kakadu_error_message (except)), ID);
+	}
+
+/*	Strip decompression.
+
+	Each pass drives one increment of every strip that is still being
+	decompressed. While the processing of one strip increment is being
+	waited on the Thread_Group continues with the work queued for the
+	other strips.
+*/
+Rendering_Monitor::Status
+	status = Rendering_Monitor::TOP_QUALITY_DATA;
+bool
+	continue_rendering = true,	//	False if rendering canceled.
+	interrupted = false;		//	True if rendering interrupted.
+unsigned int
+	decompressing = strips;
+//	Stops any pipelined data disposition however rendering ends.
+Data_Disposition_Guard
+	disposition_guard (*this);
+//	The decompression may be interrupted by cancel_rendering.
+interruptible (true, thread_env);
+while (continue_rendering &&
+		decompressing)
+	{
+	for (index = 0;
+		 continue_rendering &&
+		 index < strips;
+		 index++)
+		{
+		Rendering_Strip&
+			rendering_strip = strip[index];
+		if (! rendering_strip.Decompressing)
+			continue;
+
+		#if ((DEBUG) & DEBUG_RENDER)
+		clog << "..> strip " << index
+				<< " - decompressing region slice "
+				<< rendering_strip.Slice << endl;
+		#endif
+		try
+			{
+			rendering_strip.Decompressing =
+				decompress_increment (this, rendering_strip.Decompressor,
+					&image_data[0], pixel_bytes, pixel_bits,
+					pixel_gap, buffer_origin, row_gap, line_increment,
+					rendering_strip.Slice, rendering_strip.Rendered);
+			}
+		catch (kdu_exception except)
+			{
+			if (interruptible (false))
+				{
+				//	Rendering canceled.
+				#if ((DEBUG) & DEBUG_RENDER)
+				clog << "<-- Strip " << index << " decompression interrupted"
+						<< endl;
+				#endif
+				finish_strips (strip, NULL);
+				recover_from_interruption ();
+				interrupted = true;
+				continue_rendering = false;
+				break;
+				}
+			thread_env->handle_exception (READER_ERROR);
+			finish_strips (strip, NULL);
+			abandon_decompression (thread_env);
+			ostringstream
+				description;
+			description
+				<< "JPEG2000 codestream decompression failed" << endl
+				<< "while rendering section " << rendering_strip.Slice
+					<< " of strip " << index;
+			throw JP2_Exception (rendering_failure
+				(description.str (), Kakadu_error_message (except)), ID);
+			}
+
+		if (rendering_strip.Decompressing &&
+			rendering_strip.Slice.is_empty ())
+			//!!! Work-around for case where process should return false.
+			rendering_strip.Decompressing = false;
+		if (! rendering_strip.Decompressing)
+			--decompressing;
+
+		if (rendering_strip.Rendered.is_empty ())
+			continue;
+
+		continue_rendering =	//	False if monitor user cancelled.
+			dispose_increment (status, rendering_strip.Rendered);
+		}
+	}
+
+if (! interrupted &&
+	interruptible (false))
+	{
+	//	Interrupted after the last decompression increment.
+	finish_strips (strip, NULL);
+	recover_from_interruption ();
+	interrupted = true;
+	continue_rendering = false;
+	}
+
+//	Stop the decompressors.
+if (! interrupted &&
+	! finish_strips (strip, &kdu_exception_value))
+	{
+	close ();
+	throw JP2_Exception (rendering_failure
+		("JPEG2000 codestream decompression finish failed;\n"
+		 "the codestream may be corrupted",
+		Kakadu_error_message (kdu_exception_value)), ID);
+	}
+
+/*	Lines rendered.
+
+	If rendering was canceled only the lines from the top of the
+	rendered region to the first incomplete strip were rendered.
+*/
+unsigned int
+	rendered_lines = render_region.Height;
+for (index = 0;
+	 index < strips;
+	 index++)
+	{
+	if (! strip[index].Slice.is_empty ())
+		{
+		rendered_lines = strip[index].Slice.pos.y - render_region.Y;
+		break;
+		}
+	}
+Cube
+	rendered_res_cube (rendering_finished (rendered_lines, continue_rendering));
+#if ((DEBUG) & (DEBUG_RENDER | DEBUG_LOCATION))
+clog << "<<< JP2_File_Reader::render_strips: " << rendered_res_cube << endl;
+#endif
+return rendered_res_cube;
+}
+
+
+/*==============================================================================
+	Chunked image data rendering
+*/
+Cube
+JP2_File_Reader::render_chunks
+	(
+	kdu_thread_env*	thread_env
+	)
+{
+#if ((DEBUG) & (DEBUG_RENDER | DEBUG_LOCATION))
+clog << ">>> JP2_File_Reader::render_chunks" << endl;
+#endif
+Rectangle
+	//	Region to render on the rendering grid.
+	render_region (rendered_region ());
+KDU_dims
+	region_rendered;
+
+//	Rendering parameters.
+int
+    pixel_bits			= rendered_pixel_bits (),
+    pixel_bytes			= rendered_pixel_bytes (),
+    pixel_gap			= pixel_stride (),
+    row_gap				= line_stride (),
+    line_increment		= effective_rendering_increment_lines (),
+    increment_lines		= first_rendering_increment_lines ();
+
+//	Pixel data storage ---------------------------------------------------------
+
+allocate_image_data_buffer ();
+
+unsigned int
+	total_bands = image_bands (),
+	chunks = image_data_chunks (),
+	chunk_lines = effective_chunk_lines (),
+	chunk,
+	band;
+std::vector<void*>
+	image_data (total_bands, (void*)NULL);
+#if ((DEBUG) & DEBUG_RENDER)
+clog << "    " << chunks << " chunks of " << chunk_lines << " lines" << endl;
+#endif
+
+/*	Chunk decompression.
+
+	Each chunk is decompressed by the Decompressor, started on the
+	slice of the rendered region held by the chunk, with the chunk's
+	image data buffers and a buffer origin at the first line of the
+	chunk.
+*/
+Rendering_Monitor::Status
+	status = Rendering_Monitor::TOP_QUALITY_DATA;
+bool
+	continue_rendering = true,	//	False if rendering canceled.
+	continue_decompressing,
+	interrupted = false;		//	True if rendering interrupted.
+kdu_exception
+	kdu_exception_value;
+KDU_dims
+	region_slice;
+//	Stops any pipelined data disposition however rendering ends.
+Data_Disposition_Guard
+	disposition_guard (*this);
+for (chunk = 0;
+	 continue_rendering &&
+	 chunk < chunks;
+	 chunk++)
+	{
+	region_slice = render_region;
+	region_slice.pos.y = render_region.Y + (chunk * chunk_lines);
+	region_slice.size.y =
+		std::min (chunk_lines, render_region.Height - (chunk * chunk_lines));
+	kdu_coords
+		buffer_origin (render_region.X, region_slice.pos.y);
+	void
+		**chunk_data = image_data_chunk (chunk);
+	for (band = 0;
+		 band < total_bands;
+		 band++)
+		image_data[band] = Rendered_Bands[band] ? chunk_data[band] : NULL;
+	#if ((DEBUG) & DEBUG_RENDER)
+	clog << "==> chunk " << chunk << ": " << region_slice << endl;
+	#endif
+
+	try {start_decompressor (Decompressor, region_slice, thread_env);}
+	catch (kdu_exception except)
+		{
+		if (thread_env)
+			thread_env->handle_exception (READER_ERROR);
+		ostringstream
+			description;
+		description
+			<< "Starting the JPEG2000 codestream decompressor for chunk "
+				<< chunk << " of " << chunks << " failed";
+		throw JP2_Exception (rendering_failure
+			(description.str (), Kakadu_error_message (except)), ID);
+		}
+
+	//	The decompression may be interrupted by cancel_rendering.
+	interruptible (true, thread_env);
+	continue_decompressing = true;
+	while (continue_rendering &&
+			continue_decompressing)
+		{
+		try
+			{
+			continue_decompressing =
+				decompress_increment (this, Decompressor,
+					&image_data[0], pixel_bytes, pixel_bits,
+					pixel_gap, buffer_origin, row_gap, increment_lines,
+					region_slice, region_rendered);
+			//	Only the first increment may be a low latency increment.
+			increment_lines = line_increment;
+			}
+		catch (kdu_exception except)
+			{
+			if (interruptible (false))
+				{
+				//	Rendering canceled.
+				#if ((DEBUG) & DEBUG_RENDER)
+				clog << "<-- Chunk " << chunk << " decompression interrupted"
+						<< endl;
+				#endif
+				Decompressor.finish ();
+				recover_from_interruption ();
+				interrupted = true;
+				continue_rendering = false;
+				break;
+				}
+			abandon_decompression (thread_env, &Decompressor);
+			ostringstream
+				description;
+			description
+				<< "JPEG2000 codestream decompression failed" << endl
+				<< "while rendering section " << region_slice
+					<< " of chunk " << chunk;
+			throw JP2_Exception (rendering_failure
+				(description.str (), Kakadu_error_message (except)), ID);
+			}
+		if (continue_decompressing &&
+			region_slice.is_empty ())
+			//!!! Work-around for case where process should return false.
+			continue_decompressing = false;
+
+		if (region_rendered.is_empty ())
+			continue;
+
+		continue_rendering =	//	False if monitor user cancelled.
+			dispose_increment (status, region_rendered);
+		}
+
+	if (! interrupted &&
+		interruptible (false))
+		{
+		//	Interrupted after the last decompression increment.
+		Decompressor.finish ();
+		recover_from_interruption ();
+		interrupted = true;
+		continue_rendering = false;
+		}
+
+	//	Stop the Decompressor.
+	if (! interrupted &&
+		! Decompressor.finish (&kdu_exception_value, false))
+		{
+		close ();
+		ostringstream
+			description;
+		description
+			<< "JPEG2000 codestream decompression finish failed"
+				" for chunk " << chunk << ';' << endl
+			<< "the codestream may be corrupted";
+		throw JP2_Exception (rendering_failure
+			(description.str (), Kakadu_error_message (kdu_exception_value)),
+			ID);
+		}
+	}
+
+Cube
+	rendered_res_cube (rendering_finished
+		(continue_rendering ?
+			render_region.Height : (region_slice.pos.y - render_region.Y),
+		continue_rendering));
+#if ((DEBUG) & (DEBUG_RENDER | DEBUG_LOCATION))
+clog << "<<< JP2_File_Reader::render_chunks: " << rendered_res_cube << endl;
+#endif
+return rendered_res_cube;
+}
+
+
+/*==============================================================================
+	Line sink rendering
+*/
+Cube
+JP2_File_Reader::render_lines
+	(
+	kdu_thread_env*	thread_env
+	)
+{
+#if ((DEBUG) & (DEBUG_RENDER | DEBUG_LOCATION))
+clog << ">>> JP2_File_Reader::render_lines" << endl;
+#endif
+Rectangle
+	//	Region to render on the rendering grid.
+	render_region (rendered_region ());
+KDU_dims
+	//	Part of the render_region yet to be decompressed.
+	region_slice (render_region),
+	//	The last part of the region_slice that was decompressed.
+	region_rendered;
+
+//	Rendering parameters.
+int
+    pixel_bits			= rendered_pixel_bits (),
+    pixel_bytes			= decoded_pixel_bytes (),
+    bands				= rendered_bands (),
+    line_increment		= effective_rendering_increment_lines (),
+    increment_lines		= first_rendering_increment_lines ();
+
+//	Increment buffers ----------------------------------------------------------
+
+/*	The ring of increment buffers.
+
+	Each buffer holds the rendered bands of one increment as tightly
+	packed lines; an increment may be extended by up to an eighth (see
+	decompress_increment) plus the extra line the decompressor is apt to
+	produce. With pipelined data disposition one buffer is rendered while
+	the others are being delivered to the line sink.
+*/
+unsigned int
+	total_bands = image_bands (),
+	ring_size = pipelined_disposition () ? LINE_SINK_BUFFERS : 1,
+	slot,
+	band;
+if (! ring_size)
+	ring_size = 1;
+int
+	buffer_lines = line_increment + (line_increment >> 3) + 1,
+	buffer_pixels = buffer_lines * render_region.Width;
+std::vector<std::vector<unsigned char> >
+	ring (ring_size);
+std::vector<std::vector<void*> >
+	ring_data (ring_size, std::vector<void*> (total_bands, (void*)NULL));
+try
+	{
+	for (slot = 0;
+		 slot < ring_size;
+		 slot++)
+		{
+		ring[slot].resize ((size_t)buffer_pixels * pixel_bytes * bands);
+		unsigned char
+			*plane = &ring[slot][0];
+		for (band = 0;
+			 band < total_bands;
+			 band++)
+			{
+			if (Rendered_Bands[band])
+				{
+				ring_data[slot][band] = plane;
+				plane += (size_t)buffer_pixels * pixel_bytes;
+				}
+			}
+		}
+	}
+catch (std::bad_alloc&)
+	{
+	unsigned long long
+		size = (unsigned long long)buffer_pixels * pixel_bytes * bands;
+	ostringstream
+		message;
+	message
+		<< "Couldn't allocate " << ring_size << ' ' << magnitude (size)
+			<< " (" << size << ") byte line sink increment buffers" << endl
+		<< "for the " << source_name () << " source.";
+	throw JP2_Out_of_Range (message.str (), ID);
+	}
+#if ((DEBUG) & DEBUG_RENDER)
+clog << "    " << ring_size << " increment buffers of "
+		<< buffer_lines << " lines" << endl;
+#endif
+
+//	Decompression --------------------------------------------------------------
+
+if (stretching ())
+	//	Stretch tables for the increment disposition.
+	prepare_stretch ();
+
+try {start_decompressor (Decompressor, region_slice, thread_env);}
+catch (kdu_exception except)
+	{
+	if (thread_env)
+		thread_env->handle_exception (READER_ERROR);
+	throw JP2_Exception (rendering_failure
+		("Starting the JPEG2000 codestream decompressor failed",
+		Kakadu_error_message (except)), ID);
+	}
+
+Rendering_Monitor::Status
+	status = Rendering_Monitor::TOP_QUALITY_DATA;
+kdu_exception
+	kdu_exception_value;
+bool
+	continue_rendering = true,	//	False if rendering canceled.
+	continue_decompressing = true,
+	interrupted = false;		//	True if rendering interrupted.
+//	Stops any pipelined data disposition before the ring is released.
+Data_Disposition_Guard
+	disposition_guard (*this);
+//	The decompression may be interrupted by cancel_rendering.
+interruptible (true, thread_env);
+slot = 0;
+while (continue_rendering &&
+		continue_decompressing)
+	{
+	//	The disposition of the last increment rendered in the buffer.
+	wait_data_disposition (ring_size - 1);
+
+	#if ((DEBUG) & DEBUG_RENDER)
+	clog << "..> buffer " << slot
+			<< " - decompressing region slice " << region_slice << endl;
+	#endif
+	try
+		{
+		continue_decompressing =
+			decompress_increment (this, Decompressor,
+				&ring_data[slot][0], pixel_bytes, pixel_bits,
+				1, kdu_coords (), 0, increment_lines,
+				region_slice, region_rendered, buffer_pixels);
+		//	Only the first increment may be a low latency increment.
+		increment_lines = line_increment;
+		}
+	catch (kdu_exception except)
+		{
+		if (interruptible (false))
+			{
+			//	Rendering canceled.
+			#if ((DEBUG) & DEBUG_RENDER)
+			clog << "<-- Decompression interrupted" << endl;
+			#endif
+			Decompressor.finish ();
+			recover_from_interruption ();
+			interrupted = true;
+			continue_rendering = false;
+			break;
+			}
+		abandon_decompression (thread_env, &Decompressor);
+		ostringstream
+			description;
+		description
+			<< "JPEG2000 codestream decompression failed" << endl
+			<< "while rendering section " << region_slice;
+		throw JP2_Exception (rendering_failure
+			(description.str (), Kakadu_error_message (except)), ID);
+		}
+
+	if (continue_decompressing &&
+		region_slice.is_empty ())
+		//!!! Work-around for case where process should return false.
+		continue_decompressing = false;
+
+	if (region_rendered.is_empty ())
+		continue;
+
+	//	Deliver the lines to the line sink and notify the monitor.
+	continue_rendering =	//	False if the user cancelled.
+		dispose_increment (status, region_rendered,
+			&ring_data[slot][0], region_rendered.size.x);
+	slot = (slot + 1) % ring_size;
+	}
+
+if (! interrupted &&
+	interruptible (false))
+	{
+	//	Interrupted after the last decompression increment.
+	Decompressor.finish ();
+	recover_from_interruption ();
+	interrupted = true;
+	continue_rendering = false;
+	}
+
+//	Stop the decompressor.
+if (! interrupted)
+	{
+	if (thread_env)
+		thread_env->cs_terminate (JPEG2000_Codestream, &kdu_exception_value);
+	if (! Decompressor.finish (&kdu_exception_value, false))
+		{
+		close ();
+		throw JP2_Exception (rendering_failure
+			("JPEG2000 codestream decompression finish failed;\n"
+			 "the codestream may be corrupted",
+			Kakadu_error_message (kdu_exception_value)), ID);
+		}
+	}
+
+Cube
+	rendered_res_cube (rendering_finished
+		(region_slice.pos.y - render_region.Y, continue_rendering));
+#if ((DEBUG) & (DEBUG_RENDER | DEBUG_LOCATION))
+clog << "<<< JP2_File_Reader::render_lines: " << rendered_res_cube << endl;
+#endif
+return rendered_res_cube;
+}
+
+
+
+/*==============================================================================
+	Tile cache rendering
+*/
+#ifndef DOXYGEN_PROCESSING
+namespace
+{
+//	Floor division for cell indices of negative grid positions.
+int
+cell_index
+	(
+	int		position,
+	int		cell_size
+	)
+{
+return (position >= 0) ?
+	(position / cell_size) : -((cell_size - 1 - position) / cell_size);
+}
+
+
+//	Mix a value into a rendering format signature.
+void
+mix_format
+	(
+	unsigned long long&	format,
+	long long			value
+	)
+{format = format * 1000003ULL ^ (unsigned long long)value;}
+}	//	local namespace
+#endif	//	DOXYGEN_PROCESSING
+
+
+Cube
+JP2_File_Reader::render_cells
+	(
+	kdu_thread_env*	thread_env
+	)
+{
+#if ((DEBUG) & (DEBUG_RENDER | DEBUG_LOCATION))
+clog << ">>> JP2_File_Reader::render_cells" << endl;
+#endif
+JP2_Tile_Cache
+	*cache = tile_cache ();
+Rectangle
+	render_region (rendered_region ());
+int
+	resolution		= resolution_level (),
+	pixel_bytes		= rendered_pixel_bytes (),
+	cell_size		= cache->cell_size (),
+	pixel_gap		= pixel_stride () * pixel_bytes,
+	row_gap			= line_stride () * pixel_bytes,
+	first_row		= cell_index (render_region.Y, cell_size),
+	last_row		= cell_index
+						(render_region.Y + render_region.Height - 1, cell_size),
+	first_column	= cell_index (render_region.X, cell_size),
+	last_column		= cell_index
+						(render_region.X + render_region.Width - 1, cell_size),
+	row,
+	column;
+unsigned int
+	total_bands = image_bands (),
+	band;
+
+allocate_image_data_buffer ();
+
+//	The rendered image grid.
+kdu_coords
+	subsampling;
+JPEG2000_Codestream.get_subsampling
+	(Channel_Mapping.source_components[0], subsampling, true);
+KDU_dims
+	image_dimensions (image_size ()),
+	full,
+	region_rendered;
+full = Decompressor.find_render_dims (image_dimensions,
+	subsampling, Expand_Numerator, Expand_Denominator);
+region_rendered = render_region;
+
+//	Tile identification.
+JP2_Tile_Cache::Key
+	key;
+key.Source = source_name ();
+key.Resolution_Level = resolution;
+key.Format = rendered_pixel_bits ();
+mix_format (key.Format, float_samples ());
+mix_format (key.Format, max_quality_layers ());
+mix_format (key.Format, Expand_Numerator.x);
+mix_format (key.Format, Expand_Numerator.y);
+mix_format (key.Format, Expand_Denominator.x);
+mix_format (key.Format, Expand_Denominator.y);
+#if ((DEBUG) & DEBUG_RENDER)
+clog << "    cells " << first_column << '-' << last_column
+		<< " x " << first_row << '-' << last_row
+		<< " of " << cell_size << " pixels" << endl;
+#endif
+
+//	Cells may extend beyond the selected image region.
+KDU_dims
+	selection (image_region ());
+try {JPEG2000_Codestream.apply_input_restrictions
+	(0, 0, resolution - 1, 0, NULL, KDU_WANT_OUTPUT_COMPONENTS, thread_env);}
+catch (kdu_exception except)
+	{
+	throw JP2_Exception (rendering_failure
+		("Removing the codestream region restriction failed",
+		Kakadu_error_message (except)), ID);
+	}
+
+Rendering_Monitor::Status
+	status = Rendering_Monitor::TOP_QUALITY_DATA;
+bool
+	continue_rendering = true,	//	False if rendering canceled.
+	interrupted = false;		//	True if rendering interrupted.
+Data_Disposition_Guard
+	disposition_guard (*this);
+std::vector<std::shared_ptr<const JP2_Tile_Cache::Tile> >
+	tiles (total_bands);
+//	The cell decompression may be interrupted by cancel_rendering.
+interruptible (true, thread_env);
+for (row = first_row;
+	 row <= last_row &&
+		continue_rendering;
+	 row++)
+	{
+	for (column = first_column;
+		 column <= last_column;
+		 column++)
+		{
+		KDU_dims
+			cell;
+		cell.pos.x = column * cell_size;
+		cell.pos.y = row * cell_size;
+		cell.size.x =
+		cell.size.y = cell_size;
+		cell &= full;
+		if (cell.is_empty ())
+			continue;
+
+		//	Cached tiles.
+		bool
+			missing = false;
+		key.Column = column;
+		key.Row = row;
+		for (band = 0;
+			 band < total_bands;
+			 band++)
+			{
+			tiles[band].reset ();
+			if (! Rendered_Bands[band])
+				continue;
+			key.Band = band;
+			if (! (tiles[band] = cache->find (key)))
+				missing = true;
+			}
+
+		if (missing)
+			{
+			try {decode_cell (cell, tiles, thread_env);}
+			catch (kdu_exception except)
+				{
+				//	The cell decompressor has been finished.
+				if (interruptible (false))
+					{
+					//	Rendering canceled.
+					#if ((DEBUG) & DEBUG_RENDER)
+					clog << "<-- Cell decompression interrupted" << endl;
+					#endif
+					recover_from_interruption ();
+					interrupted = true;
+					continue_rendering = false;
+					break;
+					}
+				abandon_decompression (thread_env);
+				ostringstream
+					description;
+				description
+					<< "JPEG2000 codestream decompression failed" << endl
+					<< "while rendering cell " << cell;
+				throw JP2_Exception (rendering_failure
+					(description.str (), Kakadu_error_message (except)), ID);
+				}
+			for (band = 0;
+				 band < total_bands;
+				 band++)
+				{
+				if (! tiles[band])
+					continue;
+				key.Band = band;
+				cache->insert (key, tiles[band]);
+				}
+			}
+
+		//	Copy the part of the cell in the rendered region.
+		Rectangle
+			part (static_cast<const Rectangle&>(cell));
+		part &= render_region;
+		for (band = 0;
+			 band < total_bands;
+			 band++)
+			{
+			if (! tiles[band] ||
+				! Image_Data[band])
+				continue;
+			const JP2_Tile_Cache::Tile
+				&tile = *tiles[band];
+			const unsigned char
+				*source = &tile.Data[0]
+					+ (((size_t)(part.Y - tile.Y) * tile.Width)
+						+ (part.X - tile.X)) * pixel_bytes;
+			unsigned char
+				*destination = (unsigned char*)Image_Data[band]
+					+ (size_t)(part.Y - render_region.Y) * row_gap
+					+ (size_t)(part.X - render_region.X) * pixel_gap;
+			for (unsigned int
+					line = 0;
+					line < part.Height;
+					line++,
+					source += tile.Width * pixel_bytes,
+					destination += row_gap)
+				{
+				if (pixel_gap == pixel_bytes)
+					std::memcpy (destination, source, part.Width * pixel_bytes);
+				else
+					for (unsigned int
+							pixel = 0;
+							pixel < part.Width;
+							pixel++)
+						std::memcpy (destination + pixel * pixel_gap,
+							source + pixel * pixel_bytes, pixel_bytes);
+				}
+			}
+		}
+
+	if (interrupted)
+		//	The row of cells is incomplete.
+		break;
+
+	//	Row of cells rendered.
+	region_rendered.pos.y = render_region.Y;
+	if (row * cell_size > region_rendered.pos.y)
+		region_rendered.pos.y = row * cell_size;
+	region_rendered.size.y =
+		((row + 1) * cell_size < render_region.Y + (int)render_region.Height ?
+		 (row + 1) * cell_size : render_region.Y + (int)render_region.Height)
+		- region_rendered.pos.y;
+	continue_rendering =
+		dispose_increment (status, region_rendered);
+	}
+
+if (! interrupted &&
+	interruptible (false))
+	{
+	//	Interrupted after the last cell decompression.
+	recover_from_interruption ();
+	interrupted = true;
+	continue_rendering = false;
+	}
+
+//	Restore the selected region restriction.
+try {JPEG2000_Codestream.apply_input_restrictions
+	(0, 0, resolution - 1, 0, &selection, KDU_WANT_OUTPUT_COMPONENTS,
+	thread_env);}
+catch (kdu_exception except)
+	{
+	close ();
+	ostringstream
+		message;
+	message
+		<< "Couldn't restore the codestream region restriction" << endl
+		<< "for the " << source_name () << " source." << endl
+		<< Kakadu_error_message (except);
+	throw JP2_Exception (message.str (), ID);
+	}
+
+//	Region rendered.
+int
+	rendered_lines =
+		((row * cell_size) < render_region.Y + (int)render_region.Height ?
+		 (row * cell_size) : render_region.Y + (int)render_region.Height)
+		- render_region.Y;
+if (rendered_lines < 0)
+	rendered_lines = 0;
+Cube
+	rendered_res_cube (rendering_finished (rendered_lines, continue_rendering));
+#if ((DEBUG) & (DEBUG_RENDER | DEBUG_LOCATION))
+clog << "<<< JP2_File_Reader::render_cells: " << rendered_res_cube << endl
+	 << "    cache " << cache->hits () << " hits, "
+	 	<< cache->misses () << " misses, "
+		<< cache->evictions () << " evictions" << endl;
+#endif
+return rendered_res_cube;
+}
+
+
+void
+JP2_File_Reader::decode_cell
+	(
+	const kdu_dims&	cell,
+	std::vector<std::shared_ptr<const JP2_Tile_Cache::Tile> >&	tiles,
+	kdu_thread_env*	thread_env
+	)
+{
+#if ((DEBUG) & DEBUG_RENDER)
+clog << ">>> JP2_File_Reader::decode_cell: " << cell << endl;
+#endif
+int
+	pixel_bits	= rendered_pixel_bits (),
+	pixel_bytes	= rendered_pixel_bytes (),
+	pixels		= (int)cell.area ();
+unsigned int
+	total_bands = image_bands (),
+	band;
+
+//	Decoded tiles for the missing bands; NULL buffers skip the others.
+std::vector<std::shared_ptr<JP2_Tile_Cache::Tile> >
+	decoded (total_bands);
+std::vector<void*>
+	data (total_bands, (void*)NULL);
+for (band = 0;
+	 band < total_bands;
+	 band++)
+	{
+	if (! Rendered_Bands[band] ||
+		tiles[band])
+		continue;
+	std::shared_ptr<JP2_Tile_Cache::Tile>
+		tile (new JP2_Tile_Cache::Tile);
+	tile->X = cell.pos.x;
+	tile->Y = cell.pos.y;
+	tile->Width = cell.size.x;
+	tile->Height = cell.size.y;
+	tile->Pixel_Bytes = pixel_bytes;
+	tile->Data.resize ((size_t)pixels * pixel_bytes);
+	data[band] = &tile->Data[0];
+	decoded[band] = tile;
+	}
+
+kdu_region_decompressor
+	decompressor;
+kdu_exception
+	kdu_exception_value;
+KDU_dims
+	region_slice,
+	region_rendered;
+region_slice = cell;
+bool
+	continue_decompressing = true;
+try
+	{
+	start_decompressor (decompressor, region_slice, thread_env);
+	while (continue_decompressing)
+		{
+		continue_decompressing =
+			decompress_increment (this, decompressor,
+				&data[0], pixel_bytes, pixel_bits,
+				1, kdu_coords (), 0, cell.size.y,
+				region_slice, region_rendered, pixels);
+		if (continue_decompressing &&
+			region_slice.is_empty ())
+			continue_decompressing = false;
+
+		//	Increments are packed at the start of the buffers.
+		size_t
+			amount = (size_t)region_rendered.area () * pixel_bytes;
+		for (band = 0;
+			 band < total_bands;
+			 band++)
+			if (data[band])
+				data[band] = (unsigned char*)data[band] + amount;
+		pixels -= (int)region_rendered.area ();
+		}
+	}
+catch (kdu_exception except)
+	{
+	if (thread_env)
+		thread_env->handle_exception (READER_ERROR);
+	decompressor.finish ();
+	throw;
+	}
+if (thread_env)
+	thread_env->cs_terminate (JPEG2000_Codestream, &kdu_exception_value);
+if (! decompressor.finish (&kdu_exception_value, false))
+	throw kdu_exception_value;
+
+for (band = 0;
+	 band < total_bands;
+	 band++)
+	if (decoded[band])
+		tiles[band] = decoded[band];
+#if ((DEBUG) & DEBUG_RENDER)
+clog << "<<< JP2_File_Reader::decode_cell" << endl;
+#endif
+}
+
+/*==============================================================================
+	Progressive rendering
+*/
+bool
+JP2_File_Reader::render_preview
+	(
+	kdu_thread_env*	thread_env
+	)
+{
+#if ((DEBUG) & (DEBUG_RENDER | DEBUG_LOCATION))
+clog << ">>> JP2_File_Reader::render_preview" << endl;
+#endif
+int
+	discard		= resolution_level () - 1,
+	levels		= resolution_levels () - 1 - discard,
+	layers		= 1,
+	pixel_bits	= rendered_pixel_bits (),
+	pixel_bytes	= rendered_pixel_bytes ();
+if (levels > (int)progressive_rendering ())
+	levels = progressive_rendering ();
+if (levels < 0)
+	levels = 0;
+//	A preview from the first quality layer needs more than one layer.
+if (! levels &&
+	quality_layers () <= 1)
+	{
+	#if ((DEBUG) & (DEBUG_RENDER | DEBUG_LOCATION))
+	clog << "<<< JP2_File_Reader::render_preview: no coarser preview" << endl;
+	#endif
+	return true;
+	}
+
+//	Expansion of the coarser resolution to the rendering grid.
+kdu_coords
+	subsampling,
+	numerator (Expand_Numerator.x << levels, Expand_Numerator.y << levels);
+JPEG2000_Codestream.get_subsampling
+	(Channel_Mapping.source_components[0], subsampling, true);
+subsampling.x <<= levels;
+subsampling.y <<= levels;
+KDU_dims
+	image_dimensions (image_size ()),
+	full,
+	render_region (rendered_region ()),
+	region_slice,
+	region_rendered;
+full = Decompressor.find_render_dims (image_dimensions,
+	subsampling, numerator, Expand_Denominator);
+region_slice = render_region;
+region_slice &= full;
+#if ((DEBUG) & DEBUG_RENDER)
+clog << "    preview discard levels " << (discard + levels)
+		<< ", expand " << numerator << '/' << Expand_Denominator << endl
+	 << "    preview region " << region_slice << endl;
+#endif
+if (region_slice.is_empty ())
+	{
+	#if ((DEBUG) & (DEBUG_RENDER | DEBUG_LOCATION))
+	clog << "<<< JP2_File_Reader::render_preview: empty" << endl;
+	#endif
+	return true;
+	}
+
+//	The preview is rendered directly into the image data buffers.
+allocate_image_data_buffer ();
+unsigned int
+	total_bands = image_bands ();
+std::vector<void*>
+	image_data (total_bands, (void*)NULL);
+for (unsigned int
+		band = 0;
+		band < total_bands;
+		band++)
+	if (Rendered_Bands[band])
+		image_data[band] = Image_Data[band];
+
+kdu_region_decompressor
+	decompressor;
+kdu_exception
+	kdu_exception_value;
+bool
+	continue_decompressing = true;
+//	The decompression may be interrupted by cancel_rendering.
+interruptible (true, thread_env);
+try
+	{
+	decompressor.start
+		(
+		JPEG2000_Codestream,
+		&Channel_Mapping,
+		-1,
+		discard + levels,
+		layers,
+		region_slice,
+		numerator,
+		Expand_Denominator,
+		false,
+		KDU_WANT_OUTPUT_COMPONENTS,
+		true,
+		thread_env,
+		(thread_env ? Master_Queue : NULL)
+		);
+	while (continue_decompressing)
+		{
+		continue_decompressing =
+			decompress_increment (this, decompressor,
+				&image_data[0], pixel_bytes, pixel_bits,
+				pixel_stride (), render_region.pos, line_stride (),
+				region_slice.size.y, region_slice, region_rendered);
+		if (continue_decompressing &&
+			region_slice.is_empty ())
+			continue_decompressing = false;
+		}
+	}
+catch (kdu_exception except)
+	{
+	if (interruptible (false))
+		{
+		//	Rendering canceled.
+		#if ((DEBUG) & (DEBUG_RENDER | DEBUG_LOCATION))
+		clog << "<<< JP2_File_Reader::render_preview: interrupted" << endl;
+		#endif
+		decompressor.finish ();
+		recover_from_interruption ();
+		return false;
+		}
+	abandon_decompression (thread_env, &decompressor);
+	ostringstream
+		message;
+	message
+		<< "Couldn't render the preview of region " << rendered_region ()
+			<< endl
+		<< "at resolution level " << (discard + levels + 1) << '.' << endl
+		<< "JPEG2000 codestream decompression failed" << endl
+		<< "for the " << source_name () << " source." << endl
+		<< Kakadu_error_message (except);
+	throw JP2_Exception (message.str (), ID);
+	}
+if (interruptible (false))
+	{
+	//	Interrupted after the last decompression increment.
+	#if ((DEBUG) & (DEBUG_RENDER | DEBUG_LOCATION))
+	clog << "<<< JP2_File_Reader::render_preview: interrupted" << endl;
+	#endif
+	decompressor.finish ();
+	recover_from_interruption ();
+	return false;
+	}
+
+if (thread_env)
+	thread_env->cs_terminate (JPEG2000_Codestream, &kdu_exception_value);
+if (! decompressor.finish (&kdu_exception_value, false))
+	{
+	close ();
+	ostringstream
+		message;
+	message
+		<< "Couldn't render the preview of region " << rendered_region ()
+			<< endl
+		<< "at resolution level " << (discard + levels + 1) << '.' << endl
+		<< "JPEG2000 codestream decompression finish failed" << endl
+		<< "for the " << source_name () << " source." << endl
+		<< Kakadu_error_message (kdu_exception_value);
+	throw JP2_Exception (message.str (), ID);
+	}
+
+//	Dispose of the entire preview.
+Data_Disposition_Guard
+	disposition_guard (*this);
+Rendering_Monitor::Status
+	status = Rendering_Monitor::LOW_QUALITY_DATA;
+bool
+	continue_rendering =
+		data_disposition
+			(status, Rendering_Monitor::Status_Message[status],
+			rendered_region (), image_region ());
+if (! finish_data_disposition () ||
+	rendering_canceled ())
+	continue_rendering = false;
+#if ((DEBUG) & (DEBUG_RENDER | DEBUG_LOCATION))
+clog << "<<< JP2_File_Reader::render_preview: "
+		<< boolalpha << continue_rendering << endl;
+#endif
+return continue_rendering;
+}
+
+
+void
+JP2_File_Reader::stretch_histograms
+	(
+	std::vector<std::vector<unsigned long long> >&	histograms
+	)
+{
+#if ((DEBUG) & (DEBUG_RENDER | DEBUG_LOCATION))
+clog << ">>> JP2_File_Reader::stretch_histograms" << endl;
+#endif
+unsigned int
+	total_bands = image_bands (),
+	entries = 1 << rendered_pixel_bits (),
+	mask = entries - 1,
+	band;
+int
+	pixel_bits	= rendered_pixel_bits (),
+	pixel_bytes	= decoded_pixel_bytes (),
+	bands		= rendered_bands (),
+	discard		= resolution_level () - 1,
+	max_discard	= resolution_levels () - 1;
+
+//	Select the lowest resolution with no more than the sample pixels.
+KDU_dims
+	image_dimensions (image_region ()),
+	region;
+kdu_coords
+	subsampling;
+JPEG2000_Codestream.get_subsampling
+	(Channel_Mapping.source_components[0], subsampling, true);
+region = Decompressor.find_render_dims (image_dimensions,
+	subsampling, Expand_Numerator, Expand_Denominator);
+while (discard < max_discard &&
+		region.area () > (kdu_long)STRETCH_SAMPLE_PIXELS)
+	{
+	++discard;
+	subsampling.x <<= 1;
+	subsampling.y <<= 1;
+	region = Decompressor.find_render_dims (image_dimensions,
+		subsampling, Expand_Numerator, Expand_Denominator);
+	}
+#if ((DEBUG) & DEBUG_RENDER)
+clog << "    discard levels " << discard
+		<< ", sample region " << region << endl;
+#endif
+if (region.is_empty ())
+	{
+	#if ((DEBUG) & (DEBUG_RENDER | DEBUG_LOCATION))
+	clog << "<<< JP2_File_Reader::stretch_histograms: empty" << endl;
+	#endif
+	return;
+	}
+
+//	Sample buffers.
+int
+	buffer_pixels = (int)region.area ();
+std::vector<unsigned char>
+	buffer ((size_t)buffer_pixels * pixel_bytes * bands);
+std::vector<void*>
+	data (total_bands, (void*)NULL);
+unsigned char
+	*plane = &buffer[0];
+histograms.assign (total_bands, std::vector<unsigned long long> ());
+for (band = 0;
+	 band < total_bands;
+	 band++)
+	{
+	if (Rendered_Bands[band])
+		{
+		data[band] = plane;
+		plane += (size_t)buffer_pixels * pixel_bytes;
+		histograms[band].assign (entries, 0);
+		}
+	}
+
+kdu_region_decompressor
+	decompressor;
+kdu_exception
+	kdu_exception_value;
+KDU_dims
+	region_slice (region),
+	region_rendered;
+bool
+	continue_decompressing = true;
+try
+	{
+	decompressor.start
+		(
+		JPEG2000_Codestream,
+		&Channel_Mapping,
+		-1,
+		discard,
+		max_quality_layers (),
+		region_slice,
+		Expand_Numerator,
+		Expand_Denominator,
+		false,
+		KDU_WANT_OUTPUT_COMPONENTS,
+		true,
+		Thread_Group,
+		Master_Queue
+		);
+	while (continue_decompressing)
+		{
+		continue_decompressing =
+			decompress_increment (this, decompressor,
+				&data[0], pixel_bytes, pixel_bits,
+				1, kdu_coords (), 0, region.size.y,
+				region_slice, region_rendered, buffer_pixels);
+		if (continue_decompressing &&
+			region_slice.is_empty ())
+			continue_decompressing = false;
+
+		//	Accumulate the histograms of the increment.
+		size_t
+			samples = (size_t)region_rendered.area ();
+		for (band = 0;
+			 band < total_bands;
+			 band++)
+			{
+			if (! data[band])
+				continue;
+			unsigned long long
+				*histogram = &histograms[band][0];
+			if (pixel_bytes == 1)
+				{
+				const unsigned char
+					*sample = (const unsigned char*)data[band];
+				for (size_t
+						index = 0;
+						index < samples;
+						index++)
+					++histogram[sample[index] & mask];
+				}
+			else
+				{
+				const unsigned short
+					*sample = (const unsigned short*)data[band];
+				for (size_t
+						index = 0;
+						index < samples;
+						index++)
+					++histogram[sample[index] & mask];
+				}
+			}
+		}
+	}
+catch (kdu_exception except)
+	{
+	abandon_decompression (Thread_Group, &decompressor);
+	ostringstream
+		message;
+	message
+		<< "Couldn't obtain the stretch histograms of region "
+			<< image_region () << endl
+		<< "at resolution level " << (discard + 1) << '.' << endl
+		<< "JPEG2000 codestream decompression failed" << endl
+		<< "for the " << source_name () << " source." << endl
+		<< Kakadu_error_message (except);
+	throw JP2_Exception (message.str (), ID);
+	}
+
+if (Thread_Group)
+	Thread_Group->cs_terminate (JPEG2000_Codestream, &kdu_exception_value);
+if (! decompressor.finish (&kdu_exception_value, false))
+	{
+	close ();
+	ostringstream
+		message;
+	message
+		<< "Couldn't obtain the stretch histograms of region "
+			<< image_region () << endl
+		<< "at resolution level " << (discard + 1) << '.' << endl
+		<< "JPEG2000 codestream decompression finish failed" << endl
+		<< "for the " << source_name () << " source." << endl
+		<< Kakadu_error_message (kdu_exception_value);
+	throw JP2_Exception (message.str (), ID);
+	}
+#if ((DEBUG) & (DEBUG_RENDER | DEBUG_LOCATION))
+clog << "<<< JP2_File_Reader::stretch_histograms" << endl;
+#endif
+}
+
+
+/*==============================================================================
+	Region requests rendering
+*/
+#ifndef DOXYGEN_PROCESSING
+namespace
+{
+//	Rendering engine for a Region_Request.
+struct Region_Rendering
+{
+JP2_Reader::Region_Request
+	*Request;
+//	Index of the request in the batch.
+unsigned int
+	Index;
+//	Effective resolution level.
+unsigned int
+	Resolution;
+//	Codestream order sort key: tile row, tile column, line, pixel.
+unsigned long long
+	Tile_Row,
+	Tile_Column;
+//	The last tile row and column covered by the region.
+unsigned long long
+	Last_Tile_Row,
+	Last_Tile_Column;
+//	Effective region on the full resolution grid.
+KDU_dims
+	Region;
+//	Region to render on the rendering grid.
+KDU_dims
+	Rendered;
+//	Part of the region yet to be decompressed.
+KDU_dims
+	Slice;
+//	Part of the region decompressed by the last increment.
+KDU_dims
+	Increment;
+//	Pixel data buffer for each image band; NULL if not rendered.
+std::vector<void*>
+	Image_Data;
+unsigned int
+	Bands,
+	Pixel_Stride,
+	Line_Stride;
+kdu_region_decompressor
+	Decompressor;
+bool
+	Started;
+
+Region_Rendering ()
+	:	Request (NULL),
+		Index (0),
+		Resolution (0),
+		Tile_Row (0),
+		Tile_Column (0),
+		Last_Tile_Row (0),
+		Last_Tile_Column (0),
+		Bands (0),
+		Pixel_Stride (0),
+		Line_Stride (0),
+		Started (false)
+	{}
+};
+
+
+bool
+codestream_order
+	(
+	const Region_Rendering*	rendering_1,
+	const Region_Rendering*	rendering_2
+	)
+{
+if (rendering_1->Resolution != rendering_2->Resolution)
+	return rendering_1->Resolution < rendering_2->Resolution;
+if (rendering_1->Tile_Row != rendering_2->Tile_Row)
+	return rendering_1->Tile_Row < rendering_2->Tile_Row;
+if (rendering_1->Tile_Column != rendering_2->Tile_Column)
+	return rendering_1->Tile_Column < rendering_2->Tile_Column;
+if (rendering_1->Region.pos.y != rendering_2->Region.pos.y)
+	return rendering_1->Region.pos.y < rendering_2->Region.pos.y;
+return rendering_1->Region.pos.x < rendering_2->Region.pos.x;
+}
+
+
+//	Test if two region renderings use any of the same tiles.
+bool
+shares_tiles
+	(
+	const Region_Rendering*	rendering_1,
+	const Region_Rendering*	rendering_2
+	)
+{
+return
+	rendering_1->Tile_Row    <= rendering_2->Last_Tile_Row &&
+	rendering_2->Tile_Row    <= rendering_1->Last_Tile_Row &&
+	rendering_1->Tile_Column <= rendering_2->Last_Tile_Column &&
+	rendering_2->Tile_Column <= rendering_1->Last_Tile_Column;
+}
+
+}	//	local namespace
+#endif
+
+
+unsigned int
+JP2_File_Reader::render
+	(
+	std::vector<Region_Request>&	requests
+	)
+{
+#if ((DEBUG) & (DEBUG_RENDER | DEBUG_LOCATION))
+clog << ">>> JP2_File_Reader::render: " << requests.size ()
+		<< " region requests" << endl;
+#endif
+if (JP2_Stream.exists () &&
+	JP2_Stream.uses_cache ())
+	{
+	//	A cached source must acquire the data for each request in turn.
+	#if ((DEBUG) & (DEBUG_RENDER | DEBUG_LOCATION))
+	clog << "    Using the JP2_Reader implementation for a cached source."
+			<< endl;
+	#endif
+	return JP2_Reader::render (requests);
+	}
+if (stretching ())
+	{
+	//	Stretched rendering is done by the line rendering engine.
+	#if ((DEBUG) & (DEBUG_RENDER | DEBUG_LOCATION))
+	clog << "    Using the JP2_Reader implementation for stretching."
+			<< endl;
+	#endif
+	return JP2_Reader::render (requests);
+	}
+if (! is_open ())
+	{
+	ostringstream
+		message;
+	message
+		<< "Couldn't render " << requests.size () << " region requests" << endl
+		<< "because no source has been opened.";
+	throw JP2_Logic_Error (message.str (), ID);
+	}
+//	Obtain any processing threads that were not available.
+deploy_processing_threads ();
+Bytes_Rendered = 0;
+//	Collects the rendering statistics however rendering ends.
+Render_Statistics_Guard
+	statistics_guard (*this, Thread_Group ? Thread_Group->get_num_threads () : 1);
+
+unsigned int
+	total_bands = image_bands (),
+	levels = resolution_levels (),
+	index;
+int
+	pixel_bits			= rendered_pixel_bits (),
+	pixel_bytes			= rendered_pixel_bytes (),
+	line_increment,
+	//	The user's rendering increment, if one was specified.
+	user_increment		=
+		(rendering_increment_lines () || adaptive_rendering_increment ()) ?
+		effective_rendering_increment_lines () : 0;
+Size_2D
+	tile_dimensions (tile_size ());
+if (! tile_dimensions.Width ||
+	! tile_dimensions.Height)
+	tile_dimensions = image_size ();
+Point_2D
+	tile_origin (image_offsets ().X - tile_offsets ().X,
+				 image_offsets ().Y - tile_offsets ().Y);
+KDU_dims
+	image_dimensions (image_size ()),
+	selection;
+
+//	Request preparation --------------------------------------------------------
+
+std::vector<Region_Rendering>
+	renderings (requests.size ());
+std::vector<Region_Rendering*>
+	order;
+try
+{
+for (index = 0;
+	 index < requests.size ();
+	 index++)
+	{
+	Region_Request&
+		request = requests[index];
+	Region_Rendering&
+		rendering = renderings[index];
+	rendering.Request = &request;
+	rendering.Index = index;
+	request.Rendered_Region =
+	request.Image_Region = Cube ();
+	if (! request.Image_Data)
+		{
+		ostringstream
+			message;
+		message
+			<< "Region request " << index << " for image region "
+				<< request.Region << endl
+			<< "does not provide any pixel data buffers" << endl
+			<< "for the " << source_name () << " source.";
+		throw JP2_Invalid_Argument (message.str (), ID);
+		}
+
+	//	Image bands.
+	rendering.Image_Data.assign (total_bands, NULL);
+	for (unsigned int
+			band = 0;
+			band < total_bands;
+			band++)
+		{
+		if (request.Image_Data[band] &&
+			(request.Bands.empty () ||
+			(band < request.Bands.size () &&
+			 request.Bands[band])))
+			{
+			rendering.Image_Data[band] = request.Image_Data[band];
+			++rendering.Bands;
+			}
+		}
+	if (! rendering.Bands)
+		continue;
+
+	//	Resolution level.
+	rendering.Resolution = request.Resolution_Level;
+	if (rendering.Resolution < 1)
+		rendering.Resolution = 1;
+	else
+	if (rendering.Resolution > levels)
+		rendering.Resolution = levels;
+
+	//	Effective image region and rendered region.
+	selection = request.Region;
+	if (selection.is_empty ())
+		selection = image_dimensions;
+	else
+		selection &= image_dimensions;
+	if (selection.is_empty ())
+		continue;
+	rendering.Region = selection;
+	JPEG2000_Codestream.apply_input_restrictions
+		(0, 0, rendering.Resolution - 1, 0, &selection,
+		KDU_WANT_OUTPUT_COMPONENTS, Thread_Group);
+	JPEG2000_Codestream.get_dims (0, selection, true);
+	rendering.Rendered = selection;
+	if (rendering.Rendered.is_empty ())
+		continue;
+
+	//	Pixel data structure.
+	unsigned int
+		width = rendering.Rendered.size.x,
+		height = rendering.Rendered.size.y;
+	rendering.Pixel_Stride = request.Pixel_Stride;
+	rendering.Line_Stride  = request.Line_Stride;
+	if (! rendering.Pixel_Stride)
+		rendering.Pixel_Stride =
+			(Data_Format == FORMAT_BIP) ? rendering.Bands : 1;
+	if (! rendering.Line_Stride)
+		rendering.Line_Stride =
+			(Data_Format == FORMAT_BIP ||
+			 Data_Format == FORMAT_BIL) ? width * rendering.Bands : width;
+	unsigned long long
+		buffer_size =
+			((unsigned long long)(height - 1) * rendering.Line_Stride
+			+ (unsigned long long)(width - 1) * rendering.Pixel_Stride + 1)
+			* pixel_bytes;
+	if (request.Buffer_Size &&
+		request.Buffer_Size < buffer_size)
+		{
+		ostringstream
+			message;
+		message
+			<< "Region request " << index << " for image region "
+				<< request.Region << endl
+			<< "provides " << magnitude (request.Buffer_Size)
+				<< " (" << request.Buffer_Size << ") byte pixel data buffers,"
+				<< endl
+			<< "but " << magnitude (buffer_size)
+				<< " (" << buffer_size << ") bytes are required" << endl
+			<< "for the " << source_name () << " source.";
+		throw JP2_Invalid_Argument (message.str (), ID);
+		}
+
+	//	Codestream order.
+	rendering.Tile_Row =
+		(rendering.Region.pos.y + tile_origin.Y) / tile_dimensions.Height;
+	rendering.Tile_Column =
+		(rendering.Region.pos.x + tile_origin.X) / tile_dimensions.Width;
+	rendering.Last_Tile_Row =
+		(rendering.Region.pos.y + rendering.Region.size.y - 1 + tile_origin.Y)
+		/ tile_dimensions.Height;
+	rendering.Last_Tile_Column =
+		(rendering.Region.pos.x + rendering.Region.size.x - 1 + tile_origin.X)
+		/ tile_dimensions.Width;
+	order.push_back (&rendering);
+	}
+}
+catch (kdu_exception except)
+	{
+	//	Restore the reader's input restrictions.
+	unsigned int
+		resolution = Resolution_Level;
+	Resolution_Level = 0;
+	resolution_and_region (resolution, Image_Region);
+	ostringstream
+		message;
+	message
+		<< "Couldn't render region request " << index << " for image region "
+			<< requests[index].Region << endl
+		<< "at resolution level " << requests[index].Resolution_Level
+			<< " for the " << source_name () << " source." << endl
+		<< Kakadu_error_message (except);
+	throw JP2_Exception (message.str (), ID);
+	}
+catch (...)
+	{
+	unsigned int
+		resolution = Resolution_Level;
+	Resolution_Level = 0;
+	resolution_and_region (resolution, Image_Region);
+	throw;
+	}
+
+//	Requests in codestream order.
+std::stable_sort (order.begin (), order.end (), codestream_order);
+
+//	Decompression --------------------------------------------------------------
+
+/*	Concurrent decompression.
+
+	Region decompressors for up to the number of processing threads
+	are started together. Each pass drives one increment of every
+	started decompressor, so the Thread_Group works on all of them at
+	the same time. As each request is completed the decompressor for
+	the next request is started. Requests are grouped by resolution
+	level because the codestream input restrictions apply to all of
+	the decompressors.
+
+	A codestream tile can not be opened by more than one decompressor
+	at a time, so a request is only started while other requests are
+	being decompressed if none of them use any of its tiles; otherwise
+	it waits until they are done. When expansion factors are in effect
+	a decompressor may use tiles adjacent to its region, so the
+	requests are decompressed one at a time.
+*/
+unsigned int
+	concurrent =
+		(Thread_Group &&
+		 Expand_Numerator.x == Expand_Denominator.x &&
+		 Expand_Numerator.y == Expand_Denominator.y) ?
+		Deployed_Threads : 1,
+	resolution = 0,
+	next = 0,
+	rendered = 0;
+std::vector<Region_Rendering*>
+	active;
+Rendering_Monitor
+	*monitor = rendering_monitor ();
+Rendering_Monitor::Status
+	status = Rendering_Monitor::DONE;
+bool
+	continue_rendering = true;	//	False if rendering canceled.
+kdu_exception
+	kdu_exception_value;
+Region_Rendering
+	*rendering = NULL;
+try
+{
+while (continue_rendering &&
+		(next < order.size () ||
+		 ! active.empty ()))
+	{
+	if (rendering_canceled ())
+		{
+		continue_rendering = false;
+		status = Rendering_Monitor::CANCELED;
+		break;
+		}
+
+	//	Start more decompressors.
+	while (active.size () < concurrent &&
+		   next < order.size ())
+		{
+		rendering = order[next];
+		if (rendering->Resolution != resolution)
+			{
+			if (! active.empty ())
+				//	Finish the current resolution level group first.
+				break;
+			resolution = rendering->Resolution;
+			JPEG2000_Codestream.apply_input_restrictions
+				(0, 0, resolution - 1, 0, NULL,
+				KDU_WANT_OUTPUT_COMPONENTS, Thread_Group);
+			}
+		else
+			{
+			//	Wait for the active requests using any of the same tiles.
+			unsigned int
+				active_index = 0;
+			while (active_index < active.size () &&
+					! shares_tiles (rendering, active[active_index]))
+				++active_index;
+			if (active_index < active.size ())
+				break;
+			}
+		#if ((DEBUG) & DEBUG_RENDER)
+		clog << "==> Starting the Decompressor for request "
+				<< rendering->Index << " region " << rendering->Rendered
+				<< " at resolution level " << resolution << endl;
+		#endif
+		rendering->Slice = rendering->Rendered;
+		rendering->Decompressor.start
+			(
+			JPEG2000_Codestream,
+			&Channel_Mapping,
+			-1,
+			resolution - 1,
+			max_quality_layers (),
+			rendering->Slice,
+			Expand_Numerator,
+			Expand_Denominator,
+			true,
+			KDU_WANT_OUTPUT_COMPONENTS,
+			false,
+			Thread_Group,
+			Master_Queue
+			);
+		rendering->Started = true;
+		active.push_back (rendering);
+		++next;
+		}
+
+	//	Decompress an increment of each active region.
+	for (index = 0;
+		 continue_rendering &&
+		 index < active.size ();)
+		{
+		rendering = active[index];
+		if (user_increment)
+			line_increment = user_increment;
+		else
+			//	Default increment for the region width.
+			line_increment =
+				DEFAULT_RENDERING_INCREMENT_BYTES
+				/ rendering->Bands / pixel_bytes / rendering->Slice.size.x;
+		if (! line_increment)
+			line_increment = 1;
+		bool
+			decompressing =
+				decompress_increment (this, rendering->Decompressor,
+					&rendering->Image_Data[0], pixel_bytes, pixel_bits,
+					rendering->Pixel_Stride, rendering->Rendered.pos,
+					rendering->Line_Stride, line_increment,
+					rendering->Slice, rendering->Increment);
+		Bytes_Rendered +=
+			rendering->Increment.area () * rendering->Bands * pixel_bytes;
+		increment_statistics ();
+		if (decompressing &&
+			! rendering->Slice.is_empty ())
+			{
+			++index;
+			continue;
+			}
+
+		//	Region request completed.
+		active.erase (active.begin () + index);
+		rendering->Started = false;
+		if (! rendering->Decompressor.finish (&kdu_exception_value, false))
+			throw kdu_exception_value;
+
+		Region_Request
+			*request = rendering->Request;
+		if (float_samples ())
+			{
+			for (unsigned int
+					band = 0;
+					band < total_bands;
+					band++)
+				if (rendering->Image_Data[band])
+					calibrate_samples (band, rendering->Image_Data[band],
+						rendering->Rendered.size.x, rendering->Rendered.size.y,
+						rendering->Pixel_Stride, rendering->Line_Stride);
+			}
+		else
+		if (Swap_Pixel_Bytes &&
+			pixel_bytes > 1)
+			for (unsigned int
+					band = 0;
+					band < total_bands;
+					band++)
+				if (rendering->Image_Data[band])
+					swap_sample_bytes (rendering->Image_Data[band],
+						rendering->Rendered.size.x, rendering->Rendered.size.y,
+						rendering->Pixel_Stride, rendering->Line_Stride);
+		request->Rendered_Region =
+			static_cast<const Rectangle&>(rendering->Rendered);
+		request->Rendered_Region.Depth = rendering->Bands;
+		request->Image_Region =
+			static_cast<const Rectangle&>(rendering->Region);
+		request->Image_Region.Depth = rendering->Bands;
+		++rendered;
+		#if ((DEBUG) & (DEBUG_RENDER | DEBUG_NOTIFY))
+		clog << "<== Request " << rendering->Index << " rendered: "
+				<< request->Rendered_Region << endl;
+		#endif
+		if (monitor &&
+			! monitor->notify (*this, Rendering_Monitor::TOP_QUALITY_DATA,
+				Rendering_Monitor::Status_Message
+					[Rendering_Monitor::TOP_QUALITY_DATA],
+				request->Rendered_Region, request->Image_Region))
+			{
+			continue_rendering = false;
+			if (rendered < order.size ())
+				status = Rendering_Monitor::CANCELED;
+			}
+		}
+	}
+
+//	Stop any decompressors of canceled requests.
+for (index = 0;
+	 index < active.size ();
+	 index++)
+	{
+	rendering = active[index];
+	rendering->Started = false;
+	if (! rendering->Decompressor.finish (&kdu_exception_value, false))
+		throw kdu_exception_value;
+	}
+}
+catch (kdu_exception except)
+	{
+	#if ((DEBUG) & DEBUG_RENDER)
+	clog << "<-- Region request decompression exception!" << endl;
+	#endif
+	if (Thread_Group)
+		Thread_Group->handle_exception (READER_ERROR);
+	for (index = 0;
+		 index < active.size ();
+		 index++)
+		if (active[index]->Started)
+			active[index]->Decompressor.finish (NULL, false);
+	abandon_decompression (Thread_Group);
+	ostringstream
+		message;
+	message
+		<< "Couldn't render " << requests.size () << " region requests"
+			<< endl;
+	if (rendering)
+		message
+			<< "- region request " << rendering->Index
+				<< " for image region " << rendering->Request->Region
+				<< " at resolution level " << rendering->Resolution
+				<< " failed -" << endl;
+	message
+		<< "after rendering " << rendered << " requests with "
+			<< magnitude (Bytes_Rendered)
+			<< " (" << Bytes_Rendered << ") image data bytes" << endl
+		<< "for the " << source_name () << " source." << endl
+		<< Kakadu_error_message (except);
+	throw JP2_Exception (message.str (), ID);
+	}
+
+//	Restore the reader's input restrictions.
+resolution = Resolution_Level;
+Resolution_Level = 0;
+resolution_and_region (resolution, Image_Region);
+
+#if ((DEBUG) & (DEBUG_RENDER | DEBUG_NOTIFY | DEBUG_LOCATION))
+clog << "    JP2_File_Reader::render: notify status "
+		<< status << " \""
+		<< Rendering_Monitor::Status_Message[status] << '"' << endl;
+#endif
+if (monitor)
+	monitor->notify (*this,
+		status, Rendering_Monitor::Status_Message[status]);
+#if ((DEBUG) & (DEBUG_RENDER | DEBUG_LOCATION))
+clog << "<<< JP2_File_Reader::render: " << rendered << " rendered" << endl;
+#endif
+return rendered;
+}
+
+
+/*==============================================================================
+	Rendering interruption
+*/
+void
+JP2_File_Reader::interrupt_rendering ()
+{
+if (Interruptible &&
+	Thread_Group)
+	{
+	#if ((DEBUG) & (DEBUG_RENDER | DEBUG_LOCATION))
+	clog << ">-< JP2_File_Reader::interrupt_rendering" << endl;
+	#endif
+	Interruptible = false;
+	Interrupted = true;
+	Thread_Group->handle_exception (READER_ERROR);
+	}
+}
+
+
+bool
+JP2_File_Reader::interruptible
+	(
+	bool			enable,
+	kdu_thread_env*	thread_env
+	)
+{
+std::lock_guard<std::mutex>
+	lock (Rendering_Lock);
+bool
+	interrupted = Interrupted;
+/*	Without a processing thread environment there is no Thread_Group
+	to be put into its exception state; the rendering is only canceled
+	between increments.
+*/
+Interruptible = enable && thread_env && Thread_Group;
+Interrupted = false;
+if (Interruptible &&
+	rendering_canceled ())
+	{
+	//	Canceled before the interruptible section.
+	Interruptible = false;
+	Interrupted = true;
+	Thread_Group->handle_exception (READER_ERROR);
+	}
+return interrupted && ! enable;
+}
+
+
+void
+JP2_File_Reader::recover_from_interruption ()
+{
+#if ((DEBUG) & (DEBUG_RENDER | DEBUG_LOCATION))
+clog << ">>> JP2_File_Reader::recover_from_interruption" << endl;
+#endif
+//	The disposition thread must not be using the codestream while it is reset.
+stop_data_disposition ();
+if (Thread_Group)
+	//	Clears the exception state.
+	Thread_Group->terminate (NULL, true);
+
+/*	The codestream may not be used after a decompression exception.
+	It is recreated on the JP2 source, which remains open.
+*/
+try
+	{
+	if (JPEG2000_Codestream.exists ())
+		{
+		if (Thread_Group)
+			Thread_Group->cs_terminate (JPEG2000_Codestream);
+		JPEG2000_Codestream.destroy ();
+		}
+	JP2_Source.seek (0);
+	JPEG2000_Codestream.create (&JP2_Source, Thread_Group);
+	JPEG2000_Codestream.set_persistent ();
+	}
+catch (kdu_exception except)
+	{
+	//	The reader can not be used without its codestream.
+	string
+		report (Kakadu_error_message (except));
+	close ();
+	ostringstream
+		message;
+	message
+		<< "Couldn't reset the codestream after the rendering was interrupted"
+			<< endl
+		<< "for the " << source_name () << " source;" << endl
+		<< "the reader has been closed." << endl
+		<< report;
+	throw JP2_IO_Failure (message.str (), ID);
+	}
+
+//	Force the resolution and region to be restored.
+unsigned int
+	resolution = Resolution_Level;
+Resolution_Level = 0;
+resolution_and_region (resolution, Image_Region);
+#if ((DEBUG) & (DEBUG_RENDER | DEBUG_LOCATION))
+clog << "<<< JP2_File_Reader::recover_from_interruption" << endl;
+#endif
+}
+
+
 std::string
 JP2_File_Reader::Kakadu_error_message
 	(
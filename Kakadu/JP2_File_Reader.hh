@@ -209,9 +209,22 @@ explicit JP2_File_Reader (const std::string& source);
 
 /**	Construct a copy of a JP2_File_Reader.
 
+	The copy is opened on the same source as the JP2_file_reader.
+
+	Normally the source metadata is ingested anew. However, if the
+	metadata is shared and the JP2_file_reader is open with {@link
+	is_complete() complete} metadata, the metadata is shared with the
+	JP2_file_reader and the source metadata is not ingested again; only
+	the source stream and codestream management are opened for the
+	copy.
+
 	@param	JP2_file_reader	The JP2_File_Reader to be copied.
+	@param	share_metadata	If true, share the metadata of the
+		JP2_file_reader when possible.
+	@see	shared_clone()
 */
-JP2_File_Reader (const JP2_File_Reader& JP2_file_reader);
+JP2_File_Reader (const JP2_File_Reader& JP2_file_reader,
+	bool share_metadata = false);
 
 virtual ~JP2_File_Reader () throw();
 
@@ -226,6 +239,18 @@ virtual ~JP2_File_Reader () throw();
 */
 virtual JP2_File_Reader* clone () const;
 
+/**	Clone this JP2_File_Reader sharing its metadata.
+
+	A copy of this JP2_File_Reader that {@link
+	JP2_File_Reader(const JP2_File_Reader&, bool) shares its metadata}
+	is constructed. The clone has its own source stream, codestream and
+	rendering configuration, so it may be used concurrently with this
+	JP2_File_Reader.
+
+	@return	A pointer to a copy of this JP2_File_Reader.
+*/
+virtual JP2_File_Reader* shared_clone () const;
+
 /**	Open the JP2_File_Reader on a source file.
 
 	If the reader is not already open it is opened on the source file.
@@ -286,6 +311,73 @@ virtual bool is_open () const;
 virtual bool resolution_and_region
 	(unsigned int resolution, const PIRL::Rectangle& region);
 
+/**	Set the exact size of the rendered image region.
+
+	The {@link image_region() image region} is rendered to the specified
+	width and height, which need not be a power of two reduction of the
+	region. The {@link resolution_level() resolution level} is selected
+	by the reader: it is the lowest resolution level at which the region
+	is no smaller than the specified size. The remaining rational
+	resampling is done by the region decompressor as the image data is
+	rendered, so no image data buffer larger than the rendered size is
+	used.
+
+	While the rendered size is in effect it applies to any {@link
+	image_region(const Rectangle&) image region} that is selected and
+	any resolution level that is requested is ignored.
+
+	@param	width	The width of the rendered image region. If zero
+		the rendered size is {@link clear_rendering_scale() cleared}.
+	@param	height	The height of the rendered image region. If zero
+		the rendered size is cleared.
+	@return	This JP2_File_Reader.
+	@throws	JP2_Exception	If a kdu_exception occured.
+	@see	rendering_scale(unsigned int, unsigned int)
+*/
+JP2_File_Reader& rendered_size (unsigned int width, unsigned int height);
+
+/**	Set a rational scale of the rendered image region.
+
+	The {@link image_region() image region} is rendered with its width
+	and height scaled by numerator / denominator. The {@link
+	resolution_level() resolution level} is selected by the reader as
+	the lowest resolution level that provides the scale by a reduction
+	of no more than a factor of two; the remaining rational resampling
+	is done by the region decompressor.
+
+	While the rendering scale is in effect it applies to any {@link
+	image_region(const Rectangle&) image region} that is selected and
+	any resolution level that is requested is ignored.
+
+	@param	numerator	The scale numerator. If zero the rendering scale
+		is {@link clear_rendering_scale() cleared}.
+	@param	denominator	The scale denominator. If zero the rendering
+		scale is cleared.
+	@return	This JP2_File_Reader.
+	@throws	JP2_Exception	If a kdu_exception occured.
+	@see	rendered_size(unsigned int, unsigned int)
+*/
+JP2_File_Reader& rendering_scale
+	(unsigned int numerator, unsigned int denominator);
+
+/**	Clear any rendered size or rendering scale.
+
+	The rendered region is again determined by the {@link
+	resolution_level(unsigned int) resolution level} alone.
+
+	@return	This JP2_File_Reader.
+*/
+JP2_File_Reader& clear_rendering_scale ();
+
+/**	Test if a rendered size or rendering scale is in effect.
+
+	@return	true if a {@link rendered_size(unsigned int, unsigned int)
+		rendered size} or {@link rendering_scale(unsigned int, unsigned
+		int) rendering scale} is in effect; false otherwise.
+*/
+inline bool scaled_rendering () const
+	{return Scaled_Size.Width || Scale_Numerator;}
+
 /**	Render the image data.
 
 	The JP2 source is {@link open() opened} if this has not yet
@@ -297,6 +389,22 @@ virtual bool resolution_and_region
 	already exists the image data will be appended to the current
 	content.
 
+	When more than one {@link effective_rendering_strips() rendering
+	strip} is in effect for a local file source the image data is
+	{@link render_strips(const std::vector<kdu_core::kdu_dims>&,
+	kdu_core::kdu_thread_env*) rendered as concurrent strips}.
+
+	The processing threads for the rendering are {@link
+	select_processing_threads() selected}. When a single thread is
+	selected the image is rendered in the calling thread without the
+	processing Thread_Group, which is left intact.
+
+	When a {@link line_sink(Line_Sink*) line sink} is registered the
+	image data is {@link render_lines(kdu_core::kdu_thread_env*)
+	rendered to the line sink}
+	instead, as is an image that is {@link stretching() stretched} to
+	8-bit pixels.
+
 	@return	A Cube indicated what was rendered.
 	@throws	JP2_Logic_Error	If the reader is not ready().
 	@throws	runtime_error	If insufficient memory is available to
@@ -304,10 +412,42 @@ virtual bool resolution_and_region
 */
 virtual Cube render ();
 
+/**	Render a batch of image regions.
+
+	The requests are ordered by resolution level, then by the codestream
+	tile containing the origin of each region, so the codestream is
+	traversed coherently. Requests for the same resolution level are
+	rendered concurrently: a region decompressor is started for up to as
+	many requests as there are {@link processing_threads() processing
+	threads}, all sharing the codestream and its thread group. As each
+	request completes the next one is started. Because a codestream
+	tile can not be opened by more than one decompressor at a time, a
+	request is only started while others are in progress if none of
+	them use any of its tiles; requests that share tiles, and all
+	requests when expansion factors are in effect, are rendered one at
+	a time. Each request is rendered
+	directly into its own pixel data buffers; the reader's own rendering
+	configuration is not changed.
+
+	For a source that uses a data cache (JPIP) the {@link
+	JP2_Reader::render(std::vector<Region_Request>&) base class
+	implementation} is used.
+
+	@param	requests	A vector of Region_Requests.
+	@return	The number of requests that were completely rendered.
+	@throws	JP2_Logic_Error	If the reader is not open.
+	@throws	JP2_Invalid_Argument	If a request does not provide pixel
+		data buffers, or its buffers are too small.
+	@throws	JP2_Exception	If a kdu_exception occured. The reader is
+		closed.
+*/
+virtual unsigned int render (std::vector<Region_Request>& requests);
+
 /**	Close access to the JP2 source.
 
 	The JP2 source stream is closed and the rendering machinery resources
-	associated with it are released. <b>N.B.</b>: The JP2 metadata
+	associated with it, including the {@link release_processing_threads()
+	processing threads}, are released. <b>N.B.</b>: The JP2 metadata
 	describing the source and the reader's rendering configuration
 	remain unchanged, so the source may be {@link open(const std::string&)
 	opened} again for rendering using the previously set configuration.
@@ -317,6 +457,18 @@ virtual Cube render ();
 */
 virtual void close (bool force = false);
 
+/**	Reset the rendering configuration to its default.
+
+	The base {@link JP2_Reader::reset_rendering() rendering
+	configuration} and any rendering scale are reset. If the source is
+	open the default rendering configuration for the source is {@link
+	initialize() initialized} and the codestream is restored to the
+	entire image at full resolution. The source and the {@link
+	deployed_processing_threads() deployed processing threads} are
+	kept.
+*/
+virtual void reset_rendering ();
+
 /**	Reset the reader to it's initial, default, state.
 
 	The reader is {@link close(bool) closed}, any {@link
@@ -343,6 +495,82 @@ virtual void reset ();
 */
 std::string Kakadu_error_message (const kdu_core::kdu_exception& except);
 
+/*------------------------------------------------------------------------------
+	Process-wide processing threads
+*/
+/**	Set the process-wide processing threads limit.
+
+	Each JP2_File_Reader {@link deploy_processing_threads() deploys} its
+	own Thread_Group of {@link JP2_Reader::processing_threads()
+	processing threads}. With many concurrent readers the total number
+	of threads can greatly oversubscribe the available processing units.
+
+	When a limit is set the worker threads of all readers are drawn from
+	a process-wide pool of that many threads. A reader deploying its
+	processing threads obtains as many of its desired worker threads as
+	are available, and returns them when it is {@link close(bool)
+	closed} or its {@link release_processing_threads() processing
+	threads are released}. A reader that can obtain no worker threads
+	renders in its owner thread alone. The reader's processing threads
+	setting is not changed: the worker threads it could not obtain are
+	sought again each time it renders, and the threads it obtained are
+	its {@link deployed_processing_threads() deployed processing
+	threads}.
+
+	The owner thread of each reader is the application thread that
+	renders with the reader, so it is not counted against the limit.
+	When many readers are to be used concurrently the processing
+	threads of each should be set to a modest share of the limit.
+
+	Readers that have already deployed their processing threads keep
+	them when the limit is changed.
+
+	@param	threads	The maximum number of worker threads for all
+		readers in the process. If zero, the default, there is no
+		limit.
+*/
+static void processing_threads_limit (unsigned int threads);
+
+/**	Get the process-wide processing threads limit.
+
+	@return	The maximum number of worker threads for all readers in the
+		process. This will be zero if there is no limit.
+	@see	processing_threads_limit(unsigned int)
+*/
+static unsigned int processing_threads_limit ();
+
+/**	Get the number of process-wide worker threads in use.
+
+	@return	The number of worker threads obtained by readers from the
+		{@link processing_threads_limit(unsigned int) process-wide limit}.
+*/
+static unsigned int processing_threads_in_use ();
+
+/**	Get the number of deployed processing threads.
+
+	@return	The number of processing threads, including the rendering
+		thread, that this reader has deployed. This will be zero if no
+		processing threads are deployed, and may be less than the
+		{@link JP2_Reader::processing_threads() processing threads}
+		when a {@link processing_threads_limit(unsigned int)
+		process-wide limit} is in effect.
+*/
+inline unsigned int deployed_processing_threads () const
+	{return Deployed_Threads;}
+
+/**	Release the deployed processing threads.
+
+	The reader's Thread_Group is destroyed and any worker threads
+	obtained from the {@link processing_threads_limit(unsigned int)
+	process-wide limit} are returned. The threads are {@link
+	deploy_processing_threads() deployed} again when the reader next
+	renders. This is done when the reader is {@link close(bool) closed}.
+
+	<b>N.B.</b>: Processing threads must not be released while the
+	reader is rendering.
+*/
+virtual void release_processing_threads ();
+
 
 protected:
 
@@ -580,17 +808,376 @@ void ingest_codestream_segments (JP2_Box& codestream_box);
 
 /**	Deploy JP2 codestream processing threads.
 
-	If the Thread_Group for this reader has already been created or the
-	number of {@link JP2_Reader::processing_threads() processing threads}
-	to be used is less than two, nothing is done.
-
-	A new Thread_Group is created and threads are added to it until the
-	desired number of processing threads are present or the system
-	refuses to provide more threads (in which case the number of reported
-	processing threads is reduced accordingly).
+	If the number of {@link JP2_Reader::processing_threads() processing
+	threads} to be used is less than two, or they have all been
+	deployed, nothing is done.
+
+	If the Thread_Group for this reader has not been created it is
+	created. Worker threads are then added to it until the desired
+	number of processing threads are present or the system refuses to
+	provide more threads. When a {@link processing_threads_limit(unsigned
+	int) process-wide limit} is in effect the worker threads are
+	obtained from it. The worker threads are placed on the {@link
+	processing_CPUs() processing CPUs}, if any.
+
+	This is done when the reader is opened and again before each
+	rendering, so threads that were not available when the reader was
+	opened are obtained when they become available. The requested
+	processing threads are not changed; the number of threads actually
+	deployed is the {@link deployed_processing_threads() deployed
+	processing threads}.
 */
 virtual void deploy_processing_threads ();
 
+/**	Get the rendering strip slices of the rendered region.
+
+	The {@link rendered_region() rendered region} is divided along the
+	boundaries of the codestream tile rows that it covers into no more
+	than the specified number of slices. Each slice holds a contiguous
+	group of whole tile rows, so no tile is used by more than one slice;
+	a codestream tile can not be opened by more than one decompressor at
+	a time.
+
+	@param	strips	The maximum number of slices.
+	@return	A vector of slices on the rendering grid, from the top of the
+		rendered region down. This will be empty if the rendered region
+		can not be divided into at least two slices: it lies within a
+		single tile row, or expansion factors are in effect.
+*/
+std::vector<kdu_core::kdu_dims> strip_slices (unsigned int strips);
+
+/**	Render the image data as concurrently decompressed horizontal strips.
+
+	Each {@link strip_slices(unsigned int) strip slice} is given its own
+	kdu_region_decompressor that is started on the shared, persistent,
+	JPEG2000_Codestream with the Thread_Group processing environment.
+	The strip decompressors are then driven in turn by the calling
+	thread, one {@link effective_rendering_increment_lines() rendering
+	increment} at a time, so the work queued for each strip is available
+	to the Thread_Group while another strip is being waited on. This
+	does not scale with the number of strips. Each decompressor writes
+	directly into its part of the image data buffers. The {@link
+	data_disposition(Rendering_Monitor::Status, const std::string&,
+	const Cube&, const Cube&) data disposition} of each increment is
+	done, in the calling thread, as soon as it has been rendered.
+
+	<b>N.B.</b>: This method is used by {@link render()} when the
+	{@link effective_rendering_strips() effective rendering strips}
+	is greater than one, the rendered region covers more than one tile
+	row, a Thread_Group is used and the source is not a data cache
+	(i.e. not a JPIP source).
+
+	@param	slices	The strip slices to be rendered.
+	@param	thread_env	The Thread_Group processing environment.
+	@return	A Cube indicating what was rendered.
+	@throws	JP2_Exception	If the decompression of any strip failed.
+*/
+Cube render_strips (const std::vector<kdu_core::kdu_dims>& slices,
+	kdu_core::kdu_thread_env* thread_env);
+
+/**	Render the image data into chunked image data buffers.
+
+	Each {@link image_data_chunk(unsigned int) image data chunk} is
+	rendered in turn: the Decompressor is started on the slice of the
+	{@link rendered_region() rendered region} held by the chunk, with the
+	chunk's image data buffers and a buffer origin at the first line of
+	the chunk, and the slice is decompressed one {@link
+	effective_rendering_increment_lines() rendering increment} at a
+	time. The {@link data_disposition(Rendering_Monitor::Status, const
+	std::string&, const Cube&, const Cube&) data disposition} of each
+	increment is done as soon as it has been rendered.
+
+	<b>N.B.</b>: This method is used by {@link render()} when the image
+	data is {@link chunked_image_data() chunked} and no line sink is
+	registered. It is not available for a source that is a data cache
+	(i.e. a JPIP source).
+
+	@param	thread_env	The processing thread environment for the
+		decompression. If NULL the decompression is done entirely in the
+		calling thread.
+	@return	A Cube indicating what was rendered.
+	@throws	JP2_Exception	If the decompression failed.
+*/
+Cube render_chunks (kdu_core::kdu_thread_env* thread_env);
+
+/**	Render the image data to the line sink.
+
+	The {@link rendered_region() rendered region} is decompressed, one
+	{@link effective_rendering_increment_lines() rendering increment} at
+	a time, into a ring of increment sized buffers. Each increment is
+	{@link data_disposition(Rendering_Monitor::Status, const
+	std::string&, const Cube&, const Cube&, void**, unsigned int)
+	disposed} from its buffer, which delivers it to the {@link
+	line_sink(Line_Sink*) line sink}. The ring has a single buffer
+	unless {@link pipelined_disposition(bool) pipelined data disposition}
+	is enabled, in which case it has {@link #LINE_SINK_BUFFERS} buffers.
+	The image data buffers are not used, except when the image is
+	{@link stretching() stretched} without a line sink: then each
+	increment is mapped through the stretch tables directly into the
+	image data buffers.
+
+	<b>N.B.</b>: This method is used by {@link render()} when a line
+	sink is registered or the image is stretched. It is not available for a source that is a data
+	cache (i.e. a JPIP source).
+
+	@param	thread_env	The processing thread environment for the
+		decompression. If NULL the decompression is done entirely in the
+		calling thread.
+	@return	A Cube indicating what was rendered.
+	@throws	JP2_Out_of_Range	If the increment buffers could not be
+		allocated.
+	@throws	JP2_Exception	If the decompression failed.
+*/
+Cube render_lines (kdu_core::kdu_thread_env* thread_env);
+
+/**	Get the maximum quality layers argument for a region decompressor.
+
+	@return	The {@link rendered_quality_layers() rendered quality layers},
+		limited to the {@link quality_layers() number of quality layers}
+		in the codestream, or INT_MAX if all layers are to be rendered.
+*/
+int max_quality_layers () const;
+
+/**	Set the resolution level and image region for scaled rendering.
+
+	The selected region is clipped to the image. The target rendered
+	size is the {@link rendered_size(unsigned int, unsigned int) rendered
+	size}, or the region size multiplied by the {@link
+	rendering_scale(unsigned int, unsigned int) rendering scale}. The
+	highest discard level at which the region is no smaller than the
+	target size is applied as an input restriction, and the expansion
+	factors are set to resample the region at that level to the target
+	size.
+
+	@param	selected_region	The selected image area to be rendered
+		relative to the full resolution image. If empty the entire image
+		is selected.
+	@return	true if there was any change to the resolution, region or
+		expansion factors; false otherwise.
+	@throws	kdu_exception	If the codestream rejected the restrictions.
+*/
+bool scaled_resolution_and_region (const PIRL::Rectangle& selected_region);
+
+/**	Render the image data using the tile cache.
+
+	The rendered region is covered by the cells of the {@link
+	tile_cache(JP2_Tile_Cache*) tile cache} grid. Each row of cells is
+	rendered in turn: the tiles of each cell for each rendered band are
+	obtained from the cache, or the cell is decoded and its tiles are
+	inserted into the cache, and the part of the cell in the rendered
+	region is copied into the image data buffers. Each row of cells is
+	then {@link data_disposition(Rendering_Monitor::Status, const
+	std::string&, const Cube&, const Cube&, void**, unsigned int)
+	disposed of}.
+
+	<b>N.B.</b>: This method is used by {@link render()} when a tile
+	cache is registered for a local file source.
+
+	@param	thread_env	The processing thread environment for the
+		decompression. If NULL the decompression is done entirely in the
+		calling thread.
+	@return	A Cube indicating what was rendered.
+	@throws	JP2_Exception	If the decompression failed.
+*/
+Cube render_cells (kdu_core::kdu_thread_env* thread_env);
+
+/**	Render the image data with the selected processing threads.
+
+	This is the implementation of {@link render()}, which selects the
+	processing threads for the rendering.
+
+	@param	thread_env	The processing thread environment for the
+		rendering: the Thread_Group, or NULL if the rendering is to be
+		done entirely in the calling thread. The Thread_Group itself is
+		not changed.
+	@return	A Cube indicating what was rendered.
+*/
+Cube render_image (kdu_core::kdu_thread_env* thread_env);
+
+/**	Start a region decompressor for the rendering.
+
+	The decompressor is started on the JPEG2000_Codestream with the
+	Channel_Mapping, {@link resolution_level() resolution level}, {@link
+	max_quality_layers() quality layers} and expansion factors of the
+	rendering.
+
+	@param	decompressor	The kdu_region_decompressor to be started.
+	@param	region	The region on the rendering grid to be decompressed.
+	@param	thread_env	The processing thread environment for the
+		decompression. If NULL the decompression is done entirely in the
+		calling thread.
+	@throws	kdu_exception	If the decompressor could not be started.
+*/
+void start_decompressor (kdu_supp::kdu_region_decompressor& decompressor,
+	const kdu_core::kdu_dims& region, kdu_core::kdu_thread_env* thread_env);
+
+/**	Describe a rendering failure.
+
+	@param	description	A description of what failed.
+	@param	report	An additional report, such as a Kakadu error message,
+		to follow the description. This may be empty.
+	@return	A message identifying the rendered region, resolution level,
+		image data bytes rendered so far and source followed by the
+		description and report.
+*/
+std::string rendering_failure (const std::string& description,
+	const std::string& report = "") const;
+
+/**	Abandon a failed decompression.
+
+	The work queued on the thread environment is stopped, the
+	decompressor is finished and the reader is {@link close() closed}
+	because the codestream may not be used after a decompression
+	exception.
+
+	@param	thread_env	The processing thread environment of the
+		decompression. May be NULL.
+	@param	decompressor	The decompressor that failed. If NULL the
+		decompressors must have already been finished.
+*/
+void abandon_decompression (kdu_core::kdu_thread_env* thread_env,
+	kdu_supp::kdu_region_decompressor* decompressor = NULL);
+
+/**	Get the full resolution image region covered by rendered lines.
+
+	@param	rendered	The rendered region on the rendering grid.
+	@return	The region of the {@link image_region() image region}
+		covering the rendered region.
+*/
+Cube image_region_rendered (const Cube& rendered);
+
+/**	Dispose of a decompressed increment.
+
+	The increment is added to the {@link bytes_rendered() bytes
+	rendered} and passed to {@link data_disposition(Rendering_Monitor::Status,
+	const std::string&, const Cube&, const Cube&, void**, unsigned int)
+	data disposition} with the image region that it covers.
+
+	@param	status	The rendering status of the increment.
+	@param	increment	The region on the rendering grid that was
+		decompressed.
+	@param	data	The increment data buffers; NULL if the increment is
+		in the image data buffers.
+	@param	data_line_stride	The line stride of the data buffers.
+	@return	true if rendering is to be continued; false otherwise.
+*/
+bool dispose_increment (Rendering_Monitor::Status status,
+	const kdu_core::kdu_dims& increment,
+	void** data = NULL, unsigned int data_line_stride = 0);
+
+/**	Finish a rendering.
+
+	Any pipelined data disposition is completed and the rendering
+	monitor is notified that the rendering is done, or canceled.
+
+	@param	rendered_lines	The number of lines, from the top of the
+		rendered region, that were rendered.
+	@param	completed	true if the rendering was not canceled.
+	@return	The region that was rendered on the rendering grid.
+*/
+Cube rendering_finished (unsigned int rendered_lines, bool completed);
+
+/**	Decode a cell of the tile cache grid.
+
+	@param	cell	The cell region on the rendering grid.
+	@param	tiles	The vector of per band tiles. A tile for each
+		rendered band that is missing is decoded and set.
+	@param	thread_env	The processing thread environment for the
+		decompression. If NULL the decompression is done entirely in the
+		calling thread.
+	@throws	kdu_exception	If the decompression failed.
+*/
+void decode_cell (const kdu_core::kdu_dims& cell,
+	std::vector<std::shared_ptr<const JP2_Tile_Cache::Tile> >& tiles,
+	kdu_core::kdu_thread_env* thread_env);
+
+/**	Render a progressive rendering preview.
+
+	The rendered region is decoded from the first quality layer at the
+	{@link progressive_rendering(unsigned int) progressive rendering}
+	resolution level with expansion factors that upsample it to the
+	rendering grid, directly into the image data buffers. The preview
+	is then disposed of, and the rendering monitor notified, with the
+	{@link Rendering_Monitor::LOW_QUALITY_DATA} status.
+
+	Nothing is done if the preview would be no coarser than the image
+	rendering.
+
+	@param	thread_env	The processing thread environment for the
+		decompression. If NULL the decompression is done entirely in the
+		calling thread.
+	@return	false if the rendering monitor, or a {@link
+		cancel_rendering() cancellation}, canceled the rendering;
+		true otherwise.
+	@throws	JP2_Exception	If the decompression failed.
+*/
+bool render_preview (kdu_core::kdu_thread_env* thread_env);
+
+/**	Obtain the sample value histograms used for percentile stretching.
+
+	The rendered image region is decompressed at the lowest resolution
+	level for which it has no more than {@link #STRETCH_SAMPLE_PIXELS},
+	or the lowest resolution level available, and the histogram of each
+	rendered band is accumulated.
+
+	@param	histograms	A vector that is set to the per band histograms.
+	@throws	JP2_Exception	If the decompression failed.
+*/
+virtual void stretch_histograms
+	(std::vector<std::vector<unsigned long long> >& histograms);
+
+/**	Interrupt the rendering engine.
+
+	If the rendering engine is in an {@link interruptible(bool, kdu_core::kdu_thread_env*)
+	interruptible} section the Thread_Group is put into its exception
+	state. This stops the decompression work queued on the Thread_Group
+	and causes the rendering thread's decompression call in progress to
+	return with an exception, which the rendering engine handles as a
+	cancellation rather than a failure.
+
+	<b>N.B.</b>: This method is called by {@link cancel_rendering()
+	cancel_rendering} with the Rendering_Lock held.
+*/
+virtual void interrupt_rendering ();
+
+/**	Enable or disable interruption of the rendering engine.
+
+	While interruption is enabled the rendering engine may be {@link
+	interrupt_rendering() interrupted} by another thread. Interruption
+	is only enabled when the rendering is using the Thread_Group; a
+	rendering without a processing thread environment is only canceled
+	between its decompression increments.
+
+	@param	enable	true if interruption is to be enabled; false
+		otherwise.
+	@param	thread_env	The processing thread environment used by the
+		rendering engine. If NULL interruption is not enabled.
+	@return	true if interruption is being disabled and the rendering
+		engine was interrupted while it was enabled; false otherwise.
+		<b>N.B.</b>: When true is returned the Thread_Group is in its
+		exception state and the rendering engine must {@link
+		recover_from_interruption() recover} before it can be used
+		again.
+*/
+bool interruptible (bool enable,
+	kdu_core::kdu_thread_env* thread_env = NULL);
+
+/**	Recover from a rendering engine interruption.
+
+	The Thread_Group is terminated, which clears its exception state,
+	and the codestream, which may not be used after a decompression
+	exception, is recreated on the JP2 source with the same image
+	region and resolution level. The source, whether a local file or a
+	JPIP server connection, is not closed.
+
+	<b>N.B.</b>: Any region decompressors must have been finished
+	before this method is used.
+
+	@throws	JP2_IO_Failure	If the codestream could not be recreated.
+		The reader is closed in this case.
+*/
+void recover_from_interruption ();
+
 /*==============================================================================
 	Data
 */
@@ -621,6 +1208,24 @@ mutable kdu_supp::kdu_region_decompressor
 	Expand_Numerator,
 	Expand_Denominator;
 
+//!	Expansion factors to the most sub-sampled component.
+kdu_core::kdu_coords
+	Base_Expand_Numerator,
+	Base_Expand_Denominator;
+
+//!	Exact rendered size; zero when not in effect.
+PIRL::Size_2D
+	Scaled_Size;
+
+//!	Rendering scale; zero when not in effect.
+unsigned int
+	Scale_Numerator,
+	Scale_Denominator;
+
+//!	Flags that the metadata is shared with another reader.
+bool
+	Metadata_Shared;
+
 /*	Decompression processing threads.
 
 	The Thread_Group is used by the rendering engine.
@@ -630,6 +1235,25 @@ kdu_core::kdu_thread_env
 
 kdu_core::kdu_thread_queue
   *Master_Queue;
+
+//!	Worker threads obtained from the process-wide limit.
+unsigned int
+	Limited_Threads;
+
+/**	Processing threads in the Thread_Group, including its owner thread.
+
+	This may be less than the requested processing threads.
+*/
+unsigned int
+	Deployed_Threads;
+
+//!	Flags that the rendering engine may be interrupted.
+bool
+	Interruptible;
+
+//!	Flags that the rendering engine was interrupted.
+bool
+	Interrupted;
   
 /*	Kakadu error message queue.
 
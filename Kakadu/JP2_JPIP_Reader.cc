@@ -26,6 +26,7 @@ Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA.
 //	Kakadu
 #include	"jp2.h"
 #include	"JP2_Box.hh"
+#include	"JP2_Metrics.hh"
 #include	"kdu_client.h"
 using namespace kdu_core;
 using namespace kdu_supp;
@@ -241,6 +242,7 @@ JP2_JPIP_Reader::JP2_JPIP_Reader ()
 	Notifier (NULL),
 	JPIP_Client (),
 	Connection_ID (NOT_CONNECTED),
+	Received_Bytes (0),
 	Data_Bin_Cache (),
 	Server_Request (),
 	Server_Preferences (NULL),
@@ -263,6 +265,7 @@ JP2_JPIP_Reader::JP2_JPIP_Reader
 	Notifier (NULL),
 	JPIP_Client (),
 	Connection_ID (NOT_CONNECTED),
+	Received_Bytes (0),
 	Data_Bin_Cache (),
 	Server_Request (),
 	Server_Preferences (NULL),
@@ -301,6 +304,7 @@ JP2_JPIP_Reader::JP2_JPIP_Reader
 	Notifier (JP2_JPIP_reader.Notifier),
 	JPIP_Client (JP2_JPIP_reader.JPIP_Client),
 	Connection_ID (NOT_CONNECTED),
+	Received_Bytes (0),
 	Data_Bin_Cache (),
 	Server_Request (),
 	Server_Preferences (NULL),
@@ -947,6 +951,7 @@ if (JPIP_Client &&
 	}
 Connection_Completed = false;
 Connection_ID = NOT_CONNECTED;
+Received_Bytes = 0;
 #if ((DEBUG) & (DEBUG_OPEN | DEBUG_CONSTRUCTORS))
 clog << "<<< JP2_JPIP_Reader::close" << endl;
 #endif
@@ -1073,6 +1078,8 @@ if (! reconnected &&
 			}
 		}
 	Reconnecting = false;
+	if (! canceled)
+		JP2_Metrics::reconnected (reconnected);
 	if (monitor)
 		{
 		Rendering_Monitor::Status
@@ -1528,8 +1535,9 @@ if (region)
 	Server_Request.region.pos.y  = region->Y;
 	Server_Request.region.size.x = region->Width;
 	Server_Request.region.size.y = region->Height;
-	//	All quality layers.
-	Server_Request.max_layers    = 0;
+	//	Quality layers to be rendered (zero for all).
+	Server_Request.max_layers    =
+		rendered_quality_layers () ? max_quality_layers () : 0;
 
 	//	Add region-related metadata requests.
 	Server_Request.add_metareq (0, KDU_MRQ_WINDOW | KDU_MRQ_STREAM);
@@ -1950,6 +1958,15 @@ if (canceled &&
 in_progress =
 	JPIP_Client->get_window_in_progress
 		(&Server_Request, Connection_ID, &status);
+
+//	Record the bytes received since the last acquisition.
+kdu_long
+	received_bytes = JPIP_Client->get_received_bytes (Connection_ID);
+if (received_bytes > Received_Bytes)
+	{
+	JP2_Metrics::JPIP_bytes_received (received_bytes - Received_Bytes);
+	Received_Bytes = received_bytes;
+	}
 #if ((DEBUG) & (DEBUG_RENDER | DEBUG_DATA_ACQUISITION))
 clog << "      received_bytes: "
 		<< JPIP_Client->get_received_bytes (Connection_ID) << endl
@@ -114,6 +114,16 @@ virtual ~JP2_JPIP_Reader () throw();
 */
 virtual JP2_JPIP_Reader* clone () const;
 
+/**	Clone the JP2_JPIP_Reader.
+
+	The metadata of a JPIP source is acquired incrementally, so it is
+	not shared; a {@link clone() clone} is constructed.
+
+	@return	A pointer to a copy of this JP2_JPIP_Reader.
+*/
+virtual JP2_JPIP_Reader* shared_clone () const
+	{return clone ();}
+
 /**	Open a JP2 source.
 
 	<b>N.B.</b>: Multiple connections may be opened to the same JPIP
@@ -284,6 +294,7 @@ virtual bool resolution_and_region
 		allocate the rendered image data buffers.
 */
 virtual Cube render ();
+using JP2_File_Reader::render;
 
 /**	Get the JPIP server connection status description.
 
@@ -613,6 +624,10 @@ std::shared_ptr<kdu_supp::kdu_client>
 int
 	Connection_ID;
 
+//!	Bytes received on the connection that have been recorded in the JP2_Metrics.
+kdu_core::kdu_long
+	Received_Bytes;
+
 /*	The JP2 data bin cache manager attached to the JPIP_Client.
 
 	Each rendering engine must have its own data bin cache manager even
@@ -0,0 +1,215 @@
+/*	benchmark_swap_sample_bytes
+
+Copyright (C) 2026 Arizona Board of Regents on behalf of the
+Planetary Image Research Laboratory, Lunar and Planetary Laboratory at
+the University of Arizona.
+
+This program is free software; you can redistribute it and/or modify it
+under the terms of the GNU General Public License, version 2, as
+published by the Free Software Foundation.
+
+This program is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program; if not, write to the Free Software Foundation, Inc.,
+59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+*/
+
+#include	"JP2_Reader.hh"
+using UA::HiRISE::JP2_Reader;
+
+#include	<iostream>
+#include	<iomanip>
+#include	<cstdlib>
+#include	<vector>
+#include	<chrono>
+using namespace std;
+
+/*==============================================================================
+	Constants
+*/
+#ifndef MODULE_VERSION
+#define _VERSION_ " "
+#else
+#define _VERSION_ " v" MODULE_VERSION " "
+#endif
+//!	Application identification name with source code version and date.
+const char* const
+	ID =
+		"benchmark_swap_sample_bytes"
+		_VERSION_
+		"(" __DATE__ " " __TIME__ ")";
+
+/*==============================================================================
+	Swapping
+*/
+//	Access to the JP2_Reader sample bytes swapping.
+struct Swapper
+:	public JP2_Reader
+{
+using JP2_Reader::swap_sample_bytes;
+using JP2_Reader::sample_bytes_swapper;
+};
+
+//	The scalar byte at a time loop for comparison.
+void
+scalar_swap_sample_bytes
+	(
+	void*			data,
+	unsigned int	width,
+	unsigned int	height,
+	unsigned int	pixel_stride,
+	unsigned int	line_stride
+	)
+{
+unsigned char*
+	buffer_1;
+unsigned short*
+	buffer_2 = (unsigned short*)data;
+unsigned char
+	datum;
+pixel_stride <<= 1;
+for (unsigned int
+		line = 0;
+		line < height;
+		line++,
+		buffer_2 += line_stride)
+	{
+	buffer_1 = (unsigned char*)buffer_2;
+	for (unsigned int
+			sample = 0;
+			sample < width;
+			sample++,
+			buffer_1 += pixel_stride)
+		{
+		datum = *buffer_1;
+		*buffer_1 = *(buffer_1 + 1);
+		*(buffer_1 + 1) = datum;
+		}
+	}
+}
+
+typedef void (*Swap_Function)
+	(void*, unsigned int, unsigned int, unsigned int, unsigned int);
+
+/*	Time the swapping of all bands of an image.
+
+	@return	The swapping rate in megabytes per second.
+*/
+double
+time_swap
+	(
+	Swap_Function			swap,
+	vector<unsigned short>&	image,
+	unsigned int			width,
+	unsigned int			height,
+	unsigned int			bands,
+	unsigned int			band_offset,
+	unsigned int			pixel_stride,
+	unsigned int			line_stride,
+	unsigned int			repetitions
+	)
+{
+chrono::steady_clock::time_point
+	start = chrono::steady_clock::now ();
+for (unsigned int
+		count = 0;
+		count < repetitions;
+		count++)
+	for (unsigned int
+			band = 0;
+			band < bands;
+			band++)
+		swap (&image[band * band_offset],
+			width, height, pixel_stride, line_stride);
+double
+	seconds = chrono::duration<double>
+		(chrono::steady_clock::now () - start).count ();
+return ((double)width * height * bands * 2 * repetitions)
+	/ (seconds * 1024 * 1024);
+}
+
+/*==============================================================================
+	Main
+*/
+int
+main
+	(
+	int		count,
+	char**	arguments
+	)
+{
+unsigned int
+	width = 4096,
+	height = 4096,
+	bands = 3,
+	repetitions = 10;
+if (count > 1)
+	width = height = atoi (arguments[1]);
+if (count > 2)
+	repetitions = atoi (arguments[2]);
+if (! width ||
+	! repetitions)
+	{
+	cout << "Usage: " << arguments[0] << " [<size> [<repetitions>]]" << endl;
+	exit (1);
+	}
+cout << ID << endl
+	 << width << "w x " << height << "h x " << bands << "b, "
+	 << repetitions << " repetitions" << endl
+	 << "swap kernel: " << Swapper::sample_bytes_swapper () << endl;
+
+vector<unsigned short>
+	image ((size_t)width * height * bands, 0x1234),
+	check ((size_t)width * height * bands, 0x1234);
+struct Layout
+	{
+	const char*		Name;
+	unsigned int	Band_Offset,
+					Pixel_Stride,
+					Line_Stride;
+	}
+	layouts[] =
+	{
+	//	Band sequential.
+	{"BSQ", width * height, 1, width},
+	//	Band interleaved by line.
+	{"BIL", width, 1, width * bands},
+	//	Band interleaved by pixel.
+	{"BIP", 1, bands, width * bands}
+	};
+
+for (unsigned int
+		layout = 0;
+		layout < sizeof (layouts) / sizeof (Layout);
+		layout++)
+	{
+	Layout
+		&format = layouts[layout];
+	double
+		scalar = time_swap (scalar_swap_sample_bytes, check,
+			width, height, bands,
+			format.Band_Offset, format.Pixel_Stride, format.Line_Stride,
+			repetitions),
+		swapper = time_swap (Swapper::swap_sample_bytes, image,
+			width, height, bands,
+			format.Band_Offset, format.Pixel_Stride, format.Line_Stride,
+			repetitions);
+	cout << format.Name << ": "
+		 << fixed << setprecision (1)
+		 << setw (9) << scalar << " MB/s scalar, "
+		 << setw (9) << swapper << " MB/s "
+		 	<< Swapper::sample_bytes_swapper () << ", "
+		 << setprecision (2) << (swapper / scalar) << 'x' << endl;
+	if (image != check)
+		{
+		cout << "!!! " << format.Name
+				<< " swapped samples do not match the scalar result." << endl;
+		exit (1);
+		}
+	}
+exit (0);
+}
@@ -24,7 +24,16 @@ with this program; if not, write to the Free Software Foundation, Inc.,
 using UA::HiRISE::JP2;
 using UA::HiRISE::JP2_Reader;
 using UA::HiRISE::JP2_Exception;
+using UA::HiRISE::JP2_Invalid_Argument;
 using UA::HiRISE::bytes_of_bits;
+#include	"JP2_Tile_Cache.hh"
+using UA::HiRISE::JP2_Tile_Cache;
+#include	"JP2_Buffer_Pool.hh"
+using UA::HiRISE::JP2_Buffer_Pool;
+#include	"JP2_Reader_Pool.hh"
+using UA::HiRISE::JP2_Reader_Pool;
+#include	"JP2_File_Reader.hh"
+using UA::HiRISE::Kakadu::JP2_File_Reader;
 
 //	Kakadu
 #include	"kdu_arch.h"
@@ -48,9 +57,15 @@ using idaeim::PVL::Aggregate;
 #include	<string>
 #include	<cstring>
 #include	<vector>
+#include	<algorithm>
+#include	<memory>
 #include	<utility>
 #include	<stdexcept>
 #include	<ctime>
+#include	<thread>
+#include	<iterator>
+#include	<cstdio>
+#include	<cmath>
 
 #ifndef _WIN32
 #include	<sys/time.h>
@@ -105,6 +120,7 @@ const int
 
 	//	JP2 Reader.
 	READER_ERROR				= 40,
+	CHECK_FAILURE				= 41,
 
 	//	Unknown?
 	UNKNOWN_ERROR				= -1;
@@ -201,6 +217,18 @@ if (list_descriptions)
 	<< endl
 	<< "    Default: No clone test." << endl;
 
+cout
+	<< "  -Verify" << endl;
+if (list_descriptions)
+	cout
+	<< "    Run the functional checks of the JP2_Reader instead of rendering" << endl
+	<< "    the source. Each check is listed as passed or failed. The source" << endl
+	<< "    is expected to be the linear-1x256x256x1.8_MSB_UNSIGNED.JP2 test" << endl
+	<< "    file." << endl
+	<< endl
+	<< "    Default: No functional checks." << endl
+	<< endl;
+
 cout
 	<< "  -Help" << endl;
 if (list_descriptions)
@@ -252,6 +280,1302 @@ return true;
 }
 };
 
+/*==============================================================================
+	Functional checks
+*/
+//	Reports a functional check result.
+bool
+check
+	(
+	const string&	description,
+	bool			passed
+	)
+{
+cout << (passed ? "    passed: " : "!!! FAILED: ") << description << endl;
+return passed;
+}
+
+/*	A sourceless JP2_Reader that disposes of synthetic rendering
+	increments of a single band image.
+*/
+struct Increment_Reader
+:	public JP2_Reader
+{
+Increment_Reader
+	(
+	unsigned int	width,
+	unsigned int	height,
+	unsigned int	bits
+	)
+{
+//	Signature, File Type, and JP2 Header with Image Header boxes.
+unsigned char
+	boxes[] =
+	{
+	0x00, 0x00, 0x00, 0x0C, 'j',  'P',  ' ',  ' ',
+	0x0D, 0x0A, 0x87, 0x0A,
+	0x00, 0x00, 0x00, 0x14, 'f',  't',  'y',  'p',
+	'j',  'p',  '2',  ' ',  0x00, 0x00, 0x00, 0x00,
+	'j',  'p',  '2',  ' ',
+	0x00, 0x00, 0x00, 0x1E, 'j',  'p',  '2',  'h',
+	0x00, 0x00, 0x00, 0x16, 'i',  'h',  'd',  'r',
+	0x00, 0x00, 0x00, 0x00,		//	Height.
+	0x00, 0x00, 0x00, 0x00,		//	Width.
+	0x00, 0x01,					//	Bands.
+	0x00, 0x07, 0x00, 0x00		//	Bits - 1, compression, flags.
+	};
+unsigned char
+	*header = boxes + 48;
+for (int
+		byte = 3;
+		byte >= 0;
+		byte--,
+			height >>= 8,
+			width >>= 8)
+	{
+	header[byte]     = (unsigned char)(height & 0xFF);
+	header[byte + 4] = (unsigned char)(width & 0xFF);
+	}
+header[10] = (unsigned char)(bits - 1);
+add_JP2_boxes (boxes, sizeof (boxes));
+
+Rendered_Bits = bits;
+Rendered_Bands.assign (1, true);
+Image_Region = Rendered_Region =
+	Cube (0, 0, image_width (), image_height (), 1);
+}
+
+JP2_Reader* clone () const {return NULL;}
+int open (const std::string&) {return 0;}
+bool is_open () const {return true;}
+bool resolution_and_region (unsigned int, const PIRL::Rectangle&)
+	{return false;}
+Cube render () {return Cube ();}
+void close (bool = false) {}
+
+//	Dispose of one increment that is the entire rendered region.
+bool
+dispose
+	(
+	void*	samples
+	)
+{
+prepare_stretch ();
+void
+	*data[] = {samples};
+return data_disposition (Rendering_Monitor::DONE, "", Rendered_Region,
+	Image_Region, data, Rendered_Region.Width);
+}
+};
+
+//	Collects the lines of a single band rendering.
+struct Line_Collector
+:	public JP2_Reader::Line_Sink
+{
+vector<unsigned char>
+	Pixels;
+unsigned int
+	Pixel_Bytes;
+
+Line_Collector
+	(
+	unsigned int	pixel_bytes
+	)
+	:	Pixel_Bytes (pixel_bytes)
+{}
+
+bool
+lines
+	(
+	JP2_Reader&		JP2_reader,
+	unsigned int,
+	unsigned int,
+	unsigned int	line_count,
+	const void*		data,
+	unsigned int	line_stride
+	)
+{
+const unsigned char
+	*line = (const unsigned char*)data;
+unsigned int
+	line_bytes = JP2_reader.rendered_region ().Width * Pixel_Bytes;
+while (line_count--)
+	{
+	Pixels.insert (Pixels.end (), line, line + line_bytes);
+	line += (size_t)line_stride * Pixel_Bytes;
+	}
+return true;
+}
+};
+
+/*	Stretch 16-bit samples to 8-bit pixels with and without pixel bytes
+	swapping.
+
+	The stretched pixels are single bytes; swapping must not be applied
+	to the decoded samples that index the stretch table.
+*/
+bool
+check_stretch_swap ()
+{
+const unsigned int
+	width = 64,
+	height = 16;
+vector<unsigned short>
+	samples ((size_t)width * height);
+for (size_t
+		index = 0;
+		index < samples.size ();
+		index++)
+	samples[index] = (unsigned short)(index * 3);
+
+Line_Collector
+	unswapped (1),
+	swapped (1);
+Increment_Reader
+	reader (width, height, 16);
+reader.linear_stretch (JP2_Reader::ALL_BANDS, 0, width * height * 3);
+
+vector<unsigned short>
+	increment (samples);
+reader.line_sink (&unswapped).swap_pixel_bytes (false);
+reader.dispose (&increment[0]);
+
+increment = samples;
+reader.line_sink (&swapped).swap_pixel_bytes (true);
+reader.dispose (&increment[0]);
+reader.line_sink (NULL);
+
+bool
+	passed =
+		check ("16-bit stretch renders 8-bit pixels",
+			reader.rendered_pixel_bytes () == 1 &&
+			unswapped.Pixels.size () == samples.size ());
+passed &=
+	check ("16-bit stretch maps the sample range",
+		! unswapped.Pixels.empty () &&
+		unswapped.Pixels.front () == 0 &&
+		unswapped.Pixels.back () >= 254);
+passed &=
+	check ("16-bit stretch is unaffected by pixel bytes swapping",
+		swapped.Pixels == unswapped.Pixels);
+return passed;
+}
+
+/*	Copy the rendered pixels of the first band.
+
+	The pixels of each line are obtained from the image data address of
+	the line, so chunked image data is copied in line order.
+*/
+vector<unsigned char>
+rendered_pixels
+	(
+	JP2_Reader&	reader
+	)
+{
+vector<unsigned char>
+	pixels;
+size_t
+	line_bytes =
+		(size_t)reader.rendered_width () * reader.rendered_pixel_bytes ();
+for (unsigned int
+		line = 0;
+		line < reader.rendered_height ();
+		line++)
+	{
+	const unsigned char
+		*data = static_cast<const unsigned char*>
+			(reader.image_data (0, line, 0));
+	if (! data)
+		return vector<unsigned char> ();
+	pixels.insert (pixels.end (), data, data + line_bytes);
+	}
+return pixels;
+}
+
+/*	Render an image region of the source with and without a tile cache.
+
+	The first cached rendering decodes the tiles; the second is provided
+	entirely by cache hits. Both must match the rendering without the
+	cache.
+*/
+bool
+check_tile_cache
+	(
+	const string&	source
+	)
+{
+const Rectangle
+	region (17, 9, 200, 180);
+
+unique_ptr<JP2_Reader>
+	reader (JP2::reader (source));
+reader->image_region (region);
+reader->render ();
+vector<unsigned char>
+	fresh (rendered_pixels (*reader));
+
+JP2_Tile_Cache
+	cache;
+unique_ptr<JP2_Reader>
+	cached (JP2::reader (source));
+cached->tile_cache (&cache).image_region (region);
+cached->render ();
+vector<unsigned char>
+	decoded (rendered_pixels (*cached));
+unsigned long long
+	misses = cache.misses ();
+cached->render ();
+vector<unsigned char>
+	reused (rendered_pixels (*cached));
+
+bool
+	passed =
+		check ("tile cache decoded rendering matches a fresh decode",
+			! fresh.empty () &&
+			decoded == fresh);
+passed &=
+	check ("tile cache hit rendering matches a fresh decode",
+		cache.hits () > 0 &&
+		cache.misses () == misses &&
+		reused == fresh);
+return passed;
+}
+
+/*	Render the source as concurrent strips and as a single strip.
+
+	The strips are divided along tile rows; a source with a single tile
+	row is rendered as a single strip. Either way the rendering must
+	match the serial rendering.
+*/
+bool
+check_strip_render
+	(
+	const string&	source
+	)
+{
+unique_ptr<JP2_Reader>
+	reader (JP2::reader (source));
+reader->processing_threads (4).rendering_strips (1);
+reader->render ();
+vector<unsigned char>
+	serial (rendered_pixels (*reader));
+
+unique_ptr<JP2_Reader>
+	striped (JP2::reader (source));
+striped->processing_threads (4).rendering_strips (4);
+striped->render ();
+vector<unsigned char>
+	strips (rendered_pixels (*striped));
+
+return
+	check ("strip rendering matches the serial rendering",
+		! serial.empty () &&
+		strips == serial);
+}
+
+/*	Rendering monitor that cancels the rendering at its first increment.
+*/
+struct Canceling_Monitor
+:	public JP2_Reader::Rendering_Monitor
+{
+JP2_Reader::Rendering_Cancellation
+	&Cancellation;
+unsigned int
+	Increments;
+Status
+	Last_Status;
+
+Canceling_Monitor
+	(
+	JP2_Reader::Rendering_Cancellation&	cancellation
+	)
+	:	Cancellation (cancellation),
+		Increments (0),
+		Last_Status (DONE)
+{}
+
+bool
+notify
+	(
+	JP2_Reader&,
+	Status				status,
+	const std::string&,
+	const Cube&,
+	const Cube&
+	)
+{
+Last_Status = status;
+if (status == TOP_QUALITY_DATA &&
+	! Increments++)
+	Cancellation.cancel ();
+return true;
+}
+};
+
+/*	Render the source asynchronously, to completion and canceled.
+
+	The completed asynchronous rendering must match a synchronous
+	rendering. A rendering canceled at its first increment must end with
+	less than the whole region rendered and a CANCELED notification, and
+	the reader must then render the whole region again.
+*/
+bool
+check_async_render
+	(
+	const string&	source
+	)
+{
+unique_ptr<JP2_Reader>
+	reader (JP2::reader (source));
+reader->rendering_increment_lines (16);
+Cube
+	expected (reader->render ());
+vector<unsigned char>
+	serial (rendered_pixels (*reader));
+
+Cube
+	rendered (reader->render_async ().get ());
+bool
+	passed =
+		check ("asynchronous rendering matches the synchronous rendering",
+			rendered == expected &&
+			rendered_pixels (*reader) == serial);
+
+JP2_Reader::Rendering_Cancellation
+	cancellation;
+Canceling_Monitor
+	monitor (cancellation);
+reader->rendering_monitor (&monitor);
+Cube
+	canceled (reader->render_async (&cancellation).get ());
+reader->rendering_monitor (NULL);
+passed &=
+	check ("canceled asynchronous rendering stops early",
+		cancellation.canceled () &&
+		monitor.Last_Status == JP2_Reader::Rendering_Monitor::CANCELED &&
+		canceled.Height < expected.Height);
+
+rendered = reader->render ();
+passed &=
+	check ("rendering after a cancellation renders the whole region",
+		rendered == expected &&
+		rendered_pixels (*reader) == serial);
+return passed;
+}
+
+//	Records the rendering increments and final status of a rendering.
+struct Increment_Monitor
+:	public JP2_Reader::Rendering_Monitor
+{
+vector<Cube>
+	Increments;
+vector<std::thread::id>
+	Threads;
+Status
+	Final_Status;
+unsigned int
+	Final_Notifications,
+	Increments_After_Final;
+
+Increment_Monitor ()
+	:	Final_Status (INFO_ONLY),
+		Final_Notifications (0),
+		Increments_After_Final (0)
+{}
+
+bool
+notify
+	(
+	JP2_Reader&,
+	Status				status,
+	const std::string&,
+	const Cube&			region_rendered,
+	const Cube&
+	)
+{
+if (status == DONE ||
+	status == CANCELED)
+	{
+	Final_Status = status;
+	++Final_Notifications;
+	}
+else
+if (status & RENDERED_DATA_MASK)
+	{
+	if (Final_Notifications)
+		++Increments_After_Final;
+	Increments.push_back (region_rendered);
+	Threads.push_back (std::this_thread::get_id ());
+	}
+return true;
+}
+
+//	Test if the increments are contiguous and in order down the region.
+bool
+in_order
+	(
+	const Cube&	region
+	)
+	const
+{
+if (Increments.empty ())
+	return false;
+int
+	line = region.Y;
+for (size_t
+		index = 0;
+		index < Increments.size ();
+		index++)
+	{
+	if (Increments[index].Y != line)
+		return false;
+	line += Increments[index].Height;
+	}
+return line == (int)(region.Y + region.Height);
+}
+};
+
+/*	Render the source with and without pipelined data disposition.
+
+	The pipelined rendering must notify the monitor of each increment in
+	rendering order, from a single thread, with the final notification
+	after all the increments, and render the same pixels.
+*/
+bool
+check_pipelined_disposition
+	(
+	const string&	source
+	)
+{
+unique_ptr<JP2_Reader>
+	reader (JP2::reader (source));
+reader->rendering_increment_lines (16);
+Increment_Monitor
+	serial_monitor;
+reader->rendering_monitor (&serial_monitor);
+Cube
+	expected (reader->render ());
+vector<unsigned char>
+	serial (rendered_pixels (*reader));
+
+Increment_Monitor
+	monitor;
+reader->rendering_monitor (&monitor).pipelined_disposition (true);
+Cube
+	rendered (reader->render ());
+reader->rendering_monitor (NULL);
+
+bool
+	passed =
+		check ("pipelined disposition notifies the increments in order",
+			monitor.Increments.size () > 1 &&
+			monitor.Increments.size () == serial_monitor.Increments.size () &&
+			monitor.in_order (reader->rendered_region ()));
+passed &=
+	check ("pipelined disposition notifies from a single thread",
+		std::count (monitor.Threads.begin (), monitor.Threads.end (),
+			monitor.Threads.front ()) == (long)monitor.Threads.size ());
+passed &=
+	check ("pipelined disposition notifies completion after the increments",
+		monitor.Final_Status == JP2_Reader::Rendering_Monitor::DONE &&
+		monitor.Final_Notifications == 1 &&
+		! monitor.Increments_After_Final);
+passed &=
+	check ("pipelined disposition renders the same pixels",
+		rendered == expected &&
+		rendered_pixels (*reader) == serial);
+return passed;
+}
+
+/*	Render a region of the source directly into a file.
+
+	The file must hold exactly the rendered pixels of a rendering into
+	image data buffers, and the reader must render to its image data
+	buffers again afterwards.
+*/
+bool
+check_render_to_file
+	(
+	const string&	source
+	)
+{
+const Rectangle
+	region (5, 11, 160, 120);
+const string
+	pathname ("test_JP2_Reader_render_to_file.raw");
+
+unique_ptr<JP2_Reader>
+	reader (JP2::reader (source));
+reader->image_region (region);
+Cube
+	expected (reader->render ());
+vector<unsigned char>
+	pixels (rendered_pixels (*reader));
+
+Cube
+	rendered (reader->render_to_file (pathname, JP2_Reader::FORMAT_BSQ));
+ifstream
+	file (pathname.c_str (), ios::in | ios::binary);
+vector<unsigned char>
+	content
+		((istreambuf_iterator<char> (file)), istreambuf_iterator<char> ());
+file.close ();
+std::remove (pathname.c_str ());
+
+bool
+	passed =
+		check ("rendering to a file renders the region",
+			rendered == expected);
+passed &=
+	check ("the rendered file holds the rendered pixels",
+		! pixels.empty () &&
+		content == pixels);
+
+reader->render ();
+passed &=
+	check ("rendering after rendering to a file uses the image data buffers",
+		rendered_pixels (*reader) == pixels);
+return passed;
+}
+
+/*	Render calibrated floating point samples.
+
+	Each calibrated sample must be the integer rendering of the pixel,
+	within the rounding of the integer rendering, times the calibration
+	scale plus the calibration offset.
+*/
+bool
+check_float_calibration
+	(
+	const string&	source
+	)
+{
+const float
+	scale = 2.0f,
+	offset = 10.0f;
+
+unique_ptr<JP2_Reader>
+	reader (JP2::reader (source));
+reader->render ();
+vector<unsigned char>
+	pixels (rendered_pixels (*reader));
+unsigned int
+	pixel_bytes = reader->rendered_pixel_bytes ();
+
+unique_ptr<JP2_Reader>
+	calibrated (JP2::reader (source));
+calibrated->float_samples (true)
+	.calibration (JP2_Reader::ALL_BANDS, scale, offset);
+calibrated->render ();
+vector<unsigned char>
+	float_pixels (rendered_pixels (*calibrated));
+
+bool
+	passed =
+		check ("float samples are rendered as floats",
+			calibrated->rendered_pixel_bytes () == sizeof (float) &&
+			calibrated->calibration_scale (0) == scale &&
+			calibrated->calibration_offset (0) == offset);
+
+bool
+	matched =
+		pixel_bytes == 1 &&
+		! pixels.empty () &&
+		float_pixels.size () == pixels.size () * sizeof (float);
+float
+	sample;
+for (size_t
+		index = 0;
+		matched &&
+		index < pixels.size ();
+		index++)
+	{
+	memcpy (&sample, &float_pixels[index * sizeof (float)], sizeof (float));
+	if (fabs (sample - (pixels[index] * scale + offset)) > (scale / 2) + 0.01)
+		matched = false;
+	}
+passed &=
+	check ("calibrated float samples are the scaled and offset pixels",
+		matched);
+return passed;
+}
+
+/*	Render the source to an exact size and a rational scale.
+
+	An exact rendered size must render a region of that size. A scale of
+	one half must render the same pixels as the second resolution level,
+	and clearing the scale must render the full size again.
+*/
+bool
+check_scaled_render
+	(
+	const string&	source
+	)
+{
+unique_ptr<JP2_Reader>
+	reader (JP2::reader (source));
+JP2_File_Reader
+	*file_reader = dynamic_cast<JP2_File_Reader*>(reader.get ());
+if (! file_reader)
+	return check ("the source has a JP2_File_Reader for scaled rendering",
+		false);
+Cube
+	full (reader->render ());
+
+const unsigned int
+	width = full.Width * 2 / 5,
+	height = full.Height / 3;
+file_reader->rendered_size (width, height);
+Cube
+	sized (reader->render ());
+bool
+	passed =
+		check ("an exact rendered size renders that size",
+			file_reader->scaled_rendering () &&
+			sized.Width == width &&
+			sized.Height == height &&
+			reader->rendered_region ().Width == width &&
+			reader->rendered_region ().Height == height &&
+			rendered_pixels (*reader).size () ==
+				(size_t)width * height * reader->rendered_pixel_bytes ());
+
+unique_ptr<JP2_Reader>
+	reduced (JP2::reader (source));
+reduced->resolution_level (2);
+Cube
+	expected (reduced->render ());
+file_reader->rendering_scale (1, 2);
+Cube
+	halved (reader->render ());
+passed &=
+	check ("a one half rendering scale matches the second resolution level",
+		halved.Width == expected.Width &&
+		halved.Height == expected.Height &&
+		rendered_pixels (*reader) == rendered_pixels (*reduced));
+
+file_reader->clear_rendering_scale ();
+Cube
+	cleared (reader->render ());
+passed &=
+	check ("clearing the rendering scale renders the full size",
+		! file_reader->scaled_rendering () &&
+		cleared == full);
+return passed;
+}
+
+/*	Render the source with a reader and its shared clone concurrently.
+
+	The clone must be open with the same metadata, have its own
+	rendering configuration, and render the same pixels as the reader
+	while both render on separate threads.
+*/
+bool
+check_shared_clone
+	(
+	const string&	source
+	)
+{
+const Rectangle
+	region (32, 16, 128, 200);
+
+unique_ptr<JP2_Reader>
+	reader (JP2::reader (source));
+unique_ptr<JP2_Reader>
+	clone (reader->shared_clone ());
+bool
+	passed =
+		check ("a shared clone is open with the same metadata",
+			clone &&
+			clone->is_open () &&
+			clone->image_width () == reader->image_width () &&
+			clone->image_height () == reader->image_height () &&
+			clone->image_bands () == reader->image_bands () &&
+			clone->pixel_precision () == reader->pixel_precision ());
+if (! passed)
+	return false;
+
+clone->image_region (region);
+passed &=
+	check ("a shared clone has its own rendering configuration",
+		clone->image_region () != reader->image_region ());
+
+reader->image_region (region);
+Cube
+	expected,
+	rendered;
+std::thread
+	clone_thread ([&clone, &rendered] {rendered = clone->render ();});
+expected = reader->render ();
+clone_thread.join ();
+passed &=
+	check ("a shared clone renders the same pixels concurrently",
+		rendered == expected &&
+		rendered_pixels (*clone) == rendered_pixels (*reader));
+return passed;
+}
+
+/*	Render the source with the adaptive and low latency increments.
+
+	The adaptive increment must be whole code-block rows within the
+	rendered region, and the low latency first increment no larger than
+	the effective increment. Both must render all the increments in
+	order and the same pixels as the default increment.
+*/
+bool
+check_adaptive_increment
+	(
+	const string&	source
+	)
+{
+unique_ptr<JP2_Reader>
+	reader (JP2::reader (source));
+Cube
+	expected (reader->render ());
+vector<unsigned char>
+	pixels (rendered_pixels (*reader));
+
+reader->adaptive_rendering_increment (true);
+unsigned int
+	lines = reader->effective_rendering_increment_lines (),
+	alignment = reader->increment_alignment_lines (),
+	height = reader->rendered_height ();
+bool
+	passed =
+		check ("the adaptive increment is whole code-block rows",
+			lines &&
+			lines <= height &&
+			alignment &&
+			(lines % alignment == 0 ||
+			 lines == height));
+
+Increment_Monitor
+	adaptive;
+reader->rendering_monitor (&adaptive);
+Cube
+	rendered (reader->render ());
+passed &=
+	check ("the adaptive increment renders the same pixels",
+		adaptive.in_order (reader->rendered_region ()) &&
+		rendered == expected &&
+		rendered_pixels (*reader) == pixels);
+
+reader->low_latency_rendering (true);
+unsigned int
+	first = reader->first_rendering_increment_lines ();
+passed &=
+	check ("the low latency first increment is no larger than the increment",
+		first &&
+		first <= reader->effective_rendering_increment_lines () &&
+		(first == alignment ||
+		 first == reader->effective_rendering_increment_lines ()));
+
+Increment_Monitor
+	low_latency;
+reader->rendering_monitor (&low_latency);
+rendered = reader->render ();
+reader->rendering_monitor (NULL);
+passed &=
+	check ("the low latency increment renders the same pixels",
+		low_latency.in_order (reader->rendered_region ()) &&
+		rendered == expected &&
+		rendered_pixels (*reader) == pixels);
+return passed;
+}
+
+/*	Collect the statistics of renderings.
+
+	The statistics of the last rendering must count its increments and
+	image data bytes, have consistent times, and be replaced by those of
+	the next rendering.
+*/
+bool
+check_render_statistics
+	(
+	const string&	source
+	)
+{
+const Rectangle
+	region (0, 0, 100, 64);
+
+unique_ptr<JP2_Reader>
+	reader (JP2::reader (source));
+Increment_Monitor
+	monitor;
+reader->rendering_monitor (&monitor).rendering_increment_lines (16);
+reader->render ();
+reader->rendering_monitor (NULL);
+JP2_Reader::Render_Statistics
+	statistics (reader->last_render_statistics ());
+unsigned long long
+	bytes = (unsigned long long)reader->rendered_region ().area ()
+		* reader->rendered_bands () * reader->rendered_pixel_bytes ();
+
+bool
+	passed =
+		check ("rendering statistics count the increments and bytes",
+			statistics.Increments == monitor.Increments.size () &&
+			statistics.Bytes_Rendered == bytes &&
+			statistics.Bytes_Rendered == reader->bytes_rendered () &&
+			statistics.Peak_Buffer_Bytes >= bytes &&
+			statistics.Threads >= 1);
+passed &=
+	check ("rendering statistics times are consistent",
+		statistics.Ingest_Seconds >= 0 &&
+		statistics.Open_Seconds >= statistics.Ingest_Seconds &&
+		statistics.Render_Seconds > 0 &&
+		statistics.Decode_Seconds >= statistics.Max_Increment_Seconds &&
+		//	Allow for the rounding of the summed times.
+		statistics.Render_Seconds + 1e-6 >=
+			statistics.Decode_Seconds + statistics.Disposition_Seconds &&
+		statistics.Render_CPU_Seconds >= 0);
+
+Increment_Monitor
+	region_monitor;
+reader->rendering_monitor (&region_monitor).image_region (region);
+reader->render ();
+reader->rendering_monitor (NULL);
+statistics = reader->last_render_statistics ();
+passed &=
+	check ("rendering statistics are those of the last rendering",
+		statistics.Bytes_Rendered ==
+			(unsigned long long)region.area ()
+			* reader->rendered_bands () * reader->rendered_pixel_bytes () &&
+		statistics.Increments == region_monitor.Increments.size ());
+return passed;
+}
+
+/*	Render limited to the codestream's quality layers.
+
+	Rendering all of the codestream's quality layers must match rendering
+	with no limit, and a limit beyond the codestream's layers must be
+	rejected.
+*/
+bool
+check_quality_layers
+	(
+	const string&	source
+	)
+{
+unique_ptr<JP2_Reader>
+	reader (JP2::reader (source));
+Cube
+	expected (reader->render ());
+vector<unsigned char>
+	pixels (rendered_pixels (*reader));
+
+unsigned int
+	layers = reader->quality_layers ();
+reader->rendered_quality_layers (layers);
+Cube
+	rendered (reader->render ());
+bool
+	passed =
+		check ("rendering all quality layers matches an unlimited rendering",
+			rendered == expected &&
+			rendered_pixels (*reader) == pixels);
+
+bool
+	rejected = false;
+try {reader->rendered_quality_layers (layers + 1);}
+catch (JP2_Invalid_Argument&) {rejected = true;}
+passed &=
+	check ("more quality layers than the codestream has are rejected",
+		rejected &&
+		reader->rendered_quality_layers () == layers);
+return passed;
+}
+
+/*	Check a reader in and out of a JP2_Reader_Pool.
+
+	A reader checked in with a modified rendering configuration must be
+	checked out again, still open, with the default configuration, and
+	render the same pixels as a new reader.
+*/
+bool
+check_reader_pool
+	(
+	const string&	source
+	)
+{
+unique_ptr<JP2_Reader>
+	fresh (JP2::reader (source));
+Cube
+	expected (fresh->render ());
+vector<unsigned char>
+	pixels (rendered_pixels (*fresh));
+
+JP2_Reader_Pool
+	pool;
+JP2_Reader
+	*reader = pool.checkout (source);
+Cube
+	region (expected);
+region.Width  /= 2;
+region.Height /= 2;
+reader->image_region (region);
+reader->resolution_level (2);
+reader->swap_pixel_bytes (true);
+reader->rendering_strips (4);
+reader->pipelined_disposition (true);
+reader->render ();
+pool.checkin (reader);
+
+JP2_Reader
+	*reused = pool.checkout (source);
+bool
+	passed =
+		check ("a checked in reader is reused while it is open",
+			reused == reader &&
+			reused->is_open ());
+passed &=
+	check ("a reused reader has the default rendering configuration",
+		reused->image_region () == fresh->image_region () &&
+		reused->resolution_level () == fresh->resolution_level () &&
+		reused->rendered_bands () == fresh->rendered_bands () &&
+		! reused->swap_pixel_bytes () &&
+		reused->rendering_strips () == 1 &&
+		! reused->pipelined_disposition ());
+Cube
+	rendered (reused->render ());
+passed &=
+	check ("a reused reader renders the same pixels as a new reader",
+		rendered == expected &&
+		rendered_pixels (*reused) == pixels);
+pool.checkin (reused);
+return passed;
+}
+
+/*	Borrow and return buffers of a JP2_Buffer_Pool.
+
+	Buffer sizes are rounded up to one of four size classes between
+	successive powers of two. A returned buffer is reused for a request
+	of the same size class, and idle buffers are released when the pool
+	capacity is reduced.
+*/
+bool
+check_buffer_pool ()
+{
+const size_t
+	minimum = JP2_Buffer_Pool::MINIMUM_SIZE_CLASS;
+bool
+	passed =
+		check ("buffer pool size classes",
+			JP2_Buffer_Pool::size_class (1) == minimum &&
+			JP2_Buffer_Pool::size_class (minimum) == minimum &&
+			JP2_Buffer_Pool::size_class (minimum + 1)
+				== minimum + minimum / 4 &&
+			JP2_Buffer_Pool::size_class (minimum + minimum / 2 + 1)
+				== minimum + minimum * 3 / 4 &&
+			JP2_Buffer_Pool::size_class (minimum * 2) == minimum * 2 &&
+			JP2_Buffer_Pool::size_class (minimum * 2 + 1)
+				== minimum * 2 + minimum / 2);
+
+JP2_Buffer_Pool
+	pool (minimum * 4);
+void
+	*buffer = pool.allocate (minimum);
+pool.deallocate (buffer, minimum);
+void
+	*reused = pool.allocate (minimum - 1);
+passed &=
+	check ("buffer pool reuses an idle buffer of the same size class",
+		buffer &&
+		reused == buffer &&
+		pool.hits () == 1 &&
+		pool.misses () == 1 &&
+		pool.idle_buffers () == 0);
+
+void
+	*large = pool.allocate (minimum * 2);
+pool.deallocate (reused, minimum - 1);
+pool.deallocate (large, minimum * 2);
+passed &=
+	check ("buffer pool holds returned buffers within its capacity",
+		pool.idle_buffers () == 2 &&
+		pool.idle_bytes () == minimum * 3 &&
+		pool.bytes () == minimum * 3);
+
+pool.capacity (minimum);
+passed &=
+	check ("buffer pool capacity reduction releases the largest idle buffers",
+		pool.idle_buffers () == 1 &&
+		pool.idle_bytes () == minimum &&
+		pool.bytes () == minimum);
+
+large = pool.allocate (minimum * 2);
+pool.deallocate (large, minimum * 2);
+passed &=
+	check ("buffer pool frees a buffer returned over its capacity",
+		pool.idle_buffers () == 0 &&
+		pool.bytes () == 0);
+
+pool.capacity (minimum * 4);
+pool.deallocate (pool.allocate (minimum), minimum);
+passed &=
+	check ("buffer pool release frees the idle buffers",
+		pool.release () == minimum &&
+		pool.idle_buffers () == 0 &&
+		pool.bytes () == 0);
+return passed;
+}
+
+/*	Render the source as contiguous and chunked 16-bit image data.
+
+	The image data address of a location must account for the rendered
+	pixel bytes and, for chunked image data, the chunk holding the line.
+	The chunked image data must match the contiguous image data.
+*/
+bool
+check_chunked_image_data
+	(
+	const string&	source
+	)
+{
+unique_ptr<JP2_Reader>
+	reader (JP2::reader (source));
+reader->rendered_pixel_bits (16).render ();
+unsigned int
+	width = reader->rendered_width (),
+	height = reader->rendered_height (),
+	pixel_bytes = reader->rendered_pixel_bytes ();
+size_t
+	pixel_gap = (size_t)reader->pixel_stride () * pixel_bytes,
+	line_gap = (size_t)reader->line_stride () * pixel_bytes;
+const unsigned char
+	*data = static_cast<const unsigned char*>(reader->image_data ()[0]);
+
+vector<unsigned char>
+	contiguous;
+if (data)
+	for (unsigned int
+			line = 0;
+			line < height;
+			line++)
+		contiguous.insert (contiguous.end (),
+			data + line * line_gap,
+			data + line * line_gap + (size_t)width * pixel_bytes);
+
+const unsigned int
+	lines[]  = {0, 1, height / 2, height - 1},
+	pixels[] = {0, 1, width / 2, width - 1};
+bool
+	addressed = data && ! reader->chunked_image_data ();
+for (unsigned int
+		line = 0;
+		line < 4;
+		line++)
+	for (unsigned int
+			pixel = 0;
+			pixel < 4;
+			pixel++)
+		addressed &=
+			reader->image_data (0, lines[line], pixels[pixel]) ==
+			data + lines[line] * line_gap + pixels[pixel] * pixel_gap;
+bool
+	passed =
+		check ("image data address accounts for the pixel bytes",
+			pixel_bytes == 2 &&
+			addressed);
+
+bool
+	rejected = false;
+try {reader->image_data (0, height, 0);}
+catch (JP2_Invalid_Argument&) {rejected = true;}
+passed &=
+	check ("image data address beyond the rendered region is rejected",
+		rejected);
+
+const unsigned int
+	chunk_lines = 50;
+unique_ptr<JP2_Reader>
+	chunked (JP2::reader (source));
+chunked->rendered_pixel_bits (16).image_data_chunk_lines (chunk_lines);
+chunked->render ();
+passed &=
+	check ("chunked image data is allocated in chunks of lines",
+		chunked->chunked_image_data () &&
+		chunked->effective_chunk_lines () == chunk_lines &&
+		chunked->image_data_chunks ()
+			== (height + chunk_lines - 1) / chunk_lines);
+
+vector<unsigned char>
+	chunks;
+addressed = true;
+for (unsigned int
+		chunk = 0;
+		chunk < chunked->image_data_chunks ();
+		chunk++)
+	{
+	const unsigned char
+		*line_data = static_cast<const unsigned char*>
+			(chunked->image_data_chunk (chunk)[0]);
+	for (unsigned int
+			line = chunk * chunk_lines;
+			line < height &&
+			line < (chunk + 1) * chunk_lines;
+			line++,
+				line_data += line_gap)
+		{
+		chunks.insert (chunks.end (),
+			line_data, line_data + (size_t)width * pixel_bytes);
+		addressed &=
+			chunked->image_data (0, line, width - 1) ==
+			line_data + (width - 1) * pixel_gap;
+		}
+	}
+passed &=
+	check ("chunked image data address accounts for the chunk",
+		addressed);
+passed &=
+	check ("chunked image data matches contiguous image data",
+		! contiguous.empty () &&
+		chunks == contiguous);
+return passed;
+}
+
+/*	Render a batch of region requests as 16-bit pixels with and without
+	pixel bytes swapping.
+
+	The pixels of each request must match a single rendering of the
+	request region, and the swapped pixels must be the byte reversed
+	unswapped pixels.
+*/
+bool
+check_batch_render
+	(
+	const string&	source
+	)
+{
+const unsigned int
+	total_requests = 3,
+	levels[total_requests] = {1, 1, 2};
+const Rectangle
+	regions[total_requests] =
+		{
+		Rectangle (0, 0, 128, 96),
+		Rectangle (100, 60, 150, 190),
+		Rectangle (31, 7, 201, 143)
+		};
+
+unique_ptr<JP2_Reader>
+	reader (JP2::reader (source));
+reader->rendered_pixel_bits (16);
+
+vector<unsigned short>
+	pixels[2][total_requests];
+vector<void*>
+	buffers (total_requests);
+vector<JP2_Reader::Region_Request>
+	requests[2];
+bool
+	passed = true;
+for (unsigned int
+		swapping = 0;
+		swapping < 2;
+		swapping++)
+	{
+	for (unsigned int
+			index = 0;
+			index < total_requests;
+			index++)
+		{
+		pixels[swapping][index].assign
+			((size_t)regions[index].Width * regions[index].Height, 0);
+		buffers[index] = &pixels[swapping][index][0];
+		requests[swapping].push_back (JP2_Reader::Region_Request
+			(regions[index], levels[index], &buffers[index],
+			pixels[swapping][index].size () * sizeof (unsigned short)));
+		}
+	reader->swap_pixel_bytes (swapping != 0);
+	passed &=
+		check (swapping ?
+			"batch rendering with pixel bytes swapping renders all requests" :
+			"batch rendering renders all requests",
+			reader->render (requests[swapping]) == total_requests);
+	}
+
+bool
+	matched = true,
+	swapped = true;
+reader->swap_pixel_bytes (false);
+for (unsigned int
+		index = 0;
+		index < total_requests;
+		index++)
+	{
+	reader->resolution_and_region (levels[index], regions[index]);
+	reader->render ();
+	vector<unsigned char>
+		single (rendered_pixels (*reader));
+	const unsigned char
+		*batch = (const unsigned char*)&pixels[0][index][0];
+	matched &=
+		requests[0][index].Rendered_Region == reader->rendered_region () &&
+		! single.empty () &&
+		single.size () <= pixels[0][index].size () * sizeof (unsigned short) &&
+		equal (single.begin (), single.end (), batch);
+
+	for (size_t
+			sample = 0;
+			sample < single.size () / sizeof (unsigned short);
+			sample++)
+		swapped &=
+			pixels[1][index][sample] ==
+			(unsigned short)((pixels[0][index][sample] << 8) |
+							 (pixels[0][index][sample] >> 8));
+	}
+passed &=
+	check ("batch rendering matches single renderings", matched);
+passed &=
+	check ("batch rendering with pixel bytes swapping reverses the pixel bytes",
+		swapped);
+return passed;
+}
+
+/*	Run all the functional checks.
+
+	@return	true if all checks passed; false otherwise.
+*/
+bool
+verify_reader
+	(
+	const string&	source
+	)
+{
+cout << "Functional checks -" << endl;
+bool
+	passed = true;
+try
+	{
+	passed &= check_stretch_swap ();
+	passed &= check_tile_cache (source);
+	passed &= check_strip_render (source);
+	passed &= check_async_render (source);
+	passed &= check_pipelined_disposition (source);
+	passed &= check_render_to_file (source);
+	passed &= check_float_calibration (source);
+	passed &= check_scaled_render (source);
+	passed &= check_shared_clone (source);
+	passed &= check_adaptive_increment (source);
+	passed &= check_render_statistics (source);
+	passed &= check_quality_layers (source);
+	passed &= check_reader_pool (source);
+	passed &= check_buffer_pool ();
+	passed &= check_chunked_image_data (source);
+	passed &= check_batch_render (source);
+	}
+catch (JP2_Exception& except)
+	{
+	passed = check (string ("JP2 Reader error: ") + except.message (), false);
+	}
+catch (exception& except)
+	{
+	passed = check (string ("Exception: ") + except.what (), false);
+	}
+cout << (passed ? "All checks passed." : "!!! Checks failed.") << endl;
+return passed;
+}
+
 /*==============================================================================
 	Time duration function
 */
@@ -288,6 +1612,7 @@ bool
 	swap_bytes		= false,
 	prompt			= false,
 	clone			= false,
+	verify			= false,
 	description_only= false;
 long
 	value;
@@ -412,6 +1737,10 @@ for (int
 				clone = true;
 				break;
 
+			case 'V':	//	Verify.
+				verify = true;
+				break;
+
 			case 'D':	//	Description only.
 				description_only = true;
 				break;
@@ -437,6 +1766,9 @@ if (JP2_source.empty ())
 	usage (NO_INPUT_FILE);
     }
 
+if (verify)
+	exit (verify_reader (JP2_source) ? SUCCESS : CHECK_FAILURE);
+
 char
 	input[4];
 if (prompt)